@@ -0,0 +1,210 @@
+#!/usr/bin/env python3
+"""
+RT-MHR Benchmark Harness
+
+Runs the comparative-evaluation example over a sweep of node counts,
+protocols and RNG runs, one simulation process per core. Every run appends
+its record to its own CSV file under <out>/runs/, and a run whose file
+already exists is skipped, so an interrupted sweep picks up where it stopped.
+Once all runs are in, the records are merged into <out>/runs.csv and
+averaged into <out>/summary.csv and <out>/summary.json, with 95% confidence
+intervals for PDR, delay and control overhead.
+
+Usage:
+    python3 rtmhr_benchmark.py --ns3-path ~/ns-3.43 --nodes 5 10 20 --runs 10
+"""
+
+import argparse
+import csv
+import json
+import math
+import os
+import subprocess
+import sys
+import time
+from concurrent.futures import ThreadPoolExecutor, as_completed
+from pathlib import Path
+
+# Two-sided 95% Student t quantiles by degrees of freedom
+T_QUANTILES = {
+    1: 12.706, 2: 4.303, 3: 3.182, 4: 2.776, 5: 2.571, 6: 2.447, 7: 2.365,
+    8: 2.306, 9: 2.262, 10: 2.228, 11: 2.201, 12: 2.179, 13: 2.160,
+    14: 2.145, 15: 2.131, 16: 2.120, 17: 2.110, 18: 2.101, 19: 2.093,
+    20: 2.086, 21: 2.080, 22: 2.074, 23: 2.069, 24: 2.064, 25: 2.060,
+    26: 2.056, 27: 2.052, 28: 2.048, 29: 2.045, 30: 2.042, 40: 2.021,
+    60: 2.000, 120: 1.980,
+}
+
+METRICS = ["pdr", "throughput_kbps", "delay_ms", "overhead"]
+
+EXAMPLE = "comparative-evaluation"
+
+
+def t_quantile(df):
+    """Two-sided 95% t quantile, from the next tabulated degree of freedom down"""
+    if df <= 0:
+        return float("nan")
+    return T_QUANTILES[max(d for d in T_QUANTILES if d <= df)] if df <= 120 else 1.960
+
+
+def confidence_interval(values):
+    """Mean and 95% confidence half-width of a sample"""
+    n = len(values)
+    mean = sum(values) / n
+    if n < 2:
+        return mean, 0.0
+    variance = sum((v - mean) ** 2 for v in values) / (n - 1)
+    return mean, t_quantile(n - 1) * math.sqrt(variance / n)
+
+
+def run_file(args, protocol, nodes, run):
+    """Checkpoint file of one run, named after everything that shapes it"""
+    name = f"{protocol.lower()}-n{nodes}-t{args.time:g}-s{args.size}-r{run}.csv"
+    return args.out / "runs" / name
+
+
+def run_simulation(args, protocol, nodes, run):
+    """Run one simulation; return (protocol, nodes, run, wall seconds, error)"""
+    target = run_file(args, protocol, nodes, run)
+    partial = target.with_suffix(".part")
+    partial.unlink(missing_ok=True)
+    program = " ".join([
+        EXAMPLE,
+        f"--nodes={nodes}",
+        f"--time={args.time}",
+        f"--size={args.size}",
+        f"--run={run}",
+        f"--rtmhr={int(protocol == 'RTMHR')}",
+        f"--aodv={int(protocol == 'AODV')}",
+        f"--output={partial.resolve()}",
+    ])
+    cmd = ["./ns3", "run", "--no-build", program]
+    start = time.time()
+    try:
+        result = subprocess.run(cmd, cwd=args.ns3_path, capture_output=True, text=True,
+                                timeout=args.timeout)
+    except subprocess.TimeoutExpired:
+        return protocol, nodes, run, time.time() - start, "timed out"
+    elapsed = time.time() - start
+    if result.returncode != 0 or not partial.exists():
+        error = (result.stderr.strip().splitlines() or ["failed"])[-1]
+        return protocol, nodes, run, elapsed, error
+    # Only a complete record counts as done
+    partial.rename(target)
+    return protocol, nodes, run, elapsed, None
+
+
+def load_records(out):
+    """Read every finished run"""
+    records = []
+    for path in sorted((out / "runs").glob("*.csv")):
+        with open(path, newline="") as f:
+            records.extend(csv.DictReader(f))
+    return records
+
+
+def summarize(records):
+    """Group the runs by scenario and compute the intervals"""
+    groups = {}
+    for record in records:
+        key = (record["protocol"], int(record["nodes"]), float(record["time"]),
+               int(record["size"]))
+        groups.setdefault(key, []).append(record)
+    summary = []
+    for (protocol, nodes, duration, size), group in sorted(groups.items()):
+        row = {"protocol": protocol, "nodes": nodes, "time": duration, "size": size,
+               "runs": len(group)}
+        for metric in METRICS:
+            mean, half = confidence_interval([float(r[metric]) for r in group])
+            row[metric] = round(mean, 4)
+            row[metric + "_ci95"] = round(half, 4)
+        summary.append(row)
+    return summary
+
+
+def write_outputs(out, records, summary):
+    """Write the merged runs and the summary as CSV and JSON"""
+    if records:
+        with open(out / "runs.csv", "w", newline="") as f:
+            writer = csv.DictWriter(f, fieldnames=list(records[0].keys()))
+            writer.writeheader()
+            writer.writerows(records)
+    if summary:
+        with open(out / "summary.csv", "w", newline="") as f:
+            writer = csv.DictWriter(f, fieldnames=list(summary[0].keys()))
+            writer.writeheader()
+            writer.writerows(summary)
+    with open(out / "summary.json", "w") as f:
+        json.dump(summary, f, indent=2)
+
+
+def print_summary(summary):
+    """Print the summary table"""
+    print(f"\n{'Protocol':<9} {'Nodes':<6} {'Runs':<5} {'PDR (%)':<16} "
+          f"{'Delay (ms)':<18} {'Overhead':<14}")
+    print("-" * 72)
+    for row in summary:
+        print(f"{row['protocol']:<9} {row['nodes']:<6} {row['runs']:<5} "
+              f"{row['pdr']:>6.2f} ± {row['pdr_ci95']:<6.2f} "
+              f"{row['delay_ms']:>8.2f} ± {row['delay_ms_ci95']:<6.2f} "
+              f"{row['overhead']:>5.2f} ± {row['overhead_ci95']:<5.2f}")
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(description="Parallel, resumable RT-MHR benchmark sweep")
+    parser.add_argument("--ns3-path", type=Path, default=Path("."),
+                        help="ns-3 top-level directory")
+    parser.add_argument("--out", type=Path, default=Path("rtmhr_benchmark"),
+                        help="output and checkpoint directory")
+    parser.add_argument("--nodes", type=int, nargs="+", default=[5, 10, 15, 20, 25])
+    parser.add_argument("--protocols", nargs="+", default=["RTMHR", "AODV"],
+                        choices=["RTMHR", "AODV"])
+    parser.add_argument("--runs", type=int, default=5, help="RNG runs per point")
+    parser.add_argument("--first-run", type=int, default=1, help="first RNG run number")
+    parser.add_argument("--time", type=float, default=30.0, help="simulated seconds")
+    parser.add_argument("--size", type=int, default=1024, help="packet size")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1,
+                        help="simulations run at once")
+    parser.add_argument("--timeout", type=float, default=600.0,
+                        help="wall-clock limit per simulation, in seconds")
+    parser.add_argument("--no-build", action="store_true",
+                        help="skip building the example first")
+    args = parser.parse_args(argv)
+
+    args.out.mkdir(parents=True, exist_ok=True)
+    (args.out / "runs").mkdir(exist_ok=True)
+
+    if not args.no_build:
+        # Once up front, so the workers never race to rebuild
+        build = subprocess.run(["./ns3", "build", EXAMPLE], cwd=args.ns3_path)
+        if build.returncode != 0:
+            return build.returncode
+
+    runs = range(args.first_run, args.first_run + args.runs)
+    jobs = [(protocol, nodes, run) for nodes in args.nodes for protocol in args.protocols
+            for run in runs]
+    pending = [job for job in jobs if not run_file(args, *job).exists()]
+    print(f"{len(jobs)} runs, {len(jobs) - len(pending)} already done, "
+          f"{args.jobs} at a time")
+
+    failures = 0
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        futures = [pool.submit(run_simulation, args, *job) for job in pending]
+        for done, future in enumerate(as_completed(futures), 1):
+            protocol, nodes, run, elapsed, error = future.result()
+            status = f"FAILED ({error})" if error else "ok"
+            failures += error is not None
+            print(f"[{done}/{len(pending)}] {protocol} {nodes} nodes run {run}: "
+                  f"{status}, {elapsed:.1f} s", flush=True)
+
+    records = load_records(args.out)
+    summary = summarize(records)
+    write_outputs(args.out, records, summary)
+    print_summary(summary)
+    if failures:
+        print(f"\n{failures} runs failed; rerun the same command to retry them")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -496,10 +496,86 @@ int main(int argc, char* argv[])
         print("Visualization plots saved successfully!")
 
 
+# Record layout of RtMhrSnapshotWriter (model/rtmhr-snapshot.h), little-endian
+SNAPSHOT_MAGIC = b"RTMHRSNP"
+SNAPSHOT_HEADER = np.dtype([('magic', 'S8'), ('version', '<u2'), ('record_size', '<u2'),
+                            ('flags', '<u4')])
+SNAPSHOT_RECORD = np.dtype([
+    ('time', '<i8'), ('node', '<u4'), ('kind', '<u4'),
+    ('destination', '<u4'), ('next_hop', '<u4'), ('interface', '<u4'), ('hop_count', '<u4'),
+    ('link_quality', '<f8'), ('queuing_delay', '<f8'), ('mobility', '<f8'), ('score', '<f8'),
+    ('expiry', '<i8'),
+])
+SNAPSHOT_KINDS = {0: 'entry', 1: 'removed', 2: 'marker'}
+
+
+def _dotted(addresses):
+    """Format an array of host-order IPv4 addresses as dotted quads"""
+    addresses = np.asarray(addresses, dtype=np.uint32)
+    octets = [(addresses >> shift) & 0xff for shift in (24, 16, 8, 0)]
+    return ['.'.join(map(str, quad)) for quad in zip(*octets)]
+
+
+def read_routing_snapshot(path):
+    """Read a binary routing table snapshot into a DataFrame
+
+    Returns one row per record with times in seconds, addresses as strings and
+    the kind as 'entry', 'removed' or 'marker', plus whether the file holds
+    delta snapshots.
+    """
+    header = np.fromfile(path, dtype=SNAPSHOT_HEADER, count=1)
+    if len(header) != 1 or header['magic'][0] != SNAPSHOT_MAGIC:
+        raise ValueError(f"{path} is not an RT-MHR snapshot file")
+    if header['record_size'][0] != SNAPSHOT_RECORD.itemsize:
+        raise ValueError(f"{path}: unsupported record size {header['record_size'][0]}")
+    records = np.fromfile(path, dtype=SNAPSHOT_RECORD, offset=SNAPSHOT_HEADER.itemsize)
+    df = pd.DataFrame(records)
+    df['time'] = df['time'] / 1e9
+    df['expiry'] = df['expiry'] / 1e9
+    df['kind'] = df['kind'].map(SNAPSHOT_KINDS)
+    df['destination'] = _dotted(records['destination'])
+    df['next_hop'] = _dotted(records['next_hop'])
+    return df, bool(header['flags'][0] & 1)
+
+
+def expand_snapshot_deltas(df):
+    """Rebuild the full tables of every snapshot from delta records
+
+    Replays the entries and removals of each node in file order and emits the
+    table of every node at every marker, giving the rows a file written
+    without delta mode would hold (markers dropped).
+    """
+    columns = [c for c in df.columns if c not in ('time', 'node', 'kind')]
+    tables = {}
+    rows = []
+    snapshot = None
+
+    def emit():
+        for node in sorted(tables):
+            for route in tables[node].values():
+                rows.append({'time': snapshot, 'node': node, 'kind': 'entry', **route})
+
+    for record in df.itertuples(index=False):
+        if record.kind == 'marker':
+            if snapshot is not None:
+                emit()
+            snapshot = record.time
+        elif record.kind == 'removed':
+            tables.setdefault(record.node, {}).pop(record.destination, None)
+        else:
+            tables.setdefault(record.node, {})[record.destination] = \
+                {c: getattr(record, c) for c in columns}
+    if snapshot is not None:
+        emit()
+    return pd.DataFrame(rows, columns=df.columns)
+
+
 def main():
     parser = argparse.ArgumentParser(description='RT-MHR Protocol Evaluation')
-    parser.add_argument('--mode', choices=['simulate', 'analyze', 'both'], 
+    parser.add_argument('--mode', choices=['simulate', 'analyze', 'both', 'snapshot'], 
                        default='both', help='Operation mode')
+    parser.add_argument('--snapshot', type=Path,
+                       help='Binary routing table snapshot to convert to CSV (snapshot mode)')
     parser.add_argument('--ns3-path', default='/home/ramas/ns-allinone-3.43/ns-3.43',
                        help='Path to NS-3 installation')
     parser.add_argument('--workers', type=int, default=4,
@@ -507,6 +583,16 @@ def main():
     
     args = parser.parse_args()
     
+    if args.mode == 'snapshot':
+        df, delta = read_routing_snapshot(args.snapshot)
+        if delta:
+            df = expand_snapshot_deltas(df)
+        df = df[df['kind'] == 'entry'].drop(columns='kind')
+        output = args.snapshot.with_suffix('.csv')
+        df.to_csv(output, index=False)
+        print(f"{len(df)} routes written to {output}")
+        return
+
     # Create simulation instance
     sim = RTMHRSimulation(args.ns3_path)
     
@@ -14,12 +14,16 @@
 #include "ns3/rtmhr-helper.h"
 #include "ns3/wifi-module.h"
 
+#include <fstream>
 #include <iomanip>
 
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("ComparativeEvaluation");
 
+// RT-MHR and AODV both exchange control messages on this UDP port
+static const uint16_t ROUTING_PORT = 654;
+
 struct ProtocolResults
 {
     double pdr;
@@ -27,6 +31,8 @@ struct ProtocolResults
     double delay;
     uint32_t txPackets;
     uint32_t rxPackets;
+    uint32_t controlPackets; // Routing packets sent, all nodes together
+    double overhead;         // Routing packets sent per data packet delivered
     std::string protocolName;
 };
 
@@ -82,20 +88,27 @@ runSimulation(std::string protocol, uint32_t numNodes, double simulationTime, ui
 
     // Setup Internet stack with specified routing protocol
     InternetStackHelper internet;
+    RtMhrHelper rtmhr;
+    AodvHelper aodv;
 
     if (protocol == "RTMHR")
     {
-        RtMhrHelper rtmhr;
         internet.SetRoutingHelper(rtmhr);
     }
     else if (protocol == "AODV")
     {
-        AodvHelper aodv;
         internet.SetRoutingHelper(aodv);
     }
 
     internet.Install(nodes);
 
+    // Fixed stream numbers, so that only the run number changes the outcome
+    int64_t stream = 0;
+    stream += wifi.AssignStreams(devices, stream);
+    stream += internet.AssignStreams(nodes, stream);
+    stream += protocol == "RTMHR" ? rtmhr.AssignStreams(nodes, stream)
+                                  : aodv.AssignStreams(nodes, stream);
+
     // Assign IP addresses
     Ipv4AddressHelper address;
     address.SetBase("10.1.1.0", "255.255.255.0");
@@ -136,6 +149,7 @@ runSimulation(std::string protocol, uint32_t numNodes, double simulationTime, ui
 
     uint32_t totalTxPackets = 0;
     uint32_t totalRxPackets = 0;
+    uint32_t controlPackets = 0;
     double totalThroughput = 0.0;
     double totalDelay = 0.0;
     uint32_t flowCount = 0;
@@ -143,6 +157,11 @@ runSimulation(std::string protocol, uint32_t numNodes, double simulationTime, ui
     for (auto& flow : stats)
     {
         Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow(flow.first);
+        if (t.destinationPort == ROUTING_PORT)
+        {
+            controlPackets += flow.second.txPackets;
+            continue;
+        }
 
         totalTxPackets += flow.second.txPackets;
         totalRxPackets += flow.second.rxPackets;
@@ -163,6 +182,8 @@ runSimulation(std::string protocol, uint32_t numNodes, double simulationTime, ui
     results.pdr = totalTxPackets > 0 ? (double)totalRxPackets / totalTxPackets * 100.0 : 0.0;
     results.throughput = flowCount > 0 ? totalThroughput / flowCount : 0.0;
     results.delay = flowCount > 0 ? totalDelay / flowCount : 0.0;
+    results.controlPackets = controlPackets;
+    results.overhead = totalRxPackets > 0 ? (double)controlPackets / totalRxPackets : 0.0;
 
     Simulator::Destroy();
     return results;
@@ -177,6 +198,8 @@ main(int argc, char* argv[])
     uint32_t packetSize = 1024;
     bool testRtmhr = true;
     bool testAodv = true;
+    uint32_t run = 1;
+    std::string output;
 
     // Parse command line
     CommandLine cmd(__FILE__);
@@ -185,12 +208,17 @@ main(int argc, char* argv[])
     cmd.AddValue("size", "Packet size", packetSize);
     cmd.AddValue("rtmhr", "Test RT-MHR protocol", testRtmhr);
     cmd.AddValue("aodv", "Test AODV protocol", testAodv);
+    cmd.AddValue("run", "RNG run number", run);
+    cmd.AddValue("output", "CSV file to append one record per protocol to", output);
     cmd.Parse(argc, argv);
 
+    RngSeedManager::SetRun(run);
+
     std::cout << "=== RT-MHR vs AODV Comparative Evaluation ===" << std::endl;
     std::cout << "Nodes: " << numNodes << std::endl;
     std::cout << "Simulation Time: " << simulationTime << " seconds" << std::endl;
     std::cout << "Packet Size: " << packetSize << " bytes" << std::endl;
+    std::cout << "Run: " << run << std::endl;
     std::cout << std::endl;
 
     std::vector<ProtocolResults> results;
@@ -228,6 +256,31 @@ main(int argc, char* argv[])
                   << result.txPackets << std::setw(10) << result.rxPackets << std::endl;
     }
 
+    if (!output.empty())
+    {
+        bool header = std::ifstream(output).peek() == std::ifstream::traits_type::eof();
+        std::ofstream csv(output, std::ios::app);
+        if (!csv)
+        {
+            std::cerr << "Cannot open " << output << std::endl;
+            return 1;
+        }
+        if (header)
+        {
+            csv << "protocol,nodes,time,size,run,pdr,throughput_kbps,delay_ms,tx_packets,"
+                   "rx_packets,control_packets,overhead"
+                << std::endl;
+        }
+        csv << std::setprecision(6);
+        for (const auto& result : results)
+        {
+            csv << result.protocolName << "," << numNodes << "," << simulationTime << ","
+                << packetSize << "," << run << "," << result.pdr << "," << result.throughput
+                << "," << result.delay << "," << result.txPackets << "," << result.rxPackets
+                << "," << result.controlPackets << "," << result.overhead << std::endl;
+        }
+    }
+
     // Performance comparison
     if (results.size() == 2)
     {
@@ -0,0 +1,359 @@
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/rtmhr-helper.h"
+#include "ns3/rtmhr-packet.h"
+#include "ns3/rtmhr.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <sstream>
+
+/**
+ * \file
+ * \ingroup rtmhr
+ * \brief Wall-clock cost of the RT-MHR routing hot paths
+ *
+ * Drives RouteOutput, RouteInput, ForwardPacketTo, the RT-MHR message receive
+ * path, header serialization and composite metric scoring directly on one node
+ * whose tables are filled with synthetic routes, without any Wi-Fi simulation,
+ * and reports the mean wall-clock time and heap allocations per call for each
+ * table size. Build with the optimized profile for meaningful numbers:
+ *
+ *     ./ns3 configure --build-profile=optimized --enable-examples
+ *     ./ns3 run "rtmhr-microbenchmark --entries=10,100,1000,10000"
+ */
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("RtMhrMicroBenchmark");
+
+/// Heap allocations so far, counted by the replacement operator new below
+static uint64_t g_allocations = 0;
+
+void*
+operator new(std::size_t size)
+{
+    g_allocations++;
+    void* p = std::malloc(size ? size : 1);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void
+operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief Microbenchmarks of the RT-MHR hot paths, a friend of RtMhr
+ */
+class RtMhrMicroBenchmark
+{
+  public:
+    /**
+     * \brief Constructor
+     * \param iterations calls timed per operation and table size
+     * \param neighbors largest neighbor table built
+     */
+    RtMhrMicroBenchmark(uint32_t iterations, uint32_t neighbors);
+
+    /**
+     * \brief Time every operation against tables of one size
+     * \param entries number of synthetic routes
+     */
+    void Run(uint32_t entries);
+
+  private:
+    /// Calls prepared and timed at once; preparing copies packets, timing must not
+    static constexpr uint32_t BATCH = 1024;
+
+    /**
+     * \brief Build a node with an RT-MHR instance and fill its tables
+     * \param entries number of synthetic routes
+     */
+    void Setup(uint32_t entries);
+
+    /**
+     * \brief Time an operation and print its cost
+     * \param name operation name
+     * \param prepare called untimed before each batch with the batch size
+     * \param op the operation, called with the index of the call, BATCH times per batch
+     */
+    template <typename Prepare, typename Op>
+    void Measure(const std::string& name, Prepare prepare, Op op);
+
+    /**
+     * \brief Make one fresh packet per call of the next batch
+     * \param count batch size
+     * \param prototype packet copied
+     */
+    void MakePackets(uint32_t count, Ptr<const Packet> prototype);
+
+    /**
+     * \brief Get the destination of the i-th call, strided over the whole table
+     * \param i call index
+     * \return the destination
+     */
+    Ipv4Address GetDestination(uint32_t i) const
+    {
+        return m_destinations[(i * 7919) % m_destinations.size()];
+    }
+
+    /// Forwarding callback throwing the packet away
+    static void DiscardForward(Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header& h)
+    {
+    }
+
+    /// Error callback throwing the packet away
+    static void DiscardError(Ptr<const Packet> p, const Ipv4Header& h, Socket::SocketErrno e)
+    {
+    }
+
+    /// Local delivery callback throwing the packet away
+    static void DiscardLocal(Ptr<const Packet> p, const Ipv4Header& h, uint32_t iif)
+    {
+    }
+
+    uint32_t m_iterations;                   ///< Calls timed per operation
+    uint32_t m_maxNeighbors;                 ///< Largest neighbor table built
+    uint32_t m_entries;                      ///< Routes in the current tables
+    Ptr<RtMhr> m_rtmhr;                      ///< Instance under test
+    Ptr<NetDevice> m_device;                 ///< Its only non-loopback device
+    Ipv4Address m_local;                     ///< Its address
+    std::vector<Ipv4Address> m_destinations; ///< Synthetic route destinations
+    std::vector<Ipv4Address> m_neighbors;    ///< Synthetic neighbors
+    std::vector<Ptr<Packet>> m_packets;      ///< Packets of the current batch
+};
+
+RtMhrMicroBenchmark::RtMhrMicroBenchmark(uint32_t iterations, uint32_t neighbors)
+    : m_iterations(iterations),
+      m_maxNeighbors(neighbors),
+      m_entries(0)
+{
+}
+
+void
+RtMhrMicroBenchmark::Setup(uint32_t entries)
+{
+    m_entries = entries;
+    Ptr<Node> node = CreateObject<Node>();
+    SimpleNetDeviceHelper devices;
+    m_device = devices.Install(node).Get(0);
+
+    InternetStackHelper internet;
+    RtMhrHelper rtmhr;
+    internet.SetRoutingHelper(rtmhr);
+    internet.Install(node);
+
+    // One /8, so that every synthetic address is on the link
+    Ipv4AddressHelper address;
+    address.SetBase("10.0.0.0", "255.0.0.0");
+    m_local = address.Assign(NetDeviceContainer(m_device)).GetAddress(0);
+
+    m_rtmhr = DynamicCast<RtMhr>(node->GetObject<Ipv4>()->GetRoutingProtocol());
+    NS_ABORT_MSG_UNLESS(m_rtmhr, "RT-MHR is not the node's routing protocol");
+
+    // Let the protocol start; time stands still at 2 s from then on
+    Simulator::Stop(Seconds(2));
+    Simulator::Run();
+
+    m_neighbors.clear();
+    m_destinations.clear();
+    rtmhr::RtMhrHeader hello(RTMHR_HELLO);
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(hello);
+    const uint32_t neighborBase = Ipv4Address("10.0.1.0").Get();
+    for (uint32_t i = 0; i < std::min(entries, m_maxNeighbors); ++i)
+    {
+        m_neighbors.push_back(Ipv4Address(neighborBase + i));
+        m_rtmhr->RecvMessage(packet->Copy(), m_neighbors.back(), 1);
+    }
+
+    // Multi-hop routes spread over the neighbors, valid for the whole run
+    const uint32_t destinationBase = Ipv4Address("10.1.0.0").Get();
+    for (uint32_t i = 0; i < entries; ++i)
+    {
+        RouteEntry entry(Ipv4Address(destinationBase + i), Simulator::Now() + Hours(1));
+        entry.SetNextHop(m_neighbors[i % m_neighbors.size()], 1);
+        entry.hopCount = 2 + i % 4;
+        entry.metric.hopCount = entry.hopCount;
+        entry.metric.queuingDelay = 0.001 * (i % 10);
+        m_rtmhr->AddRoute(entry);
+        m_destinations.push_back(entry.destination);
+    }
+    m_rtmhr->m_metricEngine.Refresh(m_rtmhr->m_routeTable);
+}
+
+void
+RtMhrMicroBenchmark::MakePackets(uint32_t count, Ptr<const Packet> prototype)
+{
+    m_packets.clear();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        m_packets.push_back(prototype->Copy());
+    }
+}
+
+template <typename Prepare, typename Op>
+void
+RtMhrMicroBenchmark::Measure(const std::string& name, Prepare prepare, Op op)
+{
+    std::chrono::nanoseconds elapsed(0);
+    uint64_t allocations = 0;
+    for (uint32_t done = 0; done < m_iterations; done += BATCH)
+    {
+        uint32_t count = std::min(BATCH, m_iterations - done);
+        prepare(count);
+        uint64_t before = g_allocations;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            op(done + i);
+        }
+        elapsed += std::chrono::steady_clock::now() - start;
+        allocations += g_allocations - before;
+    }
+    std::cout << std::left << std::setw(28) << name << std::right << std::setw(8) << m_entries
+              << std::fixed << std::setprecision(1) << std::setw(12)
+              << double(elapsed.count()) / m_iterations << std::setprecision(2) << std::setw(12)
+              << double(allocations) / m_iterations << std::endl;
+}
+
+void
+RtMhrMicroBenchmark::Run(uint32_t entries)
+{
+    Setup(entries);
+    auto noPrepare = [](uint32_t) {};
+    Ptr<const Packet> payload = Create<Packet>(512);
+
+    Ipv4Header header;
+    header.SetSource(m_local);
+    header.SetProtocol(17);
+    header.SetTtl(64);
+    Socket::SocketErrno sockerr;
+    Measure(
+        "RouteOutput",
+        [&](uint32_t count) { MakePackets(count, payload); },
+        [&](uint32_t i) {
+            header.SetDestination(GetDestination(i));
+            m_rtmhr->RouteOutput(m_packets[i % BATCH], header, Ptr<NetDevice>(), sockerr);
+        });
+
+    // Packets relayed for a node that is not a neighbor
+    Ipv4RoutingProtocol::UnicastForwardCallback ucb = MakeCallback(&DiscardForward);
+    Ipv4RoutingProtocol::MulticastForwardCallback mcb;
+    Ipv4RoutingProtocol::LocalDeliverCallback lcb = MakeCallback(&DiscardLocal);
+    Ipv4RoutingProtocol::ErrorCallback ecb = MakeCallback(&DiscardError);
+    header.SetSource(Ipv4Address("10.2.0.1"));
+    Measure(
+        "RouteInput (forward)",
+        [&](uint32_t count) { MakePackets(count, payload); },
+        [&](uint32_t i) {
+            header.SetDestination(GetDestination(i));
+            m_rtmhr->RouteInput(m_packets[i % BATCH], header, m_device, ucb, mcb, lcb, ecb);
+        });
+    Measure(
+        "ForwardPacketTo",
+        [&](uint32_t count) { MakePackets(count, payload); },
+        [&](uint32_t i) {
+            header.SetDestination(GetDestination(i));
+            m_rtmhr->ForwardPacketTo(m_packets[i % BATCH], header, 1, ucb, ecb);
+        });
+
+    // The receive path past the socket read: decode, neighbor refresh, dispatch
+    rtmhr::RtMhrHeader hello(RTMHR_HELLO);
+    hello.SetDelay(0.002);
+    Ptr<Packet> helloPacket = Create<Packet>();
+    helloPacket->AddHeader(hello);
+    Measure(
+        "RecvRtMhr (HELLO)",
+        [&](uint32_t count) { MakePackets(count, helloPacket); },
+        [&](uint32_t i) {
+            m_rtmhr->RecvMessage(m_packets[i % BATCH], m_neighbors[i % m_neighbors.size()], 1);
+        });
+
+    rtmhr::RtMhrHeader rreq(RTMHR_RREQ,
+                            3,
+                            42,
+                            GetDestination(0),
+                            m_local,
+                            0.9,
+                            0.004,
+                            0.5);
+    rreq.SetSequenceNumber(7);
+    Buffer buffer;
+    buffer.AddAtStart(rreq.GetSerializedSize());
+    Measure("RtMhrHeader::Serialize", noPrepare, [&](uint32_t) { rreq.Serialize(buffer.Begin()); });
+    rtmhr::RtMhrHeader decoded;
+    Measure("RtMhrHeader::Deserialize", noPrepare, [&](uint32_t) {
+        decoded.Deserialize(buffer.Begin());
+    });
+
+    // Scores of the table's own metrics, fresh and from the cache
+    std::vector<CrossLayerMetric> metrics;
+    for (const auto& iter : m_rtmhr->m_routeTable)
+    {
+        metrics.push_back(iter.second.metric);
+    }
+    const RtMhrMetricEngine& engine = m_rtmhr->m_metricEngine;
+    double sum = 0;
+    Measure("Composite metric (compute)", noPrepare, [&](uint32_t i) {
+        sum += engine.Compute(metrics[i % metrics.size()]);
+    });
+    Measure("Composite metric (cached)", noPrepare, [&](uint32_t i) {
+        sum += engine.GetScore(metrics[i % metrics.size()]);
+    });
+    NS_LOG_LOGIC("Score sum " << sum);
+
+    m_packets.clear();
+    m_rtmhr = nullptr;
+    m_device = nullptr;
+    Simulator::Destroy();
+}
+
+} // namespace ns3
+
+int
+main(int argc, char* argv[])
+{
+    std::string entries = "10,100,1000,10000";
+    uint32_t iterations = 100000;
+    uint32_t neighbors = 50;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("entries", "Comma-separated route table sizes", entries);
+    cmd.AddValue("iterations", "Calls timed per operation and table size", iterations);
+    cmd.AddValue("neighbors", "Largest neighbor table built", neighbors);
+    cmd.Parse(argc, argv);
+
+    std::cout << std::left << std::setw(28) << "Operation" << std::right << std::setw(8)
+              << "Entries" << std::setw(12) << "ns/op" << std::setw(12) << "allocs/op"
+              << std::endl;
+    std::cout << std::string(60, '-') << std::endl;
+
+    RtMhrMicroBenchmark benchmark(iterations, std::max(neighbors, 1U));
+    std::istringstream sizes(entries);
+    std::string size;
+    while (std::getline(sizes, size, ','))
+    {
+        benchmark.Run(std::max<uint32_t>(std::stoul(size), 1));
+    }
+    return 0;
+}
@@ -6,6 +6,7 @@
 #include "ns3/node-list.h"
 #include "ns3/node.h"
 #include "ns3/rtmhr.h"
+#include "ns3/simulator.h"
 
 namespace ns3
 {
@@ -22,7 +23,8 @@ RtMhrHelper::~RtMhrHelper()
 }
 
 RtMhrHelper::RtMhrHelper(const RtMhrHelper& o)
-    : m_agentFactory(o.m_agentFactory)
+    : m_agentFactory(o.m_agentFactory),
+      m_knownPositions(o.m_knownPositions)
 {
 }
 
@@ -36,6 +38,10 @@ Ptr<Ipv4RoutingProtocol>
 RtMhrHelper::Create(Ptr<Node> node) const
 {
     Ptr<RtMhr> agent = m_agentFactory.Create<RtMhr>();
+    for (const auto& known : m_knownPositions)
+    {
+        agent->SetKnownPosition(known.first, known.second);
+    }
     node->AggregateObject(agent);
     return agent;
 }
@@ -46,6 +52,12 @@ RtMhrHelper::Set(std::string name, const AttributeValue& value)
     m_agentFactory.Set(name, value);
 }
 
+void
+RtMhrHelper::AddKnownPosition(Ipv4Address node, const Vector& position)
+{
+    m_knownPositions[node] = position;
+}
+
 int64_t
 RtMhrHelper::AssignStreams(NodeContainer c, int64_t stream)
 {
@@ -89,12 +101,16 @@ RtMhrHelper::AssignStreams(NodeContainer c, int64_t stream)
 void
 RtMhrHelper::Install() const
 {
-    NodeContainer allNodes;
+    NodeContainer localNodes;
     for (uint32_t i = 0; i < NodeList::GetNNodes(); ++i)
     {
-        allNodes.Add(NodeList::GetNode(i));
+        Ptr<Node> node = NodeList::GetNode(i);
+        if (IsLocal(node))
+        {
+            localNodes.Add(node);
+        }
     }
-    Install(allNodes);
+    Install(localNodes);
 }
 
 void
@@ -146,10 +162,19 @@ RtMhrHelper::Install(NodeContainer c) const
 {
     for (NodeContainer::Iterator i = c.Begin(); i != c.End(); ++i)
     {
-        Install(*i);
+        if (IsLocal(*i))
+        {
+            Install(*i);
+        }
     }
 }
 
+bool
+RtMhrHelper::IsLocal(Ptr<Node> node)
+{
+    return node->GetSystemId() == Simulator::GetSystemId();
+}
+
 Ptr<RtMhr>
 RtMhrHelper::GetRtMhr(Ptr<Node> node) const
 {
@@ -189,4 +214,54 @@ RtMhrHelper::GetRtMhr(Ptr<Node> node) const
     return 0;
 }
 
+RtMhrStats
+RtMhrHelper::GetStats(NodeContainer c) const
+{
+    RtMhrStats total;
+    for (NodeContainer::Iterator i = c.Begin(); i != c.End(); ++i)
+    {
+        Ptr<RtMhr> rtmhr = IsLocal(*i) ? GetRtMhr(*i) : nullptr;
+        if (rtmhr)
+        {
+            total.Merge(rtmhr->GetStats());
+        }
+    }
+    return total;
+}
+
+Ptr<RtMhrSnapshotWriter>
+RtMhrHelper::EnableSnapshots(std::string filename,
+                             Time interval,
+                             NodeContainer c,
+                             bool delta) const
+{
+    NS_LOG_FUNCTION(this << filename << interval << delta);
+    std::vector<Ptr<RtMhr>> protocols;
+    for (NodeContainer::Iterator i = c.Begin(); i != c.End(); ++i)
+    {
+        Ptr<RtMhr> rtmhr = IsLocal(*i) ? GetRtMhr(*i) : nullptr;
+        if (rtmhr)
+        {
+            protocols.push_back(rtmhr);
+        }
+    }
+    Ptr<RtMhrSnapshotWriter> writer = ns3::Create<RtMhrSnapshotWriter>(filename, delta);
+    Simulator::Schedule(interval, &RtMhrHelper::WriteSnapshotEvery, interval, protocols, writer);
+    Simulator::ScheduleDestroy(&RtMhrSnapshotWriter::Close, writer);
+    return writer;
+}
+
+void
+RtMhrHelper::WriteSnapshotEvery(Time interval,
+                                std::vector<Ptr<RtMhr>> protocols,
+                                Ptr<RtMhrSnapshotWriter> writer)
+{
+    writer->BeginSnapshot(Simulator::Now());
+    for (const auto& rtmhr : protocols)
+    {
+        rtmhr->WriteSnapshot(writer);
+    }
+    Simulator::Schedule(interval, &RtMhrHelper::WriteSnapshotEvery, interval, protocols, writer);
+}
+
 } // namespace ns3
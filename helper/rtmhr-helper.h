@@ -8,6 +8,8 @@
 #include "ns3/object-factory.h"
 #include "ns3/rtmhr.h"
 
+#include <map>
+
 namespace ns3
 {
 
@@ -65,8 +67,9 @@ class RtMhrHelper : public Ipv4RoutingHelper
     int64_t AssignStreams(NodeContainer c, int64_t stream);
 
     /**
-     * \brief Install RT-MHR routing on all nodes in the container
-     * \param c The container of nodes
+     * \brief Install RT-MHR routing on every node this simulator process runs
+     *
+     * In a distributed simulation the nodes of other ranks are skipped, see IsLocal().
      */
     void Install() const;
 
@@ -77,11 +80,23 @@ class RtMhrHelper : public Ipv4RoutingHelper
     void Install(Ptr<Node> node) const;
 
     /**
-     * \brief Install RT-MHR routing on all nodes in the container
-     * \param c The container of nodes to install on
+     * \brief Install RT-MHR routing on the nodes of the container this process runs
+     * \param c The container of nodes to install on; nodes of other ranks are skipped
      */
     void Install(NodeContainer c) const;
 
+    /**
+     * \brief Check whether a node is simulated by this process
+     * \param node the node
+     * \return true unless a distributed simulation gave the node to another rank
+     *
+     * RT-MHR keeps no state but its own node's and learns about neighbors only
+     * from the messages it receives, so every rank runs just its own nodes.
+     * Instances created on the other ranks' nodes, for example through
+     * InternetStackHelper, stay dormant.
+     */
+    static bool IsLocal(Ptr<Node> node);
+
     /**
      * \brief Get the RT-MHR routing protocol from a node
      * \param node The node to get the protocol from
@@ -89,8 +104,54 @@ class RtMhrHelper : public Ipv4RoutingHelper
      */
     Ptr<RtMhr> GetRtMhr(Ptr<Node> node) const;
 
+    /**
+     * \brief Sum the protocol counters of a set of nodes
+     * \param c NodeContainer of the nodes; those without RT-MHR or run by another
+     *          rank are skipped
+     * \return the merged counters, table sizes summed too
+     */
+    RtMhrStats GetStats(NodeContainer c) const;
+
+    /**
+     * \brief Periodically write binary routing table snapshots of a set of nodes
+     * \param filename the snapshot file, shared by the nodes
+     * \param interval time between snapshots, the first one taken after one interval
+     * \param c NodeContainer of the nodes; those without RT-MHR or run by another
+     *          rank are skipped, so each rank of a distributed run needs its own file
+     * \param delta whether later snapshots hold only the routes that changed
+     * \return the writer, flushed and closed when the simulator is destroyed
+     *
+     * A compact replacement for Ipv4RoutingHelper::PrintRoutingTableAllEvery();
+     * evaluation/rtmhr_evaluation.py reads the file back into a DataFrame.
+     */
+    Ptr<RtMhrSnapshotWriter> EnableSnapshots(std::string filename,
+                                             Time interval,
+                                             NodeContainer c,
+                                             bool delta = true) const;
+
+    /**
+     * \brief Tell every protocol this helper creates where a stationary node is
+     * \param node an address of the node, such as a road-side unit
+     * \param position its position
+     *
+     * Used with the GeoForwarding attribute, see RtMhr::SetKnownPosition().
+     * Call before installing the protocols.
+     */
+    void AddKnownPosition(Ipv4Address node, const Vector& position);
+
   private:
-    ObjectFactory m_agentFactory; ///< Object factory
+    /**
+     * \brief Write one snapshot and schedule the next
+     * \param interval time between snapshots
+     * \param protocols the protocols to snapshot
+     * \param writer the snapshot writer
+     */
+    static void WriteSnapshotEvery(Time interval,
+                                   std::vector<Ptr<RtMhr>> protocols,
+                                   Ptr<RtMhrSnapshotWriter> writer);
+
+    ObjectFactory m_agentFactory;                   ///< Object factory
+    std::map<Ipv4Address, Vector> m_knownPositions; ///< Stationary nodes given to the protocols
 };
 
 } // namespace ns3
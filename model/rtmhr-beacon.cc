@@ -0,0 +1,52 @@
+#include "rtmhr-beacon.h"
+
+#include "ns3/log.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("RtMhrBeaconScheduler");
+
+RtMhrBeaconScheduler::RtMhrBeaconScheduler()
+    : m_min(Seconds(1)),
+      m_max(Seconds(1)),
+      m_interval(Seconds(1)),
+      m_threshold(1.0),
+      m_churn(0),
+      m_traffic(false)
+{
+}
+
+void
+RtMhrBeaconScheduler::SetBounds(Time min, Time max)
+{
+    m_min = min;
+    m_max = std::max(min, max);
+    m_interval = m_min;
+}
+
+Time
+RtMhrBeaconScheduler::Update(double mobility)
+{
+    if (m_churn > 0)
+    {
+        m_interval = m_min;
+    }
+    else if (mobility > m_threshold)
+    {
+        m_interval = std::max(m_min, m_interval / 2);
+    }
+    else
+    {
+        m_interval = std::min(m_max, m_interval * 2);
+    }
+    NS_LOG_LOGIC("Churn " << m_churn << ", mobility " << mobility << ": next interval "
+                          << m_interval.As(Time::S));
+    m_churn = 0;
+    m_traffic = false;
+    return m_interval;
+}
+
+} // namespace ns3
@@ -0,0 +1,97 @@
+#ifndef RTMHR_BEACON_H
+#define RTMHR_BEACON_H
+
+#include "ns3/nstime.h"
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief Adaptive interval of a periodic beacon (HELLO or PROBE)
+ *
+ * The interval moves between a minimum and a maximum:
+ *
+ * - a neighbor joined or was lost since the last beacon: back to the minimum
+ * - the neighborhood moves faster than the mobility threshold: halved
+ * - otherwise: doubled, up to the maximum
+ *
+ * so a changing neighborhood is tracked closely while a parked one costs
+ * a beacon every maximum interval. A beacon is also suppressed when other
+ * broadcast traffic went out since the previous beacon time, as it told the
+ * neighbors as much.
+ */
+class RtMhrBeaconScheduler
+{
+  public:
+    RtMhrBeaconScheduler();
+
+    /**
+     * \brief Set the interval range and restart from the minimum
+     * \param min shortest interval
+     * \param max longest interval
+     */
+    void SetBounds(Time min, Time max);
+
+    /**
+     * \brief Set the speed above which the neighborhood counts as mobile
+     * \param threshold mobility metric threshold
+     */
+    void SetMobilityThreshold(double threshold)
+    {
+        m_threshold = threshold;
+    }
+
+    /**
+     * \brief Record a neighbor joining or leaving
+     */
+    void NotifyChurn()
+    {
+        m_churn++;
+    }
+
+    /**
+     * \brief Record a broadcast, other than the beacon, that proves liveness
+     */
+    void NotifyTraffic()
+    {
+        m_traffic = true;
+    }
+
+    /**
+     * \brief Check whether the beacon due now is redundant
+     * \return true if liveness was proven since the previous beacon time
+     */
+    bool IsSuppressed() const
+    {
+        return m_traffic;
+    }
+
+    /**
+     * \brief Pick the next interval and start a new one, at beacon time
+     * \param mobility current mobility metric of the neighborhood
+     * \return the next interval
+     */
+    Time Update(double mobility);
+
+    /**
+     * \brief Get the current interval
+     * \return the interval
+     */
+    Time GetInterval() const
+    {
+        return m_interval;
+    }
+
+  private:
+    Time m_min;         ///< Shortest interval
+    Time m_max;         ///< Longest interval
+    Time m_interval;    ///< Current interval
+    double m_threshold; ///< Mobility above which the interval shrinks
+    uint32_t m_churn;   ///< Neighbor changes since the last beacon time
+    bool m_traffic;     ///< Broadcast sent since the last beacon time
+};
+
+} // namespace ns3
+
+#endif /* RTMHR_BEACON_H */
@@ -0,0 +1,278 @@
+#include "rtmhr-classifier.h"
+
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("RtMhrClassifier");
+
+/**
+ * \brief Parse an unsigned decimal number
+ * \param text the number
+ * \param max largest accepted value
+ * \param [out] value the number
+ * \return false if text is not a number up to max
+ */
+static bool
+ParseUint(const std::string& text, uint32_t max, uint32_t& value)
+{
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos)
+    {
+        return false;
+    }
+    unsigned long v = std::strtoul(text.c_str(), nullptr, 10);
+    if (v > max)
+    {
+        return false;
+    }
+    value = v;
+    return true;
+}
+
+/**
+ * \brief Parse an A.B.C.D/L prefix
+ * \param text the prefix
+ * \param [out] addr the address
+ * \param [out] mask the mask
+ * \return false on a syntax error
+ */
+static bool
+ParsePrefix(const std::string& text, Ipv4Address& addr, Ipv4Mask& mask)
+{
+    std::string::size_type slash = text.find('/');
+    uint32_t len = 32;
+    if (slash != std::string::npos && !ParseUint(text.substr(slash + 1), 32, len))
+    {
+        return false;
+    }
+    std::string host = text.substr(0, slash);
+    if (host.empty() || host.find_first_not_of("0123456789.") != std::string::npos)
+    {
+        return false;
+    }
+    addr = Ipv4Address(host.c_str());
+    mask = Ipv4Mask(("/" + std::to_string(len)).c_str());
+    return true;
+}
+
+RtMhrClassifier::RtMhrClassifier(TrafficPriority fallback)
+    : m_fallback(fallback),
+      m_portRules(0)
+{
+    std::fill(m_dscpMask, m_dscpMask + 64, 0);
+    std::fill(m_protocolMask, m_protocolMask + 256, 0);
+}
+
+bool
+RtMhrClassifier::SetRules(const std::string& rules)
+{
+    NS_LOG_FUNCTION(this << rules);
+
+    // Compile into a scratch table so that a bad rule changes nothing
+    RtMhrClassifier compiled(m_fallback);
+    std::istringstream in(rules);
+    std::string text;
+    while (std::getline(in, text, ';'))
+    {
+        text.erase(0, text.find_first_not_of(' '));
+        text.erase(text.find_last_not_of(' ') + 1);
+        if (text.empty())
+        {
+            continue;
+        }
+        if (compiled.m_rules.size() == MAX_RULES || !compiled.AddRule(text))
+        {
+            NS_LOG_WARN("Rejecting classifier rules at \"" << text << "\"");
+            return false;
+        }
+    }
+    compiled.m_text = rules;
+    *this = compiled;
+    return true;
+}
+
+bool
+RtMhrClassifier::AddRule(const std::string& text)
+{
+    std::string::size_type colon = text.rfind(':');
+    if (colon == std::string::npos)
+    {
+        return false;
+    }
+
+    Rule rule;
+    std::string priority = text.substr(colon + 1);
+    if (priority == "high")
+    {
+        rule.priority = HIGH_PRIORITY;
+    }
+    else if (priority == "medium")
+    {
+        rule.priority = MEDIUM_PRIORITY;
+    }
+    else if (priority == "normal")
+    {
+        rule.priority = NORMAL_PRIORITY;
+    }
+    else
+    {
+        return false;
+    }
+    rule.portMin = 0;
+    rule.portMax = 65535;
+    rule.srcMask = Ipv4Mask::GetZero();
+    rule.dstMask = Ipv4Mask::GetZero();
+    rule.hits = 0;
+
+    int32_t dscp = -1;
+    int32_t protocol = -1;
+    bool hasPort = false;
+    std::istringstream in(text.substr(0, colon));
+    std::string cond;
+    while (std::getline(in, cond, ','))
+    {
+        std::string::size_type eq = cond.find('=');
+        std::string key = cond.substr(0, eq);
+        std::string value = eq == std::string::npos ? "" : cond.substr(eq + 1);
+        uint32_t n;
+        if (key == "udp" || key == "tcp")
+        {
+            protocol = key == "udp" ? 17 : 6;
+        }
+        else if (key == "proto" && ParseUint(value, 255, n))
+        {
+            protocol = n;
+        }
+        else if (key == "dscp" && ParseUint(value, 63, n))
+        {
+            dscp = n;
+        }
+        else if (key == "port")
+        {
+            std::string::size_type dash = value.find('-');
+            uint32_t lo;
+            uint32_t hi;
+            if (!ParseUint(value.substr(0, dash), 65535, lo))
+            {
+                return false;
+            }
+            hi = lo;
+            if (dash != std::string::npos && (!ParseUint(value.substr(dash + 1), 65535, hi) || hi < lo))
+            {
+                return false;
+            }
+            rule.portMin = lo;
+            rule.portMax = hi;
+            hasPort = true;
+        }
+        else if (key == "src" && ParsePrefix(value, rule.src, rule.srcMask))
+        {
+        }
+        else if (key == "dst" && ParsePrefix(value, rule.dst, rule.dstMask))
+        {
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    uint32_t bit = 1U << m_rules.size();
+    for (uint32_t d = 0; d < 64; ++d)
+    {
+        if (dscp < 0 || static_cast<uint32_t>(dscp) == d)
+        {
+            m_dscpMask[d] |= bit;
+        }
+    }
+    for (uint32_t p = 0; p < 256; ++p)
+    {
+        if (protocol < 0 || static_cast<uint32_t>(protocol) == p)
+        {
+            m_protocolMask[p] |= bit;
+        }
+    }
+    if (hasPort)
+    {
+        m_portRules |= bit;
+        m_portBitmap.resize(65536 / 64, 0);
+        for (uint32_t port = rule.portMin; port <= rule.portMax; ++port)
+        {
+            m_portBitmap[port >> 6] |= 1ULL << (port & 63);
+        }
+    }
+    m_rules.push_back(rule);
+    return true;
+}
+
+TrafficPriority
+RtMhrClassifier::Classify(Ptr<const Packet> packet, const Ipv4Header& header, int32_t& rule)
+{
+    rule = Match(packet, header);
+    if (rule < 0)
+    {
+        return m_fallback;
+    }
+    m_rules[rule].hits++;
+    return m_rules[rule].priority;
+}
+
+TrafficPriority
+RtMhrClassifier::Peek(Ptr<const Packet> packet, const Ipv4Header& header) const
+{
+    int32_t rule = Match(packet, header);
+    return rule < 0 ? m_fallback : m_rules[rule].priority;
+}
+
+int32_t
+RtMhrClassifier::Match(Ptr<const Packet> packet, const Ipv4Header& header) const
+{
+    uint8_t protocol = header.GetProtocol();
+    uint32_t candidates = m_dscpMask[header.GetTos() >> 2] & m_protocolMask[protocol];
+
+    uint16_t sport = 0;
+    uint16_t dport = 0;
+    if (candidates & m_portRules)
+    {
+        // TCP and UDP both start with the source and destination ports
+        bool hasPorts = packet && (protocol == 6 || protocol == 17) &&
+                        header.GetFragmentOffset() == 0 && packet->GetSize() >= 4;
+        if (hasPorts)
+        {
+            uint8_t ports[4];
+            packet->CopyData(ports, 4);
+            sport = (ports[0] << 8) | ports[1];
+            dport = (ports[2] << 8) | ports[3];
+        }
+        if (!hasPorts || (!IsRulePort(sport) && !IsRulePort(dport)))
+        {
+            candidates &= ~m_portRules;
+        }
+    }
+
+    while (candidates)
+    {
+        uint32_t i = __builtin_ctz(candidates);
+        candidates &= candidates - 1;
+        const Rule& r = m_rules[i];
+        if ((m_portRules & (1U << i)) && (sport < r.portMin || sport > r.portMax) &&
+            (dport < r.portMin || dport > r.portMax))
+        {
+            continue;
+        }
+        if (!r.srcMask.IsMatch(header.GetSource(), r.src) ||
+            !r.dstMask.IsMatch(header.GetDestination(), r.dst))
+        {
+            continue;
+        }
+        return i;
+    }
+    return -1;
+}
+
+} // namespace ns3
@@ -0,0 +1,151 @@
+#ifndef RTMHR_CLASSIFIER_H
+#define RTMHR_CLASSIFIER_H
+
+#include "rtmhr-pqueue.h"
+
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-header.h"
+#include "ns3/packet.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief Rule-based traffic classifier for the forwarding queue
+ *
+ * Rules are written as a ';'-separated list, each rule being a ','-separated
+ * list of conditions followed by ':' and a priority (high, medium, normal):
+ *
+ * \verbatim
+   dscp=46:high;udp,port=5000-5099:medium;dst=10.2.0.0/16:high
+   \endverbatim
+ *
+ * Conditions are "udp", "tcp", "proto=N", "dscp=N", "port=N" or "port=A-B"
+ * (matched against either L4 port), "src=A.B.C.D/L" and "dst=A.B.C.D/L". All
+ * conditions of a rule must hold; the first matching rule wins.
+ *
+ * Rules are compiled into per-DSCP and per-protocol bitmasks of the rules
+ * they allow, plus a bitmap of every port named by a rule. Classify() ANDs
+ * two masks, clears the port rules at once when neither port is in the
+ * bitmap, and only then checks the few surviving candidates in order.
+ */
+class RtMhrClassifier
+{
+  public:
+    /// Maximum number of rules
+    static const uint32_t MAX_RULES = 32;
+
+    /**
+     * \brief Constructor
+     * \param fallback priority of packets no rule matches
+     */
+    RtMhrClassifier(TrafficPriority fallback = NORMAL_PRIORITY);
+
+    /**
+     * \brief Replace the rule table
+     * \param rules the rules, in the syntax described above
+     * \return false, leaving the table unchanged, if the rules do not parse
+     */
+    bool SetRules(const std::string& rules);
+
+    /**
+     * \brief Get the rule table
+     * \return the rules as last set
+     */
+    std::string GetRules() const
+    {
+        return m_text;
+    }
+
+    /**
+     * \brief Classify a packet
+     * \param packet the packet, starting with its L4 header, or null before the
+     *        source has added one, in which case no port condition holds
+     * \param header its IP header
+     * \param [out] rule index of the matching rule, or -1 for the fallback
+     * \return the traffic class
+     */
+    TrafficPriority Classify(Ptr<const Packet> packet, const Ipv4Header& header, int32_t& rule);
+
+    /**
+     * \brief Classify a packet without counting a hit
+     * \param packet the packet, as for Classify()
+     * \param header its IP header
+     * \return the traffic class
+     */
+    TrafficPriority Peek(Ptr<const Packet> packet, const Ipv4Header& header) const;
+
+    /**
+     * \brief Get the number of rules
+     * \return the number of rules
+     */
+    uint32_t GetNRules() const
+    {
+        return m_rules.size();
+    }
+
+    /**
+     * \brief Get how many packets a rule matched
+     * \param rule the rule index
+     * \return the hit count
+     */
+    uint64_t GetHits(uint32_t rule) const
+    {
+        return m_rules[rule].hits;
+    }
+
+  private:
+    /// One compiled rule
+    struct Rule
+    {
+        TrafficPriority priority; ///< Class of matching packets
+        uint16_t portMin;         ///< Lowest matching port
+        uint16_t portMax;         ///< Highest matching port
+        Ipv4Address src;          ///< Source prefix
+        Ipv4Mask srcMask;         ///< Source prefix mask, all zero for any
+        Ipv4Address dst;          ///< Destination prefix
+        Ipv4Mask dstMask;         ///< Destination prefix mask, all zero for any
+        uint64_t hits;            ///< Packets matched
+    };
+
+    /**
+     * \brief Parse one rule and add it to the compiled tables
+     * \param text the rule
+     * \return false on a syntax error
+     */
+    bool AddRule(const std::string& text);
+
+    /**
+     * \brief Find the first rule matching a packet
+     * \param packet the packet, as for Classify()
+     * \param header its IP header
+     * \return the rule index, or -1 if none matches
+     */
+    int32_t Match(Ptr<const Packet> packet, const Ipv4Header& header) const;
+
+    /**
+     * \brief Check whether a port is named by any rule
+     * \param port the port
+     * \return true if it is
+     */
+    bool IsRulePort(uint16_t port) const
+    {
+        return m_portBitmap[port >> 6] & (1ULL << (port & 63));
+    }
+
+    TrafficPriority m_fallback;         ///< Class when no rule matches
+    std::string m_text;                 ///< Rules as set
+    std::vector<Rule> m_rules;          ///< Rules in precedence order
+    uint32_t m_dscpMask[64];            ///< Rules allowing each DSCP value
+    uint32_t m_protocolMask[256];       ///< Rules allowing each IP protocol
+    uint32_t m_portRules;               ///< Rules with a port condition
+    std::vector<uint64_t> m_portBitmap; ///< Ports named by any rule
+};
+
+} // namespace ns3
+
+#endif /* RTMHR_CLASSIFIER_H */
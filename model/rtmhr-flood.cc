@@ -0,0 +1,94 @@
+#include "rtmhr-flood.h"
+
+#include "ns3/log.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("RtMhrFloodControl");
+
+RtMhrFloodControl::RtMhrFloodControl()
+    : m_mode(RTMHR_FLOOD_ALWAYS),
+      m_threshold(3),
+      m_minProbability(0.4)
+{
+}
+
+RtMhrFloodControl::~RtMhrFloodControl()
+{
+    Clear();
+}
+
+void
+RtMhrFloodControl::SetMode(RtMhrFloodMode mode)
+{
+    Clear();
+    m_mode = mode;
+}
+
+void
+RtMhrFloodControl::SetMinProbability(double probability)
+{
+    m_minProbability = std::min(1.0, std::max(0.0, probability));
+}
+
+double
+RtMhrFloodControl::GetProbability(double distance) const
+{
+    distance = std::min(1.0, std::max(0.0, distance));
+    return m_minProbability + (1.0 - m_minProbability) * distance;
+}
+
+RtMhrFloodControl::Pending&
+RtMhrFloodControl::Add(Ipv4Address origin, uint32_t id)
+{
+    NS_LOG_FUNCTION(this << origin << id);
+    m_pending.push_back(Pending{origin, id, 1, std::vector<Ipv4Address>(), EventId()});
+    return m_pending.back();
+}
+
+RtMhrFloodControl::Pending*
+RtMhrFloodControl::Find(Ipv4Address origin, uint32_t id)
+{
+    for (auto& pending : m_pending)
+    {
+        if (pending.id == id && pending.origin == origin)
+        {
+            return &pending;
+        }
+    }
+    return nullptr;
+}
+
+bool
+RtMhrFloodControl::Release(Ipv4Address origin, uint32_t id)
+{
+    NS_LOG_FUNCTION(this << origin << id);
+    Pending* pending = Find(origin, id);
+    if (!pending)
+    {
+        return false;
+    }
+    bool forward = m_mode == RTMHR_FLOOD_COUNTER ? pending->copies < m_threshold
+                                                 : !pending->uncovered.empty();
+    NS_LOG_LOGIC("RREQ " << id << " from " << origin << ": " << pending->copies << " copies, "
+                         << pending->uncovered.size() << " neighbors uncovered, "
+                         << (forward ? "rebroadcast" : "suppressed"));
+    *pending = m_pending.back();
+    m_pending.pop_back();
+    return forward;
+}
+
+void
+RtMhrFloodControl::Clear()
+{
+    for (auto& pending : m_pending)
+    {
+        pending.event.Cancel();
+    }
+    m_pending.clear();
+}
+
+} // namespace ns3
@@ -0,0 +1,164 @@
+#ifndef RTMHR_FLOOD_H
+#define RTMHR_FLOOD_H
+
+#include "ns3/event-id.h"
+#include "ns3/ipv4-address.h"
+
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief RREQ rebroadcast disciplines
+ */
+enum RtMhrFloodMode
+{
+    RTMHR_FLOOD_ALWAYS = 0,        ///< Rebroadcast every new RREQ at once
+    RTMHR_FLOOD_COUNTER = 1,       ///< Cancel after enough copies heard while waiting
+    RTMHR_FLOOD_PROBABILISTIC = 2, ///< Rebroadcast with a probability growing with distance
+    RTMHR_FLOOD_COVERAGE = 3       ///< Cancel once the copies heard reach every neighbor
+};
+
+/**
+ * \ingroup rtmhr
+ * \brief Broadcast storm mitigation for RREQ rebroadcasts
+ *
+ * In the counter and coverage modes a node that hears a new RREQ waits a
+ * random assessment delay before rebroadcasting it, and meanwhile counts the
+ * duplicates the duplicate cache turns away. The rebroadcast is cancelled if
+ * at least the threshold number of copies was heard (counter), or if every
+ * neighbor was within range of some node that sent a copy (coverage). The
+ * probabilistic mode decides at once, from how far the sender is believed to
+ * be: neighbors at the edge of its range reach the most new nodes.
+ */
+class RtMhrFloodControl
+{
+  public:
+    /// A rebroadcast waiting for its assessment delay to end
+    struct Pending
+    {
+        Ipv4Address origin;                 ///< RREQ originator
+        uint32_t id;                        ///< Request ID
+        uint32_t copies;                    ///< Copies heard, the first one included
+        std::vector<Ipv4Address> uncovered; ///< Neighbors no copy is known to reach
+        EventId event;                      ///< The scheduled rebroadcast
+    };
+
+    RtMhrFloodControl();
+    ~RtMhrFloodControl();
+
+    /**
+     * \brief Set the rebroadcast discipline, dropping pending rebroadcasts
+     * \param mode the discipline
+     */
+    void SetMode(RtMhrFloodMode mode);
+
+    /**
+     * \brief Get the rebroadcast discipline
+     * \return the discipline
+     */
+    RtMhrFloodMode GetMode() const
+    {
+        return m_mode;
+    }
+
+    /**
+     * \brief Check whether new RREQs wait for an assessment delay
+     * \return true in the counter and coverage modes
+     */
+    bool IsDeferred() const
+    {
+        return m_mode == RTMHR_FLOOD_COUNTER || m_mode == RTMHR_FLOOD_COVERAGE;
+    }
+
+    /**
+     * \brief Set the number of copies that cancels a rebroadcast
+     * \param threshold copies heard, the first one included
+     */
+    void SetCounterThreshold(uint32_t threshold)
+    {
+        m_threshold = threshold;
+    }
+
+    /**
+     * \brief Get the number of copies that cancels a rebroadcast
+     * \return copies heard, the first one included
+     */
+    uint32_t GetCounterThreshold() const
+    {
+        return m_threshold;
+    }
+
+    /**
+     * \brief Set the rebroadcast probability of a sender right next to us
+     * \param probability the probability in [0, 1]
+     */
+    void SetMinProbability(double probability);
+
+    /**
+     * \brief Get the rebroadcast probability of a sender right next to us
+     * \return the probability
+     */
+    double GetMinProbability() const
+    {
+        return m_minProbability;
+    }
+
+    /**
+     * \brief Get the rebroadcast probability in the probabilistic mode
+     * \param distance estimated distance to the sender as a fraction of the
+     *        range, in [0, 1]
+     * \return the probability, from the minimum at 0 to 1 at the range
+     */
+    double GetProbability(double distance) const;
+
+    /**
+     * \brief Start the assessment of a new RREQ
+     * \param origin RREQ originator
+     * \param id request ID
+     * \return the record, whose uncovered neighbors and event the caller fills in
+     */
+    Pending& Add(Ipv4Address origin, uint32_t id);
+
+    /**
+     * \brief Find the assessment of a RREQ
+     * \param origin RREQ originator
+     * \param id request ID
+     * \return the record, or nullptr if no rebroadcast is pending
+     */
+    Pending* Find(Ipv4Address origin, uint32_t id);
+
+    /**
+     * \brief End the assessment of a RREQ, at the end of its delay
+     * \param origin RREQ originator
+     * \param id request ID
+     * \return true if the RREQ is still to be rebroadcast
+     */
+    bool Release(Ipv4Address origin, uint32_t id);
+
+    /**
+     * \brief Get the number of pending rebroadcasts
+     * \return the number of RREQs under assessment
+     */
+    uint32_t GetSize() const
+    {
+        return m_pending.size();
+    }
+
+    /**
+     * \brief Cancel every pending rebroadcast
+     */
+    void Clear();
+
+  private:
+    RtMhrFloodMode m_mode;          ///< Rebroadcast discipline
+    uint32_t m_threshold;           ///< Copies that cancel a rebroadcast
+    double m_minProbability;        ///< Rebroadcast probability at distance 0
+    std::vector<Pending> m_pending; ///< RREQs under assessment, a handful at most
+};
+
+} // namespace ns3
+
+#endif /* RTMHR_FLOOD_H */
@@ -0,0 +1,139 @@
+#include "rtmhr-id-cache.h"
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("RtMhrIdCache");
+
+RtMhrIdCache::RtMhrIdCache(uint32_t capacity, Time lifetime)
+    : m_head(0),
+      m_count(0),
+      m_lifetime(lifetime),
+      m_bits(0)
+{
+    SetCapacity(capacity);
+}
+
+bool
+RtMhrIdCache::FindSlot(Ipv4Address origin, uint32_t id, uint32_t& slot) const
+{
+    uint32_t mask = m_slots.size() - 1;
+    for (uint32_t i = Home(origin, id);; i = (i + 1) & mask)
+    {
+        if (m_slots[i] == 0)
+        {
+            return false;
+        }
+        const Record& record = m_ring[m_slots[i] - 1];
+        if (record.id == id && record.origin == origin)
+        {
+            slot = i;
+            return true;
+        }
+    }
+}
+
+void
+RtMhrIdCache::Unindex(uint32_t pos)
+{
+    // A request seen again after its record expired was indexed anew, at a
+    // newer position; the old record then no longer owns the slot
+    uint32_t slot;
+    const Record& record = m_ring[pos];
+    if (!FindSlot(record.origin, record.id, slot) || m_slots[slot] != pos + 1)
+    {
+        return;
+    }
+
+    // Shift back later members of the probe run, as RtMhrTable does
+    uint32_t mask = m_slots.size() - 1;
+    uint32_t hole = slot;
+    for (uint32_t j = (hole + 1) & mask; m_slots[j] != 0; j = (j + 1) & mask)
+    {
+        const Record& moved = m_ring[m_slots[j] - 1];
+        uint32_t home = Home(moved.origin, moved.id);
+        if (((j - home) & mask) >= ((j - hole) & mask))
+        {
+            m_slots[hole] = m_slots[j];
+            hole = j;
+        }
+    }
+    m_slots[hole] = 0;
+}
+
+bool
+RtMhrIdCache::IsDuplicate(Ipv4Address origin, uint32_t id)
+{
+    NS_LOG_FUNCTION(this << origin << id);
+    uint32_t capacity = m_ring.size();
+    if (capacity == 0)
+    {
+        return false;
+    }
+
+    Time now = Simulator::Now();
+    uint32_t slot;
+    bool found = FindSlot(origin, id, slot);
+    if (found && m_ring[m_slots[slot] - 1].expire >= now)
+    {
+        return true;
+    }
+
+    // A full ring overwrites its oldest record, which leaves the index first
+    if (m_count == capacity)
+    {
+        Unindex(m_head);
+    }
+    m_ring[m_head] = Record{origin, id, now + m_lifetime};
+    // A request seen before keeps its slot, which now points at the new record;
+    // a new one takes the first free slot of its probe run
+    if (!found || !FindSlot(origin, id, slot))
+    {
+        slot = Home(origin, id);
+        while (m_slots[slot] != 0)
+        {
+            slot = (slot + 1) & (m_slots.size() - 1);
+        }
+    }
+    m_slots[slot] = m_head + 1;
+    m_head = (m_head + 1) % capacity;
+    if (m_count < capacity)
+    {
+        m_count++;
+    }
+    return false;
+}
+
+void
+RtMhrIdCache::Purge()
+{
+    NS_LOG_FUNCTION(this);
+    uint32_t capacity = m_ring.size();
+    Time now = Simulator::Now();
+    while (m_count > 0 && m_ring[(m_head + capacity - m_count) % capacity].expire < now)
+    {
+        Unindex((m_head + capacity - m_count) % capacity);
+        m_count--;
+    }
+}
+
+void
+RtMhrIdCache::SetCapacity(uint32_t capacity)
+{
+    m_ring.assign(capacity, Record());
+    m_head = 0;
+    m_count = 0;
+
+    // At most half full, like RtMhrTable's index
+    m_bits = 1;
+    while ((1U << m_bits) < 2 * capacity)
+    {
+        m_bits++;
+    }
+    m_slots.assign(1U << m_bits, 0);
+}
+
+} // namespace ns3
@@ -0,0 +1,135 @@
+#ifndef RTMHR_ID_CACHE_H
+#define RTMHR_ID_CACHE_H
+
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief Fixed-capacity duplicate suppression cache for RREQ (origin, request ID) pairs
+ *
+ * Records are kept in a ring buffer ordered by insertion time, so memory is bounded by
+ * the capacity no matter how long the simulation runs. When the ring is full the oldest
+ * record is overwritten; Purge() drops records older than the lifetime from the tail.
+ *
+ * A linear-probing index of ring positions, keyed on (origin, request ID) and kept
+ * at most half full, makes IsDuplicate() O(1) instead of a scan of the ring. Each
+ * record is indexed when written and unindexed when overwritten or purged.
+ */
+class RtMhrIdCache
+{
+  public:
+    /**
+     * \brief Constructor
+     * \param capacity maximum number of records
+     * \param lifetime how long a record suppresses duplicates
+     */
+    RtMhrIdCache(uint32_t capacity, Time lifetime);
+
+    /**
+     * \brief Check whether a request was already seen, recording it if not
+     * \param origin the RREQ originator
+     * \param id the request ID
+     * \return true if the request is a duplicate
+     */
+    bool IsDuplicate(Ipv4Address origin, uint32_t id);
+
+    /**
+     * \brief Drop records whose lifetime has passed
+     */
+    void Purge();
+
+    /**
+     * \brief Get the number of live records
+     * \return the number of records
+     */
+    uint32_t GetSize() const
+    {
+        return m_count;
+    }
+
+    /**
+     * \brief Set the capacity, discarding all records
+     * \param capacity maximum number of records
+     */
+    void SetCapacity(uint32_t capacity);
+
+    /**
+     * \brief Get the capacity
+     * \return maximum number of records
+     */
+    uint32_t GetCapacity() const
+    {
+        return m_ring.size();
+    }
+
+    /**
+     * \brief Set the record lifetime
+     * \param lifetime how long a record suppresses duplicates
+     */
+    void SetLifetime(Time lifetime)
+    {
+        m_lifetime = lifetime;
+    }
+
+    /**
+     * \brief Get the record lifetime
+     * \return how long a record suppresses duplicates
+     */
+    Time GetLifetime() const
+    {
+        return m_lifetime;
+    }
+
+  private:
+    /// A seen request
+    struct Record
+    {
+        Ipv4Address origin; ///< RREQ originator
+        uint32_t id;        ///< Request ID
+        Time expire;        ///< Expiration time
+    };
+
+    /**
+     * \brief Home slot of a request in the index
+     * \param origin the RREQ originator
+     * \param id the request ID
+     * \return slot index
+     */
+    uint32_t Home(Ipv4Address origin, uint32_t id) const
+    {
+        // Fibonacci hashing, as in RtMhrTable; the ID is mixed in first
+        return ((origin.Get() ^ (id * 2246822519U)) * 2654435769U) >> (32 - m_bits);
+    }
+
+    /**
+     * \brief Find the index slot of a request
+     * \param origin the RREQ originator
+     * \param id the request ID
+     * \param [out] slot the slot index, if found
+     * \return true if found
+     */
+    bool FindSlot(Ipv4Address origin, uint32_t id, uint32_t& slot) const;
+
+    /**
+     * \brief Unindex the record at a ring position, if the index still points there
+     * \param pos the ring position
+     */
+    void Unindex(uint32_t pos);
+
+    std::vector<Record> m_ring;    ///< Ring buffer of records
+    uint32_t m_head;               ///< Slot of the next write
+    uint32_t m_count;              ///< Number of live records
+    Time m_lifetime;               ///< Record lifetime
+    std::vector<uint32_t> m_slots; ///< Index: ring position + 1 per slot, 0 if empty
+    uint32_t m_bits;               ///< log2 of the index size
+};
+
+} // namespace ns3
+
+#endif /* RTMHR_ID_CACHE_H */
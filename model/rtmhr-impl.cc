@@ -3,53 +3,126 @@
 
 #include "rtmhr.h"
 
+#include "ns3/abort.h"
+#include "ns3/arp-cache.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/ipv4-packet-info-tag.h"
 #include "ns3/log.h"
 #include "ns3/mobility-model.h"
+#include "ns3/net-device-queue-interface.h"
 #include "ns3/simulator.h"
+#include "ns3/socket.h"
 #include "ns3/wifi-net-device.h"
 
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
 #define RTMHR_PORT 654
 
 namespace ns3
 {
 
-// Forward declaration of RtMhrHeader from rtmhr namespace
-namespace rtmhr
-{
-class RtMhrHeader;
-}
-
 NS_LOG_COMPONENT_DEFINE("RtMhrImpl");
 
 // Simplified implementations to fix compilation issues
 
 void
-RtMhr::RecvHello(Ptr<Packet> packet, Ipv4Address from)
+RtMhr::RecvHello(Ptr<Packet> packet,
+                 const rtmhr::RtMhrHeader& header,
+                 Ipv4Address sender,
+                 uint32_t interface)
+{
+    NS_LOG_FUNCTION(this << packet << sender);
+    // RecvRtMhr already refreshed the neighbor; keep the load it advertises
+    NeighborEntry* neighbor = m_neighborTable.Find(sender);
+    if (neighbor)
+    {
+        neighbor->metric.queuingDelay = header.GetDelay();
+        neighbor->metric.Invalidate();
+        UpdateMobilityInfo(sender, header.GetPosition(), header.GetVelocity());
+    }
+
+    // Rescore whatever changed since the last HELLO so route selection only
+    // compares; of the routes, only those through the sender can have changed
+    m_metricEngine.Refresh(m_neighborTable);
+    if (neighbor)
+    {
+        RerankRoutesVia(sender);
+    }
+}
+
+void
+RtMhr::RecvProbe(Ptr<Packet> packet,
+                 const rtmhr::RtMhrHeader& header,
+                 Ipv4Address sender,
+                 uint32_t interface)
+{
+    NS_LOG_FUNCTION(this << packet << sender);
+    // A probe only proves the link, which RecvRtMhr has already recorded
+}
+
+void
+RtMhr::SendHello()
 {
-    NS_LOG_FUNCTION(this << packet << from);
-    // Simple hello processing - update neighbor table
-    m_neighborTable[from] = NeighborEntry(from);
+    NS_LOG_FUNCTION(this);
+
+    // Advertise own load and speed; neighbors fold them into the link metric
+    rtmhr::RtMhrHeader header(RTMHR_HELLO);
+    header.SetDelay(m_queuingDelay);
+    header.SetMobility(GetLocalSpeed());
+    header.SetSequenceNumber(m_sequenceNumber);
+    Vector position;
+    Vector velocity;
+    if (GetLocalMotion(position, velocity))
+    {
+        header.SetPosition(position);
+        header.SetVelocity(velocity);
+    }
+    SendControl(header, Ipv4Address("255.255.255.255"));
 }
 
 void
 RtMhr::SendProbe(Ipv4Address neighbor)
 {
     NS_LOG_FUNCTION(this << neighbor);
-    // Simple probe sending - create and send probe packet
-    Ptr<Packet> packet = Create<Packet>();
 
-    for (auto& i : m_socketAddresses)
+    // Unicast, so that the MAC reports on its delivery like on data frames
+    rtmhr::RtMhrHeader header(RTMHR_PROBE);
+    header.SetSequenceNumber(m_sequenceNumber);
+    SendControl(header, neighbor);
+}
+
+void
+RtMhr::UpdateLinkQuality(Ipv4Address neighbor, double delivered)
+{
+    NeighborEntry* entry = m_neighborTable.Find(neighbor);
+    if (entry)
     {
-        Ptr<Socket> socket = i.first;
-        try
-        {
-            socket->SendTo(packet, 0, InetSocketAddress(neighbor, RTMHR_PORT));
-        }
-        catch (...)
+        entry->UpdateLinkQuality(delivered, m_linkQualityGain);
+        if (delivered > 0)
         {
-            NS_LOG_WARN("Failed to send probe");
+            // An acknowledged frame proves the neighbor as well as a HELLO does
+            entry->validTime = std::max(entry->validTime, Simulator::Now() + GetNeighborLifetime());
         }
-        break; // Send via first socket only
+        NS_LOG_LOGIC("Delivery ratio to " << neighbor << " now " << entry->linkQuality);
+    }
+}
+
+void
+RtMhr::LearnHardwareAddress(NeighborEntry& neighbor)
+{
+    // MAC reports name the receiver by MAC address only; ARP knows it once
+    // unicast traffic has been exchanged with the neighbor
+    Ptr<Ipv4L3Protocol> l3 = m_ipv4->GetObject<Ipv4L3Protocol>();
+    Ptr<ArpCache> arp = l3 ? l3->GetInterface(neighbor.interface)->GetArpCache() : nullptr;
+    ArpCache::Entry* entry = arp ? arp->Lookup(neighbor.address) : nullptr;
+    if (entry && (entry->IsAlive() || entry->IsPermanent()) &&
+        Mac48Address::IsMatchingType(entry->GetMacAddress()))
+    {
+        neighbor.hardwareAddress = Mac48Address::ConvertFrom(entry->GetMacAddress());
+        m_macCache.Insert(neighbor.hardwareAddress, neighbor.address);
+        NS_LOG_LOGIC("Neighbor " << neighbor.address << " is " << neighbor.hardwareAddress);
     }
 }
 
@@ -58,70 +131,328 @@ RtMhr::ClassifyTraffic(Ptr<const Packet> packet, const Ipv4Header& header)
 {
     NS_LOG_FUNCTION(this << packet << header);
 
-    // Simple traffic classification based on protocol
-    if (header.GetProtocol() == 17) // UDP
+    int32_t rule;
+    TrafficPriority priority = m_classifier.Classify(packet, header, rule);
+    if (rule >= 0)
+    {
+        m_classifierHitTrace(rule, m_classifier.GetHits(rule));
+    }
+    return priority;
+}
+
+void
+RtMhr::ForwardPacket(Ptr<const Packet> packet,
+                     const Ipv4Header& header,
+                     Ptr<Ipv4Route> route,
+                     const UnicastForwardCallback& ucb,
+                     const ErrorCallback& ecb)
+{
+    NS_LOG_FUNCTION(this << packet->GetUid() << header.GetDestination());
+
+    uint32_t interface = GetInterfaceForDevice(route->GetOutputDevice());
+    RtMhrForwardEntry entry{packet,
+                            header,
+                            route,
+                            ucb,
+                            ecb,
+                            ClassifyTraffic(packet, header),
+                            Simulator::Now()};
+
+    // Drop at the first relay that sees the deadline will be missed, before
+    // any airtime is spent on the packet downstream
+    if (entry.priority == HIGH_PRIORITY &&
+        MissesDeadline(packet, header, Seconds(m_queuingDelay)))
+    {
+        NS_LOG_LOGIC("Dropping real-time packet " << packet->GetUid() << ", deadline unreachable");
+        m_stats.deadlineDrops++;
+        m_forwardDropTrace(packet, entry.priority);
+        ecb(packet, header, Socket::ERROR_AGAIN);
+        return;
+    }
+    if (!GetForwardQueue(interface).Enqueue(entry))
+    {
+        m_stats.CountQueueDrop(entry.priority);
+        m_forwardDropTrace(packet, entry.priority);
+        ecb(packet, header, Socket::ERROR_AGAIN);
+        return;
+    }
+    DrainForwardQueue(interface);
+}
+
+Time
+RtMhr::PredictPathDelay(const RouteEntry& rt) const
+{
+    // Loss on the first link is known first-hand; further links are taken as clean
+    const NeighborEntry* neighbor = m_neighborTable.Find(rt.nextHop);
+    double links = (neighbor ? neighbor->GetEtx() : 1.0) + std::max(rt.hopCount, 1U) - 1;
+    return Seconds(rt.metric.queuingDelay + links * m_linkDelay.GetSeconds());
+}
+
+bool
+RtMhr::MissesDeadline(Ptr<const Packet> packet, const Ipv4Header& header, Time wait) const
+{
+    rtmhr::RtMhrShim shim;
+    if (!PeekShim(packet, header, shim) || !shim.HasDeadline())
+    {
+        return false;
+    }
+    // Geographically forwarded packets have no route; count them one link away
+    const RouteEntry* rt = m_routeTable.Find(header.GetDestination());
+    Time rest = rt ? PredictPathDelay(*rt) : m_linkDelay;
+    return Simulator::Now() + wait + rest > shim.GetDeadline();
+}
+
+bool
+RtMhr::AdmitRealTimeFlow(const RouteEntry& rt)
+{
+    // A flow keeps its admission while active, whatever its path turns into
+    Time now = Simulator::Now();
+    auto flow = m_realTimeFlows.find(rt.destination);
+    if (flow != m_realTimeFlows.end() && now - flow->second <= m_activeRouteTimeout)
+    {
+        flow->second = now;
+        return true;
+    }
+    Time predicted = PredictPathDelay(rt);
+    if (predicted > m_deadlineBudget)
+    {
+        NS_LOG_DEBUG("Refusing real-time flow to " << rt.destination << ", path delay "
+                                                   << predicted.As(Time::MS) << " over budget");
+        m_stats.admissionRejects++;
+        return false;
+    }
+    NS_LOG_DEBUG("Admitting real-time flow to " << rt.destination);
+    m_realTimeFlows[rt.destination] = now;
+    m_stats.admissions++;
+    return true;
+}
+
+bool
+RtMhr::IsRealTime(const Ipv4Header& header) const
+{
+    // The source routes a packet before its transport header is on, so only
+    // rules without ports can make it real-time here; port rules still
+    // prioritize it at the relays, without a deadline
+    return m_deadlineBudget.IsStrictlyPositive() &&
+           m_classifier.Peek(nullptr, header) == HIGH_PRIORITY;
+}
+
+RtMhrPriorityQueue&
+RtMhr::GetForwardQueue(uint32_t interface)
+{
+    auto iter = m_forwardQueues.find(interface);
+    if (iter != m_forwardQueues.end())
     {
-        return HIGH_PRIORITY;
+        return iter->second;
     }
-    else if (header.GetProtocol() == 6) // TCP
+
+    RtMhrPriorityQueue& queue = m_forwardQueues[interface];
+    queue.SetScheduler(m_scheduler);
+    queue.SetMaxLen(HIGH_PRIORITY, m_highQueueLen);
+    queue.SetMaxLen(MEDIUM_PRIORITY, m_mediumQueueLen);
+    queue.SetMaxLen(NORMAL_PRIORITY, m_normalQueueLen);
+    return queue;
+}
+
+void
+RtMhr::SetForwardingScheduler(RtMhrScheduler scheduler)
+{
+    m_scheduler = scheduler;
+    for (auto& iter : m_forwardQueues)
     {
-        return MEDIUM_PRIORITY;
+        iter.second.SetScheduler(scheduler);
     }
+}
 
-    return NORMAL_PRIORITY;
+void
+RtMhr::SetClassifierRules(const std::string& rules)
+{
+    NS_LOG_FUNCTION(this << rules);
+    bool ok = m_classifier.SetRules(rules);
+    NS_ABORT_MSG_UNLESS(ok, "Malformed RT-MHR classifier rules \"" << rules << "\"");
 }
 
 void
-RtMhr::RecvRtMhr(Ptr<Socket> socket)
+RtMhr::DrainForwardQueue(uint32_t interface)
 {
-    NS_LOG_FUNCTION(this << socket);
+    NS_LOG_FUNCTION(this << interface);
 
-    if (!socket)
+    RtMhrPriorityQueue& queue = m_forwardQueues[interface];
+    Ptr<NetDevice> dev = GetNetDeviceForInterface(interface);
+    RtMhrForwardEntry entry;
+    bool progress = false;
+    while (!IsDeviceStalled(dev) && queue.Dequeue(entry))
+    {
+        progress = true;
+        Time sojourn = Simulator::Now() - entry.arrival;
+
+        // Late real-time data is useless to the receiver; don't spend airtime on it
+        if (entry.priority == HIGH_PRIORITY && sojourn > m_realTimeDeadline)
+        {
+            NS_LOG_LOGIC("Dropping stale real-time packet " << entry.packet->GetUid());
+            m_stats.CountQueueDrop(entry.priority);
+            m_forwardDropTrace(entry.packet, entry.priority);
+            entry.ecb(entry.packet, entry.header, Socket::ERROR_AGAIN);
+            continue;
+        }
+        if (entry.priority == HIGH_PRIORITY &&
+            MissesDeadline(entry.packet, entry.header, Time(0)))
+        {
+            NS_LOG_LOGIC("Dropping real-time packet " << entry.packet->GetUid()
+                                                      << ", deadline unreachable");
+            m_stats.deadlineDrops++;
+            m_forwardDropTrace(entry.packet, entry.priority);
+            entry.ecb(entry.packet, entry.header, Socket::ERROR_AGAIN);
+            continue;
+        }
+
+        // Same smoothing as the TCP RTT estimator
+        m_queuingDelay += (sojourn.GetSeconds() - m_queuingDelay) / 8;
+        m_forwardDelayTrace(entry.packet, entry.priority, sojourn);
+        Ptr<const Packet> packet = StampForwarded(entry.packet, entry.route, entry.header);
+        entry.ucb(entry.route, packet, entry.header);
+    }
+
+    Time& backoff = m_drainBackoff[interface];
+    if (queue.GetSize() == 0)
+    {
+        backoff = Time(0);
+        return;
+    }
+
+    // The device gives no wake-up we could hook into without taking it away
+    // from the traffic control layer, so poll until it accepts packets again
+    auto timer = m_drainTimers.find(interface);
+    if (timer == m_drainTimers.end())
+    {
+        timer = m_drainTimers.insert(std::make_pair(interface, Timer(Timer::CANCEL_ON_DESTROY)))
+                    .first;
+        timer->second.SetFunction(&RtMhr::DrainForwardQueue, this);
+        timer->second.SetArguments(interface);
+    }
+    if (timer->second.IsRunning())
     {
-        NS_LOG_WARN("Invalid socket in RecvRtMhr");
         return;
     }
+    // A device that stays stopped is polled less and less often, though at
+    // least four times per deadline for real-time packets to leave in time
+    if (progress || backoff.IsZero())
+    {
+        backoff = MilliSeconds(1);
+    }
+    else
+    {
+        backoff = std::min(backoff * 2, std::max(m_realTimeDeadline / 4, MilliSeconds(1)));
+    }
+    timer->second.Schedule(backoff);
+}
+
+bool
+RtMhr::IsDeviceStalled(Ptr<NetDevice> dev) const
+{
+    Ptr<NetDeviceQueueInterface> ndqi = dev ? dev->GetObject<NetDeviceQueueInterface>() : nullptr;
+    if (!ndqi)
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < ndqi->GetNTxQueues(); ++i)
+    {
+        if (!ndqi->GetTxQueue(i)->IsStopped())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+RtMhr::RecvRtMhr(Ptr<Socket> socket)
+{
+    NS_LOG_FUNCTION(this << socket);
 
-    // Simple packet reception
     Ptr<Packet> packet;
     Address from;
-
     while ((packet = socket->RecvFrom(from)))
     {
-        if (packet->GetSize() == 0)
+        Ipv4Address sender = InetSocketAddress::ConvertFrom(from).GetIpv4();
+        if (packet->GetSize() == 0 || IsMyOwnAddress(sender))
         {
-            break;
+            continue;
         }
 
-        // Process packet
-        InetSocketAddress fromAddr = InetSocketAddress::ConvertFrom(from);
-        Ipv4Address sender = fromAddr.GetIpv4();
-
-        NS_LOG_DEBUG("Received RT-MHR packet from " << sender);
+        // Receiving interface: known for per-interface sockets, otherwise taken
+        // from the packet info requested on the wildcard socket
+        uint32_t interface = 0;
+        Ipv4PacketInfoTag info;
+        auto bound = m_socketAddresses.find(socket);
+        if (bound != m_socketAddresses.end())
+        {
+            interface = m_ipv4->GetInterfaceForAddress(bound->second.GetLocal());
+        }
+        else if (packet->RemovePacketTag(info))
+        {
+            Ptr<NetDevice> dev = m_ipv4->GetObject<Node>()->GetDevice(info.GetRecvIf());
+            interface = GetInterfaceForDevice(dev);
+        }
+        RecvMessage(packet, sender, interface);
+    }
+}
 
-        // Parse RT-MHR header and handle different message types
-        NS_LOG_DEBUG("Processing packet from " << sender);
+void
+RtMhr::RecvMessage(Ptr<Packet> packet, Ipv4Address sender, uint32_t interface)
+{
+    // Receive handlers indexed by MessageType
+    static const MessageHandler handlers[] = {
+        nullptr,                  // 0 is not a message type
+        &RtMhr::RecvRouteRequest, // RTMHR_RREQ
+        &RtMhr::RecvRouteReply,   // RTMHR_RREP
+        &RtMhr::RecvRouteError,   // RTMHR_RERR
+        &RtMhr::RecvHello,        // RTMHR_HELLO
+        &RtMhr::RecvProbe,        // RTMHR_PROBE
+        nullptr,                  // RTMHR_PREP is not handled
+        &RtMhr::RecvRouteRequest, // RTMHR_ZONE_RREQ
+    };
+    const uint32_t nHandlers = sizeof(handlers) / sizeof(handlers[0]);
 
-        // For now, treat all packets as potential route requests
-        // In a full implementation, we would parse the header to determine message type
-        if (packet->GetSize() > 0)
-        {
-            // Simple logic: if we receive a packet, treat it as helping with routing
-            m_neighborTable[sender] = NeighborEntry(sender);
-            NS_LOG_DEBUG("Updated neighbor table with " << sender);
+    // A header of an unknown version, or cut short, is not decoded at all and
+    // counts as a message of unknown type
+    uint8_t first = 0;
+    uint32_t size = packet->CopyData(&first, 1) ? rtmhr::RtMhrHeader::GetMessageSize(first) : 0;
+    if (size == 0 || size > packet->GetSize())
+    {
+        NS_LOG_LOGIC("Ignoring unreadable RT-MHR message from " << sender);
+        m_stats.CountReceived(0, packet->GetSize());
+        m_rxTrace(packet);
+        DropControl(packet, 0);
+        return;
+    }
 
-            // For basic connectivity, just add a route to the sender
-            RouteEntry entry;
-            entry.destination = sender;
-            entry.nextHop = sender;
-            entry.interface = 1;
-            entry.metric = CrossLayerMetric();
-            entry.validTime = Simulator::Now() + Seconds(30);
+    // Decode in place; the handler gets the packet as received
+    rtmhr::RtMhrHeader header;
+    packet->PeekHeader(header);
+    uint32_t type = header.GetMessageType();
+    NS_LOG_DEBUG("Received RT-MHR message type " << type << " from " << sender);
+    m_stats.CountReceived(type, packet->GetSize());
+    m_rxTrace(packet);
 
-            m_routeTable[sender] = entry;
-            NS_LOG_DEBUG("Added direct route to " << sender);
-        }
+    // A message we cannot read proves nothing, not even the link
+    if (type >= nHandlers || !handlers[type])
+    {
+        NS_LOG_LOGIC("Ignoring RT-MHR message type " << type << " from " << sender);
+        DropControl(packet, type);
+        return;
     }
+
+    // Any other message proves that the sender is a neighbor
+    UpdateRouteToNeighbor(sender, interface);
+    (this->*handlers[type])(packet, header, sender, interface);
+}
+
+void
+RtMhr::DropControl(Ptr<const Packet> packet, uint32_t type)
+{
+    m_stats.CountDropped(type, packet->GetSize());
+    m_controlDropTrace(packet, RtMhrStats::Index(type));
 }
 
 // Additional simplified method implementations
@@ -130,130 +461,1421 @@ RtMhr::SendRouteRequest(Ipv4Address destination)
 {
     NS_LOG_FUNCTION(this << destination);
 
-    // Create simple RREQ packet (without complex header for now)
-    Ptr<Packet> packet = Create<Packet>(100); // Simple 100-byte packet
+    if (IsRouteRequestPending(destination))
+    {
+        NS_LOG_LOGIC("Route discovery for " << destination << " already in progress");
+        return;
+    }
+    if (m_discoveryStart.insert(std::make_pair(destination, Simulator::Now())).second)
+    {
+        m_stats.discoveries++;
+    }
 
-    // Broadcast RREQ using existing sockets
-    for (auto& i : m_socketAddresses)
+    // Rate limit: once the window's budget is spent, wait for the next window
+    // without using up one of the retries
+    Time now = Simulator::Now();
+    if (now - m_rreqWindowStart >= Seconds(1))
+    {
+        m_rreqWindowStart = now;
+        m_rreqCount = 0;
+    }
+    if (m_rreqCount >= m_rreqRateLimit)
     {
-        Ptr<Socket> socket = i.first;
-        socket->SetAllowBroadcast(true);
+        NS_LOG_LOGIC("RREQ rate limit reached, postponing discovery for " << destination);
+        ScheduleRouteRequest(destination, m_rreqWindowStart + Seconds(1) - now);
+        return;
+    }
+    m_rreqCount++;
+    uint32_t ttl = GetRequestTtl(destination);
 
-        InetSocketAddress broadcastAddr(Ipv4Address("255.255.255.255"), RTMHR_PORT);
-        socket->SendTo(packet, 0, broadcastAddr);
+    // Remember our own request so rebroadcast echoes of it are dropped
+    m_requestId++;
+    m_rreqIdCache.IsDuplicate(GetLocalAddress(), m_requestId);
 
-        NS_LOG_DEBUG("Sent simplified RREQ for " << destination);
-        break; // Send via first socket for simplicity
+    // Ask for a route at least as fresh as the one we knew; an expired one may
+    // have been replaced, so only a newer sequence number will do then
+    uint32_t requestedSeqNo = 0;
+    RouteEntry* known = m_routeTable.Find(destination);
+    if (known && known->sequenceNumber != 0)
+    {
+        requestedSeqNo = known->sequenceNumber + (known->IsExpired() ? 1 : 0);
     }
-}
 
-void
-RtMhr::SendRouteReply(Ipv4Address destination, Ipv4Address source, Ipv4Address nextHop)
-{
-    NS_LOG_FUNCTION(this << destination << source << nextHop);
+    // Location-aided mode: while the destination's position is known, the rings
+    // and the first network-wide RREQ stay inside the LAR request zone; retries
+    // after that flood the whole network
+    auto flooded = m_rreqAttempts.find(destination);
+    Vector position;
+    Vector velocity;
+    Vector center;
+    double radius;
+    bool zoned = m_geoForwarding && (flooded == m_rreqAttempts.end() || flooded->second == 0) &&
+                 m_locationTable.Lookup(destination, center, radius) &&
+                 GetLocalMotion(position, velocity);
 
-    // Create simple RREP packet
-    Ptr<Packet> packet = Create<Packet>(100);
+    rtmhr::RtMhrHeader header(zoned ? RTMHR_ZONE_RREQ : RTMHR_RREQ,
+                              0,
+                              m_requestId,
+                              destination,
+                              GetLocalAddress());
+    header.SetDelay(m_queuingDelay);
+    header.SetSequenceNumber(requestedSeqNo);
+    if (zoned)
+    {
+        header.SetPosition(position);
+        header.SetVelocity(velocity);
+        header.SetRequestZone(
+            RtMhrLocationTable::GetRequestZone(position, center, radius, m_zoneMargin));
+    }
+    SendControl(header, Ipv4Address("255.255.255.255"), ttl);
+    NS_LOG_DEBUG("Sent RREQ " << m_requestId << " for " << destination << " with TTL " << ttl);
 
-    // Send RREP back to nextHop
-    for (auto& i : m_socketAddresses)
+    // A ring is timed to its round trip; network-wide RREQs back off
+    // exponentially between retries
+    if (ttl < m_netDiameter)
     {
-        Ptr<Socket> socket = i.first;
-        InetSocketAddress addr(nextHop, RTMHR_PORT);
-        socket->SendTo(packet, 0, addr);
+        ScheduleRouteRequest(destination, m_nodeTraversalTime * (2 * (ttl + 2)));
+        return;
+    }
+    uint32_t attempts = ++m_rreqAttempts[destination];
+    ScheduleRouteRequest(destination,
+                         m_rreqTimeout * (1 << std::min<uint32_t>(attempts - 1, 16)));
+}
 
-        NS_LOG_DEBUG("Sent simplified RREP for " << destination << " to " << source << " via "
-                                                 << nextHop);
-        break; // Send via first socket
+void
+RtMhr::ScheduleRouteRequest(Ipv4Address dst, Time delay)
+{
+    Time when = Simulator::Now() + delay;
+    m_rreqDeadlines[dst] = when;
+    m_rreqHeap.push(std::make_pair(when, dst));
+    // An idle timer has no delay left either, so a retry due now must arm it
+    if (m_rreqHeap.top().first == when &&
+        (!m_rreqTimer.IsRunning() || m_rreqTimer.GetDelayLeft() > delay))
+    {
+        m_rreqTimer.Cancel();
+        m_rreqTimer.Schedule(delay);
     }
 }
 
 void
-RtMhr::RecvRouteRequest(Ptr<Packet> packet, Ipv4Address src, Ipv4Address dst)
+RtMhr::CancelRouteRequest(Ipv4Address dst)
 {
-    NS_LOG_FUNCTION(this << packet << src << dst);
+    // The heap entry goes stale and is dropped when it surfaces
+    m_rreqDeadlines.erase(dst);
+}
 
-    // Simplified RREQ processing
-    NS_LOG_DEBUG("Received simplified RREQ from " << src << " for " << dst);
+bool
+RtMhr::IsRouteRequestPending(Ipv4Address dst) const
+{
+    return m_rreqDeadlines.find(dst) != m_rreqDeadlines.end();
+}
 
-    // Check if we are the destination
-    if (IsMyOwnAddress(dst))
+void
+RtMhr::RouteRequestHeapExpire()
+{
+    NS_LOG_FUNCTION(this);
+    // One timer serves every destination: collect what is due first, since
+    // the retries themselves push new deadlines
+    Time now = Simulator::Now();
+    std::vector<Ipv4Address> due;
+    while (!m_rreqHeap.empty() && m_rreqHeap.top().first <= now)
     {
-        NS_LOG_DEBUG("We are the destination, sending RREP back to " << src);
-        SendRouteReply(dst, src, src);
-        return;
+        RreqDeadline top = m_rreqHeap.top();
+        m_rreqHeap.pop();
+        auto deadline = m_rreqDeadlines.find(top.second);
+        if (deadline != m_rreqDeadlines.end() && deadline->second == top.first)
+        {
+            m_rreqDeadlines.erase(deadline);
+            due.push_back(top.second);
+        }
+    }
+    for (const auto& dst : due)
+    {
+        RouteRequestTimerExpire(dst);
     }
 
-    // Forward RREQ (simplified)
-    NS_LOG_DEBUG("Forwarding RREQ for " << dst);
-
-    // Create basic route entry to source
-    RouteEntry entry;
-    entry.destination = src;
-    entry.nextHop = src;
-    entry.interface = 1;
-    entry.metric = CrossLayerMetric();
-    entry.validTime = Simulator::Now() + Seconds(30);
+    // Rearm for the earliest live deadline
+    while (!m_rreqHeap.empty())
+    {
+        auto deadline = m_rreqDeadlines.find(m_rreqHeap.top().second);
+        if (deadline != m_rreqDeadlines.end() && deadline->second == m_rreqHeap.top().first)
+        {
+            break;
+        }
+        m_rreqHeap.pop();
+    }
+    if (!m_rreqHeap.empty())
+    {
+        Time delay = m_rreqHeap.top().first - now;
+        if (!m_rreqTimer.IsRunning() || m_rreqTimer.GetDelayLeft() != delay)
+        {
+            m_rreqTimer.Cancel();
+            m_rreqTimer.Schedule(delay);
+        }
+    }
+}
 
-    m_routeTable[src] = entry;
+uint32_t
+RtMhr::GetRequestTtl(Ipv4Address destination)
+{
+    // Expanding ring: start near where the destination was last seen and widen
+    // by TtlIncrement per timeout, flooding the network past TtlThreshold
+    auto ring = m_rreqTtl.find(destination);
+    uint32_t ttl;
+    if (ring == m_rreqTtl.end())
+    {
+        RouteEntry* known = m_routeTable.Find(destination);
+        ttl = known ? known->hopCount + m_ttlIncrement : m_ttlStart;
+        ring = m_rreqTtl.insert(std::make_pair(destination, ttl)).first;
+    }
+    else if (ring->second < m_netDiameter)
+    {
+        ttl = ring->second + m_ttlIncrement;
+    }
+    else
+    {
+        return m_netDiameter;
+    }
+    if (ttl > m_ttlThreshold)
+    {
+        ttl = m_netDiameter;
+    }
+    ring->second = std::min(ttl, m_netDiameter);
+    return ring->second;
 }
 
 void
-RtMhr::RecvRouteReply(Ptr<Packet> packet, Ipv4Address src, Ipv4Address dst)
+RtMhr::RouteRequestTimerExpire(Ipv4Address dst)
 {
-    NS_LOG_FUNCTION(this << packet << src << dst);
+    NS_LOG_FUNCTION(this << dst);
 
-    NS_LOG_DEBUG("Received simplified RREP from " << src);
+    if (FindLiveRoute(dst))
+    {
+        SendPacketFromQueue(dst);
+        return;
+    }
 
-    // Add route to routing table
-    RouteEntry entry;
-    entry.destination = dst; // Use the dst parameter as destination
-    entry.nextHop = src;
-    entry.interface = 1;                              // Default interface
-    entry.metric = CrossLayerMetric();                // Default metrics
-    entry.validTime = Simulator::Now() + Seconds(30); // Route expires in 30s
+    if (m_rreqAttempts[dst] > m_rreqRetries)
+    {
+        NS_LOG_LOGIC("Route discovery for " << dst << " failed after " << m_rreqAttempts[dst]
+                                            << " RREQs");
+        m_rreqAttempts.erase(dst);
+        m_rreqTtl.erase(dst);
+        m_queue.Drop(dst);
+        EndDiscovery(dst, false);
+        return;
+    }
+    SendRouteRequest(dst);
+}
 
-    m_routeTable[dst] = entry;
+void
+RtMhr::SendPacketFromQueue(Ipv4Address dst)
+{
+    NS_LOG_FUNCTION(this << dst);
 
-    NS_LOG_DEBUG("Added route to " << dst << " via " << src);
-}
+    RouteEntry* rt = FindLiveRoute(dst);
+    if (!rt)
+    {
+        return;
+    }
 
-// Missing method implementations
+    // Any discovery for dst is over
+    CancelRouteRequest(dst);
+    m_rreqAttempts.erase(dst);
+    m_rreqTtl.erase(dst);
+    EndDiscovery(dst, true);
 
-Ptr<Socket>
-RtMhr::FindSocketWithInterfaceAddress(Ipv4InterfaceAddress iface) const
-{
-    NS_LOG_FUNCTION(this << iface);
-    // Simple implementation - return first socket
-    if (!m_socketAddresses.empty())
+    if (!m_queue.Find(dst))
     {
-        return m_socketAddresses.begin()->first;
+        return;
+    }
+    std::deque<RtMhrQueueEntry> entries;
+    m_queue.Dequeue(dst, entries);
+    // The discovery's end, and the traces it fires, may have moved the route
+    rt = m_routeTable.Find(dst);
+    RefreshActiveRoute(*rt, false);
+    Ptr<Ipv4Route> route = GetCachedRoute(*rt);
+    // Our own real-time packets waited for this route to be admitted on, and
+    // are refused as the packets sent after them would be. Admission is
+    // decided before the first send, after which rt may have moved
+    bool admitted = true;
+    for (const auto& entry : entries)
+    {
+        if (IsMyOwnAddress(entry.header.GetSource()) && IsRealTime(entry.header))
+        {
+            admitted = AdmitRealTimeFlow(*rt);
+            break;
+        }
+    }
+    for (const auto& entry : entries)
+    {
+        if (!admitted && IsMyOwnAddress(entry.header.GetSource()) && IsRealTime(entry.header))
+        {
+            NS_LOG_LOGIC("Refusing buffered real-time packet " << entry.packet->GetUid());
+            entry.ecb(entry.packet, entry.header, Socket::ERROR_NOROUTETOHOST);
+            continue;
+        }
+        NS_LOG_LOGIC("Sending buffered packet " << entry.packet->GetUid() << " to " << dst);
+        ForwardPacket(entry.packet, entry.header, route, entry.ucb, entry.ecb);
     }
-    return nullptr;
 }
 
 void
-RtMhr::ProbeTimerExpire()
+RtMhr::SendRouteReply(Ipv4Address destination,
+                      Ipv4Address source,
+                      Ipv4Address nextHop,
+                      uint32_t requestedSeqNo)
 {
-    NS_LOG_FUNCTION(this);
-    // Schedule next probe
-    m_probeTimer.Schedule(m_probeInterval);
+    NS_LOG_FUNCTION(this << destination << source << nextHop << requestedSeqNo);
+
+    // Our reply must be at least as fresh as the route the originator asked
+    // for, and known at all so intermediate nodes can answer for us later
+    if (static_cast<int32_t>(requestedSeqNo - m_sequenceNumber) > 0)
+    {
+        m_sequenceNumber = requestedSeqNo;
+    }
+    if (m_sequenceNumber == 0)
+    {
+        m_sequenceNumber = 1;
+    }
+    rtmhr::RtMhrHeader header(RTMHR_RREP, 0, 0, destination, source);
+    header.SetDelay(m_queuingDelay);
+    header.SetSequenceNumber(m_sequenceNumber);
+    SendControl(header, nextHop);
+
+    NS_LOG_DEBUG("Sent RREP for " << destination << " to " << source << " via " << nextHop);
 }
 
 void
-RtMhr::PurgeTimerExpire()
+RtMhr::SendReplyByIntermediateNode(const RouteEntry& toDst,
+                                   const RouteEntry& toOrigin,
+                                   Ipv4Address nextHop)
 {
-    NS_LOG_FUNCTION(this);
-    // Schedule next purge - use neighbor timeout since no purge interval exists
-    m_purgeTimer.Schedule(m_neighborTimeout);
+    NS_LOG_FUNCTION(this << toDst.destination << toOrigin.destination << nextHop);
+
+    // Both answers are built before the first send, which may grow the
+    // route table under the two references
+    Ipv4Address dst = toDst.destination;
+    Ipv4Address origin = toOrigin.destination;
+    Ipv4Address toDstHop = toDst.nextHop;
+
+    // Answer for the destination with the metrics of our own route to it
+    rtmhr::RtMhrHeader header(RTMHR_RREP, toDst.hopCount, 0, dst, origin);
+    header.SetDelay(toDst.metric.queuingDelay + m_queuingDelay);
+    header.SetMobility(toDst.metric.mobilityMetric);
+    header.SetSequenceNumber(toDst.sequenceNumber);
+
+    // The originator will send to the destination, which has not heard the
+    // RREQ; give it the route back before the first packet needs one
+    rtmhr::RtMhrHeader gratuitous(RTMHR_RREP, toOrigin.hopCount, 0, origin, dst);
+    gratuitous.SetDelay(toOrigin.metric.queuingDelay + m_queuingDelay);
+    gratuitous.SetMobility(toOrigin.metric.mobilityMetric);
+
+    // The originator's side now routes to the destination through us
+    m_routeTable.Find(dst)->InsertPrecursor(nextHop);
+    SendControl(header, nextHop);
+    NS_LOG_DEBUG("Sent RREP for " << dst << " to " << origin << " on its behalf");
+
+    if (m_gratuitousReply)
+    {
+        RouteEntry* back = m_routeTable.Find(origin);
+        if (back)
+        {
+            back->InsertPrecursor(toDstHop);
+        }
+        SendControl(gratuitous, toDstHop);
+        NS_LOG_DEBUG("Sent gratuitous RREP for " << origin << " to " << dst);
+    }
 }
 
 void
-RtMhr::HelloTimerExpire()
+RtMhr::SendControl(const rtmhr::RtMhrHeader& header, Ipv4Address to, uint32_t ttl)
 {
-    NS_LOG_FUNCTION(this);
-    // Schedule next hello
-    m_helloTimer.Schedule(m_helloInterval);
+    NS_LOG_FUNCTION(this << to << ttl);
+
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(header);
+    if (ttl != 0)
+    {
+        // Rides in the IP header, so the receiver reads what is left of it
+        SocketIpTtlTag tag;
+        tag.SetTtl(std::min<uint32_t>(ttl, 255));
+        packet->AddPacketTag(tag);
+    }
+    if (to.IsBroadcast() && header.GetMessageType() != RTMHR_HELLO)
+    {
+        // Neighbors refresh us on any control broadcast, so it stands in for a HELLO
+        m_helloScheduler.NotifyTraffic();
+    }
+
+    // Broadcasts go out on every RT-MHR interface, so each radio finds its own
+    // neighbors; unicasts leave on the interface the receiver was heard on
+    uint32_t type = header.GetMessageType();
+    if (to.IsBroadcast())
+    {
+        for (auto i = m_socketAddresses.begin(); i != m_socketAddresses.end(); ++i)
+        {
+            // Single-radio nodes, the common case, send the packet without a copy
+            Ptr<Packet> copy = std::next(i) == m_socketAddresses.end() ? packet : packet->Copy();
+            if (type != RTMHR_HELLO)
+            {
+                // Limited broadcasts leave the socket without RouteOutput()
+                uint32_t interface = m_ipv4->GetInterfaceForAddress(i->second.GetLocal());
+                StampShim(copy,
+                          rtmhr::RtMhrShim(),
+                          i->second.GetLocal(),
+                          to,
+                          m_ipv4->GetMtu(interface) - SHIM_HEADROOM);
+            }
+            if (i->first->SendTo(copy, 0, InetSocketAddress(to, RTMHR_PORT)) < 0)
+            {
+                DropControl(copy, type);
+                continue;
+            }
+            m_stats.CountSent(type, copy->GetSize());
+            m_txTrace(copy);
+        }
+        return;
+    }
+
+    Ptr<Socket> socket = GetSocketForInterface(GetInterfaceForNeighbor(to));
+    if (!socket)
+    {
+        if (m_socketAddresses.empty())
+        {
+            DropControl(packet, type);
+            return;
+        }
+        socket = m_socketAddresses.begin()->first;
+    }
+    // The socket routes the packet through RouteOutput() right away, which
+    // adds the shim
+    m_sendingControl = true;
+    int sent = socket->SendTo(packet, 0, InetSocketAddress(to, RTMHR_PORT));
+    m_sendingControl = false;
+    if (sent < 0)
+    {
+        DropControl(packet, type);
+        return;
+    }
+    m_stats.CountSent(type, packet->GetSize());
+    m_txTrace(packet);
+}
+
+void
+RtMhr::RecvRouteRequest(Ptr<Packet> packet,
+                        const rtmhr::RtMhrHeader& header,
+                        Ipv4Address sender,
+                        uint32_t interface)
+{
+    Ipv4Address origin = header.GetOrigin();
+    Ipv4Address dst = header.GetDestination();
+    uint32_t type = header.GetMessageType();
+    NS_LOG_FUNCTION(this << packet << sender << origin << dst);
+
+    if (IsMyOwnAddress(origin))
+    {
+        DropControl(packet, type);
+        return;
+    }
+    if (type == RTMHR_ZONE_RREQ)
+    {
+        // Lets the answer, and the traffic behind it, head for the originator
+        m_locationTable.Update(origin,
+                               header.GetPosition(),
+                               header.GetVelocity(),
+                               Simulator::Now());
+    }
+
+    // Every copy offers a reverse path towards the originator
+    uint8_t hops = header.GetHopCount() + 1;
+    bool duplicate = m_rreqIdCache.IsDuplicate(origin, header.GetRequestId());
+    RouteEntry& reverse =
+        UpdateRoute(origin, sender, interface, hops, header.GetDelay(), header.GetMobility());
+
+    // but only the first one is flooded on. The destination answers each copy
+    // that came over a path worth keeping, so the originator learns backups too
+    if (duplicate)
+    {
+        if (IsMyOwnAddress(dst) && reverse.HasNextHop(sender))
+        {
+            NS_LOG_DEBUG("Answering RREQ copy from " << sender << " with a backup RREP");
+            SendRouteReply(dst, origin, sender, header.GetSequenceNumber());
+        }
+        NotifyRreqCopy(origin, header.GetRequestId(), sender);
+        NS_LOG_LOGIC("Not flooding duplicate RREQ " << header.GetRequestId() << " from " << origin);
+        DropControl(packet, type);
+        return;
+    }
+    SendPacketFromQueue(origin);
+
+    // Check if we are the destination
+    if (IsMyOwnAddress(dst))
+    {
+        NS_LOG_DEBUG("We are the destination, sending RREP back to " << origin);
+        SendRouteReply(dst, origin, sender, header.GetSequenceNumber());
+        return;
+    }
+
+    // A fresh enough route of our own answers the request, unless it leads
+    // back through the node that asked
+    RouteEntry* rt = m_destinationOnly ? nullptr : FindLiveRoute(dst);
+    if (rt && rt->IsFresh(header.GetSequenceNumber()) && rt->nextHop != sender)
+    {
+        NS_LOG_DEBUG("Answering RREQ for " << dst << " from our route via " << rt->nextHop);
+        // Queued packets sent above may have moved the reverse route
+        SendReplyByIntermediateNode(*rt, *m_routeTable.Find(origin), sender);
+        return;
+    }
+
+    // A zone RREQ stops at the edge of its request zone; nodes that do not
+    // know where they are pass it on
+    Vector position;
+    Vector velocity;
+    if (type == RTMHR_ZONE_RREQ && GetLocalMotion(position, velocity) &&
+        !header.GetRequestZone().IsInside(position))
+    {
+        NS_LOG_LOGIC("RREQ " << header.GetRequestId() << " from " << origin
+                             << " outside its request zone");
+        DropControl(packet, type);
+        return;
+    }
+
+    // The ring ends where the TTL runs out; with no TTL tag the RREQ was
+    // network-wide
+    uint32_t ttl = m_netDiameter;
+    SocketIpTtlTag tag;
+    if (packet->PeekPacketTag(tag))
+    {
+        ttl = tag.GetTtl();
+    }
+    if (ttl < 2 || hops >= m_netDiameter)
+    {
+        NS_LOG_LOGIC("RREQ " << header.GetRequestId() << " from " << origin << " out of TTL");
+        DropControl(packet, type);
+        return;
+    }
+
+    NS_LOG_DEBUG("Forwarding RREQ for " << dst);
+    rtmhr::RtMhrHeader forward = header;
+    forward.SetHopCount(hops);
+    forward.SetDelay(header.GetDelay() + m_queuingDelay); // Accumulated along the path
+    // A path is as stable as its least stable link
+    forward.SetMobility(std::max(header.GetMobility(), PredictMobilityMetric(sender)));
+    FloodRouteRequest(forward, ttl - 1, sender);
+}
+
+void
+RtMhr::FloodRouteRequest(const rtmhr::RtMhrHeader& forward, uint32_t ttl, Ipv4Address sender)
+{
+    NS_LOG_FUNCTION(this << forward.GetOrigin() << forward.GetRequestId() << ttl << sender);
+
+    if (m_floodControl.GetMode() == RTMHR_FLOOD_PROBABILISTIC)
+    {
+        double probability = m_floodControl.GetProbability(GetRelativeDistance(sender));
+        if (m_uniformRandomVariable->GetValue(0, 1) >= probability)
+        {
+            NS_LOG_LOGIC("RREQ " << forward.GetRequestId() << " not rebroadcast, probability "
+                                 << probability);
+            return;
+        }
+    }
+    else if (m_floodControl.IsDeferred())
+    {
+        // Listen for copies from other neighbors before deciding
+        RtMhrFloodControl::Pending& pending =
+            m_floodControl.Add(forward.GetOrigin(), forward.GetRequestId());
+        if (m_floodControl.GetMode() == RTMHR_FLOOD_COVERAGE)
+        {
+            for (const auto& iter : m_neighborTable)
+            {
+                if (!iter.second.IsExpired() && !IsCoveredBy(iter.second, sender))
+                {
+                    pending.uncovered.push_back(iter.first);
+                }
+            }
+        }
+        double wait = m_uniformRandomVariable->GetValue(0, m_rreqAssessmentDelay.GetSeconds());
+        pending.event =
+            Simulator::Schedule(Seconds(wait), &RtMhr::RreqAssessmentExpire, this, forward, ttl);
+        return;
+    }
+    SendControl(forward, Ipv4Address("255.255.255.255"), ttl);
+}
+
+void
+RtMhr::RreqAssessmentExpire(rtmhr::RtMhrHeader forward, uint32_t ttl)
+{
+    NS_LOG_FUNCTION(this << forward.GetOrigin() << forward.GetRequestId());
+    if (m_floodControl.Release(forward.GetOrigin(), forward.GetRequestId()))
+    {
+        SendControl(forward, Ipv4Address("255.255.255.255"), ttl);
+    }
+}
+
+void
+RtMhr::NotifyRreqCopy(Ipv4Address origin, uint32_t id, Ipv4Address sender)
+{
+    RtMhrFloodControl::Pending* pending = m_floodControl.Find(origin, id);
+    if (!pending)
+    {
+        return;
+    }
+    pending->copies++;
+    auto& uncovered = pending->uncovered;
+    uncovered.erase(std::remove_if(uncovered.begin(),
+                                   uncovered.end(),
+                                   [this, sender](Ipv4Address addr) {
+                                       NeighborEntry* neighbor = m_neighborTable.Find(addr);
+                                       return !neighbor || IsCoveredBy(*neighbor, sender);
+                                   }),
+                    uncovered.end());
+}
+
+double
+RtMhr::GetRelativeDistance(Ipv4Address neighbor)
+{
+    // From the advertised positions if both ends have one; otherwise a weak
+    // link is taken as a long one. Strangers are assumed at the range edge
+    NeighborEntry* entry = m_neighborTable.Find(neighbor);
+    if (!entry)
+    {
+        return 1.0;
+    }
+    Vector position;
+    Vector velocity;
+    if (!entry->hasPosition || !GetLocalMotion(position, velocity))
+    {
+        return 1.0 - entry->linkQuality;
+    }
+    Vector there = RtMhrMobilityPredictor::Extrapolate(entry->position,
+                                                       entry->velocity,
+                                                       Simulator::Now() - entry->positionTime);
+    return CalculateDistance(position, there) / m_mobilityPredictor.GetRange();
+}
+
+bool
+RtMhr::IsCoveredBy(const NeighborEntry& neighbor, Ipv4Address sender)
+{
+    // A neighbor is known to have heard a copy if it sent it, or if both it
+    // and the sender advertised positions that put it within range
+    if (neighbor.address == sender)
+    {
+        return true;
+    }
+    NeighborEntry* from = m_neighborTable.Find(sender);
+    if (!from || !from->hasPosition || !neighbor.hasPosition)
+    {
+        return false;
+    }
+    Time now = Simulator::Now();
+    Vector a = RtMhrMobilityPredictor::Extrapolate(from->position,
+                                                   from->velocity,
+                                                   now - from->positionTime);
+    Vector b = RtMhrMobilityPredictor::Extrapolate(neighbor.position,
+                                                   neighbor.velocity,
+                                                   now - neighbor.positionTime);
+    return CalculateDistance(a, b) <= m_mobilityPredictor.GetRange();
+}
+
+void
+RtMhr::RecvRouteReply(Ptr<Packet> packet,
+                      const rtmhr::RtMhrHeader& header,
+                      Ipv4Address sender,
+                      uint32_t interface)
+{
+    Ipv4Address origin = header.GetOrigin();
+    Ipv4Address dst = header.GetDestination();
+    NS_LOG_FUNCTION(this << packet << sender << origin << dst);
+
+    uint8_t hops = header.GetHopCount() + 1;
+    RouteEntry& route =
+        UpdateRoute(dst, sender, interface, hops, header.GetDelay(), header.GetMobility());
+    uint32_t seqNo = header.GetSequenceNumber();
+    if (seqNo != 0 && !route.IsFresh(seqNo))
+    {
+        route.sequenceNumber = seqNo;
+    }
+    NS_LOG_DEBUG("Added route to " << dst << " via " << sender);
+    SendPacketFromQueue(dst);
+
+    if (IsMyOwnAddress(origin))
+    {
+        return;
+    }
+
+    // Relay towards the originator along the reverse route
+    RouteEntry* rt = FindLiveRoute(origin);
+    if (!rt)
+    {
+        NS_LOG_LOGIC("No reverse route to " << origin << ", dropping RREP");
+        DropControl(packet, RTMHR_RREP);
+        return;
+    }
+    // Each end of the path now routes through the other's next hop
+    Ipv4Address toOrigin = rt->nextHop;
+    rt->InsertPrecursor(sender);
+    m_routeTable.Find(dst)->InsertPrecursor(toOrigin);
+
+    rtmhr::RtMhrHeader forward = header;
+    forward.SetHopCount(hops);
+    forward.SetDelay(header.GetDelay() + m_queuingDelay); // Accumulated along the path
+    // A path is as stable as its least stable link
+    forward.SetMobility(std::max(header.GetMobility(), PredictMobilityMetric(sender)));
+    SendControl(forward, toOrigin);
+}
+
+void
+RtMhr::RecvRouteError(Ptr<Packet> packet,
+                      const rtmhr::RtMhrHeader& header,
+                      Ipv4Address sender,
+                      uint32_t interface)
+{
+    Ipv4Address dst = header.GetDestination();
+    NS_LOG_FUNCTION(this << packet << sender << dst);
+
+    // Only the neighbors we route through can break our paths; a broken
+    // primary is replaced by the best backup if there is one
+    RouteEntry* rt = m_routeTable.Find(dst);
+    if (!rt || !rt->HasNextHop(sender))
+    {
+        return;
+    }
+    NS_LOG_DEBUG("Route to " << dst << " via " << sender << " reported broken");
+    bool primary = rt->nextHop == sender;
+    if (rt->Failover(sender))
+    {
+        if (primary)
+        {
+            m_routeFailoverTrace(dst, sender, rt->nextHop);
+        }
+        return;
+    }
+
+    // No path is left, so the neighbors that route through us have none either
+    SendRouteError(dst, header.GetOrigin());
+}
+
+RouteEntry&
+RtMhr::UpdateRoute(Ipv4Address dst,
+                   Ipv4Address nextHop,
+                   uint32_t interface,
+                   uint32_t hopCount,
+                   double delay,
+                   double mobility)
+{
+    // The path is rated by its length and delay, by the link to its first hop
+    // and by its least stable link, which also bounds how long it is kept
+    Time now = Simulator::Now();
+    RoutePath path{nextHop,
+                   interface,
+                   hopCount,
+                   now + m_routeTimeout,
+                   CrossLayerMetric(),
+                   Time::Max(),
+                   mobility};
+    path.metric.hopCount = hopCount;
+    path.metric.queuingDelay = delay;
+    path.metric.linkQuality = 1.0;
+    path.metric.mobilityMetric = mobility;
+    NeighborEntry* neighbor = m_neighborTable.Find(nextHop);
+    if (neighbor)
+    {
+        path.metric.linkQuality = neighbor->linkQuality;
+        path.metric.mobilityMetric = std::max(mobility, PredictMobilityMetric(nextHop));
+    }
+    Time let = RtMhrMobilityPredictor::FromMobilityMetric(path.metric.mobilityMetric);
+    if (let < m_routeTimeout)
+    {
+        path.breakTime = now + let;
+        path.validTime = path.breakTime;
+    }
+
+    // Refresh in place so an unchanged next hop keeps its cached route
+    m_routeIndex.Add(nextHop, dst);
+    RouteEntry* rt = m_routeTable.Find(dst);
+    if (!rt)
+    {
+        // The expiry wheel takes the entry's lifetime when it is added
+        m_metricEngine.GetScore(path.metric);
+        RouteEntry entry(dst, path.validTime);
+        entry.SetPrimary(path);
+        return AddRoute(entry);
+    }
+    rt->OfferPath(path, m_metricEngine, 1 + m_maxBackupPaths);
+    return *rt;
+}
+
+RouteEntry*
+RtMhr::FindLiveRoute(Ipv4Address dst)
+{
+    RouteEntry* rt = m_routeTable.Find(dst);
+    if (!rt)
+    {
+        return nullptr;
+    }
+
+    // A primary that expired, or whose neighbor timed out before the next purge,
+    // is replaced right here by the best backup, without route discovery
+    for (;;)
+    {
+        NeighborEntry* neighbor = m_neighborTable.Find(rt->nextHop);
+        if (!rt->IsExpired() && !(neighbor && neighbor->IsExpired()))
+        {
+            return rt;
+        }
+        Ipv4Address failed = rt->nextHop;
+        if (!rt->Failover(failed))
+        {
+            return nullptr;
+        }
+        NS_LOG_DEBUG("Route to " << dst << " failed over from " << failed << " to "
+                                 << rt->nextHop);
+        m_routeFailoverTrace(dst, failed, rt->nextHop);
+    }
+}
+
+void
+RtMhr::RefreshActiveRoute(RouteEntry& rt, bool source)
+{
+    // Traffic keeps a route alive, though never past its predicted break
+    Time now = Simulator::Now();
+    rt.lastUsed = now;
+    rt.validTime = std::max(rt.validTime, std::min(now + m_activeRouteTimeout, rt.breakTime));
+
+    // Sources look for a replacement while the route still works, so the flow
+    // never waits for a discovery; at most once per ActiveRouteTimeout
+    if (!source || now < rt.nextRefresh)
+    {
+        return;
+    }
+    NeighborEntry* neighbor = m_neighborTable.Find(rt.nextHop);
+    bool expiring = rt.validTime - now < m_routeRefreshLead;
+    bool weak = neighbor && neighbor->linkQuality < m_refreshLinkQuality;
+    if (expiring || weak)
+    {
+        NS_LOG_DEBUG("Refreshing route to " << rt.destination << (expiring ? ", expiring" : "")
+                                            << (weak ? ", weak first link" : ""));
+        rt.nextRefresh = now + m_activeRouteTimeout;
+        SendRouteRequest(rt.destination);
+    }
+}
+
+void
+RtMhr::HandleLinkFailure(Ipv4Address neighbor)
+{
+    NS_LOG_FUNCTION(this << neighbor);
+
+    // Backups through the neighbor are dropped; live primaries through it are
+    // broken. No path through it is left, so the index forgets every route.
+    std::vector<Ipv4Address> broken;
+    m_routeIndex.Visit(neighbor, [this, neighbor, &broken](Ipv4Address dst) {
+        RouteEntry* rt = m_routeTable.Find(dst);
+        if (rt && rt->nextHop == neighbor && !rt->IsExpired())
+        {
+            broken.push_back(dst);
+        }
+        else if (rt)
+        {
+            rt->Failover(neighbor);
+        }
+        return false;
+    });
+
+    for (const auto& dst : broken)
+    {
+        RouteEntry* rt = m_routeTable.Find(dst);
+        if (rt->Failover(neighbor))
+        {
+            NS_LOG_DEBUG("Route to " << dst << " failed over from " << neighbor << " to "
+                                     << rt->nextHop);
+            m_routeFailoverTrace(dst, neighbor, rt->nextHop);
+        }
+        else if (m_fastLocalRepair)
+        {
+            PerformFastLocalRepair(dst, neighbor);
+        }
+        else
+        {
+            SendRouteError(dst, neighbor);
+        }
+    }
+}
+
+uint32_t
+RtMhr::RerankRoutesVia(Ipv4Address hop)
+{
+    NS_LOG_FUNCTION(this << hop);
+    NeighborEntry* neighbor = m_neighborTable.Find(hop);
+    if (!neighbor)
+    {
+        return 0;
+    }
+    neighbor->lastReranked = Simulator::Now();
+
+    // Paths copy the first link's terms when learned; bring those through the
+    // neighbor up to date and let them move within their route's ranking
+    double quality = neighbor->linkQuality;
+    double mobility = neighbor->metric.mobilityMetric;
+    return m_routeIndex.Visit(hop, [this, hop, quality, mobility](Ipv4Address dst) {
+        RouteEntry* rt = m_routeTable.Find(dst);
+        if (!rt || !rt->HasNextHop(hop))
+        {
+            return false;
+        }
+        m_stats.reranks++;
+        Ipv4Address previous = rt->nextHop;
+        if (rt->Reprice(hop, quality, mobility, m_metricEngine))
+        {
+            NS_LOG_DEBUG("Route to " << dst << " re-ranked from " << previous << " to "
+                                     << rt->nextHop);
+            m_stats.rankChanges++;
+        }
+        return true;
+    });
+}
+
+void
+RtMhr::UpdateRouteToNeighbor(Ipv4Address sender, uint32_t interface)
+{
+    NS_LOG_FUNCTION(this << sender << interface);
+
+    NeighborEntry* neighbor = m_neighborTable.Find(sender);
+    if (!neighbor)
+    {
+        NeighborEntry entry(sender, Simulator::Now() + GetNeighborLifetime());
+        neighbor = &AddNeighbor(entry);
+        m_helloScheduler.NotifyChurn();
+        m_probeScheduler.NotifyChurn();
+    }
+    neighbor->interface = interface;
+    neighbor->lastSeen = Simulator::Now();
+    neighbor->validTime = Simulator::Now() + GetNeighborLifetime();
+    if (neighbor->hardwareAddress == Mac48Address())
+    {
+        LearnHardwareAddress(*neighbor);
+    }
+
+    UpdateRoute(sender, sender, interface, 1);
+    SendPacketFromQueue(sender);
+}
+
+NeighborEntry&
+RtMhr::AddNeighbor(const NeighborEntry& entry)
+{
+    // Only new neighbors enter the expiry wheel; refreshed ones are rescheduled when it fires
+    bool known = m_neighborTable.Find(entry.address) != nullptr;
+    NeighborEntry& stored = m_neighborTable.Insert(entry.address, entry);
+    if (!known)
+    {
+        m_neighborExpiry.Schedule(entry.address, entry.validTime);
+    }
+    return stored;
+}
+
+RouteEntry&
+RtMhr::AddRoute(const RouteEntry& entry)
+{
+    bool known = m_routeTable.Find(entry.destination) != nullptr;
+    RouteEntry& stored = m_routeTable.Insert(entry.destination, entry);
+    if (entry.nextHop != Ipv4Address())
+    {
+        m_routeIndex.Add(entry.nextHop, entry.destination);
+    }
+    if (!known)
+    {
+        m_routeExpiry.Schedule(entry.destination, entry.validTime);
+        m_routeTableSize = m_routeTable.GetSize();
+    }
+    return stored;
+}
+
+void
+RtMhr::PurgeNeighborTable()
+{
+    NS_LOG_FUNCTION(this);
+
+    std::vector<Ipv4Address> lost;
+    m_neighborExpiry.Advance(Simulator::Now(), [this, &lost](Ipv4Address addr) {
+        NeighborEntry* neighbor = m_neighborTable.Find(addr);
+        if (!neighbor)
+        {
+            return;
+        }
+        if (!neighbor->IsExpired())
+        {
+            m_neighborExpiry.Schedule(addr, neighbor->validTime);
+            return;
+        }
+        NS_LOG_DEBUG("Neighbor " << addr << " expired");
+        m_neighborTable.Erase(addr);
+        lost.push_back(addr);
+    });
+
+    for (const auto& addr : lost)
+    {
+        m_helloScheduler.NotifyChurn();
+        m_probeScheduler.NotifyChurn();
+        HandleLinkFailure(addr);
+    }
+}
+
+void
+RtMhr::PurgeRouteTable()
+{
+    NS_LOG_FUNCTION(this);
+    m_routeExpiry.Advance(Simulator::Now(), [this](Ipv4Address dst) {
+        RouteEntry* rt = m_routeTable.Find(dst);
+        if (!rt)
+        {
+            return;
+        }
+        if (!rt->IsExpired() || rt->Failover(rt->nextHop))
+        {
+            // Still valid, possibly through a backup path that outlived the primary
+            m_routeExpiry.Schedule(dst, rt->validTime);
+            return;
+        }
+        NS_LOG_DEBUG("Route to " << dst << " expired");
+        // No path is left either, so its neighbors need not visit it again
+        m_routeIndex.Remove(rt->nextHop, dst);
+        for (const auto& path : rt->backupPaths)
+        {
+            m_routeIndex.Remove(path.nextHop, dst);
+        }
+        m_routeTable.Erase(dst);
+        m_routeTableSize = m_routeTable.GetSize();
+    });
+}
+
+void
+RtMhr::PerformFastLocalRepair(Ipv4Address destination, Ipv4Address failedNextHop)
+{
+    NS_LOG_FUNCTION(this << destination << failedNextHop);
+
+    // Stop using the broken next hop and search for a new path from here
+    // instead of reporting the loss upstream
+    RouteEntry* rt = m_routeTable.Find(destination);
+    if (rt)
+    {
+        rt->SetExpired();
+    }
+    if (m_repairs
+            .insert(std::make_pair(destination, std::make_pair(Simulator::Now(), failedNextHop)))
+            .second)
+    {
+        m_stats.repairs++;
+    }
+    SendRouteRequest(destination);
+}
+
+void
+RtMhr::EndDiscovery(Ipv4Address dst, bool found)
+{
+    Time now = Simulator::Now();
+    auto discovery = m_discoveryStart.find(dst);
+    if (discovery != m_discoveryStart.end())
+    {
+        Time latency = now - discovery->second;
+        if (found)
+        {
+            m_stats.discoveryLatency.Add(latency);
+        }
+        else
+        {
+            m_stats.discoveryFailures++;
+        }
+        m_routeDiscoveryTrace(dst, latency, found);
+        m_discoveryStart.erase(discovery);
+    }
+    auto repair = m_repairs.find(dst);
+    if (repair != m_repairs.end())
+    {
+        Time latency = now - repair->second.first;
+        Ipv4Address failed = repair->second.second;
+        m_repairs.erase(repair);
+        m_localRepairTrace(dst, latency, found);
+        if (found)
+        {
+            m_stats.repairLatency.Add(latency);
+            return;
+        }
+        // The repair was tried instead of telling the precursors; now they must know
+        m_stats.repairFailures++;
+        SendRouteError(dst, failed);
+    }
+}
+
+void
+RtMhr::SendRouteError(Ipv4Address destination, Ipv4Address unreachable)
+{
+    NS_LOG_FUNCTION(this << destination << unreachable);
+
+    // Only the neighbors that route through us need to hear of it, once: one
+    // is told directly, several share a broadcast
+    RouteEntry* rt = m_routeTable.Find(destination);
+    std::vector<Ipv4Address> precursors;
+    if (rt)
+    {
+        for (const auto& hop : rt->precursors)
+        {
+            const NeighborEntry* neighbor = m_neighborTable.Find(hop);
+            if (neighbor && !neighbor->IsExpired())
+            {
+                precursors.push_back(hop);
+            }
+        }
+        rt->precursors.clear();
+    }
+    if (precursors.empty())
+    {
+        NS_LOG_LOGIC("No precursors to tell of " << destination);
+        return;
+    }
+
+    rtmhr::RtMhrHeader header(RTMHR_RERR, 0, 0, destination, unreachable);
+    header.SetSequenceNumber(m_sequenceNumber);
+    Ipv4Address to = precursors.size() == 1 ? precursors.front() : Ipv4Address("255.255.255.255");
+    SendControl(header, to);
+
+    NS_LOG_DEBUG("Sent RERR for " << destination << " via " << unreachable << " to " << to);
+}
+
+Ptr<Socket>
+RtMhr::FindSocketWithInterfaceAddress(Ipv4InterfaceAddress iface) const
+{
+    NS_LOG_FUNCTION(this << iface);
+    for (const auto& i : m_socketAddresses)
+    {
+        if (i.second == iface)
+        {
+            return i.first;
+        }
+    }
+    return nullptr;
+}
+
+Ptr<Socket>
+RtMhr::GetSocketForInterface(uint32_t interface) const
+{
+    return interface < m_interfaceSockets.size() ? m_interfaceSockets[interface] : nullptr;
+}
+
+uint32_t
+RtMhr::GetInterfaceForNeighbor(Ipv4Address addr)
+{
+    // A neighbor is reached on the interface it was heard on; anything else
+    // on the interface of the route to it. 0, the loopback, if unknown
+    NeighborEntry* neighbor = m_neighborTable.Find(addr);
+    if (neighbor)
+    {
+        return neighbor->interface;
+    }
+    RouteEntry* rt = m_routeTable.Find(addr);
+    return rt ? rt->interface : 0;
+}
+
+void
+RtMhr::ProbeTimerExpire()
+{
+    NS_LOG_FUNCTION(this);
+
+    // Links that carried traffic were measured by the MAC reports; only idle
+    // ones need an active probe
+    Time idle = Simulator::Now() - m_probeScheduler.GetInterval();
+    std::vector<Ipv4Address> probe;
+    for (const auto& iter : m_neighborTable)
+    {
+        const NeighborEntry& neighbor = iter.second;
+        if (!neighbor.IsExpired() && neighbor.lastFeedback < idle)
+        {
+            probe.push_back(neighbor.address);
+        }
+    }
+    for (const auto& addr : probe)
+    {
+        SendProbe(addr);
+    }
+    m_probeTimer.Schedule(Jitter(m_probeScheduler.Update(GetNeighborhoodMobility())));
+}
+
+void
+RtMhr::PurgeTimerExpire()
+{
+    NS_LOG_FUNCTION(this);
+    m_rreqIdCache.Purge();
+    m_queue.Purge();
+    m_locationTable.Purge();
+    // Flows idle for an ActiveRouteTimeout are admitted afresh
+    Time idle = Simulator::Now() - m_activeRouteTimeout;
+    for (auto iter = m_realTimeFlows.begin(); iter != m_realTimeFlows.end();)
+    {
+        if (iter->second < idle)
+        {
+            iter = m_realTimeFlows.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+    PurgeNeighborTable();
+    PurgeRouteTable();
+
+    m_purgeTimer.Schedule(m_purgeInterval);
+}
+
+void
+RtMhr::HelloTimerExpire()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_helloScheduler.IsSuppressed() || (UseMetricDigests() && AreNeighborsAdvertised()))
+    {
+        NS_LOG_LOGIC("HELLO suppressed, neighbors are up to date");
+    }
+    else
+    {
+        SendHello();
+    }
+    m_helloTimer.Schedule(Jitter(m_helloScheduler.Update(GetNeighborhoodMobility())));
+}
+
+Time
+RtMhr::GetNeighborLifetime() const
+{
+    // A neighbor stays until it misses AllowedHelloLoss of its longest HELLO intervals
+    return std::max(m_neighborTimeout, m_maxHelloInterval * m_allowedHelloLoss);
+}
+
+double
+RtMhr::GetLocalSpeed() const
+{
+    Vector position;
+    Vector v;
+    GetLocalMotion(position, v);
+    return std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+}
+
+bool
+RtMhr::GetLocalMotion(Vector& position, Vector& velocity) const
+{
+    Ptr<MobilityModel> mobility = m_ipv4 ? m_ipv4->GetObject<MobilityModel>() : nullptr;
+    if (!mobility)
+    {
+        position = Vector();
+        velocity = Vector();
+        return false;
+    }
+    position = mobility->GetPosition();
+    velocity = mobility->GetVelocity();
+    return true;
+}
+
+double
+RtMhr::GetNeighborhoodMobility() const
+{
+    // Links change as fast as the fastest of their two ends moves; a neighbor
+    // that timed out before the next purge has no link left to change
+    double mobility = GetLocalSpeed();
+    for (const auto& iter : m_neighborTable)
+    {
+        if (iter.second.IsExpired())
+        {
+            continue;
+        }
+        const Vector& v = iter.second.velocity;
+        mobility = std::max(mobility, std::sqrt(v.x * v.x + v.y * v.y));
+    }
+    return mobility;
+}
+
+void
+RtMhr::UpdateMobilityInfo(Ipv4Address neighbor, Vector position, Vector velocity)
+{
+    NeighborEntry* entry = m_neighborTable.Find(neighbor);
+    if (!entry)
+    {
+        return;
+    }
+    entry->position = position;
+    entry->velocity = velocity;
+    entry->positionTime = Simulator::Now();
+    entry->hasPosition = true;
+    entry->metric.mobilityMetric = PredictMobilityMetric(neighbor);
+    entry->metric.Invalidate();
+    m_locationTable.Update(neighbor, position, velocity, entry->positionTime);
+}
+
+double
+RtMhr::PredictMobilityMetric(Ipv4Address neighbor)
+{
+    // Without both ends' motion nothing can be predicted, and the link is taken as stable
+    NeighborEntry* entry = m_neighborTable.Find(neighbor);
+    Vector position;
+    Vector velocity;
+    if (!entry || !entry->hasPosition || !GetLocalMotion(position, velocity))
+    {
+        return 0.0;
+    }
+
+    Vector there = RtMhrMobilityPredictor::Extrapolate(entry->position,
+                                                       entry->velocity,
+                                                       Simulator::Now() - entry->positionTime);
+    Time let =
+        m_mobilityPredictor.GetLinkExpirationTime(position, velocity, there, entry->velocity);
+    entry->linkExpiry = let == Time::Max() ? Time::Max() : Simulator::Now() + let;
+    NS_LOG_LOGIC("Link to " << neighbor << " predicted to last " << let.As(Time::S));
+    return RtMhrMobilityPredictor::ToMobilityMetric(let);
+}
+
+bool
+RtMhr::AreNeighborsAdvertised() const
+{
+    // With no neighbors a HELLO is the only way to find one
+    Time since = Simulator::Now() - m_helloScheduler.GetInterval();
+    uint32_t live = 0;
+    for (const auto& iter : m_neighborTable)
+    {
+        const NeighborEntry& neighbor = iter.second;
+        if (neighbor.IsExpired())
+        {
+            continue;
+        }
+        if (neighbor.lastAdvertised < since)
+        {
+            return false;
+        }
+        live++;
+    }
+    return live > 0;
+}
+
+bool
+RtMhr::PeekShim(Ptr<const Packet> packet, const Ipv4Header& header, rtmhr::RtMhrShim& shim)
+{
+    // A fragment's payload may end like a shim, so only whole datagrams have one
+    return header.IsLastFragment() && header.GetFragmentOffset() == 0 &&
+           rtmhr::RtMhrShim::Peek(packet, shim);
+}
+
+void
+RtMhr::StampShim(Ptr<Packet> packet,
+                 rtmhr::RtMhrShim shim,
+                 Ipv4Address self,
+                 Ipv4Address nextHop,
+                 uint32_t mtu)
+{
+    // Never pass the previous hop's digest on: it names a node two hops away
+    shim.RemoveDigest();
+    if (UseMetricDigests())
+    {
+        // Our delivery ratio towards the receiver is the best guess it has for its
+        // own direction until the MAC reports on frames it sends to us
+        double quality = 0.0;
+        NeighborEntry* neighbor = m_neighborTable.Find(nextHop);
+        if (neighbor)
+        {
+            if (!neighbor->lastFeedback.IsZero())
+            {
+                quality = neighbor->linkQuality;
+            }
+            neighbor->lastAdvertised = Simulator::Now();
+        }
+
+        Vector position;
+        Vector velocity;
+        GetLocalMotion(position, velocity);
+        shim.SetDigest(self, quality, m_queuingDelay, position, velocity);
+    }
+
+    // A shim that does not fit would get the packet fragmented, and then no
+    // hop could find it
+    uint32_t size = shim.GetSerializedSize();
+    if (shim.IsEmpty() || Node::ChecksumEnabled() || packet->GetSize() + size > mtu)
+    {
+        return;
+    }
+    packet->AddTrailer(shim);
+    m_stats.CountShim(size);
+}
+
+Ptr<const Packet>
+RtMhr::StampForwarded(Ptr<const Packet> packet, Ptr<Ipv4Route> route, Ipv4Header& header)
+{
+    rtmhr::RtMhrShim shim;
+    bool shimmed = PeekShim(packet, header, shim);
+    if (!shimmed && (!UseMetricDigests() || !header.IsLastFragment() ||
+                     header.GetFragmentOffset() != 0))
+    {
+        return packet;
+    }
+
+    // IpForward() takes the datagram length from the header as it is
+    Ptr<Packet> copy = packet->Copy();
+    if (shimmed)
+    {
+        copy->RemoveTrailer(shim);
+    }
+    StampShim(copy,
+              shim,
+              route->GetSource(),
+              route->GetGateway(),
+              route->GetOutputDevice()->GetMtu() - header.GetSerializedSize());
+    header.SetPayloadSize(copy->GetSize());
+    return copy;
+}
+
+void
+RtMhr::RecvMetricDigest(const rtmhr::RtMhrShim& shim, uint32_t interface)
+{
+    Ipv4Address sender = shim.GetSender();
+    if (IsMyOwnAddress(sender))
+    {
+        return;
+    }
+    NS_LOG_FUNCTION(this << sender << interface);
+
+    NeighborEntry* neighbor = m_neighborTable.Find(sender);
+    if (!neighbor)
+    {
+        UpdateRouteToNeighbor(sender, interface);
+        neighbor = m_neighborTable.Find(sender);
+    }
+    else
+    {
+        // Cheaper than UpdateRouteToNeighbor on every data packet; the one-hop
+        // route is kept as long as the neighbor since its HELLOs may be skipped
+        neighbor->interface = interface;
+        neighbor->lastSeen = Simulator::Now();
+        neighbor->validTime = Simulator::Now() + GetNeighborLifetime();
+        RouteEntry* rt = m_routeTable.Find(sender);
+        if (rt && rt->nextHop == sender)
+        {
+            rt->validTime = std::max(rt->validTime, neighbor->validTime);
+        }
+    }
+
+    neighbor->metric.queuingDelay = shim.GetDelay();
+    if (neighbor->lastFeedback.IsZero() && shim.GetLinkQuality() > 0)
+    {
+        neighbor->linkQuality = shim.GetLinkQuality();
+        neighbor->metric.linkQuality = neighbor->linkQuality;
+    }
+    neighbor->metric.Invalidate();
+    UpdateMobilityInfo(sender, shim.GetPosition(), shim.GetVelocity());
+
+    // Digests stand in for the HELLOs they suppress, at the HELLO rate
+    if (Simulator::Now() - neighbor->lastReranked >= m_helloInterval)
+    {
+        RerankRoutesVia(sender);
+    }
+}
+
+Time
+RtMhr::Jitter(Time interval)
+{
+    // Desynchronize neighbors that started together
+    return Seconds(interval.GetSeconds() * m_uniformRandomVariable->GetValue(0.75, 1.0));
 }
 
 Ipv4Address
@@ -0,0 +1,107 @@
+#include "rtmhr-location.h"
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("RtMhrLocation");
+
+RtMhrLocationTable::RtMhrLocationTable()
+    : m_lifetime(Seconds(30))
+{
+}
+
+void
+RtMhrLocationTable::Update(Ipv4Address node,
+                           const Vector& position,
+                           const Vector& velocity,
+                           Time when)
+{
+    NS_LOG_FUNCTION(this << node << position << velocity << when);
+    auto iter = m_locations.find(node);
+    if (iter == m_locations.end())
+    {
+        m_locations.emplace(node, Location{position, velocity, when, false});
+        return;
+    }
+    // Copies of a RREQ may be overtaken by fresher news
+    if (!iter->second.fixed && when >= iter->second.time)
+    {
+        iter->second = Location{position, velocity, when, false};
+    }
+}
+
+void
+RtMhrLocationTable::SetFixed(Ipv4Address node, const Vector& position)
+{
+    NS_LOG_FUNCTION(this << node << position);
+    m_locations[node] = Location{position, Vector(), Time(0), true};
+}
+
+void
+RtMhrLocationTable::Remove(Ipv4Address node)
+{
+    m_locations.erase(node);
+}
+
+bool
+RtMhrLocationTable::Lookup(Ipv4Address node, Vector& center, double& radius) const
+{
+    auto iter = m_locations.find(node);
+    if (iter == m_locations.end())
+    {
+        return false;
+    }
+    const Location& location = iter->second;
+    center = location.position;
+    if (location.fixed)
+    {
+        radius = 0.0;
+        return true;
+    }
+    Time age = Simulator::Now() - location.time;
+    if (age > m_lifetime)
+    {
+        return false;
+    }
+    const Vector& v = location.velocity;
+    radius = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z) * age.GetSeconds();
+    return true;
+}
+
+void
+RtMhrLocationTable::Purge()
+{
+    Time oldest = Simulator::Now() - m_lifetime;
+    for (auto iter = m_locations.begin(); iter != m_locations.end();)
+    {
+        if (!iter->second.fixed && iter->second.time < oldest)
+        {
+            iter = m_locations.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+Rectangle
+RtMhrLocationTable::GetRequestZone(const Vector& source,
+                                   const Vector& center,
+                                   double radius,
+                                   double margin)
+{
+    double reach = radius + margin;
+    return Rectangle(std::min(source.x - margin, center.x - reach),
+                     std::max(source.x + margin, center.x + reach),
+                     std::min(source.y - margin, center.y - reach),
+                     std::max(source.y + margin, center.y + reach));
+}
+
+} // namespace ns3
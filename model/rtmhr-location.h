@@ -0,0 +1,129 @@
+#ifndef RTMHR_LOCATION_H
+#define RTMHR_LOCATION_H
+
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+#include "ns3/rectangle.h"
+#include "ns3/vector.h"
+
+#include <map>
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief Last known positions of nodes, for location-aided routing
+ *
+ * Positions come from HELLOs and metric digests of neighbors, from the
+ * originators of zone-limited RREQs and, for stationary nodes such as road-side
+ * units, from the configuration. A learned position is trusted for the
+ * lifetime; a configured one never expires and is never overwritten.
+ *
+ * Lookup() answers with the expected zone of Ko and Vaidya's LAR: a circle
+ * around the last known position whose radius is the distance the node could
+ * have covered since, at the speed it had then. GetRequestZone() turns it into
+ * the rectangular request zone of LAR scheme 1.
+ */
+class RtMhrLocationTable
+{
+  public:
+    /**
+     * \brief Constructor, with a 30 s lifetime
+     */
+    RtMhrLocationTable();
+
+    /**
+     * \brief Record a learned position
+     * \param node the node
+     * \param position its position
+     * \param velocity its velocity
+     * \param when when the position was sampled
+     */
+    void Update(Ipv4Address node, const Vector& position, const Vector& velocity, Time when);
+
+    /**
+     * \brief Record the position of a stationary node
+     * \param node the node
+     * \param position its position, kept until Remove()
+     */
+    void SetFixed(Ipv4Address node, const Vector& position);
+
+    /**
+     * \brief Forget a node
+     * \param node the node
+     */
+    void Remove(Ipv4Address node);
+
+    /**
+     * \brief Get the expected zone of a node
+     * \param node the node
+     * \param center set to its last known position
+     * \param radius set to the distance it may have moved since, in meters
+     * \return false if the position is unknown or older than the lifetime
+     */
+    bool Lookup(Ipv4Address node, Vector& center, double& radius) const;
+
+    /**
+     * \brief Drop learned positions older than the lifetime
+     */
+    void Purge();
+
+    /**
+     * \brief Get the number of known positions, stale ones included
+     * \return the number of nodes
+     */
+    uint32_t GetSize() const
+    {
+        return m_locations.size();
+    }
+
+    /**
+     * \brief Set how long a learned position is trusted
+     * \param lifetime the lifetime
+     */
+    void SetLifetime(Time lifetime)
+    {
+        m_lifetime = lifetime;
+    }
+
+    /**
+     * \brief Get how long a learned position is trusted
+     * \return the lifetime
+     */
+    Time GetLifetime() const
+    {
+        return m_lifetime;
+    }
+
+    /**
+     * \brief Get the LAR scheme 1 request zone
+     * \param source position of the RREQ originator
+     * \param center center of the destination's expected zone
+     * \param radius radius of the expected zone
+     * \param margin distance the zone is widened by on every side
+     * \return the smallest axis-aligned rectangle holding the source and the
+     *         expected zone, widened by the margin
+     */
+    static Rectangle GetRequestZone(const Vector& source,
+                                    const Vector& center,
+                                    double radius,
+                                    double margin);
+
+  private:
+    /// A known position
+    struct Location
+    {
+        Vector position; ///< Position when sampled
+        Vector velocity; ///< Velocity when sampled
+        Time time;       ///< Sampling time
+        bool fixed;      ///< Configured, never expires
+    };
+
+    std::map<Ipv4Address, Location> m_locations; ///< Positions by node
+    Time m_lifetime;                             ///< Lifetime of a learned position
+};
+
+} // namespace ns3
+
+#endif /* RTMHR_LOCATION_H */
@@ -0,0 +1,154 @@
+#ifndef RTMHR_MAC_CACHE_H
+#define RTMHR_MAC_CACHE_H
+
+#include "ns3/ipv4-address.h"
+#include "ns3/mac48-address.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief MAC to IPv4 address map of the neighbors, for MAC-layer feedback
+ *
+ * Transmit reports from the MAC only carry the receiver's MAC address. This is
+ * an open-addressing hash table with linear probing over the 48-bit address,
+ * grown to keep it at most half full, so a lookup is normally a single probe.
+ * Mappings are never removed: a neighbor keeps its addresses while away.
+ */
+class RtMhrMacCache
+{
+  public:
+    RtMhrMacCache()
+        : m_size(0)
+    {
+    }
+
+    /**
+     * \brief Record the IPv4 address of a MAC address
+     * \param mac the MAC address
+     * \param addr the IPv4 address
+     */
+    void Insert(Mac48Address mac, Ipv4Address addr)
+    {
+        if (2 * (m_size + 1) > m_slots.size())
+        {
+            Grow();
+        }
+        uint64_t key = Key(mac);
+        uint32_t i = Probe(key);
+        if (m_slots[i].key == 0)
+        {
+            m_slots[i].key = key;
+            m_size++;
+        }
+        m_slots[i].addr = addr;
+    }
+
+    /**
+     * \brief Look up the IPv4 address of a MAC address
+     * \param mac the MAC address
+     * \param [out] addr the IPv4 address
+     * \return false if the MAC address is unknown
+     */
+    bool Lookup(Mac48Address mac, Ipv4Address& addr) const
+    {
+        if (m_slots.empty())
+        {
+            return false;
+        }
+        const Slot& slot = m_slots[Probe(Key(mac))];
+        if (slot.key == 0)
+        {
+            return false;
+        }
+        addr = slot.addr;
+        return true;
+    }
+
+    /**
+     * \brief Get the number of mappings
+     * \return the number of MAC addresses known
+     */
+    uint32_t GetSize() const
+    {
+        return m_size;
+    }
+
+    /**
+     * \brief Forget every mapping
+     */
+    void Clear()
+    {
+        m_slots.clear();
+        m_size = 0;
+    }
+
+  private:
+    /// One hash table slot
+    struct Slot
+    {
+        uint64_t key;     ///< MAC address plus a marker bit, 0 when empty
+        Ipv4Address addr; ///< IPv4 address
+    };
+
+    /**
+     * \brief Pack a MAC address into a non-zero key
+     * \param mac the MAC address
+     * \return the key
+     */
+    static uint64_t Key(Mac48Address mac)
+    {
+        uint8_t buf[6];
+        mac.CopyTo(buf);
+        uint64_t key = 1ULL << 48;
+        for (uint32_t i = 0; i < 6; ++i)
+        {
+            key |= static_cast<uint64_t>(buf[i]) << (8 * i);
+        }
+        return key;
+    }
+
+    /**
+     * \brief Find the slot of a key, or the empty slot where it belongs
+     * \param key the key
+     * \return the slot index
+     */
+    uint32_t Probe(uint64_t key) const
+    {
+        uint32_t mask = m_slots.size() - 1;
+        // Fibonacci hashing spreads the vendor-shared high bytes and sequential low bytes
+        uint32_t i = ((key * 0x9E3779B97F4A7C15ULL) >> 40) & mask;
+        while (m_slots[i].key != 0 && m_slots[i].key != key)
+        {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    /**
+     * \brief Double the table and rehash every mapping
+     */
+    void Grow()
+    {
+        std::vector<Slot> old(std::max<size_t>(16, 2 * m_slots.size()), Slot{0, Ipv4Address()});
+        old.swap(m_slots);
+        for (const auto& slot : old)
+        {
+            if (slot.key != 0)
+            {
+                m_slots[Probe(slot.key)] = slot;
+            }
+        }
+    }
+
+    std::vector<Slot> m_slots; ///< Power-of-two sized slot array
+    uint32_t m_size;           ///< Occupied slots
+};
+
+} // namespace ns3
+
+#endif /* RTMHR_MAC_CACHE_H */
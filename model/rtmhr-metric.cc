@@ -0,0 +1,73 @@
+#include "rtmhr-metric.h"
+
+#include "ns3/log.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("RtMhrMetric");
+
+CrossLayerMetric::CrossLayerMetric()
+    : linkQuality(0.0),
+      queuingDelay(0.0),
+      mobilityMetric(0.0),
+      hopCount(0),
+      timestamp(0.0),
+      score(0.0),
+      epoch(0)
+{
+}
+
+double
+CrossLayerMetric::GetCompositeMetric() const
+{
+    static const RtMhrMetricEngine defaults;
+    return epoch != 0 ? score : defaults.Compute(*this);
+}
+
+RtMhrMetricEngine::RtMhrMetricEngine()
+    : m_epoch(0),
+      m_recomputed(0)
+{
+    const double weight[TERMS] = {0.3, 0.25, 0.25, 0.2};
+    std::copy(weight, weight + TERMS, m_weight);
+    SetWeight(LINK_QUALITY, weight[LINK_QUALITY]);
+}
+
+void
+RtMhrMetricEngine::SetWeight(Term term, double weight)
+{
+    NS_LOG_FUNCTION(this << term << weight);
+    m_weight[term] = std::max(weight, 0.0);
+
+    double sum = 0.0;
+    for (uint32_t t = 0; t < TERMS; ++t)
+    {
+        sum += m_weight[t];
+    }
+    for (uint32_t t = 0; t < TERMS; ++t)
+    {
+        m_normalized[t] = sum > 0.0 ? m_weight[t] / sum : 0.0;
+    }
+
+    // Epoch 0 marks a never scored metric
+    if (++m_epoch == 0)
+    {
+        m_epoch = 1;
+    }
+}
+
+double
+RtMhrMetricEngine::Compute(const CrossLayerMetric& metric) const
+{
+    double quality = std::min(std::max(metric.linkQuality, 0.0), 1.0);
+    double delay = 1.0 / (1.0 + std::max(metric.queuingDelay, 0.0) * (1.0 / DELAY_SCALE));
+    double mobility = 1.0 / (1.0 + std::max(metric.mobilityMetric, 0.0));
+    double hops = 1.0 / (1.0 + metric.hopCount);
+    return m_normalized[LINK_QUALITY] * quality + m_normalized[DELAY] * delay +
+           m_normalized[MOBILITY] * mobility + m_normalized[HOP_COUNT] * hops;
+}
+
+} // namespace ns3
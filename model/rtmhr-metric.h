@@ -0,0 +1,159 @@
+#ifndef RTMHR_METRIC_H
+#define RTMHR_METRIC_H
+
+#include <stdint.h>
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief Cross-layer Route Metric structure
+ *
+ * The composite score is cached here by RtMhrMetricEngine. Code that changes an
+ * input field of a metric that may already be scored must call Invalidate().
+ */
+struct CrossLayerMetric
+{
+    double linkQuality;    ///< Link quality (0-1)
+    double queuingDelay;   ///< Queuing delay in seconds
+    double mobilityMetric; ///< Mobility prediction metric
+    uint32_t hopCount;     ///< Number of hops
+    double timestamp;      ///< Last update timestamp
+    double score;          ///< Composite score cached by RtMhrMetricEngine
+    uint32_t epoch;        ///< Engine weight epoch of the score, 0 while stale
+
+    /**
+     * \brief Get the composite metric
+     * \return the score as last cached by RtMhrMetricEngine, or computed with
+     *         the default weights if the metric was never scored or is stale
+     */
+    double GetCompositeMetric() const;
+
+    /**
+     * \brief Mark the cached score stale after an input field changed
+     */
+    void Invalidate()
+    {
+        epoch = 0;
+    }
+
+    /**
+     * \brief Default constructor
+     */
+    CrossLayerMetric();
+};
+
+/**
+ * \ingroup rtmhr
+ * \brief Weighted composite scoring of cross-layer metrics
+ *
+ * Every input is mapped onto [0, 1], higher being better:
+ *
+ * - link quality as is
+ * - delay as 1 / (1 + delay / DELAY_SCALE)
+ * - mobility as 1 / (1 + mobility)
+ * - hop count as 1 / (1 + hops)
+ *
+ * and the score is their weighted mean, so it is in [0, 1] whatever the
+ * weights. Scores are cached in the metric together with the weight epoch they
+ * were computed under; changing a weight starts a new epoch, which makes every
+ * cached score stale at once. Comparing candidates is then a compare of cached
+ * scalars, and Refresh() recomputes the stale entries of a table in one pass.
+ */
+class RtMhrMetricEngine
+{
+  public:
+    /// Inputs of the composite score
+    enum Term
+    {
+        LINK_QUALITY = 0, ///< CrossLayerMetric::linkQuality
+        DELAY = 1,        ///< CrossLayerMetric::queuingDelay
+        MOBILITY = 2,     ///< CrossLayerMetric::mobilityMetric
+        HOP_COUNT = 3,    ///< CrossLayerMetric::hopCount
+        TERMS = 4         ///< Number of terms
+    };
+
+    /// Delay, in seconds, that halves the delay term
+    static constexpr double DELAY_SCALE = 0.01;
+
+    /**
+     * \brief Constructor, with weights 0.3, 0.25, 0.25 and 0.2
+     */
+    RtMhrMetricEngine();
+
+    /**
+     * \brief Set the weight of a term
+     * \param term the term
+     * \param weight its weight, negative values counting as 0
+     */
+    void SetWeight(Term term, double weight);
+
+    /**
+     * \brief Get the weight of a term
+     * \param term the term
+     * \return its weight
+     */
+    double GetWeight(Term term) const
+    {
+        return m_weight[term];
+    }
+
+    /**
+     * \brief Compute the composite score, ignoring the cache
+     * \param metric the metric
+     * \return the score in [0, 1]
+     */
+    double Compute(const CrossLayerMetric& metric) const;
+
+    /**
+     * \brief Get the composite score, recomputing it only if stale
+     * \param metric the metric, whose cache is updated
+     * \return the score in [0, 1]
+     */
+    double GetScore(CrossLayerMetric& metric) const
+    {
+        if (metric.epoch != m_epoch)
+        {
+            metric.score = Compute(metric);
+            metric.epoch = m_epoch;
+            m_recomputed++;
+        }
+        return metric.score;
+    }
+
+    /**
+     * \brief Recompute the stale scores of a table
+     * \param table a table whose entries have a CrossLayerMetric named metric
+     * \return the number of scores recomputed
+     */
+    template <typename Table>
+    uint32_t Refresh(Table& table) const
+    {
+        uint64_t before = m_recomputed;
+        for (auto& iter : table)
+        {
+            GetScore(iter.second.metric);
+        }
+        return m_recomputed - before;
+    }
+
+    /**
+     * \brief Get how many scores have been computed for the cache
+     * \return the number of cache misses so far
+     */
+    uint64_t GetRecomputed() const
+    {
+        return m_recomputed;
+    }
+
+  private:
+    double m_weight[TERMS];        ///< Configured weights
+    double m_normalized[TERMS];    ///< Weights divided by their sum
+    uint32_t m_epoch;              ///< Bumped whenever a weight changes, never 0
+    mutable uint64_t m_recomputed; ///< Cache misses
+};
+
+} // namespace ns3
+
+#endif /* RTMHR_METRIC_H */
@@ -0,0 +1,66 @@
+#include "rtmhr-mobility.h"
+
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("RtMhrMobilityPredictor");
+
+RtMhrMobilityPredictor::RtMhrMobilityPredictor()
+    : m_range(250.0)
+{
+}
+
+Time
+RtMhrMobilityPredictor::GetLinkExpirationTime(const Vector& p1,
+                                              const Vector& v1,
+                                              const Vector& p2,
+                                              const Vector& v2) const
+{
+    double a = v1.x - v2.x;
+    double b = p1.x - p2.x;
+    double c = v1.y - v2.y;
+    double d = p1.y - p2.y;
+
+    double speed2 = a * a + c * c;
+    if (speed2 < 1e-12)
+    {
+        // Same velocity: the distance never changes
+        return Time::Max();
+    }
+    double r2 = std::max(m_range * m_range, b * b + d * d);
+    double cross = a * d - b * c;
+    // Not negative while the ends are within r of each other, up to rounding
+    double discriminant = std::max(speed2 * r2 - cross * cross, 0.0);
+    double let = (-(a * b + c * d) + std::sqrt(discriminant)) / speed2;
+    NS_LOG_LOGIC("Relative speed " << std::sqrt(speed2) << " m/s, link expires in " << let
+                                   << " s");
+    return let > 0 ? Seconds(let) : Seconds(0);
+}
+
+double
+RtMhrMobilityPredictor::ToMobilityMetric(Time let)
+{
+    if (let == Time::Max())
+    {
+        return 0.0;
+    }
+    // Floor at 1 ms so a broken link still gets a finite metric
+    return LET_SCALE / std::max(let.GetSeconds(), 1e-3);
+}
+
+Time
+RtMhrMobilityPredictor::FromMobilityMetric(double mobility)
+{
+    if (mobility < 1e-6)
+    {
+        return Time::Max();
+    }
+    return Seconds(LET_SCALE / mobility);
+}
+
+} // namespace ns3
@@ -0,0 +1,104 @@
+#ifndef RTMHR_MOBILITY_H
+#define RTMHR_MOBILITY_H
+
+#include "ns3/nstime.h"
+#include "ns3/vector.h"
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief Link lifetime prediction from the positions and velocities of its ends
+ *
+ * Both ends are assumed to keep their velocity, in the plane, until the
+ * distance between them exceeds the transmission range. The time left is the
+ * closed-form link expiration time of Su, Lee and Gerla:
+ *
+ *     LET = (-(ab + cd) + sqrt((a^2 + c^2) r^2 - (ad - bc)^2)) / (a^2 + c^2)
+ *
+ * with (b, d) the relative position, (a, c) the relative velocity and r the
+ * range. Ends that hear each other are in range by definition, so ends found
+ * farther apart than the range, which is then set too short, are taken to be
+ * at its edge. It maps onto the mobility metric of CrossLayerMetric as
+ * LET_SCALE / LET, so a stable link scores 0 and a link about to break grows
+ * without bound.
+ */
+class RtMhrMobilityPredictor
+{
+  public:
+    /// Link expiration time, in seconds, that makes the mobility metric 1
+    static constexpr double LET_SCALE = 10.0;
+
+    /**
+     * \brief Constructor, with a 250 m range
+     */
+    RtMhrMobilityPredictor();
+
+    /**
+     * \brief Set the transmission range
+     * \param range distance in meters beyond which links break
+     */
+    void SetRange(double range)
+    {
+        m_range = range;
+    }
+
+    /**
+     * \brief Get the transmission range
+     * \return the range in meters
+     */
+    double GetRange() const
+    {
+        return m_range;
+    }
+
+    /**
+     * \brief Predict how long a link lasts
+     * \param p1 position of one end
+     * \param v1 velocity of that end
+     * \param p2 position of the other end
+     * \param v2 velocity of the other end
+     * \return the time left, Time::Max() if the ends keep their distance
+     */
+    Time GetLinkExpirationTime(const Vector& p1,
+                               const Vector& v1,
+                               const Vector& p2,
+                               const Vector& v2) const;
+
+    /**
+     * \brief Convert a link expiration time to a mobility metric
+     * \param let the link expiration time
+     * \return LET_SCALE / let in seconds, 0 for Time::Max()
+     */
+    static double ToMobilityMetric(Time let);
+
+    /**
+     * \brief Convert a mobility metric back to a link expiration time
+     * \param mobility the mobility metric
+     * \return the link expiration time, Time::Max() for (nearly) 0
+     */
+    static Time FromMobilityMetric(double mobility);
+
+    /**
+     * \brief Dead-reckon a position
+     * \param position position when sampled
+     * \param velocity velocity when sampled
+     * \param elapsed time since the sample
+     * \return the predicted position now
+     */
+    static Vector Extrapolate(const Vector& position, const Vector& velocity, Time elapsed)
+    {
+        double t = elapsed.GetSeconds();
+        return Vector(position.x + velocity.x * t,
+                      position.y + velocity.y * t,
+                      position.z + velocity.z * t);
+    }
+
+  private:
+    double m_range; ///< Transmission range in meters
+};
+
+} // namespace ns3
+
+#endif /* RTMHR_MOBILITY_H */
@@ -0,0 +1,512 @@
+#include "rtmhr-packet.h"
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("RtMhrPacket");
+
+namespace rtmhr
+{
+
+/// Delay resolution of the compact format, in seconds
+static const double DELAY_STEP = 1e-4;
+/// Mobility resolution of the compact format (8.8 fixed point)
+static const double MOBILITY_STEP = 1.0 / 256;
+/// Position resolution of the compact format, in meters
+static const double POSITION_STEP = 0.01;
+/// Velocity resolution of the compact format, in m/s
+static const double VELOCITY_STEP = 0.01;
+
+/**
+ * \brief Quantize a value in [0, 1] to 8 bits
+ * \param v the value, clamped to [0, 1]
+ * \return the fixed-point value
+ */
+static uint8_t
+QuantizeUnit(double v)
+{
+    return static_cast<uint8_t>(std::lround(std::min(std::max(v, 0.0), 1.0) * 255));
+}
+
+/**
+ * \brief Quantize a non-negative value to 16 bits, saturating at the top of the range
+ * \param v the value
+ * \param step the value of one unit
+ * \return the fixed-point value
+ */
+static uint16_t
+QuantizeSaturate(double v, double step)
+{
+    return static_cast<uint16_t>(std::lround(std::min(std::max(v / step, 0.0), 65535.0)));
+}
+
+/**
+ * \brief Quantize a signed value to 32 bits, saturating at both ends of the range
+ * \param v the value
+ * \param step the value of one unit
+ * \return the fixed-point value, two's complement
+ */
+static uint32_t
+QuantizeSigned32(double v, double step)
+{
+    double q = std::min(std::max(v / step, -2147483648.0), 2147483647.0);
+    return static_cast<uint32_t>(static_cast<int32_t>(std::lround(q)));
+}
+
+/**
+ * \brief Quantize a signed value to 16 bits, saturating at both ends of the range
+ * \param v the value
+ * \param step the value of one unit
+ * \return the fixed-point value, two's complement
+ */
+static uint16_t
+QuantizeSigned16(double v, double step)
+{
+    double q = std::min(std::max(v / step, -32768.0), 32767.0);
+    return static_cast<uint16_t>(static_cast<int16_t>(std::lround(q)));
+}
+
+RtMhrHeader::RtMhrHeader(MessageType type,
+                         uint8_t hopCount,
+                         uint32_t requestId,
+                         Ipv4Address dst,
+                         Ipv4Address origin,
+                         double linkQuality,
+                         double delay,
+                         double mobility)
+    : m_version(VERSION),
+      m_type(type),
+      m_hopCount(hopCount),
+      m_requestId(requestId),
+      m_dst(dst),
+      m_origin(origin),
+      m_linkQuality(linkQuality),
+      m_delay(delay),
+      m_mobility(mobility),
+      m_sequenceNumber(0),
+      m_position(),
+      m_velocity(),
+      m_zone(0, 0, 0, 0)
+{
+}
+
+TypeId
+RtMhrHeader::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::rtmhr::RtMhrHeader").SetParent<Header>().AddConstructor<RtMhrHeader>();
+    return tid;
+}
+
+TypeId
+RtMhrHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+void
+RtMhrHeader::Print(std::ostream& os) const
+{
+    os << "RtMhrHeader: version=" << (uint32_t)m_version << " type=" << m_type
+       << " hopCount=" << (uint32_t)m_hopCount << " requestId=" << m_requestId
+       << " dst=" << m_dst << " origin=" << m_origin;
+}
+
+uint32_t
+RtMhrHeader::GetFields(MessageType type)
+{
+    switch (type)
+    {
+    case RTMHR_HELLO:
+        return FIELD_METRICS | FIELD_POSITION;
+    case RTMHR_PROBE:
+        return FIELD_METRICS;
+    case RTMHR_RREQ:
+        return FIELD_HOP_COUNT | FIELD_REQUEST_ID | FIELD_DST | FIELD_ORIGIN | FIELD_METRICS;
+    case RTMHR_RREP:
+    case RTMHR_PREP:
+        return FIELD_HOP_COUNT | FIELD_DST | FIELD_ORIGIN | FIELD_METRICS;
+    case RTMHR_RERR:
+        return FIELD_DST | FIELD_ORIGIN;
+    case RTMHR_ZONE_RREQ:
+        return FIELD_HOP_COUNT | FIELD_REQUEST_ID | FIELD_DST | FIELD_ORIGIN | FIELD_METRICS |
+               FIELD_POSITION | FIELD_ZONE;
+    default:
+        return FIELD_HOP_COUNT | FIELD_REQUEST_ID | FIELD_DST | FIELD_ORIGIN | FIELD_METRICS;
+    }
+}
+
+uint32_t
+RtMhrHeader::GetSerializedSize() const
+{
+    if (m_version == 0)
+    {
+        return 1 + 1 + 4 + 4 + 4 + 8 + 8 + 8 + 4; // type + hopCount + requestId + dst + origin +
+                                                  // linkQuality + delay + mobility + seqNum
+    }
+
+    uint32_t fields = GetFields(m_type);
+    uint32_t size = 1 + 4; // version/type + seqNum
+    size += (fields & FIELD_HOP_COUNT) ? 1 : 0;
+    size += (fields & FIELD_REQUEST_ID) ? 4 : 0;
+    size += (fields & FIELD_DST) ? 4 : 0;
+    size += (fields & FIELD_ORIGIN) ? 4 : 0;
+    size += (fields & FIELD_METRICS) ? 1 + 2 + 2 : 0;
+    size += (fields & FIELD_POSITION) ? 4 + 4 + 2 + 2 : 0;
+    size += (fields & FIELD_ZONE) ? 4 * 4 : 0;
+    return size;
+}
+
+uint32_t
+RtMhrHeader::GetMessageSize(uint8_t first)
+{
+    uint8_t version = first >> 4;
+    if (version != 0 && version != VERSION)
+    {
+        return 0;
+    }
+    RtMhrHeader header(static_cast<MessageType>(version == 0 ? first : first & 0x0f));
+    header.SetVersion(version);
+    return header.GetSerializedSize();
+}
+
+void
+RtMhrHeader::Serialize(Buffer::Iterator start) const
+{
+    if (m_version == 0)
+    {
+        start.WriteU8(static_cast<uint8_t>(m_type));
+        start.WriteU8(m_hopCount);
+        start.WriteHtonU32(m_requestId);
+        start.WriteHtonU32(m_dst.Get());
+        start.WriteHtonU32(m_origin.Get());
+        start.WriteU64(static_cast<uint64_t>(m_linkQuality));
+        start.WriteU64(static_cast<uint64_t>(m_delay));
+        start.WriteU64(static_cast<uint64_t>(m_mobility));
+        start.WriteHtonU32(m_sequenceNumber);
+        return;
+    }
+
+    uint32_t fields = GetFields(m_type);
+    start.WriteU8((m_version << 4) | (static_cast<uint8_t>(m_type) & 0x0f));
+    if (fields & FIELD_HOP_COUNT)
+    {
+        start.WriteU8(m_hopCount);
+    }
+    if (fields & FIELD_REQUEST_ID)
+    {
+        start.WriteHtonU32(m_requestId);
+    }
+    if (fields & FIELD_DST)
+    {
+        start.WriteHtonU32(m_dst.Get());
+    }
+    if (fields & FIELD_ORIGIN)
+    {
+        start.WriteHtonU32(m_origin.Get());
+    }
+    if (fields & FIELD_METRICS)
+    {
+        start.WriteU8(QuantizeUnit(m_linkQuality));
+        start.WriteHtonU16(QuantizeSaturate(m_delay, DELAY_STEP));
+        start.WriteHtonU16(QuantizeSaturate(m_mobility, MOBILITY_STEP));
+    }
+    if (fields & FIELD_POSITION)
+    {
+        start.WriteHtonU32(QuantizeSigned32(m_position.x, POSITION_STEP));
+        start.WriteHtonU32(QuantizeSigned32(m_position.y, POSITION_STEP));
+        start.WriteHtonU16(QuantizeSigned16(m_velocity.x, VELOCITY_STEP));
+        start.WriteHtonU16(QuantizeSigned16(m_velocity.y, VELOCITY_STEP));
+    }
+    if (fields & FIELD_ZONE)
+    {
+        start.WriteHtonU32(QuantizeSigned32(m_zone.xMin, POSITION_STEP));
+        start.WriteHtonU32(QuantizeSigned32(m_zone.xMax, POSITION_STEP));
+        start.WriteHtonU32(QuantizeSigned32(m_zone.yMin, POSITION_STEP));
+        start.WriteHtonU32(QuantizeSigned32(m_zone.yMax, POSITION_STEP));
+    }
+    start.WriteHtonU32(m_sequenceNumber);
+}
+
+uint32_t
+RtMhrHeader::Deserialize(Buffer::Iterator start)
+{
+    uint8_t first = start.ReadU8();
+    m_version = first >> 4;
+
+    if (m_version == 0)
+    {
+        // Legacy layout: the first byte is the bare message type
+        m_type = static_cast<MessageType>(first);
+        m_hopCount = start.ReadU8();
+        m_requestId = start.ReadNtohU32();
+        m_dst.Set(start.ReadNtohU32());
+        m_origin.Set(start.ReadNtohU32());
+        m_linkQuality = start.ReadU64();
+        m_delay = start.ReadU64();
+        m_mobility = start.ReadU64();
+        m_sequenceNumber = start.ReadNtohU32();
+        return GetSerializedSize();
+    }
+
+    if (m_version != VERSION)
+    {
+        // The layout of a later version is unknown, so nothing is read
+        NS_LOG_WARN("Unknown RT-MHR header version " << (uint32_t)m_version);
+        return 0;
+    }
+
+    m_type = static_cast<MessageType>(first & 0x0f);
+    uint32_t fields = GetFields(m_type);
+    m_hopCount = (fields & FIELD_HOP_COUNT) ? start.ReadU8() : 0;
+    m_requestId = (fields & FIELD_REQUEST_ID) ? start.ReadNtohU32() : 0;
+    m_dst = (fields & FIELD_DST) ? Ipv4Address(start.ReadNtohU32()) : Ipv4Address();
+    m_origin = (fields & FIELD_ORIGIN) ? Ipv4Address(start.ReadNtohU32()) : Ipv4Address();
+    if (fields & FIELD_METRICS)
+    {
+        m_linkQuality = start.ReadU8() / 255.0;
+        m_delay = start.ReadNtohU16() * DELAY_STEP;
+        m_mobility = start.ReadNtohU16() * MOBILITY_STEP;
+    }
+    else
+    {
+        m_linkQuality = 0.0;
+        m_delay = 0.0;
+        m_mobility = 0.0;
+    }
+    if (fields & FIELD_POSITION)
+    {
+        m_position.x = static_cast<int32_t>(start.ReadNtohU32()) * POSITION_STEP;
+        m_position.y = static_cast<int32_t>(start.ReadNtohU32()) * POSITION_STEP;
+        m_position.z = 0.0;
+        m_velocity.x = static_cast<int16_t>(start.ReadNtohU16()) * VELOCITY_STEP;
+        m_velocity.y = static_cast<int16_t>(start.ReadNtohU16()) * VELOCITY_STEP;
+        m_velocity.z = 0.0;
+    }
+    else
+    {
+        m_position = Vector();
+        m_velocity = Vector();
+    }
+    if (fields & FIELD_ZONE)
+    {
+        m_zone.xMin = static_cast<int32_t>(start.ReadNtohU32()) * POSITION_STEP;
+        m_zone.xMax = static_cast<int32_t>(start.ReadNtohU32()) * POSITION_STEP;
+        m_zone.yMin = static_cast<int32_t>(start.ReadNtohU32()) * POSITION_STEP;
+        m_zone.yMax = static_cast<int32_t>(start.ReadNtohU32()) * POSITION_STEP;
+    }
+    else
+    {
+        m_zone = Rectangle(0, 0, 0, 0);
+    }
+    m_sequenceNumber = start.ReadNtohU32();
+
+    return GetSerializedSize();
+}
+
+/// Last two bytes of every shim
+static const uint16_t SHIM_MAGIC = 0x524d;
+/// Sections flags and magic
+static const uint32_t SHIM_FOOTER_SIZE = 1 + 2;
+/// Sections this version knows
+static const uint8_t SHIM_SECTIONS =
+    RtMhrShim::DIGEST | RtMhrShim::DEADLINE | RtMhrShim::TARGET;
+
+/**
+ * \brief Get the size of a shim
+ * \param sections its sections
+ * \return its size in bytes
+ */
+static uint32_t
+GetShimSize(uint8_t sections)
+{
+    uint32_t size = SHIM_FOOTER_SIZE;
+    if (sections & RtMhrShim::DIGEST)
+    {
+        size += 4 + 1 + 2 + 4 + 4 + 2 + 2; // sender + linkQuality + delay + position + velocity
+    }
+    if (sections & RtMhrShim::DEADLINE)
+    {
+        size += 4;
+    }
+    if (sections & RtMhrShim::TARGET)
+    {
+        size += 4 + 4; // position
+    }
+    return size;
+}
+
+RtMhrShim::RtMhrShim()
+    : m_sections(0),
+      m_linkQuality(0.0),
+      m_delay(0.0),
+      m_deadline(0)
+{
+}
+
+TypeId
+RtMhrShim::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::rtmhr::RtMhrShim").SetParent<Trailer>().AddConstructor<RtMhrShim>();
+    return tid;
+}
+
+TypeId
+RtMhrShim::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+uint32_t
+RtMhrShim::GetSerializedSize() const
+{
+    return GetShimSize(m_sections);
+}
+
+void
+RtMhrShim::Serialize(Buffer::Iterator end) const
+{
+    Buffer::Iterator i = end;
+    i.Prev(GetSerializedSize());
+    if (m_sections & DIGEST)
+    {
+        i.WriteHtonU32(m_sender.Get());
+        i.WriteU8(QuantizeUnit(m_linkQuality));
+        i.WriteHtonU16(QuantizeSaturate(m_delay, DELAY_STEP));
+        i.WriteHtonU32(QuantizeSigned32(m_position.x, POSITION_STEP));
+        i.WriteHtonU32(QuantizeSigned32(m_position.y, POSITION_STEP));
+        i.WriteHtonU16(QuantizeSigned16(m_velocity.x, VELOCITY_STEP));
+        i.WriteHtonU16(QuantizeSigned16(m_velocity.y, VELOCITY_STEP));
+    }
+    if (m_sections & DEADLINE)
+    {
+        i.WriteHtonU32(m_deadline);
+    }
+    if (m_sections & TARGET)
+    {
+        i.WriteHtonU32(QuantizeSigned32(m_target.x, POSITION_STEP));
+        i.WriteHtonU32(QuantizeSigned32(m_target.y, POSITION_STEP));
+    }
+    i.WriteU8(m_sections);
+    i.WriteHtonU16(SHIM_MAGIC);
+}
+
+uint32_t
+RtMhrShim::Deserialize(Buffer::Iterator end)
+{
+    // Any payload may end the packet instead, so what does not read as a shim
+    // of this version is left alone
+    if (end.GetSize() < SHIM_FOOTER_SIZE)
+    {
+        return 0;
+    }
+    Buffer::Iterator i = end;
+    i.Prev(SHIM_FOOTER_SIZE);
+    uint8_t sections = i.ReadU8();
+    if (i.ReadNtohU16() != SHIM_MAGIC || (sections & ~SHIM_SECTIONS))
+    {
+        return 0;
+    }
+    uint32_t size = GetShimSize(sections);
+    if (end.GetSize() < size)
+    {
+        return 0;
+    }
+
+    i = end;
+    i.Prev(size);
+    m_sections = sections;
+    if (m_sections & DIGEST)
+    {
+        m_sender.Set(i.ReadNtohU32());
+        m_linkQuality = i.ReadU8() / 255.0;
+        m_delay = i.ReadNtohU16() * DELAY_STEP;
+        m_position.x = static_cast<int32_t>(i.ReadNtohU32()) * POSITION_STEP;
+        m_position.y = static_cast<int32_t>(i.ReadNtohU32()) * POSITION_STEP;
+        m_position.z = 0.0;
+        m_velocity.x = static_cast<int16_t>(i.ReadNtohU16()) * VELOCITY_STEP;
+        m_velocity.y = static_cast<int16_t>(i.ReadNtohU16()) * VELOCITY_STEP;
+        m_velocity.z = 0.0;
+    }
+    if (m_sections & DEADLINE)
+    {
+        m_deadline = i.ReadNtohU32();
+    }
+    if (m_sections & TARGET)
+    {
+        m_target.x = static_cast<int32_t>(i.ReadNtohU32()) * POSITION_STEP;
+        m_target.y = static_cast<int32_t>(i.ReadNtohU32()) * POSITION_STEP;
+        m_target.z = 0.0;
+    }
+    return size;
+}
+
+void
+RtMhrShim::Print(std::ostream& os) const
+{
+    os << "RtMhrShim:";
+    if (m_sections & DIGEST)
+    {
+        os << " sender=" << m_sender << " linkQuality=" << m_linkQuality << " delay=" << m_delay
+           << " position=" << m_position << " velocity=" << m_velocity;
+    }
+    if (m_sections & DEADLINE)
+    {
+        os << " deadline=" << GetDeadline();
+    }
+    if (m_sections & TARGET)
+    {
+        os << " target=" << m_target;
+    }
+}
+
+void
+RtMhrShim::SetDigest(Ipv4Address sender,
+                     double linkQuality,
+                     double delay,
+                     const Vector& position,
+                     const Vector& velocity)
+{
+    m_sections |= DIGEST;
+    m_sender = sender;
+    m_linkQuality = linkQuality;
+    m_delay = delay;
+    m_position = position;
+    m_velocity = velocity;
+}
+
+void
+RtMhrShim::SetDeadline(Time deadline)
+{
+    m_sections |= DEADLINE;
+    m_deadline = static_cast<uint32_t>(deadline.GetMicroSeconds());
+}
+
+Time
+RtMhrShim::GetDeadline() const
+{
+    // Deadlines are never half a wrap, 35 minutes, away
+    Time now = Simulator::Now();
+    uint32_t low = static_cast<uint32_t>(now.GetMicroSeconds());
+    int32_t ahead = static_cast<int32_t>(m_deadline - low);
+    Time offset = MicroSeconds(std::abs(static_cast<int64_t>(ahead)));
+    return ahead < 0 ? now - offset : now + offset;
+}
+
+bool
+RtMhrShim::Peek(Ptr<const Packet> packet, RtMhrShim& shim)
+{
+    // Packet::PeekTrailer() only reads, it just is not const
+    return ConstCast<Packet>(packet)->PeekTrailer(shim) != 0;
+}
+
+} // namespace rtmhr
+} // namespace ns3
@@ -0,0 +1,474 @@
+#ifndef RTMHR_PACKET_H
+#define RTMHR_PACKET_H
+
+#include "ns3/header.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/rectangle.h"
+#include "ns3/tag.h"
+#include "ns3/trailer.h"
+#include "ns3/vector.h"
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief RT-MHR Message Types
+ */
+enum MessageType
+{
+    RTMHR_RREQ = 1,     ///< Route Request
+    RTMHR_RREP = 2,     ///< Route Reply
+    RTMHR_RERR = 3,     ///< Route Error
+    RTMHR_HELLO = 4,    ///< Hello message for neighbor discovery
+    RTMHR_PROBE = 5,    ///< Link quality probe
+    RTMHR_PREP = 6,     ///< Path Repair message
+    RTMHR_ZONE_RREQ = 7 ///< Route Request rebroadcast only inside a request zone
+};
+
+namespace rtmhr
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief RT-MHR message header
+ *
+ * The first byte carries the format version in its high nibble and the message
+ * type in its low nibble. Version 1 is the compact format: each message type
+ * only carries the fields it uses, and metrics are fixed point:
+ *
+ * - link quality: 8 bits, 1/255 steps over [0, 1]
+ * - delay: 16 bits, 100 us steps up to 6.5535 s
+ * - mobility: 16 bits, 8.8 fixed point up to 255.996
+ * - position: 2 x 32 bits, signed centimeters in the plane (HELLO and zone RREQ)
+ * - velocity: 2 x 16 bits, signed cm/s up to 327.67 m/s (HELLO and zone RREQ)
+ * - request zone: 4 x 32 bits, signed centimeters, x then y bounds (zone RREQ only)
+ *
+ * A zone RREQ is a RREQ that also carries its originator's position and
+ * velocity, which stay unchanged as it is rebroadcast.
+ *
+ * Version 0 is the original fixed 42-byte layout, whose first byte is the bare
+ * message type. It is still decoded, and a header decoded from it is written
+ * back in the same layout.
+ */
+class RtMhrHeader : public Header
+{
+  public:
+    /// Format version written by default
+    static constexpr uint8_t VERSION = 1;
+
+    RtMhrHeader(MessageType type = RTMHR_HELLO,
+                uint8_t hopCount = 0,
+                uint32_t requestId = 0,
+                Ipv4Address dst = Ipv4Address(),
+                Ipv4Address origin = Ipv4Address(),
+                double linkQuality = 0.0,
+                double delay = 0.0,
+                double mobility = 0.0);
+
+    static TypeId GetTypeId();
+    virtual TypeId GetInstanceTypeId() const;
+    virtual void Print(std::ostream& os) const;
+    virtual void Serialize(Buffer::Iterator start) const;
+    virtual uint32_t Deserialize(Buffer::Iterator start);
+    virtual uint32_t GetSerializedSize() const;
+
+    /**
+     * \brief Get the size of the header a message starts with
+     * \param first the first byte of the message
+     * \return the serialized size, or 0 if the version is unknown
+     */
+    static uint32_t GetMessageSize(uint8_t first);
+
+    /**
+     * \brief Select the wire format
+     * \param version 0 for the legacy 42-byte layout, VERSION for the compact one
+     */
+    void SetVersion(uint8_t version)
+    {
+        m_version = version;
+    }
+
+    /**
+     * \brief Get the wire format
+     * \return the format version this header was decoded from or will be written in
+     */
+    uint8_t GetVersion() const
+    {
+        return m_version;
+    }
+
+    // Getters and Setters
+    void SetMessageType(MessageType type)
+    {
+        m_type = type;
+    }
+
+    MessageType GetMessageType() const
+    {
+        return m_type;
+    }
+
+    void SetHopCount(uint8_t hopCount)
+    {
+        m_hopCount = hopCount;
+    }
+
+    uint8_t GetHopCount() const
+    {
+        return m_hopCount;
+    }
+
+    void SetRequestId(uint32_t requestId)
+    {
+        m_requestId = requestId;
+    }
+
+    uint32_t GetRequestId() const
+    {
+        return m_requestId;
+    }
+
+    void SetDestination(Ipv4Address dst)
+    {
+        m_dst = dst;
+    }
+
+    Ipv4Address GetDestination() const
+    {
+        return m_dst;
+    }
+
+    void SetOrigin(Ipv4Address origin)
+    {
+        m_origin = origin;
+    }
+
+    Ipv4Address GetOrigin() const
+    {
+        return m_origin;
+    }
+
+    void SetLinkQuality(double quality)
+    {
+        m_linkQuality = quality;
+    }
+
+    double GetLinkQuality() const
+    {
+        return m_linkQuality;
+    }
+
+    void SetDelay(double delay)
+    {
+        m_delay = delay;
+    }
+
+    double GetDelay() const
+    {
+        return m_delay;
+    }
+
+    void SetMobility(double mobility)
+    {
+        m_mobility = mobility;
+    }
+
+    double GetMobility() const
+    {
+        return m_mobility;
+    }
+
+    void SetSequenceNumber(uint32_t seqNum)
+    {
+        m_sequenceNumber = seqNum;
+    }
+
+    uint32_t GetSequenceNumber() const
+    {
+        return m_sequenceNumber;
+    }
+
+    void SetPosition(const Vector& position)
+    {
+        m_position = position;
+    }
+
+    Vector GetPosition() const
+    {
+        return m_position;
+    }
+
+    void SetVelocity(const Vector& velocity)
+    {
+        m_velocity = velocity;
+    }
+
+    Vector GetVelocity() const
+    {
+        return m_velocity;
+    }
+
+    /**
+     * \brief Set the area a zone RREQ is rebroadcast in
+     * \param zone the request zone, in the plane
+     */
+    void SetRequestZone(const Rectangle& zone)
+    {
+        m_zone = zone;
+    }
+
+    /**
+     * \brief Get the area a zone RREQ is rebroadcast in
+     * \return the request zone
+     */
+    Rectangle GetRequestZone() const
+    {
+        return m_zone;
+    }
+
+  private:
+    /// Optional fields of the compact format
+    enum Field
+    {
+        FIELD_HOP_COUNT = 1 << 0,  ///< m_hopCount
+        FIELD_REQUEST_ID = 1 << 1, ///< m_requestId
+        FIELD_DST = 1 << 2,        ///< m_dst
+        FIELD_ORIGIN = 1 << 3,     ///< m_origin
+        FIELD_METRICS = 1 << 4,    ///< m_linkQuality, m_delay and m_mobility
+        FIELD_POSITION = 1 << 5,   ///< m_position and m_velocity
+        FIELD_ZONE = 1 << 6        ///< m_zone
+    };
+
+    /**
+     * \brief Fields a message type carries in the compact format
+     * \param type the message type
+     * \return a mask of Field values
+     */
+    static uint32_t GetFields(MessageType type);
+
+    uint8_t m_version;         ///< Wire format version
+    MessageType m_type;        ///< Message type
+    uint8_t m_hopCount;        ///< Hop count
+    uint32_t m_requestId;      ///< Request ID
+    Ipv4Address m_dst;         ///< Destination address
+    Ipv4Address m_origin;      ///< Originator address
+    double m_linkQuality;      ///< Link quality metric
+    double m_delay;            ///< Delay metric
+    double m_mobility;         ///< Mobility metric
+    uint32_t m_sequenceNumber; ///< Sequence number
+    Vector m_position;         ///< Sender position, the originator's in a zone RREQ
+    Vector m_velocity;         ///< Sender velocity, the originator's in a zone RREQ
+    Rectangle m_zone;          ///< Request zone
+};
+
+/**
+ * \ingroup rtmhr
+ * \brief RT-MHR shim, carried at the end of data and control packets
+ *
+ * Holds what the next hop must learn from a packet besides its payload, in
+ * bytes that go on the air. It is a trailer so that it can be appended and
+ * stripped under the transport layer: RouteOutput() adds it, every hop
+ * rewrites it on the way out and RouteInput() removes it before local
+ * delivery. From the end of the packet backwards it reads:
+ *
+ * - magic: 16 bits, tells a shim from payload bytes
+ * - sections: 8 bits, one flag per section present
+ * - the sections, in flag order
+ *
+ * The digest section holds the link metrics of the transmitter, in the same
+ * fixed point as the compact header, so that a busy link refreshes the
+ * neighbor table without dedicated HELLO or PROBE messages. The transmitter is
+ * named explicitly because a forwarded packet's IPv4 source is its
+ * originator. Each hop replaces the digest with its own.
+ *
+ * The deadline section holds the delivery deadline of a real-time packet,
+ * which its source sets to the send time plus the DeadlineBudget. It is 32
+ * bits of microseconds of the clock the nodes share, GPS time on real
+ * vehicles, and reads as the nearest time with those low-order bits.
+ *
+ * The target section holds the destination position of a packet forwarded
+ * geographically, so that relays which know nothing of the destination can
+ * still forward greedily towards it. Relays with a position of their own for
+ * the destination use that instead.
+ *
+ * A UDP checksum would cover the shim, so none is added while ns-3 computes
+ * checksums; they are off by default.
+ */
+class RtMhrShim : public Trailer
+{
+  public:
+    /// Sections of the shim, one flag each
+    enum Section : uint8_t
+    {
+        DIGEST = 0x01,   ///< Link metrics of the transmitter
+        DEADLINE = 0x02, ///< Delivery deadline of a real-time packet
+        TARGET = 0x04    ///< Destination position of a geographically forwarded packet
+    };
+
+    RtMhrShim();
+
+    static TypeId GetTypeId();
+    virtual TypeId GetInstanceTypeId() const;
+    virtual uint32_t GetSerializedSize() const;
+    virtual void Serialize(Buffer::Iterator end) const;
+    virtual uint32_t Deserialize(Buffer::Iterator end);
+    virtual void Print(std::ostream& os) const;
+
+    /**
+     * \brief Check whether the shim has no section left
+     * \return true if it need not be sent
+     */
+    bool IsEmpty() const
+    {
+        return m_sections == 0;
+    }
+
+    /**
+     * \brief Check whether the shim carries a metric digest
+     * \return true if it does
+     */
+    bool HasDigest() const
+    {
+        return m_sections & DIGEST;
+    }
+
+    /**
+     * \brief Set the metric digest
+     * \param sender the transmitting neighbor
+     * \param linkQuality its delivery ratio towards the receiver, 0 if unknown
+     * \param delay its smoothed queuing delay in seconds
+     * \param position its position
+     * \param velocity its velocity
+     */
+    void SetDigest(Ipv4Address sender,
+                   double linkQuality,
+                   double delay,
+                   const Vector& position,
+                   const Vector& velocity);
+
+    /// Drop the metric digest
+    void RemoveDigest()
+    {
+        m_sections &= ~DIGEST;
+    }
+
+    /**
+     * \brief Get the transmitting neighbor
+     * \return its address on the link
+     */
+    Ipv4Address GetSender() const
+    {
+        return m_sender;
+    }
+
+    /**
+     * \brief Get the transmitter's estimate of the link towards the receiver
+     * \return the delivery ratio, 0 if the transmitter has no estimate
+     */
+    double GetLinkQuality() const
+    {
+        return m_linkQuality;
+    }
+
+    /**
+     * \brief Get the transmitter's smoothed queuing delay
+     * \return the delay in seconds
+     */
+    double GetDelay() const
+    {
+        return m_delay;
+    }
+
+    /**
+     * \brief Get the transmitter's position
+     * \return its position in the plane
+     */
+    Vector GetPosition() const
+    {
+        return m_position;
+    }
+
+    /**
+     * \brief Get the transmitter's velocity
+     * \return its velocity in the plane
+     */
+    Vector GetVelocity() const
+    {
+        return m_velocity;
+    }
+
+    /**
+     * \brief Check whether the shim carries a deadline
+     * \return true if it does
+     */
+    bool HasDeadline() const
+    {
+        return m_sections & DEADLINE;
+    }
+
+    /**
+     * \brief Set the deadline
+     * \param deadline the time by which the packet must be delivered
+     */
+    void SetDeadline(Time deadline);
+
+    /**
+     * \brief Get the deadline
+     * \return the time by which the packet must be delivered, to the microsecond
+     */
+    Time GetDeadline() const;
+
+    /**
+     * \brief Check whether the shim carries a destination position
+     * \return true if it does
+     */
+    bool HasTarget() const
+    {
+        return m_sections & TARGET;
+    }
+
+    /**
+     * \brief Set the destination position
+     * \param target the position in the plane, as the source knows it
+     */
+    void SetTarget(const Vector& target)
+    {
+        m_sections |= TARGET;
+        m_target = target;
+    }
+
+    /**
+     * \brief Get the destination position
+     * \return the position in the plane, as the source knew it
+     */
+    Vector GetTarget() const
+    {
+        return m_target;
+    }
+
+    /**
+     * \brief Read the shim at the end of a packet, if it has one
+     * \param packet the packet
+     * \param shim the shim read
+     * \return true if the packet ends with a shim
+     */
+    static bool Peek(Ptr<const Packet> packet, RtMhrShim& shim);
+
+  private:
+    uint8_t m_sections;   ///< Sections present
+    Ipv4Address m_sender; ///< Transmitting neighbor
+    double m_linkQuality; ///< Delivery ratio towards the receiver
+    double m_delay;       ///< Queuing delay in seconds
+    Vector m_position;    ///< Transmitter position
+    Vector m_velocity;    ///< Transmitter velocity
+    uint32_t m_deadline;  ///< Deadline, low-order 32 bits of its microseconds
+    Vector m_target;      ///< Destination position
+};
+
+} // namespace rtmhr
+} // namespace ns3
+
+#endif /* RTMHR_PACKET_H */
@@ -0,0 +1,96 @@
+#include "rtmhr-pqueue.h"
+
+#include "ns3/log.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("RtMhrPriorityQueue");
+
+RtMhrPriorityQueue::RtMhrPriorityQueue()
+    : m_scheduler(RTMHR_SCHED_STRICT),
+      m_turn(0),
+      m_size(0)
+{
+    const uint32_t maxLen[CLASSES] = {32, 64, 128};
+    const uint32_t weight[CLASSES] = {4, 2, 1};
+    for (uint32_t c = 0; c < CLASSES; ++c)
+    {
+        m_classes[c].maxLen = maxLen[c];
+        m_classes[c].weight = weight[c];
+        m_classes[c].deficit = 0;
+    }
+    m_classes[0].deficit = m_classes[0].weight;
+}
+
+bool
+RtMhrPriorityQueue::Enqueue(const RtMhrForwardEntry& entry)
+{
+    Class& cl = m_classes[Index(entry.priority)];
+    if (cl.packets.size() >= cl.maxLen)
+    {
+        NS_LOG_LOGIC("Class " << entry.priority << " full, dropping packet "
+                              << entry.packet->GetUid());
+        return false;
+    }
+    cl.packets.push_back(entry);
+    m_size++;
+    return true;
+}
+
+bool
+RtMhrPriorityQueue::Dequeue(RtMhrForwardEntry& entry)
+{
+    if (m_size == 0)
+    {
+        return false;
+    }
+
+    if (m_scheduler == RTMHR_SCHED_STRICT)
+    {
+        for (uint32_t c = 0; c < CLASSES; ++c)
+        {
+            if (!m_classes[c].packets.empty())
+            {
+                Pop(c, entry);
+                return true;
+            }
+        }
+    }
+
+    // Deficit round robin: each turn a class may send up to its weight in packets.
+    // This terminates because some class is non-empty and every weight is at least 1.
+    for (;;)
+    {
+        Class& cl = m_classes[m_turn];
+        if (cl.deficit > 0 && !cl.packets.empty())
+        {
+            cl.deficit--;
+            Pop(m_turn, entry);
+            return true;
+        }
+        cl.deficit = 0;
+        m_turn = (m_turn + 1) % CLASSES;
+        m_classes[m_turn].deficit = m_classes[m_turn].weight;
+    }
+}
+
+void
+RtMhrPriorityQueue::Clear()
+{
+    for (uint32_t c = 0; c < CLASSES; ++c)
+    {
+        m_classes[c].packets.clear();
+    }
+    m_size = 0;
+}
+
+void
+RtMhrPriorityQueue::Pop(uint32_t c, RtMhrForwardEntry& entry)
+{
+    entry = m_classes[c].packets.front();
+    m_classes[c].packets.pop_front();
+    m_size--;
+}
+
+} // namespace ns3
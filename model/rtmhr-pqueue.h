@@ -0,0 +1,170 @@
+#ifndef RTMHR_PQUEUE_H
+#define RTMHR_PQUEUE_H
+
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+
+#include <deque>
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief Traffic Priority Levels
+ */
+enum TrafficPriority
+{
+    HIGH_PRIORITY = 1,   ///< High priority traffic (real-time)
+    MEDIUM_PRIORITY = 2, ///< Medium priority traffic
+    NORMAL_PRIORITY = 3  ///< Normal priority traffic
+};
+
+/**
+ * \ingroup rtmhr
+ * \brief Service disciplines of the forwarding queue
+ */
+enum RtMhrScheduler
+{
+    RTMHR_SCHED_STRICT = 0,  ///< Always serve the highest non-empty class
+    RTMHR_SCHED_WEIGHTED = 1 ///< Deficit round robin over the classes, in packets
+};
+
+/**
+ * \ingroup rtmhr
+ * \brief A packet waiting in the forwarding queue
+ */
+struct RtMhrForwardEntry
+{
+    Ptr<const Packet> packet;                        ///< The packet
+    Ipv4Header header;                               ///< IP header
+    Ptr<Ipv4Route> route;                            ///< Route chosen by RT-MHR
+    Ipv4RoutingProtocol::UnicastForwardCallback ucb; ///< Forward callback
+    Ipv4RoutingProtocol::ErrorCallback ecb;          ///< Error callback
+    TrafficPriority priority;                        ///< Traffic class
+    Time arrival;                                    ///< Enqueue time
+};
+
+/**
+ * \ingroup rtmhr
+ * \brief Per-interface forwarding queue with one FIFO per TrafficPriority
+ *
+ * Each class has its own depth limit and tail-drops when full, so bulk
+ * traffic cannot push real-time packets out. Dequeue() serves the classes
+ * either in strict priority order or by deficit round robin with
+ * per-class weights (4:2:1 by default).
+ */
+class RtMhrPriorityQueue
+{
+  public:
+    /// Number of traffic classes
+    static const uint32_t CLASSES = 3;
+
+    RtMhrPriorityQueue();
+
+    /**
+     * \brief Queue a packet in its class
+     * \param entry the packet
+     * \return false if the class is full and the packet was not queued
+     */
+    bool Enqueue(const RtMhrForwardEntry& entry);
+
+    /**
+     * \brief Remove the next packet to send
+     * \param [out] entry the packet
+     * \return false if the queue is empty
+     */
+    bool Dequeue(RtMhrForwardEntry& entry);
+
+    /**
+     * \brief Drop every queued packet without reporting it
+     */
+    void Clear();
+
+    /**
+     * \brief Get the number of queued packets
+     * \return the number of packets in all classes
+     */
+    uint32_t GetSize() const
+    {
+        return m_size;
+    }
+
+    /**
+     * \brief Get the number of queued packets of one class
+     * \param priority the class
+     * \return the number of packets
+     */
+    uint32_t GetSize(TrafficPriority priority) const
+    {
+        return m_classes[Index(priority)].packets.size();
+    }
+
+    /**
+     * \brief Set the service discipline
+     * \param scheduler the discipline
+     */
+    void SetScheduler(RtMhrScheduler scheduler)
+    {
+        m_scheduler = scheduler;
+    }
+
+    /**
+     * \brief Set the depth limit of a class
+     * \param priority the class
+     * \param len maximum number of packets
+     */
+    void SetMaxLen(TrafficPriority priority, uint32_t len)
+    {
+        m_classes[Index(priority)].maxLen = len;
+    }
+
+    /**
+     * \brief Set the weighted-fair share of a class
+     * \param priority the class
+     * \param weight packets served per round, at least 1
+     */
+    void SetWeight(TrafficPriority priority, uint32_t weight)
+    {
+        m_classes[Index(priority)].weight = weight > 0 ? weight : 1;
+    }
+
+  private:
+    /// One traffic class
+    struct Class
+    {
+        std::deque<RtMhrForwardEntry> packets; ///< FIFO
+        uint32_t maxLen;                       ///< Depth limit
+        uint32_t weight;                       ///< Packets per round robin turn
+        uint32_t deficit;                      ///< Packets left in the current turn
+    };
+
+    /**
+     * \brief Class index of a priority
+     * \param priority the priority
+     * \return index into m_classes, highest priority first
+     */
+    static uint32_t Index(TrafficPriority priority)
+    {
+        return priority - HIGH_PRIORITY;
+    }
+
+    /**
+     * \brief Pop the head of a class
+     * \param c the class index
+     * \param [out] entry the packet
+     */
+    void Pop(uint32_t c, RtMhrForwardEntry& entry);
+
+    Class m_classes[CLASSES];   ///< Traffic classes, highest priority first
+    RtMhrScheduler m_scheduler; ///< Service discipline
+    uint32_t m_turn;            ///< Class holding the round robin turn
+    uint32_t m_size;            ///< Total queued packets
+};
+
+} // namespace ns3
+
+#endif /* RTMHR_PQUEUE_H */
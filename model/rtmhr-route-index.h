@@ -0,0 +1,128 @@
+#ifndef RTMHR_ROUTE_INDEX_H
+#define RTMHR_ROUTE_INDEX_H
+
+#include "ns3/ipv4-address.h"
+
+#include <cstdint>
+#include <map>
+#include <set>
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief Index of the destinations whose primary or backup path leaves
+ * through each neighbor
+ *
+ * A change in a neighbor's link metric only affects the routes through it, so
+ * with this index it re-ranks those routes instead of sweeping the whole
+ * routing table. Links are added whenever a path through a neighbor is
+ * offered, but left in place when the path is dropped: Visit() asks on every
+ * visit whether the destination still depends on the neighbor and forgets it
+ * if not. A lost neighbor's routes are visited once more for the failover,
+ * which leaves none of them; an expired route is removed from its remaining
+ * next hops as it leaves the routing table.
+ */
+class RtMhrRouteIndex
+{
+  public:
+    RtMhrRouteIndex()
+        : m_size(0)
+    {
+    }
+
+    /**
+     * \brief Record that a route has a path through a neighbor
+     * \param hop the neighbor
+     * \param destination the route's destination
+     */
+    void Add(Ipv4Address hop, Ipv4Address destination)
+    {
+        if (m_routes[hop].insert(destination).second)
+        {
+            m_size++;
+        }
+    }
+
+    /**
+     * \brief Forget that a route has a path through a neighbor
+     * \param hop the neighbor
+     * \param destination the route's destination
+     */
+    void Remove(Ipv4Address hop, Ipv4Address destination)
+    {
+        auto routes = m_routes.find(hop);
+        if (routes == m_routes.end() || routes->second.erase(destination) == 0)
+        {
+            return;
+        }
+        m_size--;
+        if (routes->second.empty())
+        {
+            m_routes.erase(routes);
+        }
+    }
+
+    /**
+     * \brief Visit the routes recorded for a neighbor
+     * \param hop the neighbor
+     * \param visit called with each destination, returns false if the route
+     *        no longer has a path through the neighbor, which is then forgotten
+     * \return the number of routes still depending on the neighbor
+     */
+    template <typename Visitor>
+    uint32_t Visit(Ipv4Address hop, Visitor visit)
+    {
+        auto routes = m_routes.find(hop);
+        if (routes == m_routes.end())
+        {
+            return 0;
+        }
+        std::set<Ipv4Address>& destinations = routes->second;
+        for (auto iter = destinations.begin(); iter != destinations.end();)
+        {
+            if (visit(*iter))
+            {
+                ++iter;
+            }
+            else
+            {
+                iter = destinations.erase(iter);
+                m_size--;
+            }
+        }
+        uint32_t left = destinations.size();
+        if (destinations.empty())
+        {
+            m_routes.erase(routes);
+        }
+        return left;
+    }
+
+    /**
+     * \brief Get the number of neighbor-route links, stale ones included
+     * \return the number of links
+     */
+    uint32_t GetSize() const
+    {
+        return m_size;
+    }
+
+    /**
+     * \brief Forget every link
+     */
+    void Clear()
+    {
+        m_routes.clear();
+        m_size = 0;
+    }
+
+  private:
+    std::map<Ipv4Address, std::set<Ipv4Address>> m_routes; ///< Destinations by neighbor
+    uint32_t m_size;                                       ///< Links recorded
+};
+
+} // namespace ns3
+
+#endif /* RTMHR_ROUTE_INDEX_H */
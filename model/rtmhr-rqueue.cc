@@ -0,0 +1,108 @@
+#include "rtmhr-rqueue.h"
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("RtMhrRequestQueue");
+
+RtMhrRequestQueue::RtMhrRequestQueue(uint32_t maxLen, Time timeout)
+    : m_maxLen(maxLen),
+      m_timeout(timeout),
+      m_size(0)
+{
+}
+
+void
+RtMhrRequestQueue::Enqueue(Ptr<const Packet> packet,
+                           const Ipv4Header& header,
+                           const Ipv4RoutingProtocol::UnicastForwardCallback& ucb,
+                           const Ipv4RoutingProtocol::ErrorCallback& ecb)
+{
+    NS_LOG_FUNCTION(this << packet->GetUid() << header.GetDestination());
+    if (m_maxLen == 0)
+    {
+        DropEntry(RtMhrQueueEntry{packet, header, ucb, ecb, Simulator::Now()});
+        return;
+    }
+    std::deque<RtMhrQueueEntry>& queue = m_queues[header.GetDestination()];
+    if (queue.size() >= m_maxLen)
+    {
+        NS_LOG_LOGIC("Queue for " << header.GetDestination() << " full, dropping oldest");
+        DropEntry(queue.front());
+        queue.pop_front();
+        m_size--;
+    }
+    queue.push_back(RtMhrQueueEntry{packet, header, ucb, ecb, Simulator::Now() + m_timeout});
+    m_size++;
+}
+
+void
+RtMhrRequestQueue::Dequeue(Ipv4Address dst, std::deque<RtMhrQueueEntry>& entries)
+{
+    auto iter = m_queues.find(dst);
+    if (iter == m_queues.end())
+    {
+        return;
+    }
+    entries.swap(iter->second);
+    m_size -= entries.size();
+    m_queues.erase(iter);
+}
+
+void
+RtMhrRequestQueue::Drop(Ipv4Address dst)
+{
+    NS_LOG_FUNCTION(this << dst);
+    std::deque<RtMhrQueueEntry> entries;
+    Dequeue(dst, entries);
+    for (const auto& entry : entries)
+    {
+        DropEntry(entry);
+    }
+}
+
+void
+RtMhrRequestQueue::Purge()
+{
+    Time now = Simulator::Now();
+    for (auto iter = m_queues.begin(); iter != m_queues.end();)
+    {
+        // FIFO order means the expired packets are at the front
+        std::deque<RtMhrQueueEntry>& queue = iter->second;
+        while (!queue.empty() && queue.front().expire < now)
+        {
+            DropEntry(queue.front());
+            queue.pop_front();
+            m_size--;
+        }
+        if (queue.empty())
+        {
+            iter = m_queues.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+void
+RtMhrRequestQueue::Clear()
+{
+    m_queues.clear();
+    m_size = 0;
+}
+
+void
+RtMhrRequestQueue::DropEntry(const RtMhrQueueEntry& entry)
+{
+    NS_LOG_LOGIC("Dropping packet " << entry.packet->GetUid() << " to "
+                                    << entry.header.GetDestination());
+    entry.ecb(entry.packet, entry.header, Socket::ERROR_NOROUTETOHOST);
+}
+
+} // namespace ns3
@@ -0,0 +1,139 @@
+#ifndef RTMHR_RQUEUE_H
+#define RTMHR_RQUEUE_H
+
+#include "ns3/ipv4-header.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+
+#include <deque>
+#include <map>
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief A packet waiting for route discovery
+ */
+struct RtMhrQueueEntry
+{
+    Ptr<const Packet> packet;                        ///< The packet
+    Ipv4Header header;                               ///< IP header
+    Ipv4RoutingProtocol::UnicastForwardCallback ucb; ///< Forward callback
+    Ipv4RoutingProtocol::ErrorCallback ecb;          ///< Error callback
+    Time expire;                                     ///< Drop time
+};
+
+/**
+ * \ingroup rtmhr
+ * \brief Per-destination buffer holding packets until a route is discovered
+ *
+ * Each destination gets a FIFO of at most maxLen packets; when it is full the
+ * oldest packet is dropped. Packets older than the timeout are dropped by Purge().
+ * Dropped packets are reported through their error callback.
+ */
+class RtMhrRequestQueue
+{
+  public:
+    /**
+     * \brief Constructor
+     * \param maxLen maximum number of packets per destination
+     * \param timeout maximum time a packet is buffered
+     */
+    RtMhrRequestQueue(uint32_t maxLen, Time timeout);
+
+    /**
+     * \brief Buffer a packet
+     * \param packet the packet
+     * \param header its IP header
+     * \param ucb forward callback used once a route exists
+     * \param ecb error callback used if the packet is dropped
+     */
+    void Enqueue(Ptr<const Packet> packet,
+                 const Ipv4Header& header,
+                 const Ipv4RoutingProtocol::UnicastForwardCallback& ucb,
+                 const Ipv4RoutingProtocol::ErrorCallback& ecb);
+
+    /**
+     * \brief Remove every buffered packet for a destination
+     * \param dst the destination
+     * \param [out] entries the packets, oldest first
+     */
+    void Dequeue(Ipv4Address dst, std::deque<RtMhrQueueEntry>& entries);
+
+    /**
+     * \brief Drop every buffered packet for a destination
+     * \param dst the destination
+     */
+    void Drop(Ipv4Address dst);
+
+    /**
+     * \brief Drop packets that waited longer than the timeout
+     */
+    void Purge();
+
+    /**
+     * \brief Check whether packets are buffered for a destination
+     * \param dst the destination
+     * \return true if at least one packet is buffered
+     */
+    bool Find(Ipv4Address dst) const
+    {
+        return m_queues.find(dst) != m_queues.end();
+    }
+
+    /**
+     * \brief Get the total number of buffered packets
+     * \return the number of packets
+     */
+    uint32_t GetSize() const
+    {
+        return m_size;
+    }
+
+    /**
+     * \brief Drop every buffered packet
+     */
+    void Clear();
+
+    /// \param len maximum number of packets per destination
+    void SetMaxQueueLen(uint32_t len)
+    {
+        m_maxLen = len;
+    }
+
+    /// \return maximum number of packets per destination
+    uint32_t GetMaxQueueLen() const
+    {
+        return m_maxLen;
+    }
+
+    /// \param t maximum time a packet is buffered
+    void SetQueueTimeout(Time t)
+    {
+        m_timeout = t;
+    }
+
+    /// \return maximum time a packet is buffered
+    Time GetQueueTimeout() const
+    {
+        return m_timeout;
+    }
+
+  private:
+    /**
+     * \brief Report a dropped packet
+     * \param entry the dropped packet
+     */
+    void DropEntry(const RtMhrQueueEntry& entry);
+
+    std::map<Ipv4Address, std::deque<RtMhrQueueEntry>> m_queues; ///< Per-destination FIFOs
+    uint32_t m_maxLen;                                           ///< Per-destination limit
+    Time m_timeout;                                              ///< Buffering timeout
+    uint32_t m_size;                                             ///< Total buffered packets
+};
+
+} // namespace ns3
+
+#endif /* RTMHR_RQUEUE_H */
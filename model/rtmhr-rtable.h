@@ -0,0 +1,380 @@
+#ifndef RTMHR_RTABLE_H
+#define RTMHR_RTABLE_H
+
+#include "ns3/ipv4-address.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief Storage backends for RT-MHR route and neighbor tables
+ */
+enum RtMhrTableBackend
+{
+    RTMHR_TABLE_HASH = 0, ///< Open-addressing hash index, O(1) lookups for large tables
+    RTMHR_TABLE_FLAT = 1  ///< Sorted flat vector, binary search, best for small tables
+};
+
+/**
+ * \ingroup rtmhr
+ * \brief Ipv4Address-keyed table with a pluggable lookup backend
+ *
+ * Entries always live in one contiguous vector of (address, entry) pairs so that
+ * sweeps and table dumps walk memory linearly. The HASH backend adds a
+ * linear-probing index of positions into that vector, keyed on Ipv4Address::Get();
+ * the FLAT backend keeps the vector sorted and binary-searches it.
+ *
+ * Pointers and references returned by Find() and Insert() are invalidated by any
+ * later Insert() or Erase(), exactly like std::vector. Callers copy what they
+ * need, or Find() the entry again, across anything that may add or remove one;
+ * in RtMhr that includes every unicast send, which passes through RouteOutput().
+ */
+template <typename Entry>
+class RtMhrTable
+{
+  public:
+    /// Stored element, laid out like a std::map value_type
+    typedef std::pair<Ipv4Address, Entry> Value;
+    /// Iterator over stored elements
+    typedef typename std::vector<Value>::iterator Iterator;
+    /// Const iterator over stored elements
+    typedef typename std::vector<Value>::const_iterator ConstIterator;
+
+    /**
+     * \brief Constructor
+     * \param backend the lookup backend to start with
+     */
+    RtMhrTable(RtMhrTableBackend backend = RTMHR_TABLE_HASH)
+        : m_backend(backend),
+          m_bits(0)
+    {
+    }
+
+    /**
+     * \brief Switch lookup backend, re-indexing the current content
+     * \param backend the new backend
+     */
+    void SetBackend(RtMhrTableBackend backend)
+    {
+        m_backend = backend;
+        Reindex();
+    }
+
+    /**
+     * \brief Get the lookup backend
+     * \return the backend in use
+     */
+    RtMhrTableBackend GetBackend() const
+    {
+        return m_backend;
+    }
+
+    /**
+     * \brief Look up an entry
+     * \param addr the key
+     * \return pointer to the entry, or nullptr if absent
+     */
+    Entry* Find(Ipv4Address addr)
+    {
+        int32_t pos = Locate(addr);
+        return pos < 0 ? nullptr : &m_entries[pos].second;
+    }
+
+    /**
+     * \brief Look up an entry
+     * \param addr the key
+     * \return pointer to the entry, or nullptr if absent
+     */
+    const Entry* Find(Ipv4Address addr) const
+    {
+        int32_t pos = Locate(addr);
+        return pos < 0 ? nullptr : &m_entries[pos].second;
+    }
+
+    /**
+     * \brief Insert an entry, overwriting any entry with the same key
+     * \param addr the key
+     * \param entry the entry
+     * \return reference to the stored entry
+     */
+    Entry& Insert(Ipv4Address addr, const Entry& entry)
+    {
+        int32_t pos = Locate(addr);
+        if (pos >= 0)
+        {
+            m_entries[pos].second = entry;
+            return m_entries[pos].second;
+        }
+        return m_entries[Add(addr, entry)].second;
+    }
+
+    /**
+     * \brief Remove an entry
+     * \param addr the key
+     * \return true if an entry was removed
+     */
+    bool Erase(Ipv4Address addr)
+    {
+        if (m_backend == RTMHR_TABLE_FLAT)
+        {
+            Iterator it = LowerBound(addr);
+            if (it == m_entries.end() || it->first != addr)
+            {
+                return false;
+            }
+            m_entries.erase(it);
+            return true;
+        }
+
+        uint32_t slot;
+        if (!FindSlot(addr, slot))
+        {
+            return false;
+        }
+        uint32_t pos = m_slots[slot] - 1;
+        RemoveSlot(slot);
+
+        // Keep entries dense: move the last one into the hole
+        uint32_t last = m_entries.size() - 1;
+        if (pos != last)
+        {
+            uint32_t lastSlot;
+            FindSlot(m_entries[last].first, lastSlot);
+            m_entries[pos] = std::move(m_entries[last]);
+            m_slots[lastSlot] = pos + 1;
+        }
+        m_entries.pop_back();
+        return true;
+    }
+
+    /**
+     * \brief Remove all entries
+     */
+    void Clear()
+    {
+        m_entries.clear();
+        m_slots.clear();
+        m_bits = 0;
+    }
+
+    /**
+     * \brief Get the number of entries
+     * \return the table size
+     */
+    uint32_t GetSize() const
+    {
+        return m_entries.size();
+    }
+
+    /**
+     * \brief Check whether the table is empty
+     * \return true if the table has no entries
+     */
+    bool IsEmpty() const
+    {
+        return m_entries.empty();
+    }
+
+    /// \return iterator to the first element
+    Iterator begin()
+    {
+        return m_entries.begin();
+    }
+
+    /// \return iterator past the last element
+    Iterator end()
+    {
+        return m_entries.end();
+    }
+
+    /// \return const iterator to the first element
+    ConstIterator begin() const
+    {
+        return m_entries.begin();
+    }
+
+    /// \return const iterator past the last element
+    ConstIterator end() const
+    {
+        return m_entries.end();
+    }
+
+  private:
+    /// Smallest hash index holds 2^MIN_BITS slots; it is kept at most half full
+    static const uint32_t MIN_BITS = 4;
+
+    /**
+     * \brief Home slot of a key in the hash index
+     * \param addr the key
+     * \return slot index
+     */
+    uint32_t Home(Ipv4Address addr) const
+    {
+        // Fibonacci hashing: addresses in one subnet differ only in their low bits
+        return (addr.Get() * 2654435769U) >> (32 - m_bits);
+    }
+
+    /**
+     * \brief Find the hash slot holding a key
+     * \param addr the key
+     * \param [out] slot the slot index, if found
+     * \return true if found
+     */
+    bool FindSlot(Ipv4Address addr, uint32_t& slot) const
+    {
+        if (m_slots.empty())
+        {
+            return false;
+        }
+        uint32_t mask = m_slots.size() - 1;
+        for (uint32_t i = Home(addr);; i = (i + 1) & mask)
+        {
+            if (m_slots[i] == 0)
+            {
+                return false;
+            }
+            if (m_entries[m_slots[i] - 1].first == addr)
+            {
+                slot = i;
+                return true;
+            }
+        }
+    }
+
+    /**
+     * \brief Empty a hash slot, shifting back later members of its probe run
+     * \param slot the slot to free
+     */
+    void RemoveSlot(uint32_t slot)
+    {
+        uint32_t mask = m_slots.size() - 1;
+        uint32_t hole = slot;
+        for (uint32_t j = (hole + 1) & mask; m_slots[j] != 0; j = (j + 1) & mask)
+        {
+            uint32_t home = Home(m_entries[m_slots[j] - 1].first);
+            // Move j into the hole unless its home lies cyclically in (hole, j]
+            if (((j - home) & mask) >= ((j - hole) & mask))
+            {
+                m_slots[hole] = m_slots[j];
+                hole = j;
+            }
+        }
+        m_slots[hole] = 0;
+    }
+
+    /**
+     * \brief Place an entry position into the hash index
+     * \param pos the entry position
+     */
+    void IndexEntry(uint32_t pos)
+    {
+        uint32_t mask = m_slots.size() - 1;
+        uint32_t i = Home(m_entries[pos].first);
+        while (m_slots[i] != 0)
+        {
+            i = (i + 1) & mask;
+        }
+        m_slots[i] = pos + 1;
+    }
+
+    /**
+     * \brief Rebuild the lookup structure for the current backend
+     */
+    void Reindex()
+    {
+        if (m_backend == RTMHR_TABLE_FLAT)
+        {
+            m_slots.clear();
+            m_bits = 0;
+            std::sort(m_entries.begin(), m_entries.end(), [](const Value& a, const Value& b) {
+                return a.first < b.first;
+            });
+            return;
+        }
+
+        m_bits = MIN_BITS;
+        while ((1U << m_bits) < 2 * m_entries.size())
+        {
+            m_bits++;
+        }
+        m_slots.assign(1U << m_bits, 0);
+        for (uint32_t pos = 0; pos < m_entries.size(); ++pos)
+        {
+            IndexEntry(pos);
+        }
+    }
+
+    /**
+     * \brief Sorted insertion point of a key (FLAT backend)
+     * \param addr the key
+     * \return iterator to the first element not less than addr
+     */
+    Iterator LowerBound(Ipv4Address addr)
+    {
+        return std::lower_bound(m_entries.begin(),
+                                m_entries.end(),
+                                addr,
+                                [](const Value& v, Ipv4Address a) { return v.first < a; });
+    }
+
+    /**
+     * \brief Position of a key in the entry vector
+     * \param addr the key
+     * \return position, or -1 if absent
+     */
+    int32_t Locate(Ipv4Address addr) const
+    {
+        if (m_backend == RTMHR_TABLE_FLAT)
+        {
+            ConstIterator it = std::lower_bound(
+                m_entries.begin(),
+                m_entries.end(),
+                addr,
+                [](const Value& v, Ipv4Address a) { return v.first < a; });
+            return (it != m_entries.end() && it->first == addr) ? it - m_entries.begin() : -1;
+        }
+
+        uint32_t slot;
+        return FindSlot(addr, slot) ? static_cast<int32_t>(m_slots[slot] - 1) : -1;
+    }
+
+    /**
+     * \brief Append a new key known to be absent
+     * \param addr the key
+     * \param entry the entry
+     * \return position of the new entry
+     */
+    uint32_t Add(Ipv4Address addr, const Entry& entry)
+    {
+        if (m_backend == RTMHR_TABLE_FLAT)
+        {
+            return m_entries.insert(LowerBound(addr), Value(addr, entry)) - m_entries.begin();
+        }
+
+        m_entries.push_back(Value(addr, entry));
+        uint32_t pos = m_entries.size() - 1;
+        if (2 * m_entries.size() > m_slots.size())
+        {
+            Reindex(); // grows the index and places the new entry too
+        }
+        else
+        {
+            IndexEntry(pos);
+        }
+        return pos;
+    }
+
+    RtMhrTableBackend m_backend;   ///< Lookup backend
+    std::vector<Value> m_entries;  ///< Dense entry storage
+    std::vector<uint32_t> m_slots; ///< Hash index: entry position + 1, 0 when empty
+    uint32_t m_bits;               ///< log2 of the hash index size
+};
+
+} // namespace ns3
+
+#endif /* RTMHR_RTABLE_H */
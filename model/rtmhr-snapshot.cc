@@ -0,0 +1,186 @@
+#include "rtmhr-snapshot.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <cstring>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("RtMhrSnapshot");
+
+namespace
+{
+
+/// Records buffered before a write to the file
+constexpr uint32_t BUFFERED_RECORDS = 4096;
+
+/**
+ * \brief Append an integer to a buffer, least significant byte first
+ * \param buffer the buffer
+ * \param value the value
+ * \param bytes its width
+ */
+void
+PutLittleEndian(std::vector<uint8_t>& buffer, uint64_t value, uint32_t bytes)
+{
+    for (uint32_t i = 0; i < bytes; ++i)
+    {
+        buffer.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+/**
+ * \brief Append a double to a buffer as a little-endian IEEE 754 value
+ * \param buffer the buffer
+ * \param value the value
+ */
+void
+PutDouble(std::vector<uint8_t>& buffer, double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    PutLittleEndian(buffer, bits, 8);
+}
+
+} // namespace
+
+RtMhrSnapshotRecord::RtMhrSnapshotRecord()
+    : interface(0),
+      hopCount(0),
+      linkQuality(0),
+      queuingDelay(0),
+      mobilityMetric(0),
+      score(0),
+      expiry(0)
+{
+}
+
+bool
+RtMhrSnapshotRecord::operator==(const RtMhrSnapshotRecord& other) const
+{
+    return destination == other.destination && nextHop == other.nextHop &&
+           interface == other.interface && hopCount == other.hopCount &&
+           linkQuality == other.linkQuality && queuingDelay == other.queuingDelay &&
+           mobilityMetric == other.mobilityMetric && score == other.score &&
+           expiry == other.expiry;
+}
+
+RtMhrSnapshotWriter::RtMhrSnapshotWriter(std::string filename, bool delta)
+    : m_file(filename, std::ios::out | std::ios::binary | std::ios::trunc),
+      m_delta(delta),
+      m_records(0)
+{
+    NS_LOG_FUNCTION(this << filename << delta);
+    NS_ABORT_MSG_UNLESS(m_file.is_open(), "Cannot open snapshot file " << filename);
+    m_buffer.reserve(BUFFERED_RECORDS * RECORD_SIZE);
+
+    const char magic[] = "RTMHRSNP";
+    m_buffer.insert(m_buffer.end(), magic, magic + 8);
+    PutLittleEndian(m_buffer, VERSION, 2);
+    PutLittleEndian(m_buffer, RECORD_SIZE, 2);
+    PutLittleEndian(m_buffer, delta ? 1 : 0, 4);
+}
+
+RtMhrSnapshotWriter::~RtMhrSnapshotWriter()
+{
+    Close();
+}
+
+void
+RtMhrSnapshotWriter::BeginSnapshot(Time now)
+{
+    Append(0xffffffff, now, RtMhrSnapshotRecord::MARKER, RtMhrSnapshotRecord());
+}
+
+void
+RtMhrSnapshotWriter::Write(uint32_t node, Time now, const std::vector<RtMhrSnapshotRecord>& routes)
+{
+    if (!m_delta)
+    {
+        for (const auto& route : routes)
+        {
+            Append(node, now, RtMhrSnapshotRecord::ENTRY, route);
+        }
+        return;
+    }
+
+    Table& last = m_last[node];
+    Table current;
+    current.reserve(routes.size());
+    for (const auto& route : routes)
+    {
+        uint32_t key = route.destination.Get();
+        auto previous = last.find(key);
+        if (previous == last.end() || !(previous->second == route))
+        {
+            Append(node, now, RtMhrSnapshotRecord::ENTRY, route);
+        }
+        current.emplace(key, route);
+    }
+    for (const auto& previous : last)
+    {
+        if (current.find(previous.first) == current.end())
+        {
+            RtMhrSnapshotRecord removed;
+            removed.destination = previous.second.destination;
+            Append(node, now, RtMhrSnapshotRecord::REMOVED, removed);
+        }
+    }
+    last.swap(current);
+}
+
+void
+RtMhrSnapshotWriter::Append(uint32_t node,
+                            Time now,
+                            uint32_t kind,
+                            const RtMhrSnapshotRecord& route)
+{
+    if (!m_file.is_open())
+    {
+        return;
+    }
+    if (m_buffer.size() + RECORD_SIZE > m_buffer.capacity())
+    {
+        Flush();
+    }
+    PutLittleEndian(m_buffer, now.GetNanoSeconds(), 8);
+    PutLittleEndian(m_buffer, node, 4);
+    PutLittleEndian(m_buffer, kind, 4);
+    PutLittleEndian(m_buffer, route.destination.Get(), 4);
+    PutLittleEndian(m_buffer, route.nextHop.Get(), 4);
+    PutLittleEndian(m_buffer, route.interface, 4);
+    PutLittleEndian(m_buffer, route.hopCount, 4);
+    PutDouble(m_buffer, route.linkQuality);
+    PutDouble(m_buffer, route.queuingDelay);
+    PutDouble(m_buffer, route.mobilityMetric);
+    PutDouble(m_buffer, route.score);
+    PutLittleEndian(m_buffer, route.expiry.GetNanoSeconds(), 8);
+    m_records++;
+}
+
+void
+RtMhrSnapshotWriter::Flush()
+{
+    if (m_file.is_open() && !m_buffer.empty())
+    {
+        m_file.write(reinterpret_cast<const char*>(m_buffer.data()), m_buffer.size());
+        m_file.flush();
+    }
+    m_buffer.clear();
+}
+
+void
+RtMhrSnapshotWriter::Close()
+{
+    NS_LOG_FUNCTION(this);
+    Flush();
+    if (m_file.is_open())
+    {
+        m_file.close();
+    }
+    m_last.clear();
+}
+
+} // namespace ns3
@@ -0,0 +1,163 @@
+#ifndef RTMHR_SNAPSHOT_H
+#define RTMHR_SNAPSHOT_H
+
+#include "ns3/ipv4-address.h"
+#include "ns3/nstime.h"
+#include "ns3/simple-ref-count.h"
+
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief One route as stored in a binary routing table snapshot
+ */
+struct RtMhrSnapshotRecord
+{
+    /// Record kinds
+    enum Kind : uint32_t
+    {
+        ENTRY = 0,   ///< A route, new or changed in delta mode
+        REMOVED = 1, ///< A route gone since the node's previous snapshot, delta mode only
+        MARKER = 2,  ///< Start of a snapshot of all nodes, node and route fields unused
+    };
+
+    Ipv4Address destination; ///< Destination
+    Ipv4Address nextHop;     ///< Next hop of the primary path
+    uint32_t interface;      ///< Output interface
+    uint32_t hopCount;       ///< Hops to the destination
+    double linkQuality;      ///< Link quality (0-1)
+    double queuingDelay;     ///< Queuing delay in seconds
+    double mobilityMetric;   ///< Mobility prediction metric
+    double score;            ///< Composite metric
+    Time expiry;             ///< Absolute time the route expires
+
+    RtMhrSnapshotRecord();
+
+    /**
+     * \brief Compare every stored field
+     * \param other the other record
+     * \return true if the records are equal
+     */
+    bool operator==(const RtMhrSnapshotRecord& other) const;
+};
+
+/**
+ * \ingroup rtmhr
+ * \brief Streaming writer of binary routing table snapshots
+ *
+ * All nodes of a run share one writer and one file. The file starts with a
+ * 16 byte header: the magic "RTMHRSNP", a uint16 format version, the uint16
+ * record size and uint32 flags (bit 0 set in delta mode). Fixed-size
+ * little-endian records follow:
+ *
+ * | Offset | Type    | Field                      |
+ * |--------|---------|----------------------------|
+ * | 0      | int64   | time, ns                   |
+ * | 8      | uint32  | node ID                    |
+ * | 12     | uint32  | RtMhrSnapshotRecord::Kind  |
+ * | 16     | uint32  | destination                |
+ * | 20     | uint32  | next hop                   |
+ * | 24     | uint32  | interface                  |
+ * | 28     | uint32  | hop count                  |
+ * | 32     | float64 | link quality               |
+ * | 40     | float64 | queuing delay, s           |
+ * | 48     | float64 | mobility metric            |
+ * | 56     | float64 | composite score            |
+ * | 64     | int64   | expiry, absolute ns        |
+ *
+ * In delta mode the first snapshot of a node writes its whole table and later
+ * ones only the routes that were added or changed, plus a REMOVED record for
+ * each route that disappeared. Records are collected in a memory buffer and
+ * written in large blocks.
+ */
+class RtMhrSnapshotWriter : public SimpleRefCount<RtMhrSnapshotWriter>
+{
+  public:
+    /// Format version written to the header
+    static constexpr uint16_t VERSION = 1;
+    /// Size of the file header in bytes
+    static constexpr uint32_t HEADER_SIZE = 16;
+    /// Size of a record in bytes
+    static constexpr uint32_t RECORD_SIZE = 72;
+
+    /**
+     * \brief Open the snapshot file, replacing any existing one
+     * \param filename path of the file
+     * \param delta whether to write only changed routes
+     */
+    RtMhrSnapshotWriter(std::string filename, bool delta);
+
+    /// Flush and close the file
+    ~RtMhrSnapshotWriter();
+
+    /**
+     * \brief Write the marker that starts a snapshot of all nodes
+     * \param now the snapshot time
+     */
+    void BeginSnapshot(Time now);
+
+    /**
+     * \brief Write the routing table of one node
+     * \param node the node ID
+     * \param now the snapshot time
+     * \param routes every route of the node
+     */
+    void Write(uint32_t node, Time now, const std::vector<RtMhrSnapshotRecord>& routes);
+
+    /**
+     * \brief Write out the buffered records
+     */
+    void Flush();
+
+    /**
+     * \brief Flush and close the file; later writes are ignored
+     */
+    void Close();
+
+    /**
+     * \brief Check whether the file could be opened and written so far
+     * \return true if the file is good
+     */
+    bool IsGood() const
+    {
+        return m_file.good();
+    }
+
+    /**
+     * \brief Get the number of records written, markers included
+     * \return the number of records
+     */
+    uint64_t GetRecordCount() const
+    {
+        return m_records;
+    }
+
+  private:
+    /**
+     * \brief Append a record to the buffer
+     * \param node the node ID
+     * \param now the snapshot time
+     * \param kind the record kind
+     * \param route the route fields
+     */
+    void Append(uint32_t node, Time now, uint32_t kind, const RtMhrSnapshotRecord& route);
+
+    /// Last written table of a node, by destination
+    typedef std::unordered_map<uint32_t, RtMhrSnapshotRecord> Table;
+
+    std::ofstream m_file;                       ///< Output file
+    bool m_delta;                               ///< Write only changed routes
+    std::vector<uint8_t> m_buffer;              ///< Records not yet written
+    uint64_t m_records;                         ///< Records written
+    std::unordered_map<uint32_t, Table> m_last; ///< Previous table per node, delta mode
+};
+
+} // namespace ns3
+
+#endif /* RTMHR_SNAPSHOT_H */
@@ -0,0 +1,188 @@
+#include "rtmhr-stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+
+namespace ns3
+{
+
+RtMhrLatencyHistogram::RtMhrLatencyHistogram()
+    : m_count(0),
+      m_sum(0),
+      m_min(0),
+      m_max(0)
+{
+    std::fill(m_buckets, m_buckets + BUCKETS, 0);
+}
+
+void
+RtMhrLatencyHistogram::Add(Time latency)
+{
+    int64_t ns = std::max<int64_t>(latency.GetNanoSeconds(), 0);
+    m_min = m_count ? std::min(m_min, ns) : ns;
+    m_max = std::max(m_max, ns);
+    m_sum += ns;
+    m_count++;
+
+    // First bucket whose limit is above the sample, 1 ms doubling per bucket
+    uint32_t bucket = 0;
+    for (int64_t limit = 1000000; bucket < BUCKETS - 1 && ns >= limit; limit *= 2)
+    {
+        bucket++;
+    }
+    m_buckets[bucket]++;
+}
+
+void
+RtMhrLatencyHistogram::Merge(const RtMhrLatencyHistogram& other)
+{
+    if (other.m_count == 0)
+    {
+        return;
+    }
+    m_min = m_count ? std::min(m_min, other.m_min) : other.m_min;
+    m_max = std::max(m_max, other.m_max);
+    m_sum += other.m_sum;
+    m_count += other.m_count;
+    for (uint32_t i = 0; i < BUCKETS; ++i)
+    {
+        m_buckets[i] += other.m_buckets[i];
+    }
+}
+
+Time
+RtMhrLatencyHistogram::GetBucketLimit(uint32_t bucket)
+{
+    return bucket < BUCKETS - 1 ? MilliSeconds(int64_t(1) << bucket) : Time::Max();
+}
+
+Time
+RtMhrLatencyHistogram::GetMean() const
+{
+    return NanoSeconds(m_count ? m_sum / int64_t(m_count) : 0);
+}
+
+Time
+RtMhrLatencyHistogram::GetQuantile(double q) const
+{
+    if (m_count == 0)
+    {
+        return Time(0);
+    }
+    uint64_t rank = std::max<uint64_t>(1, std::ceil(std::min(1.0, std::max(0.0, q)) * m_count));
+    uint64_t seen = 0;
+    uint32_t bucket = 0;
+    for (; bucket < BUCKETS - 1; ++bucket)
+    {
+        seen += m_buckets[bucket];
+        if (seen >= rank)
+        {
+            break;
+        }
+    }
+    return std::min(GetBucketLimit(bucket), GetMax());
+}
+
+RtMhrStats::RtMhrStats()
+    : shims{0, 0},
+      discoveries(0),
+      discoveryFailures(0),
+      repairs(0),
+      repairFailures(0),
+      greedyForwards(0),
+      greedyDeadEnds(0),
+      reranks(0),
+      rankChanges(0),
+      admissions(0),
+      admissionRejects(0),
+      deadlineDrops(0),
+      routeTableSize(0),
+      neighborTableSize(0)
+{
+    std::memset(sent, 0, sizeof(sent));
+    std::memset(received, 0, sizeof(received));
+    std::memset(dropped, 0, sizeof(dropped));
+    std::fill(queueDrops, queueDrops + 3, 0);
+}
+
+RtMhrStats::Counter
+RtMhrStats::GetTotal(const Counter (&counters)[MESSAGE_TYPES])
+{
+    Counter total{0, 0};
+    for (const auto& counter : counters)
+    {
+        total.packets += counter.packets;
+        total.bytes += counter.bytes;
+    }
+    return total;
+}
+
+void
+RtMhrStats::Merge(const RtMhrStats& other)
+{
+    for (uint32_t i = 0; i < MESSAGE_TYPES; ++i)
+    {
+        sent[i].packets += other.sent[i].packets;
+        sent[i].bytes += other.sent[i].bytes;
+        received[i].packets += other.received[i].packets;
+        received[i].bytes += other.received[i].bytes;
+        dropped[i].packets += other.dropped[i].packets;
+        dropped[i].bytes += other.dropped[i].bytes;
+    }
+    shims.packets += other.shims.packets;
+    shims.bytes += other.shims.bytes;
+    discoveries += other.discoveries;
+    discoveryFailures += other.discoveryFailures;
+    discoveryLatency.Merge(other.discoveryLatency);
+    repairs += other.repairs;
+    repairFailures += other.repairFailures;
+    repairLatency.Merge(other.repairLatency);
+    greedyForwards += other.greedyForwards;
+    greedyDeadEnds += other.greedyDeadEnds;
+    reranks += other.reranks;
+    rankChanges += other.rankChanges;
+    admissions += other.admissions;
+    admissionRejects += other.admissionRejects;
+    deadlineDrops += other.deadlineDrops;
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        queueDrops[i] += other.queueDrops[i];
+    }
+    routeTableSize += other.routeTableSize;
+    neighborTableSize += other.neighborTableSize;
+}
+
+void
+RtMhrStats::Print(std::ostream& os) const
+{
+    static const char* names[MESSAGE_TYPES] =
+        {"unknown", "RREQ", "RREP", "RERR", "HELLO", "PROBE", "PREP", "ZRREQ"};
+    os << std::left << std::setw(8) << "Message" << std::right << std::setw(12) << "Sent"
+       << std::setw(12) << "bytes" << std::setw(12) << "Received" << std::setw(12) << "bytes"
+       << std::setw(12) << "Dropped" << std::setw(12) << "bytes" << std::endl;
+    for (uint32_t i = 0; i < MESSAGE_TYPES; ++i)
+    {
+        os << std::left << std::setw(8) << names[i] << std::right << std::setw(12)
+           << sent[i].packets << std::setw(12) << sent[i].bytes << std::setw(12)
+           << received[i].packets << std::setw(12) << received[i].bytes << std::setw(12)
+           << dropped[i].packets << std::setw(12) << dropped[i].bytes << std::endl;
+    }
+    os << "Shims " << shims.packets << ", bytes " << shims.bytes << std::endl;
+    os << "Discoveries " << discoveries << ", failed " << discoveryFailures << ", latency mean "
+       << discoveryLatency.GetMean().As(Time::MS) << " p95 "
+       << discoveryLatency.GetQuantile(0.95).As(Time::MS) << std::endl;
+    os << "Local repairs " << repairs << ", failed " << repairFailures << ", latency mean "
+       << repairLatency.GetMean().As(Time::MS) << " p95 "
+       << repairLatency.GetQuantile(0.95).As(Time::MS) << std::endl;
+    os << "Greedy forwards " << greedyForwards << ", dead ends " << greedyDeadEnds << std::endl;
+    os << "Route re-ranks " << reranks << ", primary changes " << rankChanges << std::endl;
+    os << "Real-time admissions " << admissions << ", rejects " << admissionRejects
+       << ", deadline drops " << deadlineDrops << std::endl;
+    os << "Queue drops high " << queueDrops[0] << ", medium " << queueDrops[1] << ", normal "
+       << queueDrops[2] << std::endl;
+    os << "Routes " << routeTableSize << ", neighbors " << neighborTableSize << std::endl;
+}
+
+} // namespace ns3
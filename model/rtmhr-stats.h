@@ -0,0 +1,242 @@
+#ifndef RTMHR_STATS_H
+#define RTMHR_STATS_H
+
+#include "rtmhr-packet.h"
+#include "rtmhr-pqueue.h"
+
+#include "ns3/nstime.h"
+
+#include <ostream>
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief Latency histogram with power-of-two millisecond buckets
+ *
+ * Bucket 0 holds latencies under 1 ms and bucket i those in
+ * [2^(i-1), 2^i) ms; the last bucket also takes everything longer.
+ */
+class RtMhrLatencyHistogram
+{
+  public:
+    /// Number of buckets
+    static constexpr uint32_t BUCKETS = 16;
+
+    RtMhrLatencyHistogram();
+
+    /**
+     * \brief Record one latency
+     * \param latency the latency
+     */
+    void Add(Time latency);
+
+    /**
+     * \brief Add the samples of another histogram to this one
+     * \param other the other histogram
+     */
+    void Merge(const RtMhrLatencyHistogram& other);
+
+    /**
+     * \brief Get the number of samples
+     * \return the number of samples
+     */
+    uint64_t GetCount() const
+    {
+        return m_count;
+    }
+
+    /**
+     * \brief Get the number of samples in a bucket
+     * \param bucket the bucket index
+     * \return the number of samples
+     */
+    uint64_t GetBucket(uint32_t bucket) const
+    {
+        return m_buckets[bucket];
+    }
+
+    /**
+     * \brief Get the upper bound of a bucket
+     * \param bucket the bucket index
+     * \return the bound, Time::Max() for the last bucket
+     */
+    static Time GetBucketLimit(uint32_t bucket);
+
+    /**
+     * \brief Get the mean latency
+     * \return the mean, zero without samples
+     */
+    Time GetMean() const;
+
+    /**
+     * \brief Get the shortest latency
+     * \return the minimum, zero without samples
+     */
+    Time GetMin() const
+    {
+        return NanoSeconds(m_count ? m_min : 0);
+    }
+
+    /**
+     * \brief Get the longest latency
+     * \return the maximum, zero without samples
+     */
+    Time GetMax() const
+    {
+        return NanoSeconds(m_max);
+    }
+
+    /**
+     * \brief Estimate a quantile from the buckets
+     * \param q the quantile, in [0, 1]
+     * \return the upper bound of the bucket holding it, capped at the maximum
+     */
+    Time GetQuantile(double q) const;
+
+  private:
+    uint64_t m_count;            ///< Samples
+    int64_t m_sum;               ///< Sum of the samples, in ns
+    int64_t m_min;               ///< Shortest sample, in ns
+    int64_t m_max;               ///< Longest sample, in ns
+    uint64_t m_buckets[BUCKETS]; ///< Samples per bucket
+};
+
+/**
+ * \ingroup rtmhr
+ * \brief Protocol counters of one RT-MHR instance
+ *
+ * Every counter is a plain integer increment on a path the protocol takes
+ * anyway, so they are always on. Message counters are indexed by MessageType,
+ * index 0 counting those that cannot be read: of unknown type or version, or
+ * cut short. RtMhr::GetStats() returns a copy; Merge() sums the copies of
+ * several nodes.
+ */
+struct RtMhrStats
+{
+    /// Size of the per message type arrays
+    static constexpr uint32_t MESSAGE_TYPES = RTMHR_ZONE_RREQ + 1;
+
+    /// Packets and bytes of one kind of control message
+    struct Counter
+    {
+        uint64_t packets; ///< Packets
+        uint64_t bytes;   ///< Bytes, RT-MHR header included
+    };
+
+    Counter sent[MESSAGE_TYPES];     ///< Control messages sent, per copy
+    Counter received[MESSAGE_TYPES]; ///< Control messages received
+    Counter dropped[MESSAGE_TYPES];  ///< Received ones discarded and failed sends
+    Counter shims;                   ///< Shims sent on data and control packets, per hop
+
+    uint64_t discoveries;                   ///< Route discoveries started
+    uint64_t discoveryFailures;             ///< Discoveries given up after RreqRetries
+    RtMhrLatencyHistogram discoveryLatency; ///< First RREQ to usable route, if found
+
+    uint64_t repairs;                    ///< Fast local repairs started
+    uint64_t repairFailures;             ///< Repairs that found no new route
+    RtMhrLatencyHistogram repairLatency; ///< Link break to new route, if found
+
+    uint64_t greedyForwards; ///< Data packets sent on towards a position, no route needed
+    uint64_t greedyDeadEnds; ///< Positions no neighbor was closer to, left to a RREQ
+
+    uint64_t reranks;     ///< Routes re-ranked after a neighbor's link metric changed
+    uint64_t rankChanges; ///< Re-ranks that made another path the primary
+
+    uint64_t admissions;       ///< Real-time flows admitted at this source
+    uint64_t admissionRejects; ///< Real-time packets refused, their path being too slow
+    uint64_t deadlineDrops;    ///< Real-time packets dropped that could not make their deadline
+
+    uint64_t queueDrops[3]; ///< Forwarded packets dropped, by TrafficPriority, highest first
+
+    uint32_t routeTableSize;    ///< Routes held when the snapshot was taken
+    uint32_t neighborTableSize; ///< Neighbors held when the snapshot was taken
+
+    RtMhrStats();
+
+    /**
+     * \brief Get the array index of a message type
+     * \param type the type read from the wire
+     * \return the type, or 0 if unknown
+     */
+    static uint32_t Index(uint32_t type)
+    {
+        return type < MESSAGE_TYPES ? type : 0;
+    }
+
+    /**
+     * \brief Count a control message sent
+     * \param type its MessageType
+     * \param bytes its size
+     */
+    void CountSent(uint32_t type, uint32_t bytes)
+    {
+        sent[Index(type)].packets++;
+        sent[Index(type)].bytes += bytes;
+    }
+
+    /**
+     * \brief Count a control message received
+     * \param type its MessageType
+     * \param bytes its size
+     */
+    void CountReceived(uint32_t type, uint32_t bytes)
+    {
+        received[Index(type)].packets++;
+        received[Index(type)].bytes += bytes;
+    }
+
+    /**
+     * \brief Count a shim sent on a data or control packet
+     * \param bytes its size
+     */
+    void CountShim(uint32_t bytes)
+    {
+        shims.packets++;
+        shims.bytes += bytes;
+    }
+
+    /**
+     * \brief Count a control message discarded
+     * \param type its MessageType
+     * \param bytes its size
+     */
+    void CountDropped(uint32_t type, uint32_t bytes)
+    {
+        dropped[Index(type)].packets++;
+        dropped[Index(type)].bytes += bytes;
+    }
+
+    /**
+     * \brief Count a forwarded packet dropped by its queue
+     * \param priority its class
+     */
+    void CountQueueDrop(TrafficPriority priority)
+    {
+        queueDrops[priority - HIGH_PRIORITY]++;
+    }
+
+    /**
+     * \brief Sum a counter array over the message types
+     * \param counters sent, received or dropped
+     * \return the total
+     */
+    static Counter GetTotal(const Counter (&counters)[MESSAGE_TYPES]);
+
+    /**
+     * \brief Add the counters of another instance to these
+     * \param other the other counters
+     */
+    void Merge(const RtMhrStats& other);
+
+    /**
+     * \brief Print the counters
+     * \param os the output stream
+     */
+    void Print(std::ostream& os) const;
+};
+
+} // namespace ns3
+
+#endif /* RTMHR_STATS_H */
@@ -0,0 +1,182 @@
+#ifndef RTMHR_TIMING_WHEEL_H
+#define RTMHR_TIMING_WHEEL_H
+
+#include "ns3/nstime.h"
+
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr
+ * \brief Hierarchical timing wheel used to expire table entries
+ *
+ * Three levels of 64 slots cover 64, 64^2 and 64^3 ticks ahead; anything further
+ * out waits in an overflow list. Schedule() is O(1), and Advance() touches only
+ * the slots of elapsed ticks plus entries cascading down a level, so a sweep costs
+ * O(expired) instead of a scan of the whole table.
+ *
+ * Items are never removed early. The owner is expected to check, when an item
+ * fires, whether the entry it names is really expired and to schedule it again at
+ * its new expiry time if it was refreshed meanwhile.
+ */
+template <typename T>
+class RtMhrTimingWheel
+{
+  public:
+    /**
+     * \brief Constructor
+     * \param resolution duration of one tick
+     */
+    RtMhrTimingWheel(Time resolution = MilliSeconds(100))
+        : m_resolution(resolution),
+          m_current(0),
+          m_size(0),
+          m_slots(LEVELS * SLOTS)
+    {
+    }
+
+    /**
+     * \brief Schedule an item
+     *
+     * Items never fire early: their expiry is rounded up to the next tick.
+     *
+     * \param item the item
+     * \param when absolute expiry time
+     */
+    void Schedule(const T& item, Time when)
+    {
+        int64_t steps = when.GetTimeStep();
+        int64_t res = m_resolution.GetTimeStep();
+        uint64_t tick = steps <= 0 ? 0 : (steps + res - 1) / res;
+        // Items already due fire on the next tick
+        Place(Item{item, tick > m_current ? tick : m_current + 1});
+        m_size++;
+    }
+
+    /**
+     * \brief Advance the wheel, firing every item due at or before now
+     * \param now the current time
+     * \param expire functor called once per fired item; it may call Schedule()
+     */
+    template <typename F>
+    void Advance(Time now, F expire)
+    {
+        uint64_t target = now.GetTimeStep() / m_resolution.GetTimeStep();
+        while (m_current < target)
+        {
+            m_current++;
+
+            // Cascade the coarser levels whose slot boundary was just reached
+            if ((m_current & MASK) == 0)
+            {
+                if (((m_current >> BITS) & MASK) == 0)
+                {
+                    if (((m_current >> (2 * BITS)) & MASK) == 0)
+                    {
+                        Cascade(m_overflow);
+                    }
+                    Cascade(m_slots[2 * SLOTS + ((m_current >> (2 * BITS)) & MASK)]);
+                }
+                Cascade(m_slots[SLOTS + ((m_current >> BITS) & MASK)]);
+            }
+
+            std::vector<Item> due;
+            due.swap(m_slots[m_current & MASK]);
+            m_size -= due.size();
+            for (const Item& i : due)
+            {
+                expire(i.item);
+            }
+        }
+    }
+
+    /**
+     * \brief Get the number of scheduled items
+     * \return the number of items
+     */
+    uint32_t GetSize() const
+    {
+        return m_size;
+    }
+
+    /**
+     * \brief Drop every scheduled item
+     */
+    void Clear()
+    {
+        for (auto& slot : m_slots)
+        {
+            slot.clear();
+        }
+        m_overflow.clear();
+        m_size = 0;
+    }
+
+  private:
+    static const uint32_t BITS = 6;           ///< log2 of slots per level
+    static const uint32_t SLOTS = 1U << BITS; ///< Slots per level
+    static const uint64_t MASK = SLOTS - 1;   ///< Slot index mask
+    static const uint32_t LEVELS = 3;         ///< Number of levels
+
+    /// A scheduled item
+    struct Item
+    {
+        T item;        ///< The item
+        uint64_t tick; ///< Expiry tick
+    };
+
+    /**
+     * \brief Put an item into the slot matching its distance from the current tick
+     *
+     * An item due on the current tick goes to the level-0 slot that is about to fire.
+     *
+     * \param i the item, with i.tick >= m_current
+     */
+    void Place(const Item& i)
+    {
+        uint64_t delta = i.tick - m_current;
+        if (delta < SLOTS)
+        {
+            m_slots[i.tick & MASK].push_back(i);
+        }
+        else if (delta < (1ULL << (2 * BITS)))
+        {
+            m_slots[SLOTS + ((i.tick >> BITS) & MASK)].push_back(i);
+        }
+        else if (delta < (1ULL << (3 * BITS)))
+        {
+            m_slots[2 * SLOTS + ((i.tick >> (2 * BITS)) & MASK)].push_back(i);
+        }
+        else
+        {
+            m_overflow.push_back(i);
+        }
+    }
+
+    /**
+     * \brief Re-place every item of a coarse slot relative to the current tick
+     * \param slot the slot to empty
+     */
+    void Cascade(std::vector<Item>& slot)
+    {
+        std::vector<Item> items;
+        items.swap(slot);
+        for (const Item& i : items)
+        {
+            Place(i);
+        }
+    }
+
+    Time m_resolution;                      ///< Duration of one tick
+    uint64_t m_current;                     ///< Last processed tick
+    uint32_t m_size;                        ///< Number of scheduled items
+    std::vector<std::vector<Item>> m_slots; ///< LEVELS x SLOTS buckets
+    std::vector<Item> m_overflow;           ///< Items beyond the last level
+};
+
+} // namespace ns3
+
+#endif /* RTMHR_TIMING_WHEEL_H */
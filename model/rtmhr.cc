@@ -2,6 +2,8 @@
 
 #include "ns3/adhoc-wifi-mac.h"
 #include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/log.h"
 #include "ns3/packet.h"
@@ -9,11 +11,15 @@
 #include "ns3/random-variable-stream.h"
 #include "ns3/simulator.h"
 #include "ns3/string.h"
+#include "ns3/tag.h"
 #include "ns3/tcp-header.h"
 #include "ns3/trace-source-accessor.h"
-#include "ns3/udp-header.h"
 #include "ns3/udp-socket-factory.h"
+#include "ns3/uinteger.h"
 #include "ns3/wifi-net-device.h"
+#include "ns3/wifi-remote-station-manager.h"
+
+#include <algorithm>
 
 #define RTMHR_PORT 654
 
@@ -27,237 +33,69 @@ namespace rtmhr
 
 /**
  * \ingroup rtmhr
- * \brief RT-MHR message header
+ * \brief Marks a packet looped back by RouteOutput() while its route is discovered
  */
-class RtMhrHeader : public Header
+class DeferredRouteOutputTag : public Tag
 {
   public:
-    RtMhrHeader(MessageType type = RTMHR_HELLO,
-                uint8_t hopCount = 0,
-                uint32_t requestId = 0,
-                Ipv4Address dst = Ipv4Address(),
-                Ipv4Address origin = Ipv4Address(),
-                double linkQuality = 0.0,
-                double delay = 0.0,
-                double mobility = 0.0);
-
     static TypeId GetTypeId();
     virtual TypeId GetInstanceTypeId() const;
-    virtual void Print(std::ostream& os) const;
-    virtual void Serialize(Buffer::Iterator start) const;
-    virtual uint32_t Deserialize(Buffer::Iterator start);
     virtual uint32_t GetSerializedSize() const;
-
-    // Getters and Setters
-    void SetMessageType(MessageType type)
-    {
-        m_type = type;
-    }
-
-    MessageType GetMessageType() const
-    {
-        return m_type;
-    }
-
-    void SetHopCount(uint8_t hopCount)
-    {
-        m_hopCount = hopCount;
-    }
-
-    uint8_t GetHopCount() const
-    {
-        return m_hopCount;
-    }
-
-    void SetRequestId(uint32_t requestId)
-    {
-        m_requestId = requestId;
-    }
-
-    uint32_t GetRequestId() const
-    {
-        return m_requestId;
-    }
-
-    void SetDestination(Ipv4Address dst)
-    {
-        m_dst = dst;
-    }
-
-    Ipv4Address GetDestination() const
-    {
-        return m_dst;
-    }
-
-    void SetOrigin(Ipv4Address origin)
-    {
-        m_origin = origin;
-    }
-
-    Ipv4Address GetOrigin() const
-    {
-        return m_origin;
-    }
-
-    void SetLinkQuality(double quality)
-    {
-        m_linkQuality = quality;
-    }
-
-    double GetLinkQuality() const
-    {
-        return m_linkQuality;
-    }
-
-    void SetDelay(double delay)
-    {
-        m_delay = delay;
-    }
-
-    double GetDelay() const
-    {
-        return m_delay;
-    }
-
-    void SetMobility(double mobility)
-    {
-        m_mobility = mobility;
-    }
-
-    double GetMobility() const
-    {
-        return m_mobility;
-    }
-
-    void SetSequenceNumber(uint32_t seqNum)
-    {
-        m_sequenceNumber = seqNum;
-    }
-
-    uint32_t GetSequenceNumber() const
-    {
-        return m_sequenceNumber;
-    }
-
-  private:
-    MessageType m_type;        ///< Message type
-    uint8_t m_hopCount;        ///< Hop count
-    uint32_t m_requestId;      ///< Request ID
-    Ipv4Address m_dst;         ///< Destination address
-    Ipv4Address m_origin;      ///< Originator address
-    double m_linkQuality;      ///< Link quality metric
-    double m_delay;            ///< Delay metric
-    double m_mobility;         ///< Mobility metric
-    uint32_t m_sequenceNumber; ///< Sequence number
+    virtual void Serialize(TagBuffer i) const;
+    virtual void Deserialize(TagBuffer i);
+    virtual void Print(std::ostream& os) const;
 };
 
-RtMhrHeader::RtMhrHeader(MessageType type,
-                         uint8_t hopCount,
-                         uint32_t requestId,
-                         Ipv4Address dst,
-                         Ipv4Address origin,
-                         double linkQuality,
-                         double delay,
-                         double mobility)
-    : m_type(type),
-      m_hopCount(hopCount),
-      m_requestId(requestId),
-      m_dst(dst),
-      m_origin(origin),
-      m_linkQuality(linkQuality),
-      m_delay(delay),
-      m_mobility(mobility),
-      m_sequenceNumber(0)
-{
-}
-
 TypeId
-RtMhrHeader::GetTypeId()
+DeferredRouteOutputTag::GetTypeId()
 {
-    static TypeId tid =
-        TypeId("ns3::rtmhr::RtMhrHeader").SetParent<Header>().AddConstructor<RtMhrHeader>();
+    static TypeId tid = TypeId("ns3::rtmhr::DeferredRouteOutputTag")
+                            .SetParent<Tag>()
+                            .AddConstructor<DeferredRouteOutputTag>();
     return tid;
 }
 
 TypeId
-RtMhrHeader::GetInstanceTypeId() const
+DeferredRouteOutputTag::GetInstanceTypeId() const
 {
     return GetTypeId();
 }
 
-void
-RtMhrHeader::Print(std::ostream& os) const
-{
-    os << "RtMhrHeader: type=" << m_type << " hopCount=" << (uint32_t)m_hopCount
-       << " requestId=" << m_requestId << " dst=" << m_dst << " origin=" << m_origin;
-}
-
 uint32_t
-RtMhrHeader::GetSerializedSize() const
+DeferredRouteOutputTag::GetSerializedSize() const
 {
-    return 1 + 1 + 4 + 4 + 4 + 8 + 8 + 8 + 4; // type + hopCount + requestId + dst + origin +
-                                              // linkQuality + delay + mobility + seqNum
+    return 0;
 }
 
 void
-RtMhrHeader::Serialize(Buffer::Iterator start) const
+DeferredRouteOutputTag::Serialize(TagBuffer i) const
 {
-    start.WriteU8(static_cast<uint8_t>(m_type));
-    start.WriteU8(m_hopCount);
-    start.WriteHtonU32(m_requestId);
-    start.WriteHtonU32(m_dst.Get());
-    start.WriteHtonU32(m_origin.Get());
-    start.WriteU64(m_linkQuality);
-    start.WriteU64(m_delay);
-    start.WriteU64(m_mobility);
-    start.WriteHtonU32(m_sequenceNumber);
 }
 
-uint32_t
-RtMhrHeader::Deserialize(Buffer::Iterator start)
+void
+DeferredRouteOutputTag::Deserialize(TagBuffer i)
 {
-    m_type = static_cast<MessageType>(start.ReadU8());
-    m_hopCount = start.ReadU8();
-    m_requestId = start.ReadNtohU32();
-    m_dst.Set(start.ReadNtohU32());
-    m_origin.Set(start.ReadNtohU32());
-    m_linkQuality = start.ReadU64();
-    m_delay = start.ReadU64();
-    m_mobility = start.ReadU64();
-    m_sequenceNumber = start.ReadNtohU32();
-
-    return GetSerializedSize();
 }
 
-} // namespace rtmhr
-
-// CrossLayerMetric implementation
-CrossLayerMetric::CrossLayerMetric()
-    : linkQuality(0.0),
-      queuingDelay(0.0),
-      mobilityMetric(0.0),
-      hopCount(0),
-      timestamp(0.0)
+void
+DeferredRouteOutputTag::Print(std::ostream& os) const
 {
+    os << "DeferredRouteOutputTag";
 }
 
-double
-CrossLayerMetric::GetCompositeMetric() const
-{
-    // Composite metric calculation with weights
-    double composite = (0.3 * linkQuality) + (0.25 * (1.0 / (queuingDelay + 0.001))) +
-                       (0.25 * (1.0 / (mobilityMetric + 0.001))) + (0.2 * (1.0 / (hopCount + 1)));
-    return composite;
-}
+} // namespace rtmhr
 
 // NeighborEntry implementation
-NeighborEntry::NeighborEntry(Ipv4Address addr)
+NeighborEntry::NeighborEntry(Ipv4Address addr, Time valid)
     : address(addr),
       lastSeen(Simulator::Now()),
       linkQuality(1.0),
       interface(0),
-      validTime(Simulator::Now() + Seconds(30))
+      validTime(valid),
+      linkExpiry(Time::Max()),
+      hasPosition(false)
 {
+    metric.linkQuality = linkQuality;
 }
 
 bool
@@ -266,14 +104,24 @@ NeighborEntry::IsExpired() const
     return Simulator::Now() > validTime;
 }
 
+void
+NeighborEntry::UpdateLinkQuality(double delivered, double gain)
+{
+    linkQuality += gain * (delivered - linkQuality);
+    metric.linkQuality = linkQuality;
+    metric.Invalidate();
+    lastFeedback = Simulator::Now();
+}
+
 // RouteEntry implementation
-RouteEntry::RouteEntry(Ipv4Address dest)
+RouteEntry::RouteEntry(Ipv4Address dest, Time valid)
     : destination(dest),
       interface(0),
       hopCount(0),
       sequenceNumber(0),
-      validTime(Simulator::Now() + Seconds(30)),
-      isPrimary(false)
+      validTime(valid),
+      isPrimary(false),
+      breakTime(Time::Max())
 {
 }
 
@@ -283,6 +131,244 @@ RouteEntry::IsExpired() const
     return Simulator::Now() > validTime;
 }
 
+bool
+RouteEntry::IsFresh(uint32_t requested) const
+{
+    return sequenceNumber != 0 && static_cast<int32_t>(sequenceNumber - requested) >= 0;
+}
+
+void
+RouteEntry::SetExpired()
+{
+    // Expired at once, not only from the next time step on
+    validTime = Simulator::Now() - TimeStep(1);
+}
+
+void
+RouteEntry::UpdateMetric(const CrossLayerMetric& newMetric)
+{
+    // Metric changes never touch nextHop/interface, so the cached route stays valid
+    metric = newMetric;
+    hopCount = newMetric.hopCount;
+}
+
+void
+RouteEntry::SetNextHop(Ipv4Address hop, uint32_t iface)
+{
+    if (hop != nextHop || iface != interface)
+    {
+        nextHop = hop;
+        gateway = hop;
+        interface = iface;
+        route = nullptr;
+    }
+}
+
+void
+RouteEntry::SetPrimary(const RoutePath& path)
+{
+    SetNextHop(path.nextHop, path.interface);
+    hopCount = path.hopCount;
+    validTime = path.validTime;
+    metric = path.metric;
+    breakTime = path.breakTime;
+    upstreamMobility = path.upstreamMobility;
+}
+
+RoutePath
+RouteEntry::GetPrimary() const
+{
+    return RoutePath{nextHop, interface, hopCount, validTime, metric, breakTime, upstreamMobility};
+}
+
+bool
+RouteEntry::OfferPath(const RoutePath& path, const RtMhrMetricEngine& engine, uint32_t maxPaths)
+{
+    // Every message received offers a path, so the candidates are ranked in
+    // backupPaths itself, whose storage outlives the call, not in a temporary
+    Time now = Simulator::Now();
+    backupPaths.erase(std::remove_if(backupPaths.begin(),
+                                     backupPaths.end(),
+                                     [&path, now](const RoutePath& p) {
+                                         return p.nextHop == path.nextHop || p.validTime < now;
+                                     }),
+                      backupPaths.end());
+
+    // Candidates in tie-breaking order: the primary (or its refresh) first
+    if (path.nextHop == nextHop)
+    {
+        backupPaths.insert(backupPaths.begin(), path);
+    }
+    else
+    {
+        if (!IsExpired())
+        {
+            backupPaths.insert(backupPaths.begin(), GetPrimary());
+        }
+        backupPaths.push_back(path);
+    }
+
+    // Insertion sort: stable, allocation-free and quickest for a few paths
+    for (auto& p : backupPaths)
+    {
+        engine.GetScore(p.metric);
+    }
+    for (size_t i = 1; i < backupPaths.size(); ++i)
+    {
+        RoutePath p = backupPaths[i];
+        size_t j = i;
+        for (; j > 0 && backupPaths[j - 1].metric.score < p.metric.score; --j)
+        {
+            backupPaths[j] = backupPaths[j - 1];
+        }
+        backupPaths[j] = p;
+    }
+    if (backupPaths.size() > std::max(maxPaths, 1U))
+    {
+        backupPaths.resize(std::max(maxPaths, 1U));
+    }
+
+    SetPrimary(backupPaths.front());
+    backupPaths.erase(backupPaths.begin());
+    return HasNextHop(path.nextHop);
+}
+
+bool
+RouteEntry::Reprice(Ipv4Address hop,
+                    double linkQuality,
+                    double mobility,
+                    const RtMhrMetricEngine& engine)
+{
+    auto reprice = [&](CrossLayerMetric& m, double upstream) {
+        m.linkQuality = linkQuality;
+        m.mobilityMetric = std::max(upstream, mobility);
+        m.Invalidate();
+        engine.GetScore(m);
+    };
+
+    bool live = !IsExpired();
+    if (nextHop == hop && live)
+    {
+        reprice(metric, upstreamMobility);
+        if (backupPaths.empty() || engine.GetScore(backupPaths.front().metric) <= metric.score)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        size_t i = 0;
+        while (i < backupPaths.size() && backupPaths[i].nextHop != hop)
+        {
+            ++i;
+        }
+        if (i == backupPaths.size())
+        {
+            return false;
+        }
+        reprice(backupPaths[i].metric, backupPaths[i].upstreamMobility);
+        if (SiftBackup(i, engine) != 0 || !live ||
+            backupPaths.front().metric.score <= engine.GetScore(metric))
+        {
+            return false;
+        }
+    }
+
+    // The best backup beats the primary: swap them and sink the old primary
+    RoutePath demoted = GetPrimary();
+    SetPrimary(backupPaths.front());
+    backupPaths.front() = demoted;
+    SiftBackup(0, engine);
+    return true;
+}
+
+size_t
+RouteEntry::SiftBackup(size_t i, const RtMhrMetricEngine& engine)
+{
+    RoutePath p = backupPaths[i];
+    double score = engine.GetScore(p.metric);
+    for (; i > 0 && engine.GetScore(backupPaths[i - 1].metric) < score; --i)
+    {
+        backupPaths[i] = backupPaths[i - 1];
+    }
+    for (; i + 1 < backupPaths.size() && engine.GetScore(backupPaths[i + 1].metric) > score; ++i)
+    {
+        backupPaths[i] = backupPaths[i + 1];
+    }
+    backupPaths[i] = p;
+    return i;
+}
+
+bool
+RouteEntry::Failover(Ipv4Address hop)
+{
+    Time now = Simulator::Now();
+    backupPaths.erase(std::remove_if(backupPaths.begin(),
+                                     backupPaths.end(),
+                                     [hop, now](const RoutePath& p) {
+                                         return p.nextHop == hop || p.validTime < now;
+                                     }),
+                      backupPaths.end());
+    if (nextHop != hop && !IsExpired())
+    {
+        return true;
+    }
+    if (backupPaths.empty())
+    {
+        SetExpired();
+        return false;
+    }
+    SetPrimary(backupPaths.front());
+    backupPaths.erase(backupPaths.begin());
+    return true;
+}
+
+const RoutePath*
+RouteEntry::FindPathAvoiding(uint32_t iface, double minScore) const
+{
+    // Backups are ranked, so the first that qualifies is the best
+    Time now = Simulator::Now();
+    for (const auto& backup : backupPaths)
+    {
+        if (backup.metric.score < minScore)
+        {
+            break;
+        }
+        if (backup.interface != iface && backup.validTime >= now)
+        {
+            return &backup;
+        }
+    }
+    return nullptr;
+}
+
+void
+RouteEntry::InsertPrecursor(Ipv4Address hop)
+{
+    if (std::find(precursors.begin(), precursors.end(), hop) == precursors.end())
+    {
+        precursors.push_back(hop);
+    }
+}
+
+bool
+RouteEntry::HasNextHop(Ipv4Address hop) const
+{
+    if (nextHop == hop && !IsExpired())
+    {
+        return true;
+    }
+    Time now = Simulator::Now();
+    for (const auto& backup : backupPaths)
+    {
+        if (backup.nextHop == hop && backup.validTime >= now)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 // RT-MHR Protocol Implementation
 NS_OBJECT_ENSURE_REGISTERED(RtMhr);
 
@@ -293,10 +379,41 @@ RtMhr::GetTypeId()
                             .SetParent<Ipv4RoutingProtocol>()
                             .AddConstructor<RtMhr>()
                             .AddAttribute("HelloInterval",
-                                          "HELLO messages emission interval.",
+                                          "Shortest HELLO interval, used while the "
+                                          "neighborhood changes.",
                                           TimeValue(Seconds(1)),
                                           MakeTimeAccessor(&RtMhr::m_helloInterval),
                                           MakeTimeChecker())
+                            .AddAttribute("MaxHelloInterval",
+                                          "Longest HELLO interval, reached while the "
+                                          "neighborhood is stable.",
+                                          TimeValue(Seconds(8)),
+                                          MakeTimeAccessor(&RtMhr::m_maxHelloInterval),
+                                          MakeTimeChecker())
+                            .AddAttribute("AllowedHelloLoss",
+                                          "Longest HELLO intervals without news from a "
+                                          "neighbor before it expires.",
+                                          UintegerValue(3),
+                                          MakeUintegerAccessor(&RtMhr::m_allowedHelloLoss),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("MobilityThreshold",
+                                          "Neighborhood mobility metric (m/s) above which "
+                                          "HELLO and PROBE intervals shrink.",
+                                          DoubleValue(1.0),
+                                          MakeDoubleAccessor(&RtMhr::m_mobilityThreshold),
+                                          MakeDoubleChecker<double>(0.0))
+                            .AddAttribute("ProbeInterval",
+                                          "Shortest interval between probes of an idle "
+                                          "neighbor link.",
+                                          TimeValue(Seconds(5)),
+                                          MakeTimeAccessor(&RtMhr::m_probeInterval),
+                                          MakeTimeChecker())
+                            .AddAttribute("MaxProbeInterval",
+                                          "Longest interval between probes of an idle "
+                                          "neighbor link.",
+                                          TimeValue(Seconds(20)),
+                                          MakeTimeAccessor(&RtMhr::m_maxProbeInterval),
+                                          MakeTimeChecker())
                             .AddAttribute("NeighborTimeout",
                                           "Validity time for neighbors.",
                                           TimeValue(Seconds(3)),
@@ -307,57 +424,405 @@ RtMhr::GetTypeId()
                                           TimeValue(Seconds(30)),
                                           MakeTimeAccessor(&RtMhr::m_routeTimeout),
                                           MakeTimeChecker())
+                            .AddAttribute("ActiveRouteTimeout",
+                                          "Lifetime each packet sent along a route grants it.",
+                                          TimeValue(Seconds(3)),
+                                          MakeTimeAccessor(&RtMhr::m_activeRouteTimeout),
+                                          MakeTimeChecker())
+                            .AddAttribute("RouteRefreshLead",
+                                          "An active route is rediscovered in the background "
+                                          "this long before it expires.",
+                                          TimeValue(Seconds(2)),
+                                          MakeTimeAccessor(&RtMhr::m_routeRefreshLead),
+                                          MakeTimeChecker())
+                            .AddAttribute("RefreshLinkQuality",
+                                          "An active route is rediscovered in the background "
+                                          "when its first link delivers less than this.",
+                                          DoubleValue(0.5),
+                                          MakeDoubleAccessor(&RtMhr::m_refreshLinkQuality),
+                                          MakeDoubleChecker<double>(0.0, 1.0))
+                            .AddAttribute("PurgeInterval",
+                                          "Interval between sweeps removing expired neighbors "
+                                          "and routes.",
+                                          TimeValue(Seconds(1)),
+                                          MakeTimeAccessor(&RtMhr::m_purgeInterval),
+                                          MakeTimeChecker())
                             .AddAttribute("FastLocalRepair",
                                           "Enable fast local repair mechanism.",
                                           BooleanValue(true),
                                           MakeBooleanAccessor(&RtMhr::m_fastLocalRepair),
                                           MakeBooleanChecker())
+                            .AddAttribute("PiggybackMetrics",
+                                          "Carry link metrics in a shim at the end of data and "
+                                          "control packets, skipping HELLOs to neighbors that "
+                                          "got them. Needs checksums off, the ns-3 default.",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&RtMhr::m_piggybackMetrics),
+                                          MakeBooleanChecker())
+                            .AddAttribute("MaxBackupPaths",
+                                          "Backup paths kept per destination besides the "
+                                          "primary, for failover without route discovery.",
+                                          UintegerValue(2),
+                                          MakeUintegerAccessor(&RtMhr::m_maxBackupPaths),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("ChannelDiversity",
+                                          "Forward on a backup path through another interface "
+                                          "than the packet came in on, so multi-radio relays "
+                                          "receive and send on different channels.",
+                                          BooleanValue(true),
+                                          MakeBooleanAccessor(&RtMhr::m_channelDiversity),
+                                          MakeBooleanChecker())
+                            .AddAttribute("ChannelDiversityMargin",
+                                          "Fraction of the primary path's score a "
+                                          "channel-diverse backup may fall short by.",
+                                          DoubleValue(0.2),
+                                          MakeDoubleAccessor(&RtMhr::m_diversityMargin),
+                                          MakeDoubleChecker<double>(0.0, 1.0))
+                            .AddAttribute("LinkQualityGain",
+                                          "EWMA gain of the per-neighbor delivery ratio "
+                                          "estimated from MAC transmit reports.",
+                                          DoubleValue(0.125),
+                                          MakeDoubleAccessor(&RtMhr::m_linkQualityGain),
+                                          MakeDoubleChecker<double>(0.0, 1.0))
                             .AddAttribute("LinkQualityWeight",
                                           "Weight for link quality in metric calculation.",
                                           DoubleValue(0.3),
-                                          MakeDoubleAccessor(&RtMhr::m_linkQualityWeight),
+                                          MakeDoubleAccessor(&RtMhr::SetLinkQualityWeight,
+                                                             &RtMhr::GetLinkQualityWeight),
                                           MakeDoubleChecker<double>())
                             .AddAttribute("DelayWeight",
                                           "Weight for delay in metric calculation.",
                                           DoubleValue(0.25),
-                                          MakeDoubleAccessor(&RtMhr::m_delayWeight),
+                                          MakeDoubleAccessor(&RtMhr::SetDelayWeight,
+                                                             &RtMhr::GetDelayWeight),
                                           MakeDoubleChecker<double>())
                             .AddAttribute("MobilityWeight",
                                           "Weight for mobility in metric calculation.",
                                           DoubleValue(0.25),
-                                          MakeDoubleAccessor(&RtMhr::m_mobilityWeight),
+                                          MakeDoubleAccessor(&RtMhr::SetMobilityWeight,
+                                                             &RtMhr::GetMobilityWeight),
                                           MakeDoubleChecker<double>())
                             .AddAttribute("HopCountWeight",
                                           "Weight for hop count in metric calculation.",
                                           DoubleValue(0.2),
-                                          MakeDoubleAccessor(&RtMhr::m_hopCountWeight),
+                                          MakeDoubleAccessor(&RtMhr::SetHopCountWeight,
+                                                             &RtMhr::GetHopCountWeight),
                                           MakeDoubleChecker<double>())
+                            .AddAttribute("TransmissionRange",
+                                          "Distance, in meters, at which links are predicted "
+                                          "to break.",
+                                          DoubleValue(250.0),
+                                          MakeDoubleAccessor(&RtMhr::SetTransmissionRange,
+                                                             &RtMhr::GetTransmissionRange),
+                                          MakeDoubleChecker<double>(1.0))
+                            .AddAttribute("GeoForwarding",
+                                          "Forward packets without a route greedily towards "
+                                          "the destination's last known position, and keep "
+                                          "its route discovery inside a request zone.",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&RtMhr::m_geoForwarding),
+                                          MakeBooleanChecker())
+                            .AddAttribute("LocationTimeout",
+                                          "How long a node position learned from a HELLO, "
+                                          "digest or zone RREQ is trusted.",
+                                          TimeValue(Seconds(30)),
+                                          MakeTimeAccessor(&RtMhr::SetLocationTimeout,
+                                                           &RtMhr::GetLocationTimeout),
+                                          MakeTimeChecker())
+                            .AddAttribute("RequestZoneMargin",
+                                          "Distance, in meters, a RREQ request zone is widened "
+                                          "by on every side.",
+                                          DoubleValue(100.0),
+                                          MakeDoubleAccessor(&RtMhr::m_zoneMargin),
+                                          MakeDoubleChecker<double>(0.0))
+                            .AddAttribute("RouteTableBackend",
+                                          "Lookup structure of the routing table.",
+                                          EnumValue(RTMHR_TABLE_HASH),
+                                          MakeEnumAccessor<RtMhrTableBackend>(
+                                              &RtMhr::SetRouteTableBackend,
+                                              &RtMhr::GetRouteTableBackend),
+                                          MakeEnumChecker(RTMHR_TABLE_HASH,
+                                                          "Hash",
+                                                          RTMHR_TABLE_FLAT,
+                                                          "Flat"))
+                            .AddAttribute("NeighborTableBackend",
+                                          "Lookup structure of the neighbor table.",
+                                          EnumValue(RTMHR_TABLE_FLAT),
+                                          MakeEnumAccessor<RtMhrTableBackend>(
+                                              &RtMhr::SetNeighborTableBackend,
+                                              &RtMhr::GetNeighborTableBackend),
+                                          MakeEnumChecker(RTMHR_TABLE_HASH,
+                                                          "Hash",
+                                                          RTMHR_TABLE_FLAT,
+                                                          "Flat"))
+                            .AddAttribute("RreqIdCacheSize",
+                                          "Maximum number of RREQs remembered for duplicate "
+                                          "suppression.",
+                                          UintegerValue(256),
+                                          MakeUintegerAccessor(&RtMhr::SetRreqIdCacheSize,
+                                                               &RtMhr::GetRreqIdCacheSize),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("RreqIdCacheLifetime",
+                                          "How long a seen RREQ suppresses its duplicates.",
+                                          TimeValue(Seconds(5)),
+                                          MakeTimeAccessor(&RtMhr::SetRreqIdCacheLifetime,
+                                                           &RtMhr::GetRreqIdCacheLifetime),
+                                          MakeTimeChecker())
+                            .AddAttribute("MaxQueueLen",
+                                          "Maximum number of packets buffered per destination "
+                                          "during route discovery.",
+                                          UintegerValue(64),
+                                          MakeUintegerAccessor(&RtMhr::SetMaxQueueLen,
+                                                               &RtMhr::GetMaxQueueLen),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("MaxQueueTime",
+                                          "Maximum time a packet is buffered during route "
+                                          "discovery.",
+                                          TimeValue(Seconds(5)),
+                                          MakeTimeAccessor(&RtMhr::SetMaxQueueTime,
+                                                           &RtMhr::GetMaxQueueTime),
+                                          MakeTimeChecker())
+                            .AddAttribute("RreqRetries",
+                                          "Maximum number of RREQ retransmissions before a "
+                                          "discovery gives up.",
+                                          UintegerValue(2),
+                                          MakeUintegerAccessor(&RtMhr::m_rreqRetries),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("RreqTimeout",
+                                          "Wait for a RREP before the first retry; doubled on "
+                                          "every retry.",
+                                          TimeValue(Seconds(1)),
+                                          MakeTimeAccessor(&RtMhr::m_rreqTimeout),
+                                          MakeTimeChecker())
+                            .AddAttribute("RreqRateLimit",
+                                          "Maximum number of RREQs originated per second.",
+                                          UintegerValue(10),
+                                          MakeUintegerAccessor(&RtMhr::m_rreqRateLimit),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("TtlStart",
+                                          "TTL of the first RREQ of an expanding-ring search.",
+                                          UintegerValue(1),
+                                          MakeUintegerAccessor(&RtMhr::m_ttlStart),
+                                          MakeUintegerChecker<uint32_t>(1, 255))
+                            .AddAttribute("TtlIncrement",
+                                          "TTL growth between expanding-ring RREQs.",
+                                          UintegerValue(2),
+                                          MakeUintegerAccessor(&RtMhr::m_ttlIncrement),
+                                          MakeUintegerChecker<uint32_t>(1, 255))
+                            .AddAttribute("TtlThreshold",
+                                          "Ring TTL past which RREQs are sent network-wide.",
+                                          UintegerValue(7),
+                                          MakeUintegerAccessor(&RtMhr::m_ttlThreshold),
+                                          MakeUintegerChecker<uint32_t>(1, 255))
+                            .AddAttribute("NetDiameter",
+                                          "Maximum number of hops a RREQ travels.",
+                                          UintegerValue(35),
+                                          MakeUintegerAccessor(&RtMhr::m_netDiameter),
+                                          MakeUintegerChecker<uint32_t>(1, 255))
+                            .AddAttribute("NodeTraversalTime",
+                                          "Per-hop estimate of the RREQ/RREP round trip, "
+                                          "to time out expanding-ring RREQs.",
+                                          TimeValue(MilliSeconds(40)),
+                                          MakeTimeAccessor(&RtMhr::m_nodeTraversalTime),
+                                          MakeTimeChecker())
+                            .AddAttribute("DestinationOnly",
+                                          "Only the destination answers RREQs, never an "
+                                          "intermediate node with a fresh route.",
+                                          BooleanValue(false),
+                                          MakeBooleanAccessor(&RtMhr::m_destinationOnly),
+                                          MakeBooleanChecker())
+                            .AddAttribute("GratuitousReply",
+                                          "An intermediate node answering a RREQ also sends "
+                                          "the destination a route to the originator.",
+                                          BooleanValue(true),
+                                          MakeBooleanAccessor(&RtMhr::m_gratuitousReply),
+                                          MakeBooleanChecker())
+                            .AddAttribute("RreqSuppression",
+                                          "Broadcast storm mitigation of RREQ rebroadcasts.",
+                                          EnumValue(RTMHR_FLOOD_ALWAYS),
+                                          MakeEnumAccessor<RtMhrFloodMode>(
+                                              &RtMhr::SetRreqFloodMode,
+                                              &RtMhr::GetRreqFloodMode),
+                                          MakeEnumChecker(RTMHR_FLOOD_ALWAYS,
+                                                          "Flood",
+                                                          RTMHR_FLOOD_COUNTER,
+                                                          "Counter",
+                                                          RTMHR_FLOOD_PROBABILISTIC,
+                                                          "Probabilistic",
+                                                          RTMHR_FLOOD_COVERAGE,
+                                                          "Coverage"))
+                            .AddAttribute("RreqCounterThreshold",
+                                          "RREQ copies, the first one included, that cancel a "
+                                          "rebroadcast in the Counter mode.",
+                                          UintegerValue(3),
+                                          MakeUintegerAccessor(&RtMhr::SetRreqCounterThreshold,
+                                                               &RtMhr::GetRreqCounterThreshold),
+                                          MakeUintegerChecker<uint32_t>(1))
+                            .AddAttribute("RreqAssessmentDelay",
+                                          "Longest random wait before a RREQ rebroadcast in the "
+                                          "Counter and Coverage modes.",
+                                          TimeValue(MilliSeconds(10)),
+                                          MakeTimeAccessor(&RtMhr::m_rreqAssessmentDelay),
+                                          MakeTimeChecker())
+                            .AddAttribute("RreqMinProbability",
+                                          "Rebroadcast probability of a RREQ from a sender next "
+                                          "to us in the Probabilistic mode, growing to 1 at "
+                                          "the transmission range.",
+                                          DoubleValue(0.4),
+                                          MakeDoubleAccessor(&RtMhr::SetRreqMinProbability,
+                                                             &RtMhr::GetRreqMinProbability),
+                                          MakeDoubleChecker<double>(0.0, 1.0))
+                            .AddAttribute("ForwardingScheduler",
+                                          "Service discipline of the forwarding queues.",
+                                          EnumValue(RTMHR_SCHED_STRICT),
+                                          MakeEnumAccessor<RtMhrScheduler>(
+                                              &RtMhr::SetForwardingScheduler,
+                                              &RtMhr::GetForwardingScheduler),
+                                          MakeEnumChecker(RTMHR_SCHED_STRICT,
+                                                          "StrictPriority",
+                                                          RTMHR_SCHED_WEIGHTED,
+                                                          "WeightedFair"))
+                            .AddAttribute("HighPriorityQueueLen",
+                                          "Forwarding queue depth for high priority traffic.",
+                                          UintegerValue(32),
+                                          MakeUintegerAccessor(&RtMhr::m_highQueueLen),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("MediumPriorityQueueLen",
+                                          "Forwarding queue depth for medium priority traffic.",
+                                          UintegerValue(64),
+                                          MakeUintegerAccessor(&RtMhr::m_mediumQueueLen),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("NormalPriorityQueueLen",
+                                          "Forwarding queue depth for normal priority traffic.",
+                                          UintegerValue(128),
+                                          MakeUintegerAccessor(&RtMhr::m_normalQueueLen),
+                                          MakeUintegerChecker<uint32_t>())
+                            .AddAttribute("RealTimeDeadline",
+                                          "Queued high priority packets older than this are "
+                                          "dropped instead of sent.",
+                                          TimeValue(MilliSeconds(100)),
+                                          MakeTimeAccessor(&RtMhr::m_realTimeDeadline),
+                                          MakeTimeChecker())
+                            .AddAttribute("DeadlineBudget",
+                                          "End-to-end delay budget of high priority packets "
+                                          "sent from this node: they carry a deadline in the "
+                                          "RT-MHR shim, are dropped by the relay that predicts "
+                                          "they will miss it, and new flows are refused over paths "
+                                          "too slow for it. Zero turns this off.",
+                                          TimeValue(Time(0)),
+                                          MakeTimeAccessor(&RtMhr::m_deadlineBudget),
+                                          MakeTimeChecker(Time(0)))
+                            .AddAttribute("LinkDelay",
+                                          "Predicted delay of one transmission over a link, "
+                                          "scaled by the link's ETX to predict deadlines.",
+                                          TimeValue(MilliSeconds(2)),
+                                          MakeTimeAccessor(&RtMhr::m_linkDelay),
+                                          MakeTimeChecker(Time(0)))
+                            .AddAttribute("ClassifierRules",
+                                          "Rules assigning forwarded packets a traffic class, "
+                                          "e.g. \"dscp=46:high;udp,port=5000-5099:medium\". "
+                                          "Unmatched packets are normal priority.",
+                                          StringValue("dscp=46:high;udp:high;tcp:medium"),
+                                          MakeStringAccessor(&RtMhr::SetClassifierRules,
+                                                             &RtMhr::GetClassifierRules),
+                                          MakeStringChecker())
                             .AddTraceSource("Tx",
-                                            "Send RT-MHR packet.",
+                                            "An RT-MHR control message was sent, once per copy.",
                                             MakeTraceSourceAccessor(&RtMhr::m_txTrace),
                                             "ns3::Packet::TracedCallback")
                             .AddTraceSource("Rx",
-                                            "Receive RT-MHR packet.",
+                                            "An RT-MHR control message was received.",
                                             MakeTraceSourceAccessor(&RtMhr::m_rxTrace),
-                                            "ns3::Packet::TracedCallback");
+                                            "ns3::Packet::TracedCallback")
+                            .AddTraceSource("ForwardQueueDelay",
+                                            "A forwarded packet left its queue.",
+                                            MakeTraceSourceAccessor(&RtMhr::m_forwardDelayTrace),
+                                            "ns3::RtMhr::ForwardDelayTracedCallback")
+                            .AddTraceSource("ForwardQueueDrop",
+                                            "A forwarded packet was dropped by its queue.",
+                                            MakeTraceSourceAccessor(&RtMhr::m_forwardDropTrace),
+                                            "ns3::RtMhr::ForwardDropTracedCallback")
+                            .AddTraceSource("ClassifierHit",
+                                            "A forwarded packet matched a classifier rule.",
+                                            MakeTraceSourceAccessor(&RtMhr::m_classifierHitTrace),
+                                            "ns3::RtMhr::ClassifierHitTracedCallback")
+                            .AddTraceSource("RouteFailover",
+                                            "A route switched to its best backup path.",
+                                            MakeTraceSourceAccessor(&RtMhr::m_routeFailoverTrace),
+                                            "ns3::RtMhr::RouteFailoverTracedCallback")
+                            .AddTraceSource("ControlDrop",
+                                            "A control message was discarded or could not be "
+                                            "sent.",
+                                            MakeTraceSourceAccessor(&RtMhr::m_controlDropTrace),
+                                            "ns3::RtMhr::ControlDropTracedCallback")
+                            .AddTraceSource("RouteDiscovery",
+                                            "A route discovery found a route or gave up.",
+                                            MakeTraceSourceAccessor(&RtMhr::m_routeDiscoveryTrace),
+                                            "ns3::RtMhr::RouteDiscoveryTracedCallback")
+                            .AddTraceSource("LocalRepair",
+                                            "A fast local repair found a route or gave up.",
+                                            MakeTraceSourceAccessor(&RtMhr::m_localRepairTrace),
+                                            "ns3::RtMhr::RouteDiscoveryTracedCallback")
+                            .AddTraceSource("RouteTableSize",
+                                            "Number of routes held.",
+                                            MakeTraceSourceAccessor(&RtMhr::m_routeTableSize),
+                                            "ns3::TracedValueCallback::Uint32");
     return tid;
 }
 
 RtMhr::RtMhr()
-    : m_helloTimer(Timer::CANCEL_ON_DESTROY),
+    : m_routeTable(RTMHR_TABLE_HASH),
+      m_neighborTable(RTMHR_TABLE_FLAT),
+      m_helloTimer(Timer::CANCEL_ON_DESTROY),
       m_probeTimer(Timer::CANCEL_ON_DESTROY),
       m_purgeTimer(Timer::CANCEL_ON_DESTROY),
+      m_rreqTimer(Timer::CANCEL_ON_DESTROY),
       m_helloInterval(Seconds(1)),
+      m_maxHelloInterval(Seconds(8)),
+      m_allowedHelloLoss(3),
+      m_mobilityThreshold(1.0),
       m_neighborTimeout(Seconds(3)),
       m_routeTimeout(Seconds(30)),
+      m_activeRouteTimeout(Seconds(3)),
+      m_routeRefreshLead(Seconds(2)),
+      m_refreshLinkQuality(0.5),
       m_probeInterval(Seconds(5)),
+      m_maxProbeInterval(Seconds(20)),
+      m_purgeInterval(Seconds(1)),
       m_fastLocalRepair(true),
+      m_piggybackMetrics(false),
+      m_dormant(false),
+      m_maxBackupPaths(2),
+      m_channelDiversity(true),
+      m_diversityMargin(0.2),
+      m_linkQualityGain(0.125),
+      m_rreqRetries(2),
+      m_rreqTimeout(Seconds(1)),
+      m_rreqRateLimit(10),
+      m_ttlStart(1),
+      m_ttlIncrement(2),
+      m_ttlThreshold(7),
+      m_netDiameter(35),
+      m_nodeTraversalTime(MilliSeconds(40)),
+      m_destinationOnly(false),
+      m_gratuitousReply(true),
+      m_rreqAssessmentDelay(MilliSeconds(10)),
+      m_scheduler(RTMHR_SCHED_STRICT),
+      m_highQueueLen(32),
+      m_mediumQueueLen(64),
+      m_normalQueueLen(128),
+      m_realTimeDeadline(MilliSeconds(100)),
+      m_geoForwarding(false),
+      m_zoneMargin(100.0),
+      m_deadlineBudget(Time(0)),
+      m_linkDelay(MilliSeconds(2)),
+      m_sendingControl(false),
       m_requestId(0),
       m_sequenceNumber(0),
-      m_linkQualityWeight(0.3),
-      m_delayWeight(0.25),
-      m_mobilityWeight(0.25),
-      m_hopCountWeight(0.2)
+      m_rreqIdCache(256, Seconds(5)),
+      m_queue(64, Seconds(5)),
+      m_rreqCount(0),
+      m_queuingDelay(0.0)
 {
     m_uniformRandomVariable = CreateObject<UniformRandomVariable>();
 }
@@ -370,11 +835,17 @@ void
 RtMhr::DoDispose()
 {
     m_ipv4 = 0;
+    m_lo = 0;
+    m_queue.Clear();
+    m_forwardQueues.clear();
+    m_drainTimers.clear();
+    m_drainBackoff.clear();
     for (auto iter = m_socketAddresses.begin(); iter != m_socketAddresses.end(); iter++)
     {
         iter->first->Close();
     }
     m_socketAddresses.clear();
+    m_interfaceSockets.clear();
     Ipv4RoutingProtocol::DoDispose();
 }
 
@@ -385,8 +856,22 @@ RtMhr::SetIpv4(Ptr<Ipv4> ipv4)
     NS_ASSERT(!m_ipv4);
     m_ipv4 = ipv4;
 
+    // Interface 0 is always the loopback device
+    m_lo = m_ipv4->GetNetDevice(0);
+    NS_ASSERT(m_lo);
+
+    // In a distributed simulation a node belongs to one rank; the copies the
+    // other ranks hold of it must stay silent
+    Ptr<Node> node = m_ipv4->GetObject<Node>();
+    m_dormant = node->GetSystemId() != Simulator::GetSystemId();
+    if (m_dormant)
+    {
+        NS_LOG_LOGIC("Node " << node->GetId() << " runs on rank " << node->GetSystemId());
+        return;
+    }
+
     // Start protocol after delay
-    Simulator::ScheduleWithContext(m_ipv4->GetObject<Node>()->GetId(),
+    Simulator::ScheduleWithContext(node->GetId(),
                                    Seconds(m_uniformRandomVariable->GetValue(0, 1)),
                                    &RtMhr::Start,
                                    this);
@@ -403,18 +888,26 @@ RtMhr::Start()
     m_recvSocket->Bind(local);
     m_recvSocket->SetRecvCallback(MakeCallback(&RtMhr::RecvRtMhr, this));
     m_recvSocket->SetAllowBroadcast(true);
+    m_recvSocket->SetRecvPktInfo(true);
+    m_recvSocket->SetIpRecvTtl(true);
+
+    m_rreqTimer.SetFunction(&RtMhr::RouteRequestHeapExpire, this);
 
     // Set up hello timer
+    m_helloScheduler.SetBounds(m_helloInterval, m_maxHelloInterval);
+    m_helloScheduler.SetMobilityThreshold(m_mobilityThreshold);
     m_helloTimer.SetFunction(&RtMhr::HelloTimerExpire, this);
-    m_helloTimer.Schedule(m_helloInterval);
+    m_helloTimer.Schedule(Jitter(m_helloScheduler.GetInterval()));
 
     // Set up probe timer
+    m_probeScheduler.SetBounds(m_probeInterval, m_maxProbeInterval);
+    m_probeScheduler.SetMobilityThreshold(m_mobilityThreshold);
     m_probeTimer.SetFunction(&RtMhr::ProbeTimerExpire, this);
-    m_probeTimer.Schedule(m_probeInterval);
+    m_probeTimer.Schedule(Jitter(m_probeScheduler.GetInterval()));
 
     // Set up purge timer
     m_purgeTimer.SetFunction(&RtMhr::PurgeTimerExpire, this);
-    m_purgeTimer.Schedule(Seconds(1));
+    m_purgeTimer.Schedule(m_purgeInterval);
 }
 
 void
@@ -431,11 +924,24 @@ RtMhr::Stop()
         m_recvSocket = 0;
     }
 
-    for (auto& timer : m_rreqTimers)
+    m_rreqTimer.Cancel();
+    m_rreqDeadlines.clear();
+    m_realTimeFlows.clear();
+    m_rreqHeap = RreqHeap();
+    m_rreqAttempts.clear();
+    m_rreqTtl.clear();
+    m_discoveryStart.clear();
+    m_repairs.clear();
+    m_floodControl.Clear();
+    m_queue.Clear();
+
+    for (auto& timer : m_drainTimers)
     {
         timer.second.Cancel();
     }
-    m_rreqTimers.clear();
+    m_drainTimers.clear();
+    m_drainBackoff.clear();
+    m_forwardQueues.clear();
 }
 
 Ptr<Ipv4Route>
@@ -462,59 +968,137 @@ RtMhr::RouteOutput(Ptr<Packet> p,
     Ipv4Address dst = header.GetDestination();
     NS_LOG_DEBUG("Looking for route to " << dst);
 
+    // The protocol's own messages are never real-time data; relays read the
+    // deadline of those that are from the shim
+    bool realTime = !m_sendingControl && IsRealTime(header);
+    rtmhr::RtMhrShim shim;
+    if (realTime)
+    {
+        shim.SetDeadline(Simulator::Now() + m_deadlineBudget);
+    }
+
     // Check if destination is in routing table
-    auto routeIter = m_routeTable.find(dst);
-    if (routeIter != m_routeTable.end() && !routeIter->second.IsExpired())
-    {
-        Ptr<Ipv4Route> route = Create<Ipv4Route>();
-        route->SetDestination(dst);
-        route->SetGateway(routeIter->second.nextHop);
-        route->SetSource(GetAddressForInterface(routeIter->second.interface));
-        route->SetOutputDevice(GetNetDeviceForInterface(routeIter->second.interface));
+    RouteEntry* rt = FindLiveRoute(dst);
+    if (rt)
+    {
+        if (realTime && !AdmitRealTimeFlow(*rt))
+        {
+            sockerr = Socket::ERROR_NOROUTETOHOST;
+            return Ptr<Ipv4Route>();
+        }
         sockerr = Socket::ERROR_NOTERROR;
-        NS_LOG_DEBUG("Found route to " << dst << " via " << routeIter->second.nextHop);
+        NS_LOG_DEBUG("Found route to " << dst << " via " << rt->nextHop);
+        // The refresh may send a RREQ, which can move the entry, so it comes last
+        Ptr<Ipv4Route> route = GetCachedRoute(*rt);
+        RefreshActiveRoute(*rt, true);
+        StampShim(p,
+                  shim,
+                  route->GetSource(),
+                  route->GetGateway(),
+                  route->GetOutputDevice()->GetMtu() - SHIM_HEADROOM);
         return route;
     }
 
+    // Location-aided mode: a destination whose position is known is headed for
+    // through the neighbor closest to it, and discovered only where none is closer
+    Vector target;
+    double radius;
+    bool located = m_geoForwarding && m_locationTable.Lookup(dst, target, radius);
+    if (located && realTime)
+    {
+        // A greedy hop predicts nothing of the path beyond it, so real-time
+        // flows are only admitted on a discovered route
+        NS_LOG_DEBUG("Real-time packet to " << dst << " waits for a route to admit it on");
+    }
+    else if (located)
+    {
+        Ptr<Ipv4Route> route = GetGreedyRoute(target);
+        if (route)
+        {
+            NS_LOG_DEBUG("Forwarding to " << dst << " towards " << target << " via "
+                                          << route->GetGateway());
+            m_stats.greedyForwards++;
+            // Tells relays that know nothing of the destination where it is
+            shim.SetTarget(target);
+            sockerr = Socket::ERROR_NOTERROR;
+            StampShim(p,
+                      shim,
+                      route->GetSource(),
+                      route->GetGateway(),
+                      route->GetOutputDevice()->GetMtu() - SHIM_HEADROOM);
+            return route;
+        }
+        NS_LOG_DEBUG("No neighbor closer to " << dst << " at " << target);
+        m_stats.greedyDeadEnds++;
+    }
+
     // No route found, try to create a direct route for same subnet
     NS_LOG_DEBUG("No route found for " << dst << ", checking for direct connectivity");
 
-    // Check if destination is on same subnet as any of our interfaces
+    // Only a neighbor on the same subnet as one of our interfaces is sent to
+    // directly: in a single-subnet MANET every destination shares the subnet,
+    // and the others must be discovered. A located destination is known not
+    // to be a neighbor
+    bool neighbor = !located && m_neighborTable.Find(dst);
     for (auto& addr : m_socketAddresses)
     {
         Ipv4InterfaceAddress iaddr = addr.second;
-        if (dst.IsSubnetDirectedBroadcast(iaddr.GetMask()) ||
-            dst.GetSubnetDirectedBroadcast(iaddr.GetMask()) ==
-                iaddr.GetLocal().GetSubnetDirectedBroadcast(iaddr.GetMask()))
+        if (!located && (dst.IsSubnetDirectedBroadcast(iaddr.GetMask()) ||
+                         (neighbor && dst.GetSubnetDirectedBroadcast(iaddr.GetMask()) ==
+                                          iaddr.GetLocal().GetSubnetDirectedBroadcast(
+                                              iaddr.GetMask()))))
         {
-            // Destination is on same subnet, create direct route
+            // Destination is a neighbor on the same subnet, create direct route
             RouteEntry entry;
             entry.destination = dst;
             entry.nextHop = dst; // Direct route
             entry.interface = GetInterfaceForDevice(addr.first->GetBoundNetDevice());
-            entry.metric = CrossLayerMetric();                // Default metric
-            entry.validTime = Simulator::Now() + Seconds(30); // 30 second lifetime
-
-            m_routeTable[dst] = entry;
-
-            // Create and return the route
-            Ptr<Ipv4Route> route = Create<Ipv4Route>();
-            route->SetDestination(dst);
-            route->SetGateway(dst); // Direct route
-            route->SetSource(iaddr.GetLocal());
-            route->SetOutputDevice(addr.first->GetBoundNetDevice());
+            entry.hopCount = 1;
+            entry.metric = CrossLayerMetric(); // Default metric
+            entry.validTime = Simulator::Now() + m_routeTimeout;
+
+            // Build the route once and keep it with the entry for later packets
+            entry.route = Create<Ipv4Route>();
+            entry.route->SetDestination(dst);
+            entry.route->SetGateway(dst); // Direct route
+            entry.route->SetSource(iaddr.GetLocal());
+            entry.route->SetOutputDevice(addr.first->GetBoundNetDevice());
+
+            // The link to a neighbor is a path like any other; a broadcast
+            // has no single path to predict, so it is not admitted
+            RouteEntry& stored = AddRoute(entry);
+            if (realTime && !dst.IsSubnetDirectedBroadcast(iaddr.GetMask()) &&
+                !AdmitRealTimeFlow(stored))
+            {
+                sockerr = Socket::ERROR_NOROUTETOHOST;
+                return Ptr<Ipv4Route>();
+            }
             sockerr = Socket::ERROR_NOTERROR;
+            StampShim(p,
+                      shim,
+                      iaddr.GetLocal(),
+                      dst,
+                      entry.route->GetOutputDevice()->GetMtu() - SHIM_HEADROOM);
 
             NS_LOG_DEBUG("Created direct route to " << dst);
-            return route;
+            return entry.route;
         }
     }
 
-    // If we can't create a direct route, initiate route discovery
-    SendRouteRequest(dst);
-
-    sockerr = Socket::ERROR_NOROUTETOHOST;
-    return Ptr<Ipv4Route>();
+    // No route yet: loop the packet back through RouteInput(), where it waits in the
+    // request queue while the route is discovered. Its deadline waits with it,
+    // the rest of the shim is added once the next hop is known
+    if (!shim.IsEmpty() && !Node::ChecksumEnabled())
+    {
+        p->AddTrailer(shim);
+    }
+    rtmhr::DeferredRouteOutputTag tag;
+    if (!p->PeekPacketTag(tag))
+    {
+        p->AddPacketTag(tag);
+    }
+    sockerr = Socket::ERROR_NOTERROR;
+    return LoopbackRoute(header, oif);
 }
 
 bool
@@ -537,66 +1121,138 @@ RtMhr::RouteInput(Ptr<const Packet> p,
     NS_ASSERT(m_ipv4);
     NS_ASSERT(p);
 
+    // Packet deferred by RouteOutput()
+    if (idev == m_lo)
+    {
+        rtmhr::DeferredRouteOutputTag tag;
+        if (p->PeekPacketTag(tag))
+        {
+            DeferredRouteOutput(p, header, ucb, ecb);
+            return true;
+        }
+    }
+
     int32_t iif = m_ipv4->GetInterfaceForDevice(idev);
     NS_ASSERT(iif >= 0);
 
+    // Control messages included, so this is the one place digests are read
+    rtmhr::RtMhrShim shim;
+    bool shimmed = PeekShim(p, header, shim);
+    if (shimmed && shim.HasDigest() && UseMetricDigests())
+    {
+        RecvMetricDigest(shim, iif);
+    }
+
     Ipv4Address dst = header.GetDestination();
     Ipv4Address origin = header.GetSource();
 
-    // Check if packet is for local delivery
+    // Check if packet is for local delivery; RT-MHR control messages reach
+    // m_recvSocket this way too, so nothing but the shim is parsed here
     if (m_ipv4->IsDestinationAddress(dst, iif))
     {
-        if (dst.IsLocalhost())
-        {
-            lcb(p, header, iif);
-            return true;
-        }
-
-        // Check if it's an RT-MHR control packet
-        if (header.GetProtocol() == 17) // UDP protocol number
+        if (shimmed)
         {
+            // The transport layer takes the datagram length from the header
             Ptr<Packet> packet = p->Copy();
-            UdpHeader udpHeader;
-            packet->RemoveHeader(udpHeader);
-
-            if (udpHeader.GetDestinationPort() == RTMHR_PORT)
-            {
-                // It's an RT-MHR control packet, process it
-                Ptr<Socket> fakeSocket = nullptr;
-                RecvRtMhr(fakeSocket);
-                return true;
-            }
+            packet->RemoveTrailer(shim);
+            Ipv4Header stripped = header;
+            stripped.SetPayloadSize(packet->GetSize());
+            lcb(packet, stripped, iif);
+            return true;
         }
-
         lcb(p, header, iif);
         return true;
     }
 
-    // Packet needs to be forwarded
-    return ForwardPacketTo(p, header, ucb, ecb);
+    // Packet needs to be forwarded, the shim with it until its next hop is known
+    return ForwardPacketTo(p, header, iif, ucb, ecb);
+}
+
+void
+RtMhr::DeferredRouteOutput(Ptr<const Packet> p,
+                           const Ipv4Header& header,
+                           const UnicastForwardCallback& ucb,
+                           const ErrorCallback& ecb)
+{
+    NS_LOG_FUNCTION(this << p->GetUid() << header.GetDestination());
+
+    Ptr<Packet> packet = p->Copy();
+    rtmhr::DeferredRouteOutputTag tag;
+    packet->RemovePacketTag(tag);
+    m_queue.Enqueue(packet, header, ucb, ecb);
+
+    // The route may have been found while the packet was looping back
+    Ipv4Address dst = header.GetDestination();
+    if (FindLiveRoute(dst))
+    {
+        SendPacketFromQueue(dst);
+        return;
+    }
+    SendRouteRequest(dst);
 }
 
 bool
 RtMhr::ForwardPacketTo(Ptr<const Packet> p,
                        const Ipv4Header& header,
+                       uint32_t iif,
                        const UnicastForwardCallback& ucb,
                        const ErrorCallback& ecb)
 {
-    NS_LOG_FUNCTION(this << p->GetUid() << header.GetDestination());
+    NS_LOG_FUNCTION(this << p->GetUid() << header.GetDestination() << iif);
 
     Ipv4Address dst = header.GetDestination();
 
-    // Look for route in routing table
-    auto routeIter = m_routeTable.find(dst);
-    if (routeIter != m_routeTable.end() && !routeIter->second.IsExpired())
+    // Look for route in routing table, failing over to a backup path if need be
+    RouteEntry* rt = FindLiveRoute(dst);
+    if (rt)
     {
-        Ptr<Ipv4Route> route = Create<Ipv4Route>();
-        route->SetDestination(dst);
-        route->SetGateway(routeIter->second.nextHop);
-        route->SetSource(GetAddressForInterface(routeIter->second.interface));
-        route->SetOutputDevice(GetNetDeviceForInterface(routeIter->second.interface));
+        RefreshActiveRoute(*rt, false);
+        Ptr<Ipv4Route> route = GetCachedRoute(*rt);
 
-        ucb(route, p, header);
+        // A relay sending on the channel it receives on halves its throughput;
+        // a nearly as good path on another radio avoids that
+        if (m_channelDiversity && rt->interface == iif && m_socketAddresses.size() > 1)
+        {
+            const RoutePath* path =
+                rt->FindPathAvoiding(iif, rt->metric.score * (1.0 - m_diversityMargin));
+            if (path)
+            {
+                NS_LOG_LOGIC("Forwarding to " << dst << " via " << path->nextHop
+                                              << " on interface " << path->interface);
+                route = GetDiverseRoute(*rt, *path);
+            }
+        }
+        ForwardPacket(p, header, route, ucb, ecb);
+        return true;
+    }
+
+    // A route under local repair is only down for a discovery's time; its
+    // traffic waits for the new path instead of being dropped
+    if (m_repairs.find(dst) != m_repairs.end())
+    {
+        NS_LOG_LOGIC("Buffering packet to " << dst << " during local repair");
+        m_queue.Enqueue(p->Copy(), header, ucb, ecb);
+        return true;
+    }
+
+    // Location-aided mode: a packet headed for a position moves on greedily,
+    // and where no neighbor is closer it waits here for a route discovery
+    Vector target;
+    if (m_geoForwarding && GetGeoTarget(p, header, target))
+    {
+        Ptr<Ipv4Route> route = GetGreedyRoute(target);
+        if (route)
+        {
+            NS_LOG_LOGIC("Forwarding to " << dst << " towards " << target << " via "
+                                          << route->GetGateway());
+            m_stats.greedyForwards++;
+            ForwardPacket(p, header, route, ucb, ecb);
+            return true;
+        }
+        NS_LOG_DEBUG("No neighbor closer to " << dst << " at " << target << ", discovering");
+        m_stats.greedyDeadEnds++;
+        m_queue.Enqueue(p->Copy(), header, ucb, ecb);
+        SendRouteRequest(dst);
         return true;
     }
 
@@ -605,6 +1261,66 @@ RtMhr::ForwardPacketTo(Ptr<const Packet> p,
     return false;
 }
 
+bool
+RtMhr::GetGeoTarget(Ptr<const Packet> p, const Ipv4Header& header, Vector& target) const
+{
+    // Our own news of the destination may be fresher than the source's
+    double radius;
+    if (m_locationTable.Lookup(header.GetDestination(), target, radius))
+    {
+        return true;
+    }
+    rtmhr::RtMhrShim shim;
+    if (PeekShim(p, header, shim) && shim.HasTarget())
+    {
+        target = shim.GetTarget();
+        return true;
+    }
+    return false;
+}
+
+Ptr<Ipv4Route>
+RtMhr::GetGreedyRoute(const Vector& target)
+{
+    Vector position;
+    Vector velocity;
+    if (!GetLocalMotion(position, velocity))
+    {
+        return nullptr;
+    }
+
+    // Strict progress keeps a packet from going round in circles as long as
+    // the nodes agree on where they are
+    Time now = Simulator::Now();
+    double best = CalculateDistance(position, target);
+    RouteEntry* next = nullptr;
+    for (const auto& iter : m_neighborTable)
+    {
+        const NeighborEntry& neighbor = iter.second;
+        if (neighbor.IsExpired() || !neighbor.hasPosition)
+        {
+            continue;
+        }
+        Vector there = RtMhrMobilityPredictor::Extrapolate(neighbor.position,
+                                                           neighbor.velocity,
+                                                           now - neighbor.positionTime);
+        double distance = CalculateDistance(there, target);
+        if (distance >= best)
+        {
+            continue;
+        }
+        RouteEntry* hop = FindLiveRoute(neighbor.address);
+        if (hop && hop->nextHop == neighbor.address)
+        {
+            best = distance;
+            next = hop;
+        }
+    }
+    // Only the gateway and device of a route are used on the way out, so the
+    // cached one-hop route to the neighbor will do
+    return next ? GetCachedRoute(*next) : nullptr;
+}
+
 Ptr<NetDevice>
 RtMhr::GetNetDeviceFromContext() const
 {
@@ -616,8 +1332,42 @@ RtMhr::GetNetDeviceFromContext() const
 void
 RtMhr::NotifyTxOk(const WifiMacHeader& hdr)
 {
-    // Callback for successful transmissions - used for link quality estimation
     NS_LOG_FUNCTION(this);
+
+    // Every acknowledged unicast data frame is a free link quality sample
+    Ipv4Address addr;
+    if (hdr.IsData() && !hdr.GetAddr1().IsGroup() && m_macCache.Lookup(hdr.GetAddr1(), addr))
+    {
+        UpdateLinkQuality(addr, 1.0);
+    }
+}
+
+void
+RtMhr::NotifyTxFailed(Mac48Address mac)
+{
+    NS_LOG_FUNCTION(this << mac);
+
+    // Reported once per unacknowledged attempt, so retries lower the estimate too
+    Ipv4Address addr;
+    if (m_macCache.Lookup(mac, addr))
+    {
+        UpdateLinkQuality(addr, 0.0);
+    }
+}
+
+void
+RtMhr::NotifyTxFinalFailed(Mac48Address mac)
+{
+    NS_LOG_FUNCTION(this << mac);
+
+    // The MAC gave up on the frame: treat the link as broken now rather than
+    // waiting for the neighbor to time out
+    Ipv4Address addr;
+    if (m_macCache.Lookup(mac, addr))
+    {
+        NS_LOG_DEBUG("Link to " << addr << " failed at the MAC layer");
+        HandleLinkFailure(addr);
+    }
 }
 
 Ptr<Ipv4Route>
@@ -628,7 +1378,7 @@ RtMhr::LoopbackRoute(const Ipv4Header& hdr, Ptr<NetDevice> oif) const
     rt->SetDestination(hdr.GetDestination());
 
     // Source address selection
-    uint32_t iif = (oif ? m_ipv4->GetInterfaceForDevice(oif) : -1);
+    int32_t iif = (oif ? m_ipv4->GetInterfaceForDevice(oif) : -1);
 
     // Single interface simple case
     if (m_ipv4->GetNInterfaces() == 1)
@@ -636,7 +1386,7 @@ RtMhr::LoopbackRoute(const Ipv4Header& hdr, Ptr<NetDevice> oif) const
         Ipv4InterfaceAddress addr = m_ipv4->GetAddress(0, 0);
         rt->SetSource(addr.GetLocal());
         rt->SetGateway(Ipv4Address("127.0.0.1"));
-        rt->SetOutputDevice(m_ipv4->GetNetDevice(0));
+        rt->SetOutputDevice(m_lo);
         return rt;
     }
 
@@ -646,21 +1396,73 @@ RtMhr::LoopbackRoute(const Ipv4Header& hdr, Ptr<NetDevice> oif) const
         Ipv4InterfaceAddress addr = m_ipv4->GetAddress(iif, 0);
         rt->SetSource(addr.GetLocal());
     }
+    else if (!m_socketAddresses.empty())
+    {
+        // Deferred packets must leave with a routable source address
+        rt->SetSource(m_socketAddresses.begin()->second.GetLocal());
+    }
     else
     {
         rt->SetSource(m_ipv4->GetAddress(0, 0).GetLocal());
     }
 
     rt->SetGateway(Ipv4Address("127.0.0.1"));
-    rt->SetOutputDevice(oif ? oif : m_ipv4->GetNetDevice(0));
+    rt->SetOutputDevice(m_lo);
     return rt;
 }
 
+Ptr<Ipv4Route>
+RtMhr::GetCachedRoute(RouteEntry& entry) const
+{
+    if (!entry.route)
+    {
+        entry.route = Create<Ipv4Route>();
+        entry.route->SetDestination(entry.destination);
+        entry.route->SetGateway(entry.nextHop);
+        entry.route->SetSource(GetAddressForInterface(entry.interface));
+        entry.route->SetOutputDevice(GetNetDeviceForInterface(entry.interface));
+    }
+    return entry.route;
+}
+
+Ptr<Ipv4Route>
+RtMhr::GetDiverseRoute(RouteEntry& entry, const RoutePath& path) const
+{
+    // Flows through a relay keep to the same backup, so one cached route will do
+    Ptr<NetDevice> dev = GetNetDeviceForInterface(path.interface);
+    if (!entry.diverseRoute || entry.diverseRoute->GetGateway() != path.nextHop ||
+        entry.diverseRoute->GetOutputDevice() != dev)
+    {
+        entry.diverseRoute = Create<Ipv4Route>();
+        entry.diverseRoute->SetDestination(entry.destination);
+        entry.diverseRoute->SetGateway(path.nextHop);
+        entry.diverseRoute->SetSource(GetAddressForInterface(path.interface));
+        entry.diverseRoute->SetOutputDevice(dev);
+    }
+    return entry.diverseRoute;
+}
+
+void
+RtMhr::InvalidateCachedRoutes()
+{
+    // Interface addresses changed: source address/device of every cached route may be stale
+    for (auto& iter : m_routeTable)
+    {
+        iter.second.route = nullptr;
+        iter.second.diverseRoute = nullptr;
+    }
+}
+
 void
 RtMhr::NotifyInterfaceUp(uint32_t i)
 {
     NS_LOG_FUNCTION(this << m_ipv4->GetAddress(i, 0).GetLocal());
 
+    if (m_dormant)
+    {
+        return;
+    }
+
     Ptr<Ipv4L3Protocol> l3 = m_ipv4->GetObject<Ipv4L3Protocol>();
     if (l3->GetNAddresses(i) > 1)
     {
@@ -673,16 +1475,7 @@ RtMhr::NotifyInterfaceUp(uint32_t i)
         return;
     }
 
-    // Create a socket for this interface
-    Ptr<Socket> socket = Socket::CreateSocket(GetObject<Node>(), UdpSocketFactory::GetTypeId());
-    NS_ASSERT(socket);
-    socket->SetRecvCallback(MakeCallback(&RtMhr::RecvRtMhr, this));
-    socket->BindToNetDevice(l3->GetNetDevice(i));
-    socket->Bind(InetSocketAddress(Ipv4Address::GetAny(), RTMHR_PORT));
-    socket->SetAllowBroadcast(true);
-    socket->SetIpRecvTtl(true);
-
-    m_socketAddresses.insert(std::make_pair(socket, iface));
+    CreateInterfaceSocket(i, iface);
 
     // Allow neighbor layer access
     Ptr<NetDevice> dev = m_ipv4->GetNetDevice(i);
@@ -697,27 +1490,74 @@ RtMhr::NotifyInterfaceUp(uint32_t i)
                 mac->TraceConnectWithoutContext("TxOkHeader",
                                                 MakeCallback(&RtMhr::NotifyTxOk, this));
             }
+            Ptr<WifiRemoteStationManager> manager = wifi->GetRemoteStationManager();
+            if (manager)
+            {
+                manager->TraceConnectWithoutContext("MacTxDataFailed",
+                                                    MakeCallback(&RtMhr::NotifyTxFailed, this));
+                manager->TraceConnectWithoutContext(
+                    "MacTxFinalDataFailed",
+                    MakeCallback(&RtMhr::NotifyTxFinalFailed, this));
+            }
         }
     }
 }
 
+Ptr<Socket>
+RtMhr::CreateInterfaceSocket(uint32_t interface, Ipv4InterfaceAddress iface)
+{
+    NS_LOG_FUNCTION(this << interface << iface);
+
+    // Bound to the interface's device, so what it sends leaves on that radio
+    // and what it receives tells the interface it came in on
+    Ptr<Socket> socket = Socket::CreateSocket(GetObject<Node>(), UdpSocketFactory::GetTypeId());
+    NS_ASSERT(socket);
+    socket->SetRecvCallback(MakeCallback(&RtMhr::RecvRtMhr, this));
+    socket->BindToNetDevice(m_ipv4->GetNetDevice(interface));
+    socket->Bind(InetSocketAddress(Ipv4Address::GetAny(), RTMHR_PORT));
+    socket->SetAllowBroadcast(true);
+    socket->SetIpRecvTtl(true);
+
+    m_socketAddresses.insert(std::make_pair(socket, iface));
+    if (interface >= m_interfaceSockets.size())
+    {
+        m_interfaceSockets.resize(interface + 1);
+    }
+    m_interfaceSockets[interface] = socket;
+    return socket;
+}
+
+void
+RtMhr::CloseInterfaceSocket(Ptr<Socket> socket)
+{
+    NS_LOG_FUNCTION(this << socket);
+
+    // By search: the address, and with it the interface index, may already be gone
+    socket->Close();
+    m_socketAddresses.erase(socket);
+    std::replace(m_interfaceSockets.begin(), m_interfaceSockets.end(), socket, Ptr<Socket>());
+}
+
 void
 RtMhr::NotifyInterfaceDown(uint32_t i)
 {
     NS_LOG_FUNCTION(this << m_ipv4->GetAddress(i, 0).GetLocal());
 
-    // Close socket and remove from map
-    Ptr<Socket> socket = FindSocketWithInterfaceAddress(m_ipv4->GetAddress(i, 0));
+    Ptr<Socket> socket = GetSocketForInterface(i);
     NS_ASSERT(socket);
-    socket->Close();
-    m_socketAddresses.erase(socket);
+    CloseInterfaceSocket(socket);
+    InvalidateCachedRoutes();
 
     if (m_socketAddresses.empty())
     {
         NS_LOG_LOGIC("No RT-MHR interfaces");
         Stop();
-        m_routeTable.clear();
-        m_neighborTable.clear();
+        m_routeTable.Clear();
+        m_routeIndex.Clear();
+        m_routeTableSize = 0;
+        m_neighborTable.Clear();
+        m_routeExpiry.Clear();
+        m_neighborExpiry.Clear();
         return;
     }
 }
@@ -727,7 +1567,7 @@ RtMhr::NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address)
 {
     NS_LOG_FUNCTION(this << " interface " << interface << " address " << address);
     Ptr<Ipv4L3Protocol> l3 = m_ipv4->GetObject<Ipv4L3Protocol>();
-    if (!l3->IsUp(interface))
+    if (m_dormant || !l3->IsUp(interface))
     {
         return;
     }
@@ -743,14 +1583,8 @@ RtMhr::NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address)
                 return;
             }
 
-            Ptr<Socket> socket =
-                Socket::CreateSocket(GetObject<Node>(), UdpSocketFactory::GetTypeId());
-            NS_ASSERT(socket);
-            socket->SetRecvCallback(MakeCallback(&RtMhr::RecvRtMhr, this));
-            socket->BindToNetDevice(l3->GetNetDevice(interface));
-            socket->Bind(InetSocketAddress(Ipv4Address::GetAny(), RTMHR_PORT));
-            socket->SetAllowBroadcast(true);
-            m_socketAddresses.insert(std::make_pair(socket, iface));
+            CreateInterfaceSocket(interface, iface);
+            InvalidateCachedRoutes();
         }
     }
     else
@@ -767,29 +1601,26 @@ RtMhr::NotifyRemoveAddress(uint32_t i, Ipv4InterfaceAddress address)
     Ptr<Socket> socket = FindSocketWithInterfaceAddress(address);
     if (socket)
     {
-        socket->Close();
-        m_socketAddresses.erase(socket);
+        CloseInterfaceSocket(socket);
+        InvalidateCachedRoutes();
 
+        // Create a socket for the remaining address
         Ptr<Ipv4L3Protocol> l3 = m_ipv4->GetObject<Ipv4L3Protocol>();
         if (l3->GetNAddresses(i))
         {
-            Ipv4InterfaceAddress iface = l3->GetAddress(i, 0);
-            // Create a socket for the remaining address
-            socket = Socket::CreateSocket(GetObject<Node>(), UdpSocketFactory::GetTypeId());
-            NS_ASSERT(socket);
-            socket->SetRecvCallback(MakeCallback(&RtMhr::RecvRtMhr, this));
-            socket->BindToNetDevice(l3->GetNetDevice(i));
-            socket->Bind(InetSocketAddress(Ipv4Address::GetAny(), RTMHR_PORT));
-            socket->SetAllowBroadcast(true);
-            m_socketAddresses.insert(std::make_pair(socket, iface));
+            CreateInterfaceSocket(i, l3->GetAddress(i, 0));
         }
 
         if (m_socketAddresses.empty())
         {
             NS_LOG_LOGIC("No RT-MHR interfaces");
             Stop();
-            m_routeTable.clear();
-            m_neighborTable.clear();
+            m_routeTable.Clear();
+            m_routeIndex.Clear();
+            m_routeTableSize = 0;
+            m_neighborTable.Clear();
+            m_routeExpiry.Clear();
+            m_neighborExpiry.Clear();
             return;
         }
     }
@@ -809,19 +1640,14 @@ RtMhr::PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
 
     *stream->GetStream() << "Destination\tNext Hop\tInterface\tMetric\tExpiry" << std::endl;
 
+    std::ostream& os = *stream->GetStream();
     for (auto iter = m_routeTable.begin(); iter != m_routeTable.end(); ++iter)
     {
-        std::ostringstream dest, gw, interface, metric, expiry;
-        dest << iter->second.destination;
-        gw << iter->second.nextHop;
-        interface << iter->second.interface;
-        metric << iter->second.metric.GetCompositeMetric();
-        expiry << std::max(Seconds(0), iter->second.validTime - Now()).As(unit);
-
-        *stream->GetStream() << dest.str() << "\t" << gw.str() << "\t" << interface.str() << "\t"
-                             << metric.str() << "\t" << expiry.str() << std::endl;
+        os << iter->second.destination << "\t" << iter->second.nextHop << "\t"
+           << iter->second.interface << "\t" << m_metricEngine.Compute(iter->second.metric)
+           << "\t" << std::max(Seconds(0), iter->second.validTime - Now()).As(unit) << "\n";
     }
-    *stream->GetStream() << std::endl;
+    os << std::endl;
 }
 
 int64_t
@@ -832,4 +1658,36 @@ RtMhr::AssignStreams(int64_t stream)
     return 1;
 }
 
+RtMhrStats
+RtMhr::GetStats() const
+{
+    RtMhrStats stats = m_stats;
+    stats.routeTableSize = m_routeTable.GetSize();
+    stats.neighborTableSize = m_neighborTable.GetSize();
+    return stats;
+}
+
+void
+RtMhr::WriteSnapshot(Ptr<RtMhrSnapshotWriter> writer) const
+{
+    std::vector<RtMhrSnapshotRecord> routes;
+    routes.reserve(m_routeTable.GetSize());
+    for (auto iter = m_routeTable.begin(); iter != m_routeTable.end(); ++iter)
+    {
+        const RouteEntry& entry = iter->second;
+        RtMhrSnapshotRecord record;
+        record.destination = entry.destination;
+        record.nextHop = entry.nextHop;
+        record.interface = entry.interface;
+        record.hopCount = entry.hopCount;
+        record.linkQuality = entry.metric.linkQuality;
+        record.queuingDelay = entry.metric.queuingDelay;
+        record.mobilityMetric = entry.metric.mobilityMetric;
+        record.score = m_metricEngine.Compute(entry.metric);
+        record.expiry = entry.validTime;
+        routes.push_back(record);
+    }
+    writer->Write(m_ipv4->GetObject<Node>()->GetId(), Now(), routes);
+}
+
 } // namespace ns3
@@ -1,6 +1,23 @@
 #ifndef RTMHR_H
 #define RTMHR_H
 
+#include "rtmhr-beacon.h"
+#include "rtmhr-classifier.h"
+#include "rtmhr-flood.h"
+#include "rtmhr-id-cache.h"
+#include "rtmhr-location.h"
+#include "rtmhr-mac-cache.h"
+#include "rtmhr-metric.h"
+#include "rtmhr-mobility.h"
+#include "rtmhr-packet.h"
+#include "rtmhr-pqueue.h"
+#include "rtmhr-route-index.h"
+#include "rtmhr-rqueue.h"
+#include "rtmhr-rtable.h"
+#include "rtmhr-snapshot.h"
+#include "rtmhr-stats.h"
+#include "rtmhr-timing-wheel.h"
+
 #include "ns3/callback.h"
 #include "ns3/ipv4-interface.h"
 #include "ns3/ipv4-l3-protocol.h"
@@ -16,12 +33,14 @@
 #include "ns3/socket.h"
 #include "ns3/timer.h"
 #include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
 #include "ns3/wifi-mac-header.h"
 #include "ns3/wifi-net-device.h"
 
+#include <algorithm>
 #include <list>
 #include <map>
-#include <set>
+#include <queue>
 #include <vector>
 
 /**
@@ -34,75 +53,74 @@ namespace ns3
 
 /**
  * \ingroup rtmhr
- * \brief RT-MHR Message Types
- */
-enum MessageType
-{
-    RTMHR_RREQ = 1,  ///< Route Request
-    RTMHR_RREP = 2,  ///< Route Reply
-    RTMHR_RERR = 3,  ///< Route Error
-    RTMHR_HELLO = 4, ///< Hello message for neighbor discovery
-    RTMHR_PROBE = 5, ///< Link quality probe
-    RTMHR_PREP = 6   ///< Path Repair message
-};
-
-/**
- * \ingroup rtmhr
- * \brief Traffic Priority Levels
+ * \brief Neighbor Table Entry
  */
-enum TrafficPriority
+struct NeighborEntry
 {
-    HIGH_PRIORITY = 1,   ///< High priority traffic (real-time)
-    MEDIUM_PRIORITY = 2, ///< Medium priority traffic
-    NORMAL_PRIORITY = 3  ///< Normal priority traffic
-};
+    Ipv4Address address;
+    Time lastSeen;
+    double linkQuality;
+    uint32_t interface;
+    CrossLayerMetric metric;
+    Time validTime;
+    Mac48Address hardwareAddress; ///< MAC address, once learned from ARP
+    Time lastFeedback;            ///< Last MAC-layer report on a frame sent to it
+    Time lastAdvertised;          ///< Last metric digest piggybacked to it
+    Vector position;              ///< Advertised position, at positionTime
+    Vector velocity;              ///< Advertised velocity
+    Time positionTime;            ///< When position was advertised
+    Time linkExpiry;              ///< Predicted link break, Time::Max() if none
+    Time lastReranked;            ///< Last re-rank of the routes through it
+    bool hasPosition;             ///< Whether the neighbor advertised its position
 
-/**
- * \ingroup rtmhr
- * \brief Cross-layer Route Metric structure
- */
-struct CrossLayerMetric
-{
-    double linkQuality;    ///< Link quality (0-1)
-    double queuingDelay;   ///< Queuing delay in seconds
-    double mobilityMetric; ///< Mobility prediction metric
-    uint32_t hopCount;     ///< Number of hops
-    double timestamp;      ///< Last update timestamp
+    NeighborEntry() = default;
+    /**
+     * \brief Constructor
+     * \param addr the neighbor's address
+     * \param valid when the entry expires unless the neighbor is heard again
+     */
+    NeighborEntry(Ipv4Address addr, Time valid);
+    bool IsExpired() const;
 
     /**
-     * \brief Calculate composite metric
-     * \return Combined metric value
+     * \brief Fold one transmission attempt into the delivery ratio estimate
+     * \param delivered 1 if the attempt was acknowledged, 0 if it failed
+     * \param gain EWMA gain
      */
-    double GetCompositeMetric() const;
+    void UpdateLinkQuality(double delivered, double gain);
 
     /**
-     * \brief Default constructor
+     * \brief Get the expected transmission count of the link
+     * \return 1 / delivery ratio, capped at 100
      */
-    CrossLayerMetric();
+    double GetEtx() const
+    {
+        return 1.0 / std::max(linkQuality, 0.01);
+    }
 };
 
 /**
  * \ingroup rtmhr
- * \brief Neighbor Table Entry
+ * \brief One candidate path towards a destination
  */
-struct NeighborEntry
+struct RoutePath
 {
-    Ipv4Address address;
-    Time lastSeen;
-    double linkQuality;
-    uint32_t interface;
-    CrossLayerMetric metric;
-    Time validTime;
-
-    NeighborEntry() = default;
-    NeighborEntry(Ipv4Address addr);
-    bool IsExpired() const;
-    void UpdateLinkQuality(double quality);
+    Ipv4Address nextHop;     ///< First hop of the path
+    uint32_t interface;      ///< Output interface towards nextHop
+    uint32_t hopCount;       ///< Number of hops
+    Time validTime;          ///< Expiry time
+    CrossLayerMetric metric; ///< Path metric, scored by RtMhrMetricEngine
+    Time breakTime;          ///< Predicted break, Time::Max() if none
+    double upstreamMobility; ///< Mobility metric of the path beyond its first link
 };
 
 /**
  * \ingroup rtmhr
  * \brief Route Table Entry with multi-path support
+ *
+ * The primary path lives in the entry's own fields; backupPaths holds the next
+ * best paths through other next hops, best first, so a failed primary is
+ * replaced by promoting backupPaths.front() without any route discovery.
  */
 struct RouteEntry
 {
@@ -115,15 +133,129 @@ struct RouteEntry
     Time validTime;
     bool isPrimary;
     CrossLayerMetric metric;
-    std::vector<Ipv4Address> backupPaths;
+    std::vector<RoutePath> backupPaths; ///< Ranked alternatives to the primary path
+    Ptr<Ipv4Route> route; ///< Cached output route, rebuilt when nextHop/interface change
+    Time breakTime; ///< Predicted break of the primary path, Time::Max() if none
+    Time lastUsed;                      ///< Last packet sent along the route
+    Time nextRefresh;                   ///< Earliest time for another background discovery
+    Ptr<Ipv4Route> diverseRoute;        ///< Cached route of the last channel-diverse path
+    double upstreamMobility = 0.0;      ///< Mobility metric of the primary beyond its first link
+    std::vector<Ipv4Address> precursors; ///< Neighbors routing to the destination through us
 
     RouteEntry() = default;
-    RouteEntry(Ipv4Address dest);
+    /**
+     * \brief Constructor, without a next hop
+     * \param dest the destination
+     * \param valid when the entry expires unless refreshed
+     */
+    RouteEntry(Ipv4Address dest, Time valid);
     bool IsExpired() const;
     void SetExpired();
     void UpdateMetric(const CrossLayerMetric& newMetric);
+
+    /**
+     * \brief Check whether the route is as fresh as a RREQ demands
+     * \param requested destination sequence number in the RREQ, 0 if unknown
+     * \return true if the route's sequence number is known and, wrap-around
+     *         considered, not older than requested
+     */
+    bool IsFresh(uint32_t requested) const;
+
+    /**
+     * \brief Change the next hop and drop the cached route if it no longer applies
+     * \param hop the new next hop
+     * \param iface the new output interface
+     */
+    void SetNextHop(Ipv4Address hop, uint32_t iface);
+
+    /**
+     * \brief Make a path the primary one, replacing the current primary fields
+     * \param path the path
+     */
+    void SetPrimary(const RoutePath& path);
+
+    /**
+     * \brief Get the primary path
+     * \return the primary path
+     */
+    RoutePath GetPrimary() const;
+
+    /**
+     * \brief Rank a newly learned path against the known ones
+     *
+     * A path through a next hop already known replaces it. The live paths are
+     * then ranked by composite score, the current primary winning ties, and the
+     * best maxPaths are kept with the best one as primary.
+     *
+     * \param path the path
+     * \param engine the scoring engine
+     * \param maxPaths number of paths kept, primary included
+     * \return true if the path was kept
+     */
+    bool OfferPath(const RoutePath& path, const RtMhrMetricEngine& engine, uint32_t maxPaths);
+
+    /**
+     * \brief Refresh the first-link terms of the path through a next hop
+     * and restore the ranking
+     *
+     * Only the repriced path moves, so the ranking is restored in one pass
+     * over the few paths; a backup that now beats the primary takes its
+     * place, the primary winning ties as in OfferPath().
+     *
+     * \param hop the next hop
+     * \param linkQuality delivery ratio of the link to it
+     * \param mobility mobility metric of the link to it
+     * \param engine the scoring engine
+     * \return true if another path became the primary
+     */
+    bool Reprice(Ipv4Address hop,
+                 double linkQuality,
+                 double mobility,
+                 const RtMhrMetricEngine& engine);
+
+    /**
+     * \brief Forget the paths through a next hop, promoting the best backup if
+     * it was the primary or the primary has expired
+     * \param hop the failed next hop
+     * \return false if no live path is left, in which case the entry is expired
+     */
+    bool Failover(Ipv4Address hop);
+
+    /**
+     * \brief Remember a neighbor that routes to the destination through us
+     * \param hop the neighbor, told with a RERR when the route breaks
+     */
+    void InsertPrecursor(Ipv4Address hop);
+
+    /**
+     * \brief Check whether a next hop is the primary or a backup
+     * \param hop the next hop
+     * \return true if a live path goes through it
+     */
+    bool HasNextHop(Ipv4Address hop) const;
+
+    /**
+     * \brief Find the best live backup path leaving on another interface
+     * \param iface the interface to avoid
+     * \param minScore lowest composite score accepted
+     * \return the path, or nullptr if none qualifies
+     */
+    const RoutePath* FindPathAvoiding(uint32_t iface, double minScore) const;
+
+    /**
+     * \brief Move a backup whose score changed to its rank
+     * \param i its index in backupPaths
+     * \param engine the scoring engine
+     * \return its new index
+     */
+    size_t SiftBackup(size_t i, const RtMhrMetricEngine& engine);
 };
 
+/// Main routing table keyed by destination
+typedef RtMhrTable<RouteEntry> RtMhrRoutingTable;
+/// Neighbor table keyed by neighbor address
+typedef RtMhrTable<NeighborEntry> RtMhrNeighborTable;
+
 /**
  * \ingroup rtmhr
  * \brief RT-MHR Routing Protocol implementation
@@ -147,6 +279,57 @@ class RtMhr : public Ipv4RoutingProtocol
      */
     virtual ~RtMhr();
 
+    /**
+     * TracedCallback signature for packets leaving the forwarding queue
+     * \param [in] packet the packet
+     * \param [in] priority its TrafficPriority
+     * \param [in] sojourn time it spent queued
+     */
+    typedef void (*ForwardDelayTracedCallback)(Ptr<const Packet> packet,
+                                               uint32_t priority,
+                                               Time sojourn);
+
+    /**
+     * TracedCallback signature for packets dropped by the forwarding queue
+     * \param [in] packet the packet
+     * \param [in] priority its TrafficPriority
+     */
+    typedef void (*ForwardDropTracedCallback)(Ptr<const Packet> packet, uint32_t priority);
+
+    /**
+     * TracedCallback signature for forwarded packets matched by a classifier rule
+     * \param [in] rule index of the rule in ClassifierRules
+     * \param [in] hits packets the rule has matched so far, this one included
+     */
+    typedef void (*ClassifierHitTracedCallback)(uint32_t rule, uint64_t hits);
+
+    /**
+     * TracedCallback signature for routes switched to a backup path
+     * \param [in] destination the route destination
+     * \param [in] failed the next hop given up
+     * \param [in] nextHop the next hop now used
+     */
+    typedef void (*RouteFailoverTracedCallback)(Ipv4Address destination,
+                                                Ipv4Address failed,
+                                                Ipv4Address nextHop);
+
+    /**
+     * TracedCallback signature for control messages discarded or not sent
+     * \param [in] packet the message
+     * \param [in] type its MessageType, 0 if unknown
+     */
+    typedef void (*ControlDropTracedCallback)(Ptr<const Packet> packet, uint32_t type);
+
+    /**
+     * TracedCallback signature for finished route discoveries and local repairs
+     * \param [in] destination the route destination
+     * \param [in] latency time since the discovery or repair started
+     * \param [in] found whether a route was found
+     */
+    typedef void (*RouteDiscoveryTracedCallback)(Ipv4Address destination,
+                                                 Time latency,
+                                                 bool found);
+
     // Inherited from Ipv4RoutingProtocol
     virtual Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p,
                                        const Ipv4Header& header,
@@ -221,36 +404,553 @@ class RtMhr : public Ipv4RoutingProtocol
         m_fastLocalRepair = enable;
     }
 
+    /**
+     * \brief Set the lookup backend of the routing table
+     * \param backend the backend
+     */
+    void SetRouteTableBackend(RtMhrTableBackend backend)
+    {
+        m_routeTable.SetBackend(backend);
+    }
+
+    /**
+     * \brief Get the lookup backend of the routing table
+     * \return the backend
+     */
+    RtMhrTableBackend GetRouteTableBackend() const
+    {
+        return m_routeTable.GetBackend();
+    }
+
+    /**
+     * \brief Set the lookup backend of the neighbor table
+     * \param backend the backend
+     */
+    void SetNeighborTableBackend(RtMhrTableBackend backend)
+    {
+        m_neighborTable.SetBackend(backend);
+    }
+
+    /**
+     * \brief Get the lookup backend of the neighbor table
+     * \return the backend
+     */
+    RtMhrTableBackend GetNeighborTableBackend() const
+    {
+        return m_neighborTable.GetBackend();
+    }
+
+    /**
+     * \brief Set the capacity of the duplicate RREQ cache
+     * \param size maximum number of remembered requests
+     */
+    void SetRreqIdCacheSize(uint32_t size)
+    {
+        m_rreqIdCache.SetCapacity(size);
+    }
+
+    /**
+     * \brief Get the capacity of the duplicate RREQ cache
+     * \return maximum number of remembered requests
+     */
+    uint32_t GetRreqIdCacheSize() const
+    {
+        return m_rreqIdCache.GetCapacity();
+    }
+
+    /**
+     * \brief Set how long a seen RREQ suppresses its duplicates
+     * \param lifetime the record lifetime
+     */
+    void SetRreqIdCacheLifetime(Time lifetime)
+    {
+        m_rreqIdCache.SetLifetime(lifetime);
+    }
+
+    /**
+     * \brief Get how long a seen RREQ suppresses its duplicates
+     * \return the record lifetime
+     */
+    Time GetRreqIdCacheLifetime() const
+    {
+        return m_rreqIdCache.GetLifetime();
+    }
+
+    /**
+     * \brief Set the RREQ rebroadcast discipline
+     * \param mode the discipline
+     */
+    void SetRreqFloodMode(RtMhrFloodMode mode)
+    {
+        m_floodControl.SetMode(mode);
+    }
+
+    /**
+     * \brief Get the RREQ rebroadcast discipline
+     * \return the discipline
+     */
+    RtMhrFloodMode GetRreqFloodMode() const
+    {
+        return m_floodControl.GetMode();
+    }
+
+    /**
+     * \brief Set how many RREQ copies cancel a rebroadcast in the counter mode
+     * \param threshold copies heard, the first one included
+     */
+    void SetRreqCounterThreshold(uint32_t threshold)
+    {
+        m_floodControl.SetCounterThreshold(threshold);
+    }
+
+    /**
+     * \brief Get how many RREQ copies cancel a rebroadcast in the counter mode
+     * \return copies heard, the first one included
+     */
+    uint32_t GetRreqCounterThreshold() const
+    {
+        return m_floodControl.GetCounterThreshold();
+    }
+
+    /**
+     * \brief Set the rebroadcast probability of the closest senders in the probabilistic mode
+     * \param probability the probability
+     */
+    void SetRreqMinProbability(double probability)
+    {
+        m_floodControl.SetMinProbability(probability);
+    }
+
+    /**
+     * \brief Get the rebroadcast probability of the closest senders in the probabilistic mode
+     * \return the probability
+     */
+    double GetRreqMinProbability() const
+    {
+        return m_floodControl.GetMinProbability();
+    }
+
+    /**
+     * \brief Set how many packets are buffered per destination during route discovery
+     * \param len maximum number of packets
+     */
+    void SetMaxQueueLen(uint32_t len)
+    {
+        m_queue.SetMaxQueueLen(len);
+    }
+
+    /**
+     * \brief Get how many packets are buffered per destination during route discovery
+     * \return maximum number of packets
+     */
+    uint32_t GetMaxQueueLen() const
+    {
+        return m_queue.GetMaxQueueLen();
+    }
+
+    /**
+     * \brief Set how long a packet is buffered during route discovery
+     * \param t the buffering timeout
+     */
+    void SetMaxQueueTime(Time t)
+    {
+        m_queue.SetQueueTimeout(t);
+    }
+
+    /**
+     * \brief Get how long a packet is buffered during route discovery
+     * \return the buffering timeout
+     */
+    Time GetMaxQueueTime() const
+    {
+        return m_queue.GetQueueTimeout();
+    }
+
+    /**
+     * \brief Set the service discipline of the forwarding queues
+     * \param scheduler the discipline
+     */
+    void SetForwardingScheduler(RtMhrScheduler scheduler);
+
+    /**
+     * \brief Get the service discipline of the forwarding queues
+     * \return the discipline
+     */
+    RtMhrScheduler GetForwardingScheduler() const
+    {
+        return m_scheduler;
+    }
+
+    /**
+     * \brief Set the traffic classifier rules
+     * \param rules the rules, in the RtMhrClassifier syntax
+     */
+    void SetClassifierRules(const std::string& rules);
+
+    /**
+     * \brief Get the traffic classifier rules
+     * \return the rules
+     */
+    std::string GetClassifierRules() const
+    {
+        return m_classifier.GetRules();
+    }
+
+    /**
+     * \brief Set the CRM weight of link quality
+     * \param weight the weight
+     */
+    void SetLinkQualityWeight(double weight)
+    {
+        m_metricEngine.SetWeight(RtMhrMetricEngine::LINK_QUALITY, weight);
+    }
+
+    /**
+     * \brief Get the CRM weight of link quality
+     * \return the weight
+     */
+    double GetLinkQualityWeight() const
+    {
+        return m_metricEngine.GetWeight(RtMhrMetricEngine::LINK_QUALITY);
+    }
+
+    /**
+     * \brief Set the CRM weight of delay
+     * \param weight the weight
+     */
+    void SetDelayWeight(double weight)
+    {
+        m_metricEngine.SetWeight(RtMhrMetricEngine::DELAY, weight);
+    }
+
+    /**
+     * \brief Get the CRM weight of delay
+     * \return the weight
+     */
+    double GetDelayWeight() const
+    {
+        return m_metricEngine.GetWeight(RtMhrMetricEngine::DELAY);
+    }
+
+    /**
+     * \brief Set the CRM weight of mobility
+     * \param weight the weight
+     */
+    void SetMobilityWeight(double weight)
+    {
+        m_metricEngine.SetWeight(RtMhrMetricEngine::MOBILITY, weight);
+    }
+
+    /**
+     * \brief Get the CRM weight of mobility
+     * \return the weight
+     */
+    double GetMobilityWeight() const
+    {
+        return m_metricEngine.GetWeight(RtMhrMetricEngine::MOBILITY);
+    }
+
+    /**
+     * \brief Set the CRM weight of hop count
+     * \param weight the weight
+     */
+    void SetHopCountWeight(double weight)
+    {
+        m_metricEngine.SetWeight(RtMhrMetricEngine::HOP_COUNT, weight);
+    }
+
+    /**
+     * \brief Get the CRM weight of hop count
+     * \return the weight
+     */
+    double GetHopCountWeight() const
+    {
+        return m_metricEngine.GetWeight(RtMhrMetricEngine::HOP_COUNT);
+    }
+
+    /**
+     * \brief Set the range used to predict link breaks
+     * \param range transmission range in meters
+     */
+    void SetTransmissionRange(double range)
+    {
+        m_mobilityPredictor.SetRange(range);
+    }
+
+    /**
+     * \brief Get the range used to predict link breaks
+     * \return transmission range in meters
+     */
+    double GetTransmissionRange() const
+    {
+        return m_mobilityPredictor.GetRange();
+    }
+
+    /**
+     * \brief Set how long a learned node position is trusted
+     * \param lifetime the lifetime
+     */
+    void SetLocationTimeout(Time lifetime)
+    {
+        m_locationTable.SetLifetime(lifetime);
+    }
+
+    /**
+     * \brief Get how long a learned node position is trusted
+     * \return the lifetime
+     */
+    Time GetLocationTimeout() const
+    {
+        return m_locationTable.GetLifetime();
+    }
+
+    /**
+     * \brief Tell the protocol where a stationary node is, such as a road-side unit
+     * \param node an address of the node
+     * \param position its position, never expired
+     *
+     * With GeoForwarding set, packets to the node are forwarded greedily
+     * towards the position and its route discoveries stay in a request zone.
+     * RtMhrHelper::AddKnownPosition() sets it on every protocol it creates.
+     */
+    void SetKnownPosition(Ipv4Address node, const Vector& position)
+    {
+        m_locationTable.SetFixed(node, position);
+    }
+
+    /**
+     * \brief Get the last known node positions
+     * \return the location table
+     */
+    const RtMhrLocationTable& GetLocationTable() const
+    {
+        return m_locationTable;
+    }
+
+    /**
+     * \brief Get the CRM scoring engine
+     * \return the engine
+     */
+    const RtMhrMetricEngine& GetMetricEngine() const
+    {
+        return m_metricEngine;
+    }
+
+    /**
+     * \brief Get the smoothed time forwarded packets spend queued
+     * \return the queuing delay in seconds
+     */
+    double GetQueuingDelay() const
+    {
+        return m_queuingDelay;
+    }
+
+    /**
+     * \brief Get the routing table
+     * \return the routing table
+     */
+    const RtMhrRoutingTable& GetRoutingTable() const
+    {
+        return m_routeTable;
+    }
+
+    /**
+     * \brief Get the neighbor table
+     * \return the neighbor table
+     */
+    const RtMhrNeighborTable& GetNeighborTable() const
+    {
+        return m_neighborTable;
+    }
+
+    /**
+     * \brief Get the queue of packets waiting for a route discovery
+     * \return the request queue
+     */
+    const RtMhrRequestQueue& GetRequestQueue() const
+    {
+        return m_queue;
+    }
+
+    /**
+     * \brief Get the index of routes by next hop
+     * \return the index
+     */
+    const RtMhrRouteIndex& GetRouteIndex() const
+    {
+        return m_routeIndex;
+    }
+
+    /**
+     * \brief Get a snapshot of the protocol counters
+     * \return the counters, with the current table sizes
+     */
+    RtMhrStats GetStats() const;
+
+    /**
+     * \brief Append the routing table to a binary snapshot
+     * \param writer the snapshot writer of the run
+     *
+     * A compact alternative to PrintRoutingTable() for periodic dumps; see
+     * RtMhrHelper::EnableSnapshots().
+     */
+    void WriteSnapshot(Ptr<RtMhrSnapshotWriter> writer) const;
+
   protected:
     virtual void DoDispose() override;
 
   private:
+    /// Drives the private hot paths directly, see examples/rtmhr-microbenchmark.cc
+    friend class RtMhrMicroBenchmark;
+    /// Uses hand-made routes, see test/rtmhr-test-suite.cc
+    friend class RtMhrRouteRefreshTestCase;
+    /// Starts discoveries directly, see test/rtmhr-test-suite.cc
+    friend class RtMhrRouteRequestHeapTestCase;
+
+    /// Receive handler of one message type, see RecvRtMhr()
+    typedef void (RtMhr::*MessageHandler)(Ptr<Packet> packet,
+                                          const rtmhr::RtMhrHeader& header,
+                                          Ipv4Address sender,
+                                          uint32_t interface);
+
     // Core Protocol Functions
     void Start();
     void Stop();
 
     // Route Discovery
     void RouteRequestTimerExpire(Ipv4Address dst);
+
+    /**
+     * \brief Set or move the RREQ retry deadline of a destination
+     * \param dst the destination
+     * \param delay time until the retry
+     */
+    void ScheduleRouteRequest(Ipv4Address dst, Time delay);
+
+    /**
+     * \brief Drop the RREQ retry deadline of a destination
+     * \param dst the destination
+     */
+    void CancelRouteRequest(Ipv4Address dst);
+
+    /**
+     * \brief Check whether a RREQ retry is pending for a destination
+     * \param dst the destination
+     * \return true if a deadline is set
+     */
+    bool IsRouteRequestPending(Ipv4Address dst) const;
+
+    /// Run the RREQ retries that are due and rearm m_rreqTimer for the next one
+    void RouteRequestHeapExpire();
+
     void SendRouteRequest(Ipv4Address destination);
-    void RecvRouteRequest(Ptr<Packet> packet, Ipv4Address src, Ipv4Address dst);
-    void SendRouteReply(Ipv4Address destination, Ipv4Address source, Ipv4Address nextHop);
-    void RecvRouteReply(Ptr<Packet> packet, Ipv4Address src, Ipv4Address dst);
+    void RecvRouteRequest(Ptr<Packet> packet,
+                          const rtmhr::RtMhrHeader& header,
+                          Ipv4Address sender,
+                          uint32_t interface);
+    void SendRouteReply(Ipv4Address destination,
+                        Ipv4Address source,
+                        Ipv4Address nextHop,
+                        uint32_t requestedSeqNo = 0);
+    void SendReplyByIntermediateNode(const RouteEntry& toDst,
+                                     const RouteEntry& toOrigin,
+                                     Ipv4Address nextHop);
+    uint32_t GetRequestTtl(Ipv4Address destination);
+    void FloodRouteRequest(const rtmhr::RtMhrHeader& forward, uint32_t ttl, Ipv4Address sender);
+    void RreqAssessmentExpire(rtmhr::RtMhrHeader forward, uint32_t ttl);
+    void NotifyRreqCopy(Ipv4Address origin, uint32_t id, Ipv4Address sender);
+    double GetRelativeDistance(Ipv4Address neighbor);
+    bool IsCoveredBy(const NeighborEntry& neighbor, Ipv4Address sender);
+    void RecvRouteReply(Ptr<Packet> packet,
+                        const rtmhr::RtMhrHeader& header,
+                        Ipv4Address sender,
+                        uint32_t interface);
+    void DeferredRouteOutput(Ptr<const Packet> p,
+                             const Ipv4Header& header,
+                             const UnicastForwardCallback& ucb,
+                             const ErrorCallback& ecb);
+    void SendPacketFromQueue(Ipv4Address dst);
 
     // Route Maintenance
     void SendRouteError(Ipv4Address destination, Ipv4Address unreachable);
-    void RecvRouteError(Ptr<Packet> packet, Ipv4Address src);
+    void RecvRouteError(Ptr<Packet> packet,
+                        const rtmhr::RtMhrHeader& header,
+                        Ipv4Address sender,
+                        uint32_t interface);
     void PerformFastLocalRepair(Ipv4Address destination, Ipv4Address failedNextHop);
+    void EndDiscovery(Ipv4Address dst, bool found);
+    RouteEntry& AddRoute(const RouteEntry& entry);
+    RouteEntry& UpdateRoute(Ipv4Address dst,
+                            Ipv4Address nextHop,
+                            uint32_t interface,
+                            uint32_t hopCount,
+                            double delay = 0.0,
+                            double mobility = 0.0);
+    RouteEntry* FindLiveRoute(Ipv4Address dst);
+    void RefreshActiveRoute(RouteEntry& rt, bool source);
+    void HandleLinkFailure(Ipv4Address neighbor);
+    void PurgeRouteTable();
+
+    /**
+     * \brief Re-rank the paths of the routes through a neighbor after its
+     * link metric changed
+     * \param hop the neighbor
+     * \return the number of routes re-ranked
+     */
+    uint32_t RerankRoutesVia(Ipv4Address hop);
 
     // Neighbor Management
     void SendHello();
-    void RecvHello(Ptr<Packet> packet, Ipv4Address src);
+    void RecvHello(Ptr<Packet> packet,
+                   const rtmhr::RtMhrHeader& header,
+                   Ipv4Address sender,
+                   uint32_t interface);
     void UpdateNeighborTable(Ipv4Address neighbor, const CrossLayerMetric& metric);
+    NeighborEntry& AddNeighbor(const NeighborEntry& entry);
+    void UpdateRouteToNeighbor(Ipv4Address sender, uint32_t interface);
     void PurgeNeighborTable();
+    Time GetNeighborLifetime() const;
+    double GetNeighborhoodMobility() const;
+    double GetLocalSpeed() const;
+    bool GetLocalMotion(Vector& position, Vector& velocity) const;
+    Time Jitter(Time interval);
+    bool AreNeighborsAdvertised() const;
+
+    // RT-MHR Shim
+
+    /// IPv4 and UDP header bytes a packet leaving the socket still gets after its shim
+    static constexpr uint32_t SHIM_HEADROOM = 20 + 8;
+
+    /**
+     * \brief Check whether metric digests are sent and read
+     * \return true if PiggybackMetrics is set and packets may carry a shim
+     */
+    bool UseMetricDigests() const
+    {
+        return m_piggybackMetrics && !Node::ChecksumEnabled();
+    }
+
+    static bool PeekShim(Ptr<const Packet> packet,
+                         const Ipv4Header& header,
+                         rtmhr::RtMhrShim& shim);
+    void StampShim(Ptr<Packet> packet,
+                   rtmhr::RtMhrShim shim,
+                   Ipv4Address self,
+                   Ipv4Address nextHop,
+                   uint32_t mtu);
+    Ptr<const Packet> StampForwarded(Ptr<const Packet> packet,
+                                     Ptr<Ipv4Route> route,
+                                     Ipv4Header& header);
+    void RecvMetricDigest(const rtmhr::RtMhrShim& shim, uint32_t interface);
 
     // Link Quality Monitoring
     void SendProbe(Ipv4Address neighbor);
-    void RecvProbe(Ptr<Packet> packet, Ipv4Address src);
-    void UpdateLinkQuality(Ipv4Address neighbor, double quality);
+    void RecvProbe(Ptr<Packet> packet,
+                   const rtmhr::RtMhrHeader& header,
+                   Ipv4Address sender,
+                   uint32_t interface);
+    void UpdateLinkQuality(Ipv4Address neighbor, double delivered);
+    void LearnHardwareAddress(NeighborEntry& neighbor);
     CrossLayerMetric CalculateCrossLayerMetric(Ipv4Address neighbor);
 
     // Mobility Prediction
@@ -260,10 +960,47 @@ class RtMhr : public Ipv4RoutingProtocol
     // Priority Queuing
     void ForwardPacket(Ptr<const Packet> packet,
                        const Ipv4Header& header,
-                       Ipv4Address nextHop,
-                       uint32_t interface);
+                       Ptr<Ipv4Route> route,
+                       const UnicastForwardCallback& ucb,
+                       const ErrorCallback& ecb);
+    RtMhrPriorityQueue& GetForwardQueue(uint32_t interface);
+    void DrainForwardQueue(uint32_t interface);
+    bool IsDeviceStalled(Ptr<NetDevice> dev) const;
     TrafficPriority ClassifyTraffic(Ptr<const Packet> packet, const Ipv4Header& header);
 
+    // Real-Time Deadlines
+    /**
+     * \brief Predict how long a packet takes from here to the destination
+     * \param rt the route it takes
+     * \return the downstream queuing delay advertised for the path plus one
+     *         LinkDelay per hop, the first one scaled by the link's ETX
+     */
+    Time PredictPathDelay(const RouteEntry& rt) const;
+
+    /**
+     * \brief Check whether a real-time packet can no longer make its deadline
+     * \param packet the packet
+     * \param header its IPv4 header
+     * \param wait time it is still expected to wait in the local queue
+     * \return true if its shim has a deadline the predicted arrival is past
+     */
+    bool MissesDeadline(Ptr<const Packet> packet, const Ipv4Header& header, Time wait) const;
+
+    /**
+     * \brief Admit the real-time flow of a source to a destination
+     * \param rt the route to the destination
+     * \return false if the flow is new and its path cannot meet the DeadlineBudget
+     */
+    bool AdmitRealTimeFlow(const RouteEntry& rt);
+
+    /**
+     * \brief Check whether a packet a source sends is real-time data
+     * \param header its IP header
+     * \return true if a deadline is set and a rule without ports makes it
+     *         HIGH_PRIORITY; the rule's hit is not counted
+     */
+    bool IsRealTime(const Ipv4Header& header) const;
+
     // Utility Functions
     Ipv4Address GetNextHopForDestination(Ipv4Address destination);
     bool IsMyOwnAddress(Ipv4Address src);
@@ -273,17 +1010,51 @@ class RtMhr : public Ipv4RoutingProtocol
     uint32_t GetInterfaceForDevice(Ptr<NetDevice> dev) const;
     Ptr<NetDevice> GetNetDeviceFromContext() const;
     Ptr<Ipv4Route> LoopbackRoute(const Ipv4Header& hdr, Ptr<NetDevice> oif) const;
+    Ptr<Ipv4Route> GetCachedRoute(RouteEntry& entry) const;
+    void InvalidateCachedRoutes();
+
+    // Location-aided forwarding
+
+    /**
+     * \brief Get the position a packet without a route is forwarded towards
+     * \param p the packet
+     * \param header its IPv4 header
+     * \param target set to the destination's position
+     * \return false if neither this node nor the packet's shim knows it
+     */
+    bool GetGeoTarget(Ptr<const Packet> p, const Ipv4Header& header, Vector& target) const;
+
+    /**
+     * \brief Pick the greedy next hop towards a position
+     * \param target the position
+     * \return the route to the live neighbor closest to the target, or null if
+     *         no neighbor is closer to it than this node
+     */
+    Ptr<Ipv4Route> GetGreedyRoute(const Vector& target);
 
     // Forwarding
     bool ForwardPacketTo(Ptr<const Packet> p,
                          const Ipv4Header& header,
+                         uint32_t iif,
                          const UnicastForwardCallback& ucb,
-                         const ErrorCallback& ecb); // Socket handling
+                         const ErrorCallback& ecb);
+    Ptr<Ipv4Route> GetDiverseRoute(RouteEntry& entry, const RoutePath& path) const;
+
+    // Socket handling
     void RecvRtMhr(Ptr<Socket> socket);
+    void RecvMessage(Ptr<Packet> packet, Ipv4Address sender, uint32_t interface);
+    void DropControl(Ptr<const Packet> packet, uint32_t type);
+    void SendControl(const rtmhr::RtMhrHeader& header, Ipv4Address to, uint32_t ttl = 0);
     Ptr<Socket> FindSocketWithInterfaceAddress(Ipv4InterfaceAddress iface) const;
+    Ptr<Socket> GetSocketForInterface(uint32_t interface) const;
+    uint32_t GetInterfaceForNeighbor(Ipv4Address addr);
+    Ptr<Socket> CreateInterfaceSocket(uint32_t interface, Ipv4InterfaceAddress iface);
+    void CloseInterfaceSocket(Ptr<Socket> socket);
 
     // WiFi MAC layer callbacks
     void NotifyTxOk(const WifiMacHeader& hdr);
+    void NotifyTxFailed(Mac48Address addr);
+    void NotifyTxFinalFailed(Mac48Address addr);
 
     // Timer callbacks
     void HelloTimerExpire();
@@ -292,36 +1063,104 @@ class RtMhr : public Ipv4RoutingProtocol
 
     // Member Variables
     Ptr<Ipv4> m_ipv4;                                              ///< IPv4 object
+    Ptr<NetDevice> m_lo;                                           ///< Loopback device
     std::map<Ptr<Socket>, Ipv4InterfaceAddress> m_socketAddresses; ///< Socket to interface map
+    std::vector<Ptr<Socket>> m_interfaceSockets;                   ///< Sockets by interface index
     Ptr<Socket> m_recvSocket; ///< Socket for receiving RT-MHR messages
 
     // Routing Tables
-    std::map<Ipv4Address, RouteEntry> m_routeTable;       ///< Main routing table
-    std::map<Ipv4Address, NeighborEntry> m_neighborTable; ///< Neighbor table
+    RtMhrRoutingTable m_routeTable;                 ///< Main routing table
+    RtMhrNeighborTable m_neighborTable;             ///< Neighbor table
+    RtMhrRouteIndex m_routeIndex;                   ///< Routes by the next hops of their paths
+    RtMhrTimingWheel<Ipv4Address> m_routeExpiry;    ///< Route expiry schedule
+    RtMhrTimingWheel<Ipv4Address> m_neighborExpiry; ///< Neighbor expiry schedule
 
     // Timers
-    Timer m_helloTimer;                        ///< Hello timer
-    Timer m_probeTimer;                        ///< Probe timer
-    Timer m_purgeTimer;                        ///< Purge timer
-    std::map<Ipv4Address, Timer> m_rreqTimers; ///< RREQ timers
+    /// RREQ retry deadline of a destination
+    typedef std::pair<Time, Ipv4Address> RreqDeadline;
+    /// RREQ retry deadlines, earliest first
+    typedef std::priority_queue<RreqDeadline, std::vector<RreqDeadline>, std::greater<RreqDeadline>>
+        RreqHeap;
+
+    Timer m_helloTimer;                          ///< Hello timer
+    Timer m_probeTimer;                          ///< Probe timer
+    Timer m_purgeTimer;                          ///< Purge timer
+    Timer m_rreqTimer;                           ///< Fires at the earliest RREQ deadline
+    std::map<Ipv4Address, Time> m_rreqDeadlines; ///< Pending RREQ retry per destination
+    RreqHeap m_rreqHeap;                         ///< RREQ deadlines, stale ones included
 
     // Configuration Parameters
-    Time m_helloInterval;   ///< Hello interval
-    Time m_neighborTimeout; ///< Neighbor timeout
-    Time m_routeTimeout;    ///< Route timeout
-    Time m_probeInterval;   ///< Probe interval
-    bool m_fastLocalRepair; ///< Fast local repair flag
+    Time m_helloInterval;        ///< Shortest hello interval
+    Time m_maxHelloInterval;     ///< Longest hello interval
+    uint32_t m_allowedHelloLoss; ///< Hellos missed before a neighbor expires
+    double m_mobilityThreshold;  ///< Mobility above which beacons speed up
+    Time m_neighborTimeout;      ///< Neighbor timeout
+    Time m_routeTimeout;         ///< Route timeout
+    Time m_activeRouteTimeout;   ///< Lifetime each packet grants its route
+    Time m_routeRefreshLead;     ///< Rediscover active routes this long before expiry
+    double m_refreshLinkQuality; ///< Rediscover active routes over links worse than this
+    Time m_probeInterval;        ///< Shortest probe interval
+    Time m_maxProbeInterval;     ///< Longest probe interval
+    Time m_purgeInterval;        ///< Expired entry sweep interval
+    bool m_fastLocalRepair;      ///< Fast local repair flag
+    bool m_piggybackMetrics;     ///< Carry link metrics on data and control packets
+    bool m_dormant;              ///< Node run by another rank of a distributed simulation
+    uint32_t m_maxBackupPaths;   ///< Backup paths kept per destination
+    bool m_channelDiversity;     ///< Forward on another radio than the packet came in on
+    double m_diversityMargin;    ///< Score fraction given up for channel diversity
+    double m_linkQualityGain;    ///< EWMA gain of the MAC delivery ratio
+    uint32_t m_rreqRetries;      ///< RREQ retransmissions before giving up
+    Time m_rreqTimeout;          ///< Wait for RREP before the first retry
+    uint32_t m_rreqRateLimit;    ///< Maximum RREQs originated per second
+    uint32_t m_ttlStart;         ///< TTL of the first expanding-ring RREQ
+    uint32_t m_ttlIncrement;     ///< TTL growth per expanding-ring step
+    uint32_t m_ttlThreshold;     ///< Ring TTL past which RREQs flood the network
+    uint32_t m_netDiameter;      ///< Hop limit of a network-wide RREQ
+    Time m_nodeTraversalTime;    ///< One-hop RREQ/RREP turnaround estimate
+    bool m_destinationOnly;      ///< Only the destination answers RREQs
+    bool m_gratuitousReply;      ///< Intermediate replies also tell the destination
+    Time m_rreqAssessmentDelay;  ///< Longest wait before a deferred RREQ rebroadcast
+    RtMhrScheduler m_scheduler;  ///< Forwarding queue discipline
+    uint32_t m_highQueueLen;     ///< Forwarding queue depth, high priority
+    uint32_t m_mediumQueueLen;   ///< Forwarding queue depth, medium priority
+    uint32_t m_normalQueueLen;   ///< Forwarding queue depth, normal priority
+    Time m_realTimeDeadline;     ///< Age at which queued real-time packets are dropped
+    bool m_geoForwarding;        ///< Forward greedily towards known positions
+    double m_zoneMargin;         ///< Widening of a RREQ request zone, in meters
+    Time m_deadlineBudget;       ///< End-to-end delay budget of real-time packets, 0 for none
+    Time m_linkDelay;            ///< Predicted delay of one transmission over a link
+    bool m_sendingControl;       ///< Inside SendControl(), whose unicasts pass RouteOutput()
 
     // Protocol State
-    uint32_t m_requestId;                                      ///< Request ID counter
-    uint32_t m_sequenceNumber;                                 ///< Sequence number
-    std::set<std::pair<Ipv4Address, uint32_t>> m_seenRequests; ///< Seen requests
+    uint32_t m_requestId;                           ///< Request ID counter
+    uint32_t m_sequenceNumber;                      ///< Sequence number
+    RtMhrIdCache m_rreqIdCache;                     ///< Recently seen (origin, request ID) pairs
+    RtMhrFloodControl m_floodControl;               ///< RREQ rebroadcast suppression
+    RtMhrRequestQueue m_queue;                      ///< Packets waiting for route discovery
+    std::map<Ipv4Address, uint32_t> m_rreqAttempts; ///< Network-wide RREQs per ongoing discovery
+    std::map<Ipv4Address, uint32_t> m_rreqTtl;      ///< Current ring TTL per ongoing discovery
+    uint32_t m_rreqCount;                           ///< RREQs originated in this rate window
+    Time m_rreqWindowStart;                         ///< Start of the current rate window
+    RtMhrMacCache m_macCache;                       ///< Neighbor MAC to IPv4 addresses
+    RtMhrLocationTable m_locationTable;             ///< Last known node positions
+    std::map<Ipv4Address, Time> m_realTimeFlows;    ///< Admitted flows by destination, last sent
+    RtMhrBeaconScheduler m_helloScheduler;          ///< Adaptive HELLO interval
+    RtMhrBeaconScheduler m_probeScheduler;          ///< Adaptive PROBE interval
+    RtMhrStats m_stats;                             ///< Protocol counters
+    std::map<Ipv4Address, Time> m_discoveryStart;   ///< Start of each ongoing discovery
+    /// Start and failed next hop of each ongoing local repair
+    std::map<Ipv4Address, std::pair<Time, Ipv4Address>> m_repairs;
+
+    // Forwarding queues
+    std::map<uint32_t, RtMhrPriorityQueue> m_forwardQueues; ///< Per-interface forwarding queues
+    std::map<uint32_t, Timer> m_drainTimers;                ///< Retries while the device is busy
+    std::map<uint32_t, Time> m_drainBackoff; ///< Current retry interval, by interface
+    double m_queuingDelay;                                  ///< Smoothed sojourn time, in seconds
+    RtMhrClassifier m_classifier;                           ///< Assigns forwarded packets a class
 
     // Cross-layer parameters
-    double m_linkQualityWeight; ///< Link quality weight in CRM
-    double m_delayWeight;       ///< Delay weight in CRM
-    double m_mobilityWeight;    ///< Mobility weight in CRM
-    double m_hopCountWeight;    ///< Hop count weight in CRM
+    RtMhrMetricEngine m_metricEngine;           ///< CRM weights and score cache
+    RtMhrMobilityPredictor m_mobilityPredictor; ///< Link expiration time estimates
 
     // Random number generation
     Ptr<UniformRandomVariable> m_uniformRandomVariable; ///< Uniform random variable
@@ -329,6 +1168,21 @@ class RtMhr : public Ipv4RoutingProtocol
     // Traced callbacks
     TracedCallback<Ptr<const Packet>> m_txTrace; ///< TX trace
     TracedCallback<Ptr<const Packet>> m_rxTrace; ///< RX trace
+    /// Forwarded packet left its queue: packet, TrafficPriority, sojourn time
+    TracedCallback<Ptr<const Packet>, uint32_t, Time> m_forwardDelayTrace;
+    /// Forwarded packet dropped by its queue: packet, TrafficPriority
+    TracedCallback<Ptr<const Packet>, uint32_t> m_forwardDropTrace;
+    /// Classifier rule matched: rule index, hit count
+    TracedCallback<uint32_t, uint64_t> m_classifierHitTrace;
+    /// Primary path replaced by a backup: destination, failed and new next hop
+    TracedCallback<Ipv4Address, Ipv4Address, Ipv4Address> m_routeFailoverTrace;
+    /// Control message discarded or not sent: packet, MessageType
+    TracedCallback<Ptr<const Packet>, uint32_t> m_controlDropTrace;
+    /// Route discovery over: destination, latency, success
+    TracedCallback<Ipv4Address, Time, bool> m_routeDiscoveryTrace;
+    /// Local repair over: destination, latency, success
+    TracedCallback<Ipv4Address, Time, bool> m_localRepairTrace;
+    TracedValue<uint32_t> m_routeTableSize; ///< Routes held, updated on every change
 };
 
 } // namespace ns3
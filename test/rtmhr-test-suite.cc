@@ -1,8 +1,14 @@
+#include "rtmhr-test-topology.h"
+
+#include "ns3/boolean.h"
 #include "ns3/constant-position-mobility-model.h"
+#include "ns3/double.h"
 #include "ns3/internet-stack-helper.h"
 #include "ns3/ipv4-address-helper.h"
+#include "ns3/inet-socket-address.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/mobility-helper.h"
+#include "ns3/mobility-model.h"
 #include "ns3/node-container.h"
 #include "ns3/node.h"
 #include "ns3/packet.h"
@@ -11,8 +17,22 @@
 #include "ns3/simple-channel.h"
 #include "ns3/simple-net-device-helper.h"
 #include "ns3/simulator.h"
+#include "ns3/socket.h"
+#include "ns3/system-wall-clock-ms.h"
 #include "ns3/test.h"
 #include "ns3/udp-header.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
 
 using namespace ns3;
 
@@ -142,6 +162,7 @@ class RtMhrMetricTestCase : public TestCase
   private:
     virtual void DoRun() override;
     void TestCrossLayerMetric();
+    void TestMetricEngine();
 };
 
 RtMhrMetricTestCase::RtMhrMetricTestCase()
@@ -180,28 +201,3405 @@ RtMhrMetricTestCase::TestCrossLayerMetric()
     NS_TEST_ASSERT_MSG_GT(composite2, composite, "Better metric should have higher value");
 }
 
+void
+RtMhrMetricTestCase::TestMetricEngine()
+{
+    RtMhrMetricEngine engine;
+    CrossLayerMetric metric;
+    metric.linkQuality = 0.5;
+    metric.hopCount = 1;
+    NS_TEST_ASSERT_MSG_EQ_TOL(metric.GetCompositeMetric(),
+                              engine.Compute(metric),
+                              1e-12,
+                              "Unscored metric takes the default weights");
+    double score = engine.GetScore(metric);
+    NS_TEST_ASSERT_MSG_EQ_TOL(metric.GetCompositeMetric(), score, 1e-12, "Score is cached");
+
+    // Unchanged inputs are served from the cache
+    uint64_t recomputed = engine.GetRecomputed();
+    engine.GetScore(metric);
+    NS_TEST_ASSERT_MSG_EQ(engine.GetRecomputed(), recomputed, "Cached score reused");
+
+    // So are changed ones until the metric is invalidated
+    metric.linkQuality = 1.0;
+    NS_TEST_ASSERT_MSG_EQ_TOL(engine.GetScore(metric), score, 1e-12, "Stale until invalidated");
+    metric.Invalidate();
+    NS_TEST_ASSERT_MSG_GT(engine.GetScore(metric), score, "Rescored after invalidation");
+
+    // Weights are honored, and changing one makes every cached score stale
+    engine.SetWeight(RtMhrMetricEngine::LINK_QUALITY, 1.0);
+    engine.SetWeight(RtMhrMetricEngine::DELAY, 0.0);
+    engine.SetWeight(RtMhrMetricEngine::MOBILITY, 0.0);
+    engine.SetWeight(RtMhrMetricEngine::HOP_COUNT, 0.0);
+    NS_TEST_ASSERT_MSG_EQ_TOL(engine.GetScore(metric), 1.0, 1e-12, "Link quality only");
+    engine.SetWeight(RtMhrMetricEngine::LINK_QUALITY, 0.0);
+    engine.SetWeight(RtMhrMetricEngine::HOP_COUNT, 2.0);
+    NS_TEST_ASSERT_MSG_EQ_TOL(engine.GetScore(metric), 0.5, 1e-12, "Hop count only");
+
+    // The attributes reach the engine
+    Ptr<RtMhr> rtmhr = CreateObject<RtMhr>();
+    rtmhr->SetAttribute("LinkQualityWeight", DoubleValue(0.7));
+    NS_TEST_ASSERT_MSG_EQ_TOL(rtmhr->GetMetricEngine().GetWeight(RtMhrMetricEngine::LINK_QUALITY),
+                              0.7,
+                              1e-12,
+                              "LinkQualityWeight attribute");
+
+    // Batch refresh only recomputes stale entries
+    RtMhrNeighborTable table;
+    table.Insert(Ipv4Address("10.1.1.1"), NeighborEntry(Ipv4Address("10.1.1.1"), Seconds(30)));
+    table.Insert(Ipv4Address("10.1.1.2"), NeighborEntry(Ipv4Address("10.1.1.2"), Seconds(30)));
+    NS_TEST_ASSERT_MSG_EQ(engine.Refresh(table), 2, "Both entries scored");
+    NS_TEST_ASSERT_MSG_EQ(engine.Refresh(table), 0, "Nothing stale");
+    table.Find(Ipv4Address("10.1.1.2"))->metric.Invalidate();
+    NS_TEST_ASSERT_MSG_EQ(engine.Refresh(table), 1, "Only the invalidated entry");
+}
+
 void
 RtMhrMetricTestCase::DoRun()
 {
     TestCrossLayerMetric();
+    TestMetricEngine();
 }
 
 /**
  * \ingroup rtmhr-test
  * \ingroup tests
- * \brief RT-MHR Test Suite
+ * \brief RT-MHR cached route invalidation test case
  */
-class RtMhrTestSuite : public TestSuite
+class RtMhrRouteCacheTestCase : public TestCase
 {
   public:
-    RtMhrTestSuite();
+    RtMhrRouteCacheTestCase();
+    virtual ~RtMhrRouteCacheTestCase();
+
+  private:
+    virtual void DoRun() override;
 };
 
-RtMhrTestSuite::RtMhrTestSuite()
-    : TestSuite("rtmhr", Type::UNIT)
+RtMhrRouteCacheTestCase::RtMhrRouteCacheTestCase()
+    : TestCase("RT-MHR cached route invalidation test")
 {
-    AddTestCase(new RtMhrBasicTestCase, Duration::QUICK);
-    AddTestCase(new RtMhrMetricTestCase, Duration::QUICK);
+}
+
+RtMhrRouteCacheTestCase::~RtMhrRouteCacheTestCase()
+{
+}
+
+void
+RtMhrRouteCacheTestCase::DoRun()
+{
+    RouteEntry entry(Ipv4Address("10.1.1.3"), Seconds(30));
+    entry.SetNextHop(Ipv4Address("10.1.1.2"), 1);
+    entry.route = Create<Ipv4Route>();
+    Ptr<Ipv4Route> cached = entry.route;
+
+    // Same next hop and interface must keep the cached route
+    entry.SetNextHop(Ipv4Address("10.1.1.2"), 1);
+    NS_TEST_ASSERT_MSG_EQ(entry.route, cached, "Unchanged next hop should keep cached route");
+
+    // Metric updates must keep the cached route
+    CrossLayerMetric metric;
+    metric.hopCount = 2;
+    entry.UpdateMetric(metric);
+    NS_TEST_ASSERT_MSG_EQ(entry.route, cached, "Metric update should keep cached route");
+    NS_TEST_ASSERT_MSG_EQ(entry.hopCount, 2, "Metric update should refresh hop count");
+
+    // A next hop change must drop it
+    entry.SetNextHop(Ipv4Address("10.1.1.4"), 1);
+    NS_TEST_ASSERT_MSG_EQ(entry.route, nullptr, "Next hop change should drop cached route");
+
+    // So must an interface change
+    entry.route = cached;
+    entry.SetNextHop(Ipv4Address("10.1.1.4"), 2);
+    NS_TEST_ASSERT_MSG_EQ(entry.route, nullptr, "Interface change should drop cached route");
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR route/neighbor table backend test case
+ */
+class RtMhrTableTestCase : public TestCase
+{
+  public:
+    RtMhrTableTestCase();
+    virtual ~RtMhrTableTestCase();
+
+  private:
+    virtual void DoRun() override;
+    void TestBackend(RtMhrTableBackend backend);
+};
+
+RtMhrTableTestCase::RtMhrTableTestCase()
+    : TestCase("RT-MHR route/neighbor table backend test")
+{
+}
+
+RtMhrTableTestCase::~RtMhrTableTestCase()
+{
+}
+
+void
+RtMhrTableTestCase::TestBackend(RtMhrTableBackend backend)
+{
+    RtMhrTable<uint32_t> table(backend);
+    const uint32_t base = Ipv4Address("10.1.0.0").Get();
+
+    // Enough entries to force several hash index resizes
+    for (uint32_t i = 0; i < 600; ++i)
+    {
+        table.Insert(Ipv4Address(base + i), i);
+    }
+    NS_TEST_ASSERT_MSG_EQ(table.GetSize(), 600, "All entries should be stored");
+
+    // Remove every third entry
+    for (uint32_t i = 0; i < 600; i += 3)
+    {
+        NS_TEST_ASSERT_MSG_EQ(table.Erase(Ipv4Address(base + i)), true, "Entry should be erased");
+    }
+    NS_TEST_ASSERT_MSG_EQ(table.Erase(Ipv4Address(base)), false, "Entry is already gone");
+    NS_TEST_ASSERT_MSG_EQ(table.GetSize(), 400, "Erased entries should be gone");
+
+    for (uint32_t i = 0; i < 600; ++i)
+    {
+        const uint32_t* value = table.Find(Ipv4Address(base + i));
+        if (i % 3 == 0)
+        {
+            NS_TEST_ASSERT_MSG_EQ(value, nullptr, "Erased entry should not be found");
+        }
+        else
+        {
+            NS_TEST_ASSERT_MSG_NE(value, nullptr, "Remaining entry should be found");
+            NS_TEST_ASSERT_MSG_EQ(*value, i, "Remaining entry should keep its value");
+        }
+    }
+
+    // Overwrite keeps the size
+    table.Insert(Ipv4Address(base + 1), 7);
+    NS_TEST_ASSERT_MSG_EQ(*table.Find(Ipv4Address(base + 1)), 7, "Insert should overwrite");
+    NS_TEST_ASSERT_MSG_EQ(table.GetSize(), 400, "Overwrite should not add an entry");
+
+    // Switching backend keeps the content
+    table.SetBackend(backend == RTMHR_TABLE_HASH ? RTMHR_TABLE_FLAT : RTMHR_TABLE_HASH);
+    uint32_t count = 0;
+    for (const auto& iter : table)
+    {
+        NS_TEST_ASSERT_MSG_EQ(*table.Find(iter.first), iter.second, "Lookup after switch");
+        count++;
+    }
+    NS_TEST_ASSERT_MSG_EQ(count, 400, "Iteration should visit every entry");
+
+    // An entry held across inserts and erases that move it is found again
+    // with its content; the first pointer is not used past them
+    uint32_t* held = table.Find(Ipv4Address(base + 2));
+    NS_TEST_ASSERT_MSG_NE(held, nullptr, "Entry to hold");
+    uint32_t value = *held;
+    for (uint32_t i = 600; i < 1800; ++i)
+    {
+        table.Insert(Ipv4Address(base + i), i);
+    }
+    table.Erase(Ipv4Address(base + 1));
+    held = table.Find(Ipv4Address(base + 2));
+    NS_TEST_ASSERT_MSG_NE(held, nullptr, "Held entry survives the growth");
+    NS_TEST_ASSERT_MSG_EQ(*held, value, "Held entry keeps its content");
+    *held = 9;
+    NS_TEST_ASSERT_MSG_EQ(*table.Find(Ipv4Address(base + 2)), 9, "Write through the new pointer");
+}
+
+void
+RtMhrTableTestCase::DoRun()
+{
+    TestBackend(RTMHR_TABLE_HASH);
+    TestBackend(RTMHR_TABLE_FLAT);
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR duplicate RREQ cache test case
+ */
+class RtMhrIdCacheTestCase : public TestCase
+{
+  public:
+    RtMhrIdCacheTestCase();
+    virtual ~RtMhrIdCacheTestCase();
+
+  private:
+    virtual void DoRun() override;
+    void CheckExpired();
+    /// Check a request seen again after its record expired, but before the purge
+    void CheckReseen();
+
+    RtMhrIdCache m_cache; ///< Cache under test
+};
+
+RtMhrIdCacheTestCase::RtMhrIdCacheTestCase()
+    : TestCase("RT-MHR duplicate RREQ cache test"),
+      m_cache(4, Seconds(1))
+{
+}
+
+RtMhrIdCacheTestCase::~RtMhrIdCacheTestCase()
+{
+}
+
+void
+RtMhrIdCacheTestCase::CheckExpired()
+{
+    m_cache.Purge();
+    NS_TEST_ASSERT_MSG_EQ(m_cache.GetSize(), 0, "Expired records should be purged");
+    NS_TEST_ASSERT_MSG_EQ(m_cache.IsDuplicate(Ipv4Address("10.1.1.1"), 5),
+                          false,
+                          "Expired request should no longer be a duplicate");
+}
+
+void
+RtMhrIdCacheTestCase::CheckReseen()
+{
+    Ipv4Address origin("10.1.1.1");
+    NS_TEST_ASSERT_MSG_EQ(m_cache.IsDuplicate(origin, 5), false, "Unpurged record expired");
+    NS_TEST_ASSERT_MSG_EQ(m_cache.IsDuplicate(origin, 5), true, "Recorded again");
+
+    // Overwriting the expired record leaves the newer one indexed
+    for (uint32_t id = 6; id <= 8; ++id)
+    {
+        m_cache.IsDuplicate(origin, id);
+    }
+    NS_TEST_ASSERT_MSG_EQ(m_cache.GetSize(), 4, "Oldest record overwritten");
+    NS_TEST_ASSERT_MSG_EQ(m_cache.IsDuplicate(origin, 5), true, "Newer record still found");
+    NS_TEST_ASSERT_MSG_EQ(m_cache.IsDuplicate(origin, 6), true, "Other records still found");
+}
+
+void
+RtMhrIdCacheTestCase::DoRun()
+{
+    Ipv4Address origin("10.1.1.1");
+    NS_TEST_ASSERT_MSG_EQ(m_cache.IsDuplicate(origin, 1), false, "First copy is not a duplicate");
+    NS_TEST_ASSERT_MSG_EQ(m_cache.IsDuplicate(origin, 1), true, "Second copy is a duplicate");
+    NS_TEST_ASSERT_MSG_EQ(m_cache.IsDuplicate(Ipv4Address("10.1.1.2"), 1),
+                          false,
+                          "Same ID from another origin is not a duplicate");
+
+    // Capacity bounds memory: the oldest record is overwritten
+    for (uint32_t id = 2; id <= 5; ++id)
+    {
+        m_cache.IsDuplicate(origin, id);
+    }
+    NS_TEST_ASSERT_MSG_EQ(m_cache.GetSize(), 4, "Cache size should be bounded by capacity");
+    NS_TEST_ASSERT_MSG_EQ(m_cache.IsDuplicate(origin, 5), true, "Newest record should be kept");
+
+    Simulator::Schedule(Seconds(2), &RtMhrIdCacheTestCase::CheckExpired, this);
+    Simulator::Schedule(Seconds(4), &RtMhrIdCacheTestCase::CheckReseen, this);
+    Simulator::Run();
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR expiry timing wheel test case
+ */
+class RtMhrTimingWheelTestCase : public TestCase
+{
+  public:
+    RtMhrTimingWheelTestCase();
+    virtual ~RtMhrTimingWheelTestCase();
+
+  private:
+    virtual void DoRun() override;
+};
+
+RtMhrTimingWheelTestCase::RtMhrTimingWheelTestCase()
+    : TestCase("RT-MHR expiry timing wheel test")
+{
+}
+
+RtMhrTimingWheelTestCase::~RtMhrTimingWheelTestCase()
+{
+}
+
+void
+RtMhrTimingWheelTestCase::DoRun()
+{
+    RtMhrTimingWheel<uint32_t> wheel(MilliSeconds(100));
+
+    // One item per level, plus one in the overflow list
+    wheel.Schedule(1, Seconds(3));
+    wheel.Schedule(2, Seconds(30));
+    wheel.Schedule(3, Seconds(3000));
+    wheel.Schedule(4, Seconds(30000));
+    NS_TEST_ASSERT_MSG_EQ(wheel.GetSize(), 4, "All items should be scheduled");
+
+    std::vector<uint32_t> fired;
+    auto collect = [&fired](uint32_t item) { fired.push_back(item); };
+
+    wheel.Advance(Seconds(2.9), collect);
+    NS_TEST_ASSERT_MSG_EQ(fired.size(), 0, "Nothing should fire early");
+    wheel.Advance(Seconds(3), collect);
+    NS_TEST_ASSERT_MSG_EQ(fired.size(), 1, "First item should fire at its expiry");
+    NS_TEST_ASSERT_MSG_EQ(fired[0], 1, "Wrong item fired");
+
+    wheel.Advance(Seconds(29.9), collect);
+    NS_TEST_ASSERT_MSG_EQ(fired.size(), 1, "Level-1 item should not fire early");
+    wheel.Advance(Seconds(30), collect);
+    NS_TEST_ASSERT_MSG_EQ(fired.size(), 2, "Level-1 item should cascade and fire");
+
+    // Rescheduling from the callback, as the purge sweep does for refreshed entries
+    wheel.Advance(Seconds(3000), [&wheel, &fired](uint32_t item) {
+        fired.push_back(item);
+        wheel.Schedule(item, Seconds(3001));
+    });
+    NS_TEST_ASSERT_MSG_EQ(fired.size(), 3, "Level-2 item should cascade and fire");
+    wheel.Advance(Seconds(3001), collect);
+    NS_TEST_ASSERT_MSG_EQ(fired.size(), 4, "Rescheduled item should fire again");
+
+    wheel.Advance(Seconds(30000), collect);
+    NS_TEST_ASSERT_MSG_EQ(fired.size(), 5, "Overflow item should fire");
+    NS_TEST_ASSERT_MSG_EQ(fired[4], 4, "Wrong overflow item fired");
+    NS_TEST_ASSERT_MSG_EQ(wheel.GetSize(), 0, "Wheel should be empty");
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR route discovery packet buffer test case
+ */
+class RtMhrRequestQueueTestCase : public TestCase
+{
+  public:
+    RtMhrRequestQueueTestCase();
+    virtual ~RtMhrRequestQueueTestCase();
+
+  private:
+    virtual void DoRun() override;
+    void CheckExpired();
+    void Dropped(Ptr<const Packet> p, const Ipv4Header& header, Socket::SocketErrno err);
+    void Forwarded(Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header& header);
+
+    RtMhrRequestQueue m_queue; ///< Queue under test
+    uint32_t m_dropped;        ///< Packets reported through the error callback
+};
+
+RtMhrRequestQueueTestCase::RtMhrRequestQueueTestCase()
+    : TestCase("RT-MHR route discovery packet buffer test"),
+      m_queue(2, Seconds(1)),
+      m_dropped(0)
+{
+}
+
+RtMhrRequestQueueTestCase::~RtMhrRequestQueueTestCase()
+{
+}
+
+void
+RtMhrRequestQueueTestCase::Dropped(Ptr<const Packet> p,
+                                   const Ipv4Header& header,
+                                   Socket::SocketErrno err)
+{
+    NS_TEST_ASSERT_MSG_EQ(err, Socket::ERROR_NOROUTETOHOST, "Drops report no route to host");
+    m_dropped++;
+}
+
+void
+RtMhrRequestQueueTestCase::Forwarded(Ptr<Ipv4Route> route,
+                                     Ptr<const Packet> p,
+                                     const Ipv4Header& header)
+{
+}
+
+void
+RtMhrRequestQueueTestCase::CheckExpired()
+{
+    m_queue.Purge();
+    NS_TEST_ASSERT_MSG_EQ(m_queue.GetSize(), 0, "Expired packets should be purged");
+    NS_TEST_ASSERT_MSG_EQ(m_queue.Find(Ipv4Address("10.1.1.3")),
+                          false,
+                          "Empty destination should be forgotten");
+    NS_TEST_ASSERT_MSG_EQ(m_dropped, 2, "Expired packet should be reported as dropped");
+}
+
+void
+RtMhrRequestQueueTestCase::DoRun()
+{
+    Ipv4RoutingProtocol::UnicastForwardCallback ucb =
+        MakeCallback(&RtMhrRequestQueueTestCase::Forwarded, this);
+    Ipv4RoutingProtocol::ErrorCallback ecb =
+        MakeCallback(&RtMhrRequestQueueTestCase::Dropped, this);
+
+    Ipv4Header header;
+    header.SetDestination(Ipv4Address("10.1.1.2"));
+    Ptr<Packet> first = Create<Packet>(10);
+    m_queue.Enqueue(first, header, ucb, ecb);
+    m_queue.Enqueue(Create<Packet>(10), header, ucb, ecb);
+    m_queue.Enqueue(Create<Packet>(10), header, ucb, ecb);
+    NS_TEST_ASSERT_MSG_EQ(m_queue.GetSize(), 2, "Per-destination length should be bounded");
+    NS_TEST_ASSERT_MSG_EQ(m_dropped, 1, "Overflow should drop a packet");
+
+    std::deque<RtMhrQueueEntry> entries;
+    m_queue.Dequeue(Ipv4Address("10.1.1.2"), entries);
+    NS_TEST_ASSERT_MSG_EQ(entries.size(), 2, "Both buffered packets should be dequeued");
+    NS_TEST_ASSERT_MSG_NE(entries.front().packet->GetUid(),
+                          first->GetUid(),
+                          "The oldest packet should have been dropped");
+    NS_TEST_ASSERT_MSG_EQ(m_queue.GetSize(), 0, "Dequeue should empty the queue");
+
+    header.SetDestination(Ipv4Address("10.1.1.3"));
+    m_queue.Enqueue(Create<Packet>(10), header, ucb, ecb);
+    Simulator::Schedule(Seconds(2), &RtMhrRequestQueueTestCase::CheckExpired, this);
+    Simulator::Run();
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR deferred route output test case
+ *
+ * Three nodes in a line, each in range of the next only. Packets from the
+ * first to the last find no route: RouteOutput() loops them back, they wait
+ * in the request queue behind a single discovery and leave once the RREP is
+ * in.
+ */
+class RtMhrDeferredRouteTestCase : public TestCase
+{
+  public:
+    RtMhrDeferredRouteTestCase();
+    virtual ~RtMhrDeferredRouteTestCase();
+
+  private:
+    virtual void DoRun() override;
+
+    /**
+     * \brief Send datagrams from the first node to the last, then check them
+     * with CheckBuffered()
+     * \param count the number of datagrams
+     * \param buffered the datagrams sent so far, these included
+     */
+    void Send(uint32_t count, uint32_t buffered);
+
+    /**
+     * \brief Check that the datagrams sent so far wait for a single RREQ
+     * \param buffered the datagrams sent so far
+     */
+    void CheckBuffered(uint32_t buffered);
+
+    /**
+     * \brief Count the datagrams reaching the last node
+     * \param socket the receiving socket
+     */
+    void Receive(Ptr<Socket> socket);
+
+    RtMhrTestTopology m_chain; ///< The three nodes
+    RtMhrHelper m_rtmhr;       ///< Helper of the scenario
+    Ptr<Socket> m_source;      ///< Sending socket of the first node
+    uint32_t m_received;       ///< Datagrams received by the last node
+};
+
+RtMhrDeferredRouteTestCase::RtMhrDeferredRouteTestCase()
+    : TestCase("RT-MHR deferred route output test"),
+      m_chain(RtMhrTestTopology::HIGHWAY, 3),
+      m_received(0)
+{
+}
+
+RtMhrDeferredRouteTestCase::~RtMhrDeferredRouteTestCase()
+{
+}
+
+void
+RtMhrDeferredRouteTestCase::Send(uint32_t count, uint32_t buffered)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        m_source->SendTo(Create<Packet>(64), 0, InetSocketAddress(m_chain.GetAddress(2), 9));
+    }
+    // The loopback device delivers at once, so this runs once they are queued
+    Simulator::ScheduleNow(&RtMhrDeferredRouteTestCase::CheckBuffered, this, buffered);
+}
+
+void
+RtMhrDeferredRouteTestCase::CheckBuffered(uint32_t buffered)
+{
+    Ptr<RtMhr> source = m_rtmhr.GetRtMhr(m_chain.GetNodes().Get(0));
+    NS_TEST_ASSERT_MSG_EQ(source->GetRoutingTable().Find(m_chain.GetAddress(2)),
+                          nullptr,
+                          "No direct route made up to a node two hops away");
+    NS_TEST_ASSERT_MSG_EQ(source->GetRequestQueue().GetSize(), buffered, "Packets buffered");
+    RtMhrStats stats = source->GetStats();
+    NS_TEST_ASSERT_MSG_EQ(stats.discoveries, 1, "One discovery for the destination");
+    NS_TEST_ASSERT_MSG_EQ(stats.sent[RTMHR_RREQ].packets, 1, "One RREQ for all the misses");
+    NS_TEST_ASSERT_MSG_EQ(m_received, 0, "Nothing delivered yet");
+}
+
+void
+RtMhrDeferredRouteTestCase::Receive(Ptr<Socket> socket)
+{
+    while (socket->Recv())
+    {
+        m_received++;
+    }
+}
+
+void
+RtMhrDeferredRouteTestCase::DoRun()
+{
+    // A line of stationary vehicles, 100 m apart with a 150 m range
+    m_chain.SetLanes(1);
+    m_chain.SetSpeed(0.0);
+    m_chain.SetSpacing(100.0);
+    m_chain.SetRange(150.0);
+    m_chain.Install(m_rtmhr);
+
+    Ptr<Socket> sink =
+        Socket::CreateSocket(m_chain.GetNodes().Get(2), UdpSocketFactory::GetTypeId());
+    sink->Bind(InetSocketAddress(Ipv4Address::GetAny(), 9));
+    sink->SetRecvCallback(MakeCallback(&RtMhrDeferredRouteTestCase::Receive, this));
+    m_source = Socket::CreateSocket(m_chain.GetNodes().Get(0), UdpSocketFactory::GetTypeId());
+
+    // The first ring only reaches the middle node, which has no fresh route
+    // to answer with; the second one finds the destination at 3.24 s
+    Simulator::Schedule(Seconds(3), &RtMhrDeferredRouteTestCase::Send, this, 3, 3);
+    Simulator::Schedule(Seconds(3.1), &RtMhrDeferredRouteTestCase::Send, this, 2, 5);
+    Simulator::Stop(Seconds(5));
+    Simulator::Run();
+
+    Ptr<RtMhr> source = m_rtmhr.GetRtMhr(m_chain.GetNodes().Get(0));
+    RtMhrStats stats = source->GetStats();
+    NS_TEST_ASSERT_MSG_EQ(m_received, 5, "Buffered packets flushed along the discovered route");
+    NS_TEST_ASSERT_MSG_EQ(source->GetRequestQueue().GetSize(), 0, "Request queue emptied");
+    NS_TEST_ASSERT_MSG_EQ(stats.discoveryLatency.GetCount(), 1, "Discovery succeeded");
+    NS_TEST_ASSERT_MSG_EQ(stats.discoveryFailures, 0, "Discovery not given up");
+    const RouteEntry* rt = source->GetRoutingTable().Find(m_chain.GetAddress(2));
+    NS_TEST_ASSERT_MSG_NE(rt, nullptr, "Route installed");
+    NS_TEST_ASSERT_MSG_EQ(rt->nextHop, m_chain.GetAddress(1), "Through the middle node");
+    NS_TEST_ASSERT_MSG_EQ(rt->hopCount, 2, "Two hops");
+    m_source->Close();
+    sink->Close();
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR RREQ rate limit test case
+ *
+ * Repeated misses for a destination nobody knows start a single discovery,
+ * and with RreqRateLimit at 1 its second ring waits for the next one second
+ * window.
+ */
+class RtMhrRreqRateLimitTestCase : public TestCase
+{
+  public:
+    RtMhrRreqRateLimitTestCase();
+    virtual ~RtMhrRreqRateLimitTestCase();
+
+  private:
+    virtual void DoRun() override;
+
+    /// Send a datagram to the missing destination
+    void Send();
+
+    /**
+     * \brief Check the RREQs sent so far
+     * \param rreqs the expected number
+     */
+    void CheckRreqs(uint32_t rreqs);
+
+    RtMhrTestTopology m_pair; ///< The two nodes
+    RtMhrHelper m_rtmhr;      ///< Helper of the scenario
+    Ptr<Socket> m_source;     ///< Sending socket of the first node
+};
+
+RtMhrRreqRateLimitTestCase::RtMhrRreqRateLimitTestCase()
+    : TestCase("RT-MHR RREQ rate limit test"),
+      m_pair(RtMhrTestTopology::GRID, 2)
+{
+}
+
+RtMhrRreqRateLimitTestCase::~RtMhrRreqRateLimitTestCase()
+{
+}
+
+void
+RtMhrRreqRateLimitTestCase::Send()
+{
+    m_source->SendTo(Create<Packet>(64), 0, InetSocketAddress(Ipv4Address("10.1.0.50"), 9));
+}
+
+void
+RtMhrRreqRateLimitTestCase::CheckRreqs(uint32_t rreqs)
+{
+    RtMhrStats stats = m_rtmhr.GetRtMhr(m_pair.GetNodes().Get(0))->GetStats();
+    NS_TEST_ASSERT_MSG_EQ(stats.discoveries, 1, "A single discovery");
+    NS_TEST_ASSERT_MSG_EQ(stats.sent[RTMHR_RREQ].packets, rreqs, "RREQs sent");
+}
+
+void
+RtMhrRreqRateLimitTestCase::DoRun()
+{
+    m_rtmhr.Set("RreqRateLimit", UintegerValue(1));
+    m_pair.Install(m_rtmhr);
+    m_source = Socket::CreateSocket(m_pair.GetNodes().Get(0), UdpSocketFactory::GetTypeId());
+
+    // Five misses within the first ring's 240 ms timeout
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        Simulator::Schedule(Seconds(3) + MilliSeconds(40 * i),
+                            &RtMhrRreqRateLimitTestCase::Send,
+                            this);
+    }
+    Simulator::Schedule(Seconds(3.2), &RtMhrRreqRateLimitTestCase::CheckRreqs, this, 1);
+    // The second ring is due at 3.24 s but postponed to the next window
+    Simulator::Schedule(Seconds(3.9), &RtMhrRreqRateLimitTestCase::CheckRreqs, this, 1);
+    Simulator::Schedule(Seconds(4.1), &RtMhrRreqRateLimitTestCase::CheckRreqs, this, 2);
+    Simulator::Stop(Seconds(4.2));
+    Simulator::Run();
+
+    Ptr<RtMhr> source = m_rtmhr.GetRtMhr(m_pair.GetNodes().Get(0));
+    NS_TEST_ASSERT_MSG_EQ(source->GetRequestQueue().GetSize(), 5, "All misses buffered");
+    m_source->Close();
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR control message dispatch test case
+ *
+ * A node without RT-MHR writes messages of every type to the RT-MHR port of
+ * its neighbor, which must hand each one to its handler and drop those of
+ * unhandled or unknown types, unknown versions or cut short before they touch
+ * a table.
+ */
+class RtMhrDispatchTestCase : public TestCase
+{
+  public:
+    RtMhrDispatchTestCase();
+    virtual ~RtMhrDispatchTestCase();
+
+  private:
+    virtual void DoRun() override;
+
+    /**
+     * \brief Send a message to the RT-MHR node
+     * \param header the message
+     */
+    void Inject(rtmhr::RtMhrHeader header);
+
+    /**
+     * \brief Send raw bytes to the RT-MHR node
+     * \param packet the bytes
+     */
+    void InjectPacket(Ptr<Packet> packet);
+
+    /// Check that unhandled and unknown types left the tables alone
+    void CheckUnknown();
+    /// Check that the PROBE made the sender a neighbor
+    void CheckLink();
+    /// Check that the HELLO handler took the advertised delay
+    void CheckHello();
+    /// Check the routes made by the RREQ, zone RREQ and RREP handlers
+    void CheckRoutes();
+    /// Check that the RERR handler broke the route, and the handled counts
+    void CheckError();
+
+    NodeContainer m_nodes; ///< RT-MHR node and injecting node
+    RtMhrHelper m_rtmhr;   ///< Helper of the scenario
+    Ptr<Socket> m_socket;  ///< Injecting socket
+};
+
+RtMhrDispatchTestCase::RtMhrDispatchTestCase()
+    : TestCase("RT-MHR control message dispatch test")
+{
+}
+
+RtMhrDispatchTestCase::~RtMhrDispatchTestCase()
+{
+}
+
+void
+RtMhrDispatchTestCase::Inject(rtmhr::RtMhrHeader header)
+{
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(header);
+    InjectPacket(packet);
+}
+
+void
+RtMhrDispatchTestCase::InjectPacket(Ptr<Packet> packet)
+{
+    // 654 is the RT-MHR port
+    m_socket->SendTo(packet, 0, InetSocketAddress(Ipv4Address("10.1.1.1"), 654));
+}
+
+void
+RtMhrDispatchTestCase::CheckUnknown()
+{
+    RtMhrStats stats = m_rtmhr.GetRtMhr(m_nodes.Get(0))->GetStats();
+    NS_TEST_ASSERT_MSG_EQ(stats.received[RTMHR_PREP].packets, 1, "PREP received");
+    NS_TEST_ASSERT_MSG_EQ(stats.dropped[RTMHR_PREP].packets, 1, "Unhandled PREP dropped");
+    NS_TEST_ASSERT_MSG_EQ(stats.received[0].packets, 3, "Unreadable messages received");
+    NS_TEST_ASSERT_MSG_EQ(stats.dropped[0].packets, 3, "Unreadable messages dropped");
+    NS_TEST_ASSERT_MSG_EQ(stats.neighborTableSize, 0, "Sender not taken for a neighbor");
+    NS_TEST_ASSERT_MSG_EQ(stats.routeTableSize, 0, "No route learned");
+}
+
+void
+RtMhrDispatchTestCase::CheckLink()
+{
+    Ptr<RtMhr> rtmhr = m_rtmhr.GetRtMhr(m_nodes.Get(0));
+    NS_TEST_ASSERT_MSG_EQ(rtmhr->GetStats().received[RTMHR_PROBE].packets, 1, "PROBE received");
+    NS_TEST_ASSERT_MSG_NE(rtmhr->GetNeighborTable().Find(Ipv4Address("10.1.1.2")),
+                          nullptr,
+                          "PROBE proves the link");
+    NS_TEST_ASSERT_MSG_NE(rtmhr->GetRoutingTable().Find(Ipv4Address("10.1.1.2")),
+                          nullptr,
+                          "Route to the neighbor");
+}
+
+void
+RtMhrDispatchTestCase::CheckHello()
+{
+    const NeighborEntry* neighbor =
+        m_rtmhr.GetRtMhr(m_nodes.Get(0))->GetNeighborTable().Find(Ipv4Address("10.1.1.2"));
+    NS_TEST_ASSERT_MSG_NE(neighbor, nullptr, "Neighbor known");
+    NS_TEST_ASSERT_MSG_EQ_TOL(neighbor->metric.queuingDelay,
+                              0.05,
+                              1e-4,
+                              "HELLO handler took the advertised load");
+}
+
+void
+RtMhrDispatchTestCase::CheckRoutes()
+{
+    Ptr<RtMhr> rtmhr = m_rtmhr.GetRtMhr(m_nodes.Get(0));
+    const RtMhrRoutingTable& table = rtmhr->GetRoutingTable();
+    const RouteEntry* reverse = table.Find(Ipv4Address("10.1.1.9"));
+    NS_TEST_ASSERT_MSG_NE(reverse, nullptr, "RREQ handler made the reverse route");
+    NS_TEST_ASSERT_MSG_EQ(reverse->nextHop, Ipv4Address("10.1.1.2"), "Back through the sender");
+    NS_TEST_ASSERT_MSG_NE(table.Find(Ipv4Address("10.1.1.10")),
+                          nullptr,
+                          "Zone RREQ handler made the reverse route");
+    Vector center;
+    double radius;
+    NS_TEST_ASSERT_MSG_EQ(rtmhr->GetLocationTable().Lookup(Ipv4Address("10.1.1.10"),
+                                                           center,
+                                                           radius),
+                          true,
+                          "Zone RREQ handler learned the originator's position");
+    const RouteEntry* forward = table.Find(Ipv4Address("10.1.1.20"));
+    NS_TEST_ASSERT_MSG_NE(forward, nullptr, "RREP handler made the forward route");
+    NS_TEST_ASSERT_MSG_EQ(forward->IsExpired(), false, "Forward route live");
+}
+
+void
+RtMhrDispatchTestCase::CheckError()
+{
+    RtMhrStats stats = m_rtmhr.GetRtMhr(m_nodes.Get(0))->GetStats();
+    for (uint32_t type : {RTMHR_RREQ, RTMHR_RREP, RTMHR_RERR, RTMHR_HELLO, RTMHR_ZONE_RREQ})
+    {
+        NS_TEST_ASSERT_MSG_EQ(stats.received[type].packets, 1, "Message " << type << " received");
+        NS_TEST_ASSERT_MSG_EQ(stats.dropped[type].packets, 0, "Message " << type << " handled");
+    }
+    const RouteEntry* forward =
+        m_rtmhr.GetRtMhr(m_nodes.Get(0))->GetRoutingTable().Find(Ipv4Address("10.1.1.20"));
+    NS_TEST_ASSERT_MSG_EQ(forward->IsExpired(), true, "RERR handler broke the route");
+    NS_TEST_ASSERT_MSG_EQ(stats.sent[RTMHR_RERR].packets, 0, "No precursor to pass the RERR to");
+}
+
+void
+RtMhrDispatchTestCase::DoRun()
+{
+    m_nodes.Create(2);
+    SimpleNetDeviceHelper deviceHelper;
+    deviceHelper.SetChannel("ns3::SimpleChannel");
+    NetDeviceContainer devices = deviceHelper.Install(m_nodes);
+    InternetStackHelper internet;
+    internet.SetRoutingHelper(m_rtmhr);
+    internet.Install(m_nodes.Get(0));
+    InternetStackHelper plain;
+    plain.Install(m_nodes.Get(1));
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.1.1.0", "255.255.255.0");
+    ipv4.Assign(devices);
+    MobilityHelper mobility;
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.Install(m_nodes);
+    m_socket = Socket::CreateSocket(m_nodes.Get(1), UdpSocketFactory::GetTypeId());
+
+    // Unhandled and out of range types
+    Simulator::Schedule(Seconds(1),
+                        &RtMhrDispatchTestCase::Inject,
+                        this,
+                        rtmhr::RtMhrHeader(RTMHR_PREP, 0, 0, Ipv4Address("10.1.1.30")));
+    Simulator::Schedule(Seconds(1),
+                        &RtMhrDispatchTestCase::Inject,
+                        this,
+                        rtmhr::RtMhrHeader(static_cast<MessageType>(12)));
+    // A RREQ cut short, and a header of a later version
+    const uint8_t truncated[] = {0x11, 0, 0, 0, 0, 1};
+    const uint8_t later[23] = {0x21};
+    Simulator::Schedule(Seconds(1),
+                        &RtMhrDispatchTestCase::InjectPacket,
+                        this,
+                        Create<Packet>(truncated, sizeof(truncated)));
+    Simulator::Schedule(Seconds(1),
+                        &RtMhrDispatchTestCase::InjectPacket,
+                        this,
+                        Create<Packet>(later, sizeof(later)));
+    Simulator::Schedule(Seconds(1.5), &RtMhrDispatchTestCase::CheckUnknown, this);
+
+    Simulator::Schedule(Seconds(2),
+                        &RtMhrDispatchTestCase::Inject,
+                        this,
+                        rtmhr::RtMhrHeader(RTMHR_PROBE));
+    Simulator::Schedule(Seconds(2.5), &RtMhrDispatchTestCase::CheckLink, this);
+
+    rtmhr::RtMhrHeader hello(RTMHR_HELLO);
+    hello.SetDelay(0.05);
+    Simulator::Schedule(Seconds(3), &RtMhrDispatchTestCase::Inject, this, hello);
+    Simulator::Schedule(Seconds(3.5), &RtMhrDispatchTestCase::CheckHello, this);
+
+    rtmhr::RtMhrHeader rreq(RTMHR_RREQ,
+                            0,
+                            1,
+                            Ipv4Address("10.1.1.50"),
+                            Ipv4Address("10.1.1.9"));
+    rtmhr::RtMhrHeader zreq(RTMHR_ZONE_RREQ,
+                            0,
+                            1,
+                            Ipv4Address("10.1.1.50"),
+                            Ipv4Address("10.1.1.10"));
+    zreq.SetPosition(Vector(300, 0, 0));
+    zreq.SetRequestZone(Rectangle(-100, 1000, -100, 100));
+    rtmhr::RtMhrHeader rrep(RTMHR_RREP,
+                            0,
+                            0,
+                            Ipv4Address("10.1.1.20"),
+                            Ipv4Address("10.1.1.1"));
+    rrep.SetSequenceNumber(5);
+    Simulator::Schedule(Seconds(4), &RtMhrDispatchTestCase::Inject, this, rreq);
+    Simulator::Schedule(Seconds(4), &RtMhrDispatchTestCase::Inject, this, zreq);
+    Simulator::Schedule(Seconds(4), &RtMhrDispatchTestCase::Inject, this, rrep);
+    Simulator::Schedule(Seconds(4.5), &RtMhrDispatchTestCase::CheckRoutes, this);
+
+    Simulator::Schedule(Seconds(5),
+                        &RtMhrDispatchTestCase::Inject,
+                        this,
+                        rtmhr::RtMhrHeader(RTMHR_RERR,
+                                           0,
+                                           0,
+                                           Ipv4Address("10.1.1.20"),
+                                           Ipv4Address("10.1.1.2")));
+    Simulator::Schedule(Seconds(5.5), &RtMhrDispatchTestCase::CheckError, this);
+    Simulator::Stop(Seconds(6));
+    Simulator::Run();
+    m_socket->Close();
+    Simulator::Destroy();
+}
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR active route refresh test case, a friend of RtMhr
+ *
+ * Every use of a route moves its expiry out by ActiveRouteTimeout, though
+ * never past its predicted break. A source that keeps using a route starts
+ * a background discovery at most once per ActiveRouteTimeout.
+ */
+class RtMhrRouteRefreshTestCase : public TestCase
+{
+  public:
+    RtMhrRouteRefreshTestCase();
+    virtual ~RtMhrRouteRefreshTestCase();
+
+  private:
+    virtual void DoRun() override;
+
+    /**
+     * \brief Use the hand-made route, as a forwarder would
+     * \param expected the validity time it must end up with
+     */
+    void Use(Time expected);
+
+    /// Send a datagram from the first node to the last
+    void Send();
+
+    /**
+     * \brief Check the discoveries started by the first node so far
+     * \param discoveries the expected number
+     */
+    void CheckDiscoveries(uint32_t discoveries);
+
+    Ptr<RtMhr> m_protocol;     ///< Owner of the hand-made route
+    RouteEntry m_route;        ///< Hand-made route, with a predicted break
+    RtMhrTestTopology m_chain; ///< The three nodes
+    RtMhrHelper m_rtmhr;       ///< Helper of the scenario
+    Ptr<Socket> m_source;      ///< Sending socket of the first node
+};
+
+RtMhrRouteRefreshTestCase::RtMhrRouteRefreshTestCase()
+    : TestCase("RT-MHR active route refresh test"),
+      m_chain(RtMhrTestTopology::HIGHWAY, 3)
+{
+}
+
+RtMhrRouteRefreshTestCase::~RtMhrRouteRefreshTestCase()
+{
+}
+
+void
+RtMhrRouteRefreshTestCase::Use(Time expected)
+{
+    m_protocol->RefreshActiveRoute(m_route, false);
+    NS_TEST_ASSERT_MSG_EQ(m_route.validTime, expected, "Validity after use");
+    NS_TEST_ASSERT_MSG_EQ(m_route.lastUsed, Simulator::Now(), "Use recorded");
+}
+
+void
+RtMhrRouteRefreshTestCase::Send()
+{
+    m_source->SendTo(Create<Packet>(64), 0, InetSocketAddress(m_chain.GetAddress(2), 9));
+}
+
+void
+RtMhrRouteRefreshTestCase::CheckDiscoveries(uint32_t discoveries)
+{
+    Ptr<RtMhr> source = m_rtmhr.GetRtMhr(m_chain.GetNodes().Get(0));
+    NS_TEST_ASSERT_MSG_EQ(source->GetStats().discoveries, discoveries, "Discoveries so far");
+}
+
+void
+RtMhrRouteRefreshTestCase::DoRun()
+{
+    // A route valid until 1 s and predicted to break at 5 s, used without
+    // the 3 s ActiveRouteTimeout ever running out
+    m_protocol = CreateObject<RtMhr>();
+    m_route = RouteEntry(Ipv4Address("10.1.1.9"), Seconds(1));
+    m_route.breakTime = Seconds(5);
+    Simulator::Schedule(Seconds(0.5), &RtMhrRouteRefreshTestCase::Use, this, Seconds(3.5));
+    Simulator::Schedule(Seconds(1.5), &RtMhrRouteRefreshTestCase::Use, this, Seconds(4.5));
+    Simulator::Schedule(Seconds(2.5), &RtMhrRouteRefreshTestCase::Use, this, Seconds(5));
+    Simulator::Schedule(Seconds(4.9), &RtMhrRouteRefreshTestCase::Use, this, Seconds(5));
+
+    // A line of stationary vehicles, 100 m apart with a 150 m range. With the
+    // refresh lead longer than any lifetime, every use finds the route
+    // expiring, so only the once per ActiveRouteTimeout limit holds back the
+    // refreshes: 4 s, 7 s and 10 s, after the discovery at 3 s
+    m_rtmhr.Set("RouteTimeout", TimeValue(Seconds(3)));
+    m_rtmhr.Set("RouteRefreshLead", TimeValue(Seconds(10)));
+    m_chain.SetLanes(1);
+    m_chain.SetSpeed(0.0);
+    m_chain.SetSpacing(100.0);
+    m_chain.SetRange(150.0);
+    m_chain.Install(m_rtmhr);
+    Ptr<Socket> sink =
+        Socket::CreateSocket(m_chain.GetNodes().Get(2), UdpSocketFactory::GetTypeId());
+    sink->Bind(InetSocketAddress(Ipv4Address::GetAny(), 9));
+    m_source = Socket::CreateSocket(m_chain.GetNodes().Get(0), UdpSocketFactory::GetTypeId());
+
+    Simulator::Schedule(Seconds(3), &RtMhrRouteRefreshTestCase::Send, this);
+    for (uint32_t i = 0; i < 70; i++)
+    {
+        Simulator::Schedule(Seconds(4) + MilliSeconds(100) * i,
+                            &RtMhrRouteRefreshTestCase::Send,
+                            this);
+    }
+    Simulator::Schedule(Seconds(3.9), &RtMhrRouteRefreshTestCase::CheckDiscoveries, this, 1);
+    Simulator::Schedule(Seconds(6.95), &RtMhrRouteRefreshTestCase::CheckDiscoveries, this, 2);
+    Simulator::Schedule(Seconds(9.95), &RtMhrRouteRefreshTestCase::CheckDiscoveries, this, 3);
+    Simulator::Stop(Seconds(11.5));
+    Simulator::Run();
+
+    CheckDiscoveries(4);
+    Ptr<RtMhr> source = m_rtmhr.GetRtMhr(m_chain.GetNodes().Get(0));
+    NS_TEST_ASSERT_MSG_EQ(source->GetStats().discoveryFailures, 0, "Every refresh answered");
+    m_source->Close();
+    sink->Close();
+    m_protocol = nullptr;
+    Simulator::Destroy();
+}
+
+} // namespace ns3
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR compact header format test case
+ */
+class RtMhrHeaderTestCase : public TestCase
+{
+  public:
+    RtMhrHeaderTestCase();
+    virtual ~RtMhrHeaderTestCase();
+
+  private:
+    virtual void DoRun() override;
+};
+
+RtMhrHeaderTestCase::RtMhrHeaderTestCase()
+    : TestCase("RT-MHR compact header format test")
+{
+}
+
+RtMhrHeaderTestCase::~RtMhrHeaderTestCase()
+{
+}
+
+void
+RtMhrHeaderTestCase::DoRun()
+{
+    // Each type only carries its own fields
+    NS_TEST_ASSERT_MSG_EQ(rtmhr::RtMhrHeader(RTMHR_HELLO).GetSerializedSize(), 22, "HELLO size");
+    NS_TEST_ASSERT_MSG_EQ(rtmhr::RtMhrHeader(RTMHR_RREQ).GetSerializedSize(), 23, "RREQ size");
+    NS_TEST_ASSERT_MSG_EQ(rtmhr::RtMhrHeader(RTMHR_RREP).GetSerializedSize(), 19, "RREP size");
+    NS_TEST_ASSERT_MSG_EQ(rtmhr::RtMhrHeader(RTMHR_RERR).GetSerializedSize(), 13, "RERR size");
+
+    rtmhr::RtMhrHeader rreq(RTMHR_RREQ,
+                            3,
+                            42,
+                            Ipv4Address("10.1.1.9"),
+                            Ipv4Address("10.1.1.1"),
+                            0.8,
+                            0.0123,
+                            2.5);
+    rreq.SetSequenceNumber(7);
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(rreq);
+    NS_TEST_ASSERT_MSG_EQ(packet->GetSize(), 23, "Serialized RREQ size");
+
+    rtmhr::RtMhrHeader decoded;
+    packet->RemoveHeader(decoded);
+    NS_TEST_ASSERT_MSG_EQ((uint32_t)decoded.GetVersion(), 1, "Version");
+    NS_TEST_ASSERT_MSG_EQ(decoded.GetMessageType(), RTMHR_RREQ, "Message type");
+    NS_TEST_ASSERT_MSG_EQ((uint32_t)decoded.GetHopCount(), 3, "Hop count");
+    NS_TEST_ASSERT_MSG_EQ(decoded.GetRequestId(), 42, "Request ID");
+    NS_TEST_ASSERT_MSG_EQ(decoded.GetDestination(), Ipv4Address("10.1.1.9"), "Destination");
+    NS_TEST_ASSERT_MSG_EQ(decoded.GetOrigin(), Ipv4Address("10.1.1.1"), "Origin");
+    NS_TEST_ASSERT_MSG_EQ(decoded.GetSequenceNumber(), 7, "Sequence number");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetLinkQuality(), 0.8, 1.0 / 510, "Link quality");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetDelay(), 0.0123, 5e-5, "Delay");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetMobility(), 2.5, 1.0 / 512, "Mobility");
+
+    // HELLOs carry the sender's motion
+    rtmhr::RtMhrHeader hello(RTMHR_HELLO);
+    hello.SetPosition(Vector(-1500.25, 320.5, 7.0));
+    hello.SetVelocity(Vector(27.78, -0.5, 0.0));
+    packet = Create<Packet>();
+    packet->AddHeader(hello);
+    NS_TEST_ASSERT_MSG_EQ(packet->GetSize(), 22, "Serialized HELLO size");
+    packet->RemoveHeader(decoded);
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetPosition().x, -1500.25, 0.005, "Position x");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetPosition().y, 320.5, 0.005, "Position y");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetVelocity().x, 27.78, 0.005, "Velocity x");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetVelocity().y, -0.5, 0.005, "Velocity y");
+
+    // Legacy captures still decode, and are written back unchanged
+    rtmhr::RtMhrHeader legacy(RTMHR_RREP, 2, 9, Ipv4Address("10.1.1.5"), Ipv4Address("10.1.1.6"));
+    legacy.SetVersion(0);
+    packet = Create<Packet>();
+    packet->AddHeader(legacy);
+    NS_TEST_ASSERT_MSG_EQ(packet->GetSize(), 42, "Legacy header size");
+    packet->RemoveHeader(decoded);
+    NS_TEST_ASSERT_MSG_EQ((uint32_t)decoded.GetVersion(), 0, "Legacy version");
+    NS_TEST_ASSERT_MSG_EQ(decoded.GetMessageType(), RTMHR_RREP, "Legacy message type");
+    NS_TEST_ASSERT_MSG_EQ(decoded.GetRequestId(), 9, "Legacy request ID");
+    NS_TEST_ASSERT_MSG_EQ(decoded.GetOrigin(), Ipv4Address("10.1.1.6"), "Legacy origin");
+    NS_TEST_ASSERT_MSG_EQ(decoded.GetSerializedSize(), 42, "Legacy header is rewritten as is");
+
+    // The first byte tells the size to expect; later versions are not read
+    NS_TEST_ASSERT_MSG_EQ(rtmhr::RtMhrHeader::GetMessageSize(0x11), 23, "RREQ size from byte");
+    NS_TEST_ASSERT_MSG_EQ(rtmhr::RtMhrHeader::GetMessageSize(RTMHR_RREP), 42, "Legacy size");
+    NS_TEST_ASSERT_MSG_EQ(rtmhr::RtMhrHeader::GetMessageSize(0x21), 0, "Unknown version size");
+    const uint8_t later[23] = {0x21};
+    packet = Create<Packet>(later, sizeof(later));
+    NS_TEST_ASSERT_MSG_EQ(packet->PeekHeader(decoded), 0, "Unknown version not decoded");
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR shim and piggybacked metric digest test case
+ */
+class RtMhrMetricDigestTestCase : public TestCase
+{
+  public:
+    RtMhrMetricDigestTestCase();
+    virtual ~RtMhrMetricDigestTestCase();
+
+  private:
+    virtual void DoRun() override;
+};
+
+RtMhrMetricDigestTestCase::RtMhrMetricDigestTestCase()
+    : TestCase("RT-MHR shim and piggybacked metric digest test")
+{
+}
+
+RtMhrMetricDigestTestCase::~RtMhrMetricDigestTestCase()
+{
+}
+
+void
+RtMhrMetricDigestTestCase::DoRun()
+{
+    rtmhr::RtMhrShim shim;
+    NS_TEST_ASSERT_MSG_EQ(shim.IsEmpty(), true, "No section yet");
+    shim.SetDigest(Ipv4Address("10.1.1.3"),
+                   0.6,
+                   0.0042,
+                   Vector(1234.567, -89.01, 5.0),
+                   Vector(-33.3, 12.5, 1.0));
+    NS_TEST_ASSERT_MSG_EQ(shim.GetSerializedSize(), 22, "Digest and footer size");
+
+    // Same fixed point as the compact header, in bytes that go on the air
+    Ptr<Packet> packet = Create<Packet>(100);
+    packet->AddTrailer(shim);
+    NS_TEST_ASSERT_MSG_EQ(packet->GetSize(), 122, "Shim appended");
+
+    rtmhr::RtMhrShim decoded;
+    NS_TEST_ASSERT_MSG_EQ(rtmhr::RtMhrShim::Peek(packet, decoded), true, "Shim found");
+    NS_TEST_ASSERT_MSG_EQ(decoded.HasDigest(), true, "Digest attached");
+    NS_TEST_ASSERT_MSG_EQ(decoded.GetSender(), Ipv4Address("10.1.1.3"), "Sender");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetLinkQuality(), 0.6, 1.0 / 510, "Link quality");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetDelay(), 0.0042, 5e-5, "Delay");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetPosition().x, 1234.567, 0.005, "Position x");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetPosition().y, -89.01, 0.005, "Position y");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetPosition().z, 0.0, 1e-12, "Planar position");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetVelocity().x, -33.3, 0.005, "Velocity x");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetVelocity().y, 12.5, 0.005, "Velocity y");
+    NS_TEST_ASSERT_MSG_EQ(packet->RemoveTrailer(decoded), 22, "Shim stripped");
+    NS_TEST_ASSERT_MSG_EQ(packet->GetSize(), 100, "Payload left as it was");
+
+    // Payload that does not end like a shim is not mistaken for one
+    NS_TEST_ASSERT_MSG_EQ(rtmhr::RtMhrShim::Peek(packet, decoded), false, "Zero bytes");
+    NS_TEST_ASSERT_MSG_EQ(rtmhr::RtMhrShim::Peek(Create<Packet>(2), decoded),
+                          false,
+                          "Shorter than a footer");
+
+    // Out of range values saturate instead of wrapping
+    shim.SetDigest(Ipv4Address("10.1.1.4"), 2.0, 10.0, Vector(), Vector(500.0, -500.0, 0.0));
+    packet->AddTrailer(shim);
+    rtmhr::RtMhrShim::Peek(packet, decoded);
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetLinkQuality(), 1.0, 1e-12, "Link quality clamped");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetDelay(), 6.5535, 1e-9, "Delay saturated");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetVelocity().x, 327.67, 1e-9, "Velocity saturated");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetVelocity().y, -327.68, 1e-9, "Negative velocity saturated");
+
+    // A shim left with no section is not sent at all
+    shim.RemoveDigest();
+    NS_TEST_ASSERT_MSG_EQ(shim.IsEmpty(), true, "Digest removed");
+    NS_TEST_ASSERT_MSG_EQ(shim.GetSerializedSize(), 3, "Footer only");
+
+    RtMhrStats stats;
+    stats.CountShim(22);
+    RtMhrStats total;
+    total.Merge(stats);
+    total.Merge(stats);
+    NS_TEST_ASSERT_MSG_EQ(total.shims.packets, 2, "Shims summed");
+    NS_TEST_ASSERT_MSG_EQ(total.shims.bytes, 44, "Shim bytes summed");
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR priority forwarding queue test case
+ */
+class RtMhrPriorityQueueTestCase : public TestCase
+{
+  public:
+    RtMhrPriorityQueueTestCase();
+    virtual ~RtMhrPriorityQueueTestCase();
+
+  private:
+    virtual void DoRun() override;
+
+    /**
+     * \brief Build a queue entry
+     * \param priority its traffic class
+     * \return the entry
+     */
+    RtMhrForwardEntry MakeEntry(TrafficPriority priority);
+};
+
+RtMhrPriorityQueueTestCase::RtMhrPriorityQueueTestCase()
+    : TestCase("RT-MHR priority forwarding queue test")
+{
+}
+
+RtMhrPriorityQueueTestCase::~RtMhrPriorityQueueTestCase()
+{
+}
+
+RtMhrForwardEntry
+RtMhrPriorityQueueTestCase::MakeEntry(TrafficPriority priority)
+{
+    RtMhrForwardEntry entry;
+    entry.packet = Create<Packet>(10);
+    entry.priority = priority;
+    return entry;
+}
+
+void
+RtMhrPriorityQueueTestCase::DoRun()
+{
+    RtMhrPriorityQueue queue;
+    queue.SetMaxLen(NORMAL_PRIORITY, 2);
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        queue.Enqueue(MakeEntry(NORMAL_PRIORITY));
+    }
+    NS_TEST_ASSERT_MSG_EQ(queue.GetSize(NORMAL_PRIORITY), 2, "Class depth should be bounded");
+    NS_TEST_ASSERT_MSG_EQ(queue.Enqueue(MakeEntry(HIGH_PRIORITY)),
+                          true,
+                          "A full class must not block another one");
+
+    // Strict priority serves the real-time packet first
+    RtMhrForwardEntry entry;
+    queue.Dequeue(entry);
+    NS_TEST_ASSERT_MSG_EQ(entry.priority, HIGH_PRIORITY, "High priority first");
+    queue.Dequeue(entry);
+    NS_TEST_ASSERT_MSG_EQ(entry.priority, NORMAL_PRIORITY, "Then normal priority");
+
+    // Weighted fair queueing shares 4:2:1 among backlogged classes
+    RtMhrPriorityQueue wfq;
+    wfq.SetScheduler(RTMHR_SCHED_WEIGHTED);
+    for (uint32_t i = 0; i < 28; ++i)
+    {
+        wfq.Enqueue(MakeEntry(HIGH_PRIORITY));
+        wfq.Enqueue(MakeEntry(MEDIUM_PRIORITY));
+        wfq.Enqueue(MakeEntry(NORMAL_PRIORITY));
+    }
+    uint32_t served[4] = {0, 0, 0, 0};
+    for (uint32_t i = 0; i < 28; ++i)
+    {
+        wfq.Dequeue(entry);
+        served[entry.priority]++;
+    }
+    NS_TEST_ASSERT_MSG_EQ(served[HIGH_PRIORITY], 16, "High priority share");
+    NS_TEST_ASSERT_MSG_EQ(served[MEDIUM_PRIORITY], 8, "Medium priority share");
+    NS_TEST_ASSERT_MSG_EQ(served[NORMAL_PRIORITY], 4, "Normal priority share");
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR traffic classifier test case
+ */
+class RtMhrClassifierTestCase : public TestCase
+{
+  public:
+    RtMhrClassifierTestCase();
+    virtual ~RtMhrClassifierTestCase();
+
+  private:
+    virtual void DoRun() override;
+};
+
+RtMhrClassifierTestCase::RtMhrClassifierTestCase()
+    : TestCase("RT-MHR traffic classifier test")
+{
+}
+
+RtMhrClassifierTestCase::~RtMhrClassifierTestCase()
+{
+}
+
+void
+RtMhrClassifierTestCase::DoRun()
+{
+    RtMhrClassifier classifier;
+    NS_TEST_ASSERT_MSG_EQ(classifier.SetRules("dscp=46:high;udp,port=5000-5099:medium;"
+                                              "dst=10.2.0.0/16:high;tcp:normal"),
+                          true,
+                          "Rules should parse");
+    NS_TEST_ASSERT_MSG_EQ(classifier.GetNRules(), 4, "Four rules");
+
+    Ptr<Packet> packet = Create<Packet>(20);
+    UdpHeader udp;
+    udp.SetSourcePort(40000);
+    udp.SetDestinationPort(5050);
+    packet->AddHeader(udp);
+
+    Ipv4Header ip;
+    ip.SetProtocol(17);
+    ip.SetSource(Ipv4Address("10.1.1.1"));
+    ip.SetDestination(Ipv4Address("10.1.1.2"));
+    int32_t rule;
+    NS_TEST_ASSERT_MSG_EQ(classifier.Classify(packet, ip, rule), MEDIUM_PRIORITY, "Port rule");
+    NS_TEST_ASSERT_MSG_EQ(rule, 1, "Matched by the port rule");
+
+    // The earlier DSCP rule takes precedence over the port rule
+    ip.SetTos(46 << 2);
+    NS_TEST_ASSERT_MSG_EQ(classifier.Classify(packet, ip, rule), HIGH_PRIORITY, "DSCP rule");
+    NS_TEST_ASSERT_MSG_EQ(rule, 0, "Rules are matched in order");
+
+    ip.SetTos(0);
+    ip.SetDestination(Ipv4Address("10.2.3.4"));
+    udp.SetDestinationPort(6000);
+    packet = Create<Packet>(20);
+    packet->AddHeader(udp);
+    NS_TEST_ASSERT_MSG_EQ(classifier.Classify(packet, ip, rule), HIGH_PRIORITY, "Prefix rule");
+    NS_TEST_ASSERT_MSG_EQ(rule, 2, "Matched by the prefix rule");
+
+    ip.SetDestination(Ipv4Address("10.3.0.1"));
+    NS_TEST_ASSERT_MSG_EQ(classifier.Classify(packet, ip, rule), NORMAL_PRIORITY, "Fallback");
+    NS_TEST_ASSERT_MSG_EQ(rule, -1, "No rule matched");
+
+    // Peeking, as the source does without a transport header, counts nothing
+    ip.SetDestination(Ipv4Address("10.2.3.4"));
+    NS_TEST_ASSERT_MSG_EQ(classifier.Peek(nullptr, ip), HIGH_PRIORITY, "Peek at the prefix rule");
+    NS_TEST_ASSERT_MSG_EQ(classifier.GetHits(0), 1, "DSCP rule hits");
+    NS_TEST_ASSERT_MSG_EQ(classifier.GetHits(1), 1, "Port rule hits");
+    NS_TEST_ASSERT_MSG_EQ(classifier.GetHits(2), 1, "Prefix rule hits");
+
+    // A malformed table is rejected and leaves the old one in place
+    NS_TEST_ASSERT_MSG_EQ(classifier.SetRules("dscp=99:high"), false, "DSCP out of range");
+    NS_TEST_ASSERT_MSG_EQ(classifier.SetRules("udp:urgent"), false, "Unknown priority");
+    NS_TEST_ASSERT_MSG_EQ(classifier.SetRules("port=9-1:high"), false, "Empty port range");
+    NS_TEST_ASSERT_MSG_EQ(classifier.GetNRules(), 4, "Old rules kept");
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR multipath route store test case
+ */
+class RtMhrMultipathTestCase : public TestCase
+{
+  public:
+    RtMhrMultipathTestCase();
+    virtual ~RtMhrMultipathTestCase();
+
+  private:
+    virtual void DoRun() override;
+
+    /**
+     * \brief Build a path
+     * \param nextHop its first hop
+     * \param hopCount its length
+     * \return the path
+     */
+    RoutePath MakePath(Ipv4Address nextHop, uint32_t hopCount);
+};
+
+RtMhrMultipathTestCase::RtMhrMultipathTestCase()
+    : TestCase("RT-MHR multipath route store test")
+{
+}
+
+RtMhrMultipathTestCase::~RtMhrMultipathTestCase()
+{
+}
+
+RoutePath
+RtMhrMultipathTestCase::MakePath(Ipv4Address nextHop, uint32_t hopCount)
+{
+    RoutePath path{nextHop, 1, hopCount, Seconds(30), CrossLayerMetric(), Time::Max()};
+    path.metric.linkQuality = 1.0;
+    path.metric.hopCount = hopCount;
+    return path;
+}
+
+void
+RtMhrMultipathTestCase::DoRun()
+{
+    Ipv4Address a("10.1.1.2");
+    Ipv4Address b("10.1.1.3");
+    Ipv4Address c("10.1.1.4");
+    RtMhrMetricEngine engine;
+    RouteEntry entry(Ipv4Address("10.1.1.9"), Seconds(30));
+    entry.SetPrimary(MakePath(a, 3));
+
+    // A shorter path takes over and the old primary becomes the backup
+    NS_TEST_ASSERT_MSG_EQ(entry.OfferPath(MakePath(b, 1), engine, 2), true, "Better path kept");
+    NS_TEST_ASSERT_MSG_EQ(entry.nextHop, b, "Best path is primary");
+    NS_TEST_ASSERT_MSG_EQ(entry.backupPaths.size(), 1, "Old primary is a backup");
+
+    // Only the best two paths are kept
+    RoutePath unstable = MakePath(c, 2);
+    unstable.breakTime = Seconds(20);
+    NS_TEST_ASSERT_MSG_EQ(entry.OfferPath(unstable, engine, 2), true, "Second best kept");
+    NS_TEST_ASSERT_MSG_EQ(entry.HasNextHop(a), false, "Worst path dropped");
+    NS_TEST_ASSERT_MSG_EQ(entry.OfferPath(MakePath(a, 3), engine, 2), false, "Worse path refused");
+
+    // A refresh through the primary's next hop replaces it, ranked in place
+    const RoutePath* storage = entry.backupPaths.data();
+    entry.OfferPath(MakePath(b, 1), engine, 2);
+    NS_TEST_ASSERT_MSG_EQ(entry.nextHop, b, "Refresh keeps the primary");
+    NS_TEST_ASSERT_MSG_EQ(entry.backupPaths.size(), 1, "Refresh adds no path");
+    NS_TEST_ASSERT_MSG_EQ(entry.backupPaths.data(), storage, "Backup storage reused");
+
+    // Losing the primary promotes the backup at once
+    entry.route = Create<Ipv4Route>();
+    NS_TEST_ASSERT_MSG_EQ(entry.Failover(b), true, "Backup available");
+    NS_TEST_ASSERT_MSG_EQ(entry.nextHop, c, "Backup promoted");
+    NS_TEST_ASSERT_MSG_EQ(entry.hopCount, 2, "Backup hop count");
+    NS_TEST_ASSERT_MSG_EQ(entry.breakTime, Seconds(20), "Backup predicted break");
+    NS_TEST_ASSERT_MSG_EQ(entry.route, nullptr, "Cached route dropped");
+
+    // The last path going expires the route
+    NS_TEST_ASSERT_MSG_EQ(entry.Failover(c), false, "No path left");
+    NS_TEST_ASSERT_MSG_EQ(entry.IsExpired(), true, "Route expired");
+
+    // A multi-radio relay can leave on another interface than it received on
+    RouteEntry radios(Ipv4Address("10.1.1.9"), Seconds(30));
+    radios.SetPrimary(MakePath(a, 1));
+    RoutePath otherRadio = MakePath(b, 2);
+    otherRadio.interface = 2;
+    radios.OfferPath(MakePath(c, 2), engine, 3);
+    radios.OfferPath(otherRadio, engine, 3);
+    const RoutePath* diverse = radios.FindPathAvoiding(1, 0.0);
+    NS_TEST_ASSERT_MSG_NE(diverse, nullptr, "Backup on the other radio found");
+    NS_TEST_ASSERT_MSG_EQ(diverse->nextHop, b, "Same-interface backup skipped");
+    NS_TEST_ASSERT_MSG_EQ(radios.FindPathAvoiding(2, 0.0)->nextHop, c, "Best other backup");
+    NS_TEST_ASSERT_MSG_EQ(radios.FindPathAvoiding(1, radios.metric.score),
+                          nullptr,
+                          "Backups short of the minimum score refused");
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR MAC feedback link estimation test case
+ */
+class RtMhrLinkEstimationTestCase : public TestCase
+{
+  public:
+    RtMhrLinkEstimationTestCase();
+    virtual ~RtMhrLinkEstimationTestCase();
+
+  private:
+    virtual void DoRun() override;
+};
+
+RtMhrLinkEstimationTestCase::RtMhrLinkEstimationTestCase()
+    : TestCase("RT-MHR MAC feedback link estimation test")
+{
+}
+
+RtMhrLinkEstimationTestCase::~RtMhrLinkEstimationTestCase()
+{
+}
+
+void
+RtMhrLinkEstimationTestCase::DoRun()
+{
+    // The MAC cache keeps every mapping as it grows
+    RtMhrMacCache cache;
+    char mac[18];
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        std::snprintf(mac, sizeof(mac), "00:00:00:00:%02x:%02x", i >> 8, i & 0xff);
+        cache.Insert(Mac48Address(mac), Ipv4Address(0x0a010100 + i));
+    }
+    NS_TEST_ASSERT_MSG_EQ(cache.GetSize(), 100, "All mappings stored");
+    Ipv4Address addr;
+    NS_TEST_ASSERT_MSG_EQ(cache.Lookup(Mac48Address("00:00:00:00:00:2a"), addr),
+                          true,
+                          "Known MAC found");
+    NS_TEST_ASSERT_MSG_EQ(addr, Ipv4Address("10.1.1.42"), "Mapped address");
+    NS_TEST_ASSERT_MSG_EQ(cache.Lookup(Mac48Address("00:00:00:00:01:00"), addr),
+                          false,
+                          "Unknown MAC not found");
+
+    // Acknowledged and failed attempts move the delivery ratio
+    NeighborEntry neighbor(Ipv4Address("10.1.1.2"), Seconds(30));
+    NS_TEST_ASSERT_MSG_EQ_TOL(neighbor.GetEtx(), 1.0, 1e-12, "A new link is assumed perfect");
+    neighbor.metric.epoch = 1;
+    neighbor.UpdateLinkQuality(0.0, 0.5);
+    NS_TEST_ASSERT_MSG_EQ_TOL(neighbor.linkQuality, 0.5, 1e-12, "Failed attempt");
+    NS_TEST_ASSERT_MSG_EQ_TOL(neighbor.GetEtx(), 2.0, 1e-12, "Two transmissions expected");
+    NS_TEST_ASSERT_MSG_EQ_TOL(neighbor.metric.linkQuality, 0.5, 1e-12, "Metric follows");
+    NS_TEST_ASSERT_MSG_EQ(neighbor.metric.epoch, 0, "Metric score made stale");
+    neighbor.UpdateLinkQuality(1.0, 0.5);
+    NS_TEST_ASSERT_MSG_EQ_TOL(neighbor.linkQuality, 0.75, 1e-12, "Acknowledged attempt");
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR adaptive beacon interval test case
+ */
+class RtMhrBeaconSchedulerTestCase : public TestCase
+{
+  public:
+    RtMhrBeaconSchedulerTestCase();
+    virtual ~RtMhrBeaconSchedulerTestCase();
+
+  private:
+    virtual void DoRun() override;
+};
+
+RtMhrBeaconSchedulerTestCase::RtMhrBeaconSchedulerTestCase()
+    : TestCase("RT-MHR adaptive beacon interval test")
+{
+}
+
+RtMhrBeaconSchedulerTestCase::~RtMhrBeaconSchedulerTestCase()
+{
+}
+
+void
+RtMhrBeaconSchedulerTestCase::DoRun()
+{
+    RtMhrBeaconScheduler beacon;
+    beacon.SetBounds(Seconds(1), Seconds(8));
+    beacon.SetMobilityThreshold(1.0);
+    NS_TEST_ASSERT_MSG_EQ(beacon.GetInterval(), Seconds(1), "Starts at the minimum");
+
+    // A stable, parked neighborhood backs off to the maximum
+    NS_TEST_ASSERT_MSG_EQ(beacon.Update(0.0), Seconds(2), "Doubled");
+    NS_TEST_ASSERT_MSG_EQ(beacon.Update(0.0), Seconds(4), "Doubled");
+    NS_TEST_ASSERT_MSG_EQ(beacon.Update(0.0), Seconds(8), "Doubled");
+    NS_TEST_ASSERT_MSG_EQ(beacon.Update(0.0), Seconds(8), "Capped at the maximum");
+
+    // Movement halves it, churn resets it
+    NS_TEST_ASSERT_MSG_EQ(beacon.Update(5.0), Seconds(4), "Halved while mobile");
+    beacon.NotifyChurn();
+    NS_TEST_ASSERT_MSG_EQ(beacon.Update(0.0), Seconds(1), "Back to the minimum on churn");
+    NS_TEST_ASSERT_MSG_EQ(beacon.Update(5.0), Seconds(1), "Never below the minimum");
+
+    // Other broadcast traffic suppresses only the next beacon
+    NS_TEST_ASSERT_MSG_EQ(beacon.IsSuppressed(), false, "Nothing sent yet");
+    beacon.NotifyTraffic();
+    NS_TEST_ASSERT_MSG_EQ(beacon.IsSuppressed(), true, "Broadcast stands in for the beacon");
+    beacon.Update(0.0);
+    NS_TEST_ASSERT_MSG_EQ(beacon.IsSuppressed(), false, "Cleared at beacon time");
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR link expiration time prediction test case
+ */
+class RtMhrMobilityTestCase : public TestCase
+{
+  public:
+    RtMhrMobilityTestCase();
+    virtual ~RtMhrMobilityTestCase();
+
+  private:
+    virtual void DoRun() override;
+};
+
+RtMhrMobilityTestCase::RtMhrMobilityTestCase()
+    : TestCase("RT-MHR link expiration time prediction test")
+{
+}
+
+RtMhrMobilityTestCase::~RtMhrMobilityTestCase()
+{
+}
+
+void
+RtMhrMobilityTestCase::DoRun()
+{
+    RtMhrMobilityPredictor predictor;
+    predictor.SetRange(250.0);
+
+    // Same velocity: the link never breaks
+    Time let = predictor.GetLinkExpirationTime(Vector(0, 0, 0),
+                                               Vector(30, 0, 0),
+                                               Vector(100, 0, 0),
+                                               Vector(30, 0, 0));
+    NS_TEST_ASSERT_MSG_EQ(let, Time::Max(), "Convoy link is stable");
+    NS_TEST_ASSERT_MSG_EQ_TOL(RtMhrMobilityPredictor::ToMobilityMetric(let), 0.0, 1e-12, "No mobility");
+
+    // Moving apart at 10 m/s from 100 m: 150 m to go
+    let = predictor.GetLinkExpirationTime(Vector(0, 0, 0),
+                                          Vector(-5, 0, 0),
+                                          Vector(100, 0, 0),
+                                          Vector(5, 0, 0));
+    NS_TEST_ASSERT_MSG_EQ_TOL(let.GetSeconds(), 15.0, 1e-6, "Diverging link");
+
+    // Closing in at 20 m/s from 100 m: passes, then 250 m apart after 350 m
+    let = predictor.GetLinkExpirationTime(Vector(0, 0, 0),
+                                          Vector(10, 0, 0),
+                                          Vector(100, 0, 0),
+                                          Vector(-10, 0, 0));
+    NS_TEST_ASSERT_MSG_EQ_TOL(let.GetSeconds(), 17.5, 1e-6, "Oncoming link");
+
+    // Passing abreast 150 m to the side: range left along the road is 200 m each way
+    let = predictor.GetLinkExpirationTime(Vector(0, 0, 0),
+                                          Vector(20, 0, 0),
+                                          Vector(0, 150, 0),
+                                          Vector(0, 0, 0));
+    NS_TEST_ASSERT_MSG_EQ_TOL(let.GetSeconds(), 10.0, 1e-6, "Side link");
+
+    // Heard beyond the range while moving apart: at the edge already
+    let = predictor.GetLinkExpirationTime(Vector(0, 0, 0),
+                                          Vector(0, 0, 0),
+                                          Vector(300, 0, 0),
+                                          Vector(1, 0, 0));
+    NS_TEST_ASSERT_MSG_EQ(let, Seconds(0), "Range taken as the observed distance");
+
+    // Metric and link expiration time convert both ways
+    double mobility = RtMhrMobilityPredictor::ToMobilityMetric(Seconds(20));
+    NS_TEST_ASSERT_MSG_EQ_TOL(mobility, RtMhrMobilityPredictor::LET_SCALE / 20, 1e-12, "Metric");
+    NS_TEST_ASSERT_MSG_EQ_TOL(RtMhrMobilityPredictor::FromMobilityMetric(mobility).GetSeconds(),
+                              20.0,
+                              1e-9,
+                              "Round trip");
+    NS_TEST_ASSERT_MSG_EQ(RtMhrMobilityPredictor::FromMobilityMetric(0.0),
+                          Time::Max(),
+                          "Stable path");
+
+    // Dead reckoning
+    Vector p = RtMhrMobilityPredictor::Extrapolate(Vector(10, 20, 0), Vector(2, -1, 0), Seconds(3));
+    NS_TEST_ASSERT_MSG_EQ_TOL(p.x, 16.0, 1e-12, "Extrapolated x");
+    NS_TEST_ASSERT_MSG_EQ_TOL(p.y, 17.0, 1e-12, "Extrapolated y");
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR route freshness test case, for replies by intermediate nodes
+ */
+class RtMhrRouteFreshnessTestCase : public TestCase
+{
+  public:
+    RtMhrRouteFreshnessTestCase();
+    virtual ~RtMhrRouteFreshnessTestCase();
+
+  private:
+    virtual void DoRun() override;
+};
+
+RtMhrRouteFreshnessTestCase::RtMhrRouteFreshnessTestCase()
+    : TestCase("RT-MHR route freshness test")
+{
+}
+
+RtMhrRouteFreshnessTestCase::~RtMhrRouteFreshnessTestCase()
+{
+}
+
+void
+RtMhrRouteFreshnessTestCase::DoRun()
+{
+    RouteEntry rt(Ipv4Address("10.0.0.9"), Seconds(30));
+    NS_TEST_ASSERT_MSG_EQ(rt.IsFresh(0), false, "Unknown sequence number answers nothing");
+
+    rt.sequenceNumber = 5;
+    NS_TEST_ASSERT_MSG_EQ(rt.IsFresh(0), true, "Any known number beats an unknown one");
+    NS_TEST_ASSERT_MSG_EQ(rt.IsFresh(4), true, "Newer than requested");
+    NS_TEST_ASSERT_MSG_EQ(rt.IsFresh(5), true, "As fresh as requested");
+    NS_TEST_ASSERT_MSG_EQ(rt.IsFresh(6), false, "Older than requested");
+
+    // Sequence numbers wrap around
+    rt.sequenceNumber = 2;
+    NS_TEST_ASSERT_MSG_EQ(rt.IsFresh(0xfffffffe), true, "Newer across the wrap");
+    rt.sequenceNumber = 0xfffffffe;
+    NS_TEST_ASSERT_MSG_EQ(rt.IsFresh(2), false, "Older across the wrap");
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR multi-hop route discovery test case
+ *
+ * On a line of six nodes, the second node looks for the last one. Its
+ * expanding ring goes out with TTL 1, 3 and 5, each ring after the previous
+ * one timed out, and the destination answers the last one. The first node
+ * then looks for the same destination: the second node answers for it from
+ * its fresh route, and sends the destination a gratuitous reply, unless
+ * DestinationOnly makes it keep quiet, in which case the first node needs
+ * the same three rings.
+ */
+class RtMhrDiscoveryTestCase : public TestCase
+{
+  public:
+    /**
+     * \brief Constructor
+     * \param destinationOnly the DestinationOnly attribute
+     */
+    RtMhrDiscoveryTestCase(bool destinationOnly);
+    virtual ~RtMhrDiscoveryTestCase();
+
+  private:
+    /// A message seen by the traces
+    struct Message
+    {
+        Time time;                 ///< When it was sent or received
+        uint32_t ttl;              ///< TTL it arrived with, 0 if sent
+        rtmhr::RtMhrHeader header; ///< Its header
+    };
+
+    virtual void DoRun() override;
+
+    /**
+     * \brief Record a message received by a node
+     * \param context the node index
+     * \param packet the message
+     */
+    void Received(std::string context, Ptr<const Packet> packet);
+
+    /**
+     * \brief Record a message sent by a node
+     * \param context the node index
+     * \param packet the message
+     */
+    void Sent(std::string context, Ptr<const Packet> packet);
+
+    /**
+     * \brief Send a datagram
+     * \param from the sending node
+     * \param to the destination node
+     */
+    void Send(uint32_t from, uint32_t to);
+
+    /**
+     * \brief Get the messages of a type a node received from an originator
+     * \param node the receiving node
+     * \param type the message type
+     * \param origin the originating node
+     * \param hops the hops the messages had come before the last one
+     * \return the messages, oldest first
+     */
+    std::vector<Message> GetReceived(uint32_t node,
+                                     MessageType type,
+                                     uint32_t origin,
+                                     uint8_t hops) const;
+
+    /**
+     * \brief Count the RREPs a node sent for a destination to an originator
+     * \param node the sending node
+     * \param dst the destination node the RREP is for
+     * \param origin the originating node it goes to
+     * \return the number of RREPs
+     */
+    uint32_t CountReplies(uint32_t node, uint32_t dst, uint32_t origin) const;
+
+    bool m_destinationOnly;                 ///< DestinationOnly attribute
+    RtMhrTestTopology m_line;               ///< The six nodes
+    RtMhrHelper m_rtmhr;                    ///< Helper of the scenario
+    std::vector<std::vector<Message>> m_rx; ///< Messages received, by node
+    std::vector<std::vector<Message>> m_tx; ///< Messages sent, by node
+    std::vector<Ptr<Socket>> m_sockets;     ///< Sending sockets, by node
+};
+
+RtMhrDiscoveryTestCase::RtMhrDiscoveryTestCase(bool destinationOnly)
+    : TestCase(destinationOnly ? "RT-MHR multi-hop route discovery test, destination only"
+                               : "RT-MHR multi-hop route discovery test"),
+      m_destinationOnly(destinationOnly),
+      m_line(RtMhrTestTopology::HIGHWAY, 6)
+{
+}
+
+RtMhrDiscoveryTestCase::~RtMhrDiscoveryTestCase()
+{
+}
+
+void
+RtMhrDiscoveryTestCase::Received(std::string context, Ptr<const Packet> packet)
+{
+    // The receiving socket records the TTL left in the IP header
+    Message message{Simulator::Now(), 0, rtmhr::RtMhrHeader()};
+    packet->PeekHeader(message.header);
+    SocketIpTtlTag tag;
+    if (packet->PeekPacketTag(tag))
+    {
+        message.ttl = tag.GetTtl();
+    }
+    m_rx[std::stoul(context)].push_back(message);
+}
+
+void
+RtMhrDiscoveryTestCase::Sent(std::string context, Ptr<const Packet> packet)
+{
+    Message message{Simulator::Now(), 0, rtmhr::RtMhrHeader()};
+    packet->PeekHeader(message.header);
+    m_tx[std::stoul(context)].push_back(message);
+}
+
+void
+RtMhrDiscoveryTestCase::Send(uint32_t from, uint32_t to)
+{
+    m_sockets[from]->SendTo(Create<Packet>(64), 0, InetSocketAddress(m_line.GetAddress(to), 9));
+}
+
+std::vector<RtMhrDiscoveryTestCase::Message>
+RtMhrDiscoveryTestCase::GetReceived(uint32_t node,
+                                    MessageType type,
+                                    uint32_t origin,
+                                    uint8_t hops) const
+{
+    std::vector<Message> messages;
+    for (const Message& message : m_rx[node])
+    {
+        if (message.header.GetMessageType() == type && message.header.GetHopCount() == hops &&
+            message.header.GetOrigin() == m_line.GetAddress(origin))
+        {
+            messages.push_back(message);
+        }
+    }
+    return messages;
+}
+
+uint32_t
+RtMhrDiscoveryTestCase::CountReplies(uint32_t node, uint32_t dst, uint32_t origin) const
+{
+    uint32_t replies = 0;
+    for (const Message& message : m_tx[node])
+    {
+        if (message.header.GetMessageType() == RTMHR_RREP &&
+            message.header.GetDestination() == m_line.GetAddress(dst) &&
+            message.header.GetOrigin() == m_line.GetAddress(origin))
+        {
+            replies++;
+        }
+    }
+    return replies;
+}
+
+void
+RtMhrDiscoveryTestCase::DoRun()
+{
+    // A line of stationary vehicles, 100 m apart with a 150 m range
+    m_rtmhr.Set("DestinationOnly", BooleanValue(m_destinationOnly));
+    m_line.SetLanes(1);
+    m_line.SetSpeed(0.0);
+    m_line.SetSpacing(100.0);
+    m_line.SetRange(150.0);
+    m_line.Install(m_rtmhr);
+    m_rx.resize(6);
+    m_tx.resize(6);
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        Ptr<RtMhr> rtmhr = m_rtmhr.GetRtMhr(m_line.GetNodes().Get(i));
+        std::string context = std::to_string(i);
+        rtmhr->TraceConnect("Rx", context, MakeCallback(&RtMhrDiscoveryTestCase::Received, this));
+        rtmhr->TraceConnect("Tx", context, MakeCallback(&RtMhrDiscoveryTestCase::Sent, this));
+        m_sockets.push_back(
+            Socket::CreateSocket(m_line.GetNodes().Get(i), UdpSocketFactory::GetTypeId()));
+    }
+    Ptr<Socket> sink =
+        Socket::CreateSocket(m_line.GetNodes().Get(5), UdpSocketFactory::GetTypeId());
+    sink->Bind(InetSocketAddress(Ipv4Address::GetAny(), 9));
+
+    Simulator::Schedule(Seconds(3), &RtMhrDiscoveryTestCase::Send, this, 1, 5);
+    Simulator::Schedule(Seconds(5), &RtMhrDiscoveryTestCase::Send, this, 0, 5);
+    Simulator::Stop(Seconds(7));
+    Simulator::Run();
+
+    // The rings of the second node, heard by its neighbor towards the
+    // destination; a ring times out after NodeTraversalTime * 2 * (TTL + 2)
+    std::vector<Message> rings = GetReceived(2, RTMHR_RREQ, 1, 0);
+    NS_TEST_ASSERT_MSG_EQ(rings.size(), 3, "Three rings");
+    const uint32_t ttls[] = {1, 3, 5};
+    const Time starts[] = {Seconds(3), MilliSeconds(3240), MilliSeconds(3640)};
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        NS_TEST_ASSERT_MSG_EQ(rings[i].ttl, ttls[i], "TTL of ring " << i);
+        NS_TEST_ASSERT_MSG_EQ_TOL(rings[i].time,
+                                  starts[i],
+                                  MilliSeconds(1),
+                                  "Start of ring " << i);
+    }
+    std::vector<Message> heard = GetReceived(5, RTMHR_RREQ, 1, 3);
+    NS_TEST_ASSERT_MSG_EQ(heard.size(), 1, "Only the last ring reached the destination");
+    NS_TEST_ASSERT_MSG_EQ(heard[0].ttl, 2, "Four hops into a TTL of 5");
+    NS_TEST_ASSERT_MSG_EQ(CountReplies(5, 5, 1), 1, "The destination answered the last ring");
+    for (uint32_t node = 2; node < 5; node++)
+    {
+        NS_TEST_ASSERT_MSG_EQ(CountReplies(node, 5, 1), 1, "Reply relayed by node " << node);
+    }
+
+    // The first node's requests, heard by its only neighbor
+    Ptr<RtMhr> first = m_rtmhr.GetRtMhr(m_line.GetNodes().Get(0));
+    const RouteEntry* rt = first->GetRoutingTable().Find(m_line.GetAddress(5));
+    NS_TEST_ASSERT_MSG_NE(rt, nullptr, "The first node found the destination");
+    NS_TEST_ASSERT_MSG_EQ(rt->nextHop, m_line.GetAddress(1), "Through the second node");
+    NS_TEST_ASSERT_MSG_EQ(rt->hopCount, 5, "Five hops");
+    rings = GetReceived(1, RTMHR_RREQ, 0, 0);
+    heard = GetReceived(5, RTMHR_RREQ, 0, 4);
+    std::vector<Message> gratuitous;
+    for (const Message& message : m_rx[5])
+    {
+        if (message.header.GetMessageType() == RTMHR_RREP &&
+            message.header.GetDestination() == m_line.GetAddress(0))
+        {
+            gratuitous.push_back(message);
+        }
+    }
+    if (m_destinationOnly)
+    {
+        NS_TEST_ASSERT_MSG_EQ(rings.size(), 3, "No intermediate answer, three rings");
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            NS_TEST_ASSERT_MSG_EQ(rings[i].ttl, ttls[i], "TTL of ring " << i);
+        }
+        NS_TEST_ASSERT_MSG_EQ(heard.size(), 1, "The last ring reached the destination");
+        NS_TEST_ASSERT_MSG_EQ(CountReplies(5, 5, 0), 1, "The destination answered");
+        NS_TEST_ASSERT_MSG_EQ(gratuitous.size(), 0, "No gratuitous reply");
+    }
+    else
+    {
+        NS_TEST_ASSERT_MSG_EQ(rings.size(), 1, "Answered within the first ring");
+        NS_TEST_ASSERT_MSG_EQ(rings[0].ttl, 1, "TTL of the first ring");
+        NS_TEST_ASSERT_MSG_EQ(heard.size(), 0, "The RREQ never reached the destination");
+        NS_TEST_ASSERT_MSG_EQ(CountReplies(1, 5, 0), 1, "The second node answered");
+        NS_TEST_ASSERT_MSG_EQ(CountReplies(5, 5, 0), 0, "Not the destination");
+        NS_TEST_ASSERT_MSG_EQ(gratuitous.size(), 1, "Gratuitous reply reached the destination");
+        const RouteEntry* back =
+            m_rtmhr.GetRtMhr(m_line.GetNodes().Get(5))->GetRoutingTable().Find(
+                m_line.GetAddress(0));
+        NS_TEST_ASSERT_MSG_NE(back, nullptr, "The destination has a route back");
+        NS_TEST_ASSERT_MSG_EQ(back->nextHop, m_line.GetAddress(4), "Through its neighbor");
+        NS_TEST_ASSERT_MSG_EQ(back->hopCount, 5, "Five hops back");
+    }
+
+    for (auto& socket : m_sockets)
+    {
+        socket->Close();
+    }
+    sink->Close();
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR RREQ broadcast suppression test case
+ */
+class RtMhrFloodControlTestCase : public TestCase
+{
+  public:
+    RtMhrFloodControlTestCase();
+    virtual ~RtMhrFloodControlTestCase();
+
+  private:
+    virtual void DoRun() override;
+};
+
+RtMhrFloodControlTestCase::RtMhrFloodControlTestCase()
+    : TestCase("RT-MHR RREQ broadcast suppression test")
+{
+}
+
+RtMhrFloodControlTestCase::~RtMhrFloodControlTestCase()
+{
+}
+
+void
+RtMhrFloodControlTestCase::DoRun()
+{
+    Ipv4Address origin("10.0.0.1");
+    RtMhrFloodControl flood;
+    NS_TEST_ASSERT_MSG_EQ(flood.IsDeferred(), false, "Plain flooding decides at once");
+
+    // Counter: the threshold number of copies cancels the rebroadcast
+    flood.SetMode(RTMHR_FLOOD_COUNTER);
+    flood.SetCounterThreshold(3);
+    NS_TEST_ASSERT_MSG_EQ(flood.IsDeferred(), true, "Counter mode waits");
+    flood.Add(origin, 1);
+    flood.Add(origin, 2);
+    NS_TEST_ASSERT_MSG_EQ((flood.Find(origin, 3) == nullptr), true, "Not under assessment");
+    flood.Find(origin, 1)->copies += 2;
+    flood.Find(origin, 2)->copies += 1;
+    NS_TEST_ASSERT_MSG_EQ(flood.Release(origin, 1), false, "Three copies heard, suppressed");
+    NS_TEST_ASSERT_MSG_EQ(flood.Release(origin, 2), true, "Two copies heard, rebroadcast");
+    NS_TEST_ASSERT_MSG_EQ(flood.GetSize(), 0, "Released assessments are gone");
+    NS_TEST_ASSERT_MSG_EQ(flood.Release(origin, 2), false, "Released only once");
+
+    // Coverage: rebroadcast while some neighbor may not have heard a copy
+    flood.SetMode(RTMHR_FLOOD_COVERAGE);
+    flood.Add(origin, 4).uncovered.push_back(Ipv4Address("10.0.0.7"));
+    flood.Add(origin, 5);
+    NS_TEST_ASSERT_MSG_EQ(flood.Release(origin, 4), true, "A neighbor is left uncovered");
+    NS_TEST_ASSERT_MSG_EQ(flood.Release(origin, 5), false, "Every neighbor covered");
+
+    // Changing the mode drops what is pending
+    flood.Add(origin, 6);
+    flood.SetMode(RTMHR_FLOOD_PROBABILISTIC);
+    NS_TEST_ASSERT_MSG_EQ(flood.GetSize(), 0, "Assessments dropped on a mode change");
+
+    // Probabilistic: from the minimum next to the sender to 1 at the range edge
+    flood.SetMinProbability(0.4);
+    NS_TEST_ASSERT_MSG_EQ_TOL(flood.GetProbability(0.0), 0.4, 1e-12, "Minimum next to the sender");
+    NS_TEST_ASSERT_MSG_EQ_TOL(flood.GetProbability(0.5), 0.7, 1e-12, "Linear in distance");
+    NS_TEST_ASSERT_MSG_EQ_TOL(flood.GetProbability(2.0), 1.0, 1e-12, "Capped at the range");
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR protocol statistics test case
+ */
+class RtMhrStatsTestCase : public TestCase
+{
+  public:
+    RtMhrStatsTestCase();
+    virtual ~RtMhrStatsTestCase();
+
+  private:
+    virtual void DoRun() override;
+    void TestHistogram();
+    void TestCounters();
+    void TestSimulation();
+
+    /**
+     * \brief Tx trace sink
+     * \param packet the control packet
+     */
+    void Sent(Ptr<const Packet> packet);
+
+    /**
+     * \brief RouteTableSize trace sink
+     * \param oldValue the previous size
+     * \param newValue the new size
+     */
+    void RouteTableSizeChanged(uint32_t oldValue, uint32_t newValue);
+
+    uint32_t m_sent;   ///< Packets seen by the Tx trace
+    uint32_t m_routes; ///< Last size seen by the RouteTableSize trace
+};
+
+RtMhrStatsTestCase::RtMhrStatsTestCase()
+    : TestCase("RT-MHR protocol statistics test"),
+      m_sent(0),
+      m_routes(0)
+{
+}
+
+RtMhrStatsTestCase::~RtMhrStatsTestCase()
+{
+}
+
+void
+RtMhrStatsTestCase::Sent(Ptr<const Packet> packet)
+{
+    m_sent++;
+}
+
+void
+RtMhrStatsTestCase::RouteTableSizeChanged(uint32_t oldValue, uint32_t newValue)
+{
+    m_routes = newValue;
+}
+
+void
+RtMhrStatsTestCase::TestHistogram()
+{
+    RtMhrLatencyHistogram histogram;
+    NS_TEST_ASSERT_MSG_EQ(histogram.GetQuantile(0.5), Time(0), "Empty histogram");
+
+    // Power-of-two millisecond buckets, the last one open-ended
+    histogram.Add(MicroSeconds(500));
+    histogram.Add(MilliSeconds(3));
+    histogram.Add(MilliSeconds(3));
+    histogram.Add(Seconds(100));
+    NS_TEST_ASSERT_MSG_EQ(histogram.GetCount(), 4, "Every sample counted");
+    NS_TEST_ASSERT_MSG_EQ(histogram.GetBucket(0), 1, "Under 1 ms");
+    NS_TEST_ASSERT_MSG_EQ(histogram.GetBucket(2), 2, "Between 2 and 4 ms");
+    NS_TEST_ASSERT_MSG_EQ(histogram.GetBucket(RtMhrLatencyHistogram::BUCKETS - 1),
+                          1,
+                          "Longer than the last limit");
+    NS_TEST_ASSERT_MSG_EQ(histogram.GetMin(), MicroSeconds(500), "Minimum");
+    NS_TEST_ASSERT_MSG_EQ(histogram.GetMax(), Seconds(100), "Maximum");
+    NS_TEST_ASSERT_MSG_EQ(histogram.GetQuantile(0.5), MilliSeconds(4), "Median bucket limit");
+    NS_TEST_ASSERT_MSG_EQ(histogram.GetQuantile(1.0), Seconds(100), "Capped at the maximum");
+
+    RtMhrLatencyHistogram other;
+    other.Add(MicroSeconds(100));
+    histogram.Merge(other);
+    NS_TEST_ASSERT_MSG_EQ(histogram.GetCount(), 5, "Merged samples");
+    NS_TEST_ASSERT_MSG_EQ(histogram.GetMin(), MicroSeconds(100), "Merged minimum");
+    NS_TEST_ASSERT_MSG_EQ(histogram.GetBucket(0), 2, "Merged bucket");
+}
+
+void
+RtMhrStatsTestCase::TestCounters()
+{
+    RtMhrStats a;
+    a.CountSent(RTMHR_HELLO, 20);
+    a.CountSent(RTMHR_RREQ, 40);
+    a.CountReceived(200, 8); // Unknown types share index 0
+    a.CountDropped(RTMHR_RREQ, 40);
+    a.CountQueueDrop(MEDIUM_PRIORITY);
+    NS_TEST_ASSERT_MSG_EQ(a.sent[RTMHR_HELLO].bytes, 20, "Bytes by type");
+    NS_TEST_ASSERT_MSG_EQ(a.received[0].packets, 1, "Unknown type");
+    NS_TEST_ASSERT_MSG_EQ(a.queueDrops[1], 1, "Drops by priority");
+    RtMhrStats::Counter total = RtMhrStats::GetTotal(a.sent);
+    NS_TEST_ASSERT_MSG_EQ(total.packets, 2, "Packets over all types");
+    NS_TEST_ASSERT_MSG_EQ(total.bytes, 60, "Bytes over all types");
+
+    RtMhrStats b;
+    b.CountSent(RTMHR_HELLO, 20);
+    b.discoveries = 3;
+    b.discoveryLatency.Add(MilliSeconds(10));
+    a.Merge(b);
+    NS_TEST_ASSERT_MSG_EQ(a.sent[RTMHR_HELLO].packets, 2, "Merged counters");
+    NS_TEST_ASSERT_MSG_EQ(a.discoveries, 3, "Merged discoveries");
+    NS_TEST_ASSERT_MSG_EQ(a.discoveryLatency.GetCount(), 1, "Merged latencies");
+}
+
+void
+RtMhrStatsTestCase::TestSimulation()
+{
+    NodeContainer nodes;
+    nodes.Create(2);
+    SimpleNetDeviceHelper deviceHelper;
+    deviceHelper.SetChannel("ns3::SimpleChannel");
+    NetDeviceContainer devices = deviceHelper.Install(nodes);
+    InternetStackHelper internet;
+    RtMhrHelper rtmhr;
+    internet.SetRoutingHelper(rtmhr);
+    internet.Install(nodes);
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.1.1.0", "255.255.255.0");
+    ipv4.Assign(devices);
+    MobilityHelper mobility;
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.Install(nodes);
+
+    Ptr<RtMhr> first = rtmhr.GetRtMhr(nodes.Get(0));
+    first->TraceConnectWithoutContext("Tx", MakeCallback(&RtMhrStatsTestCase::Sent, this));
+    first->TraceConnectWithoutContext(
+        "RouteTableSize",
+        MakeCallback(&RtMhrStatsTestCase::RouteTableSizeChanged, this));
+
+    Simulator::Stop(Seconds(5));
+    Simulator::Run();
+
+    // HELLOs went both ways and made the nodes routes to each other
+    RtMhrStats stats = first->GetStats();
+    NS_TEST_ASSERT_MSG_GT(stats.sent[RTMHR_HELLO].packets, 0, "HELLOs sent");
+    NS_TEST_ASSERT_MSG_GT(stats.received[RTMHR_HELLO].packets, 0, "HELLOs received");
+    NS_TEST_ASSERT_MSG_EQ(RtMhrStats::GetTotal(stats.sent).packets, m_sent, "Tx trace fires");
+    NS_TEST_ASSERT_MSG_EQ(stats.routeTableSize, 1, "Route to the other node");
+    NS_TEST_ASSERT_MSG_EQ(m_routes, 1, "RouteTableSize trace follows the table");
+
+    RtMhrStats total = rtmhr.GetStats(nodes);
+    RtMhrStats second = rtmhr.GetRtMhr(nodes.Get(1))->GetStats();
+    NS_TEST_ASSERT_MSG_EQ(total.sent[RTMHR_HELLO].packets,
+                          stats.sent[RTMHR_HELLO].packets + second.sent[RTMHR_HELLO].packets,
+                          "Helper sums the nodes");
+    NS_TEST_ASSERT_MSG_EQ(total.routeTableSize, 2, "Table sizes summed");
+    Simulator::Destroy();
+}
+
+void
+RtMhrStatsTestCase::DoRun()
+{
+    TestHistogram();
+    TestCounters();
+    TestSimulation();
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR binary routing table snapshot test case
+ */
+class RtMhrSnapshotTestCase : public TestCase
+{
+  public:
+    RtMhrSnapshotTestCase();
+    virtual ~RtMhrSnapshotTestCase();
+
+  private:
+    virtual void DoRun() override;
+
+    /**
+     * \brief Write the same three snapshots of one node
+     * \param filename the snapshot file
+     * \param delta whether to write only changes
+     * \return the number of records written
+     */
+    uint64_t WriteSnapshots(std::string filename, bool delta);
+
+    /**
+     * \brief Read a little-endian integer from a file
+     * \param file the file, positioned at the value
+     * \param bytes its width
+     * \return the value
+     */
+    uint64_t ReadLittleEndian(std::ifstream& file, uint32_t bytes);
+};
+
+RtMhrSnapshotTestCase::RtMhrSnapshotTestCase()
+    : TestCase("RT-MHR binary routing table snapshot test")
+{
+}
+
+RtMhrSnapshotTestCase::~RtMhrSnapshotTestCase()
+{
+}
+
+uint64_t
+RtMhrSnapshotTestCase::WriteSnapshots(std::string filename, bool delta)
+{
+    std::vector<RtMhrSnapshotRecord> routes(3);
+    for (uint32_t i = 0; i < routes.size(); ++i)
+    {
+        routes[i].destination = Ipv4Address(0x0a010102 + i);
+        routes[i].nextHop = Ipv4Address("10.1.1.2");
+        routes[i].interface = 1;
+        routes[i].hopCount = i + 1;
+        routes[i].score = 0.5;
+        routes[i].expiry = Seconds(10);
+    }
+
+    RtMhrSnapshotWriter writer(filename, delta);
+    NS_TEST_EXPECT_MSG_EQ(writer.IsGood(), true, "Snapshot file opened");
+    writer.BeginSnapshot(Seconds(1));
+    writer.Write(7, Seconds(1), routes);
+    // Unchanged table
+    writer.BeginSnapshot(Seconds(2));
+    writer.Write(7, Seconds(2), routes);
+    // One route changed, one removed
+    routes[0].hopCount = 4;
+    routes.pop_back();
+    writer.BeginSnapshot(Seconds(3));
+    writer.Write(7, Seconds(3), routes);
+    writer.Close();
+    NS_TEST_EXPECT_MSG_EQ(writer.IsGood(), true, "Snapshot file written");
+    return writer.GetRecordCount();
+}
+
+uint64_t
+RtMhrSnapshotTestCase::ReadLittleEndian(std::ifstream& file, uint32_t bytes)
+{
+    uint64_t value = 0;
+    for (uint32_t i = 0; i < bytes; ++i)
+    {
+        value |= uint64_t(static_cast<uint8_t>(file.get())) << (8 * i);
+    }
+    return value;
+}
+
+void
+RtMhrSnapshotTestCase::DoRun()
+{
+    std::string full = CreateTempDirFilename("rtmhr-full.snapshot");
+    std::string delta = CreateTempDirFilename("rtmhr-delta.snapshot");
+
+    // 3 markers plus 3, 3 and 2 routes
+    NS_TEST_ASSERT_MSG_EQ(WriteSnapshots(full, false), 11, "Full snapshots hold every route");
+    // 3 markers plus 3 routes, nothing, 1 changed and 1 removed
+    NS_TEST_ASSERT_MSG_EQ(WriteSnapshots(delta, true), 8, "Delta snapshots hold changes");
+
+    std::ifstream file(delta, std::ios::binary);
+    char magic[8];
+    file.read(magic, 8);
+    NS_TEST_ASSERT_MSG_EQ(std::string(magic, 8), "RTMHRSNP", "File magic");
+    NS_TEST_ASSERT_MSG_EQ(ReadLittleEndian(file, 2), RtMhrSnapshotWriter::VERSION, "Version");
+    NS_TEST_ASSERT_MSG_EQ(ReadLittleEndian(file, 2), RtMhrSnapshotWriter::RECORD_SIZE, "Size");
+    NS_TEST_ASSERT_MSG_EQ(ReadLittleEndian(file, 4), 1, "Delta flag");
+
+    // The first route follows the first marker
+    file.seekg(RtMhrSnapshotWriter::HEADER_SIZE + RtMhrSnapshotWriter::RECORD_SIZE);
+    NS_TEST_ASSERT_MSG_EQ(ReadLittleEndian(file, 8), 1000000000, "Time in ns");
+    NS_TEST_ASSERT_MSG_EQ(ReadLittleEndian(file, 4), 7, "Node ID");
+    NS_TEST_ASSERT_MSG_EQ(ReadLittleEndian(file, 4), RtMhrSnapshotRecord::ENTRY, "Kind");
+    NS_TEST_ASSERT_MSG_EQ(ReadLittleEndian(file, 4), 0x0a010102, "Destination");
+
+    // The removed route is the last record
+    file.seekg(0, std::ios::end);
+    NS_TEST_ASSERT_MSG_EQ(uint64_t(file.tellg()),
+                          RtMhrSnapshotWriter::HEADER_SIZE + 8 * RtMhrSnapshotWriter::RECORD_SIZE,
+                          "Records are fixed size");
+    file.seekg(-int64_t(RtMhrSnapshotWriter::RECORD_SIZE) + 12, std::ios::end);
+    NS_TEST_ASSERT_MSG_EQ(ReadLittleEndian(file, 4), RtMhrSnapshotRecord::REMOVED, "Removal");
+    NS_TEST_ASSERT_MSG_EQ(ReadLittleEndian(file, 4), 0x0a010104, "Removed destination");
+}
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR RREQ retry heap test case, a friend of RtMhr
+ *
+ * An isolated node starts discoveries that can never succeed, for one and
+ * for sixteen destinations at once, and runs them to the end. The retries of
+ * every destination share one timer, so the extra destinations cost the
+ * scheduler no more events than the extra RREQ frames themselves. A retry
+ * due at once still arms the idle timer.
+ */
+class RtMhrRouteRequestHeapTestCase : public TestCase
+{
+  public:
+    RtMhrRouteRequestHeapTestCase();
+    virtual ~RtMhrRouteRequestHeapTestCase();
+
+  private:
+    virtual void DoRun() override;
+
+    /**
+     * \brief Start the discoveries of a run
+     * \param protocol the isolated node's protocol
+     * \param destinations the number of destinations
+     */
+    static void Discover(Ptr<RtMhr> protocol, uint32_t destinations);
+
+    /**
+     * \brief Run discoveries for a number of destinations to the end
+     * \param destinations the number of destinations
+     * \param rreqs set to the RREQs sent
+     * \return the simulator events run
+     */
+    uint64_t CountEvents(uint32_t destinations, uint64_t& rreqs);
+
+    /**
+     * \brief Build an isolated node
+     * \param rtmhr the helper to install the protocol with
+     * \return its protocol
+     */
+    static Ptr<RtMhr> CreateNode(RtMhrHelper& rtmhr);
+
+    /**
+     * \brief Schedule a retry due at once
+     * \param protocol the isolated node's protocol
+     */
+    static void RetryNow(Ptr<RtMhr> protocol);
+
+    /**
+     * \brief Check that the retry due at once ran
+     * \param protocol the isolated node's protocol
+     */
+    void CheckRetried(Ptr<RtMhr> protocol);
+
+    /// Schedule a retry with no delay while the timer is idle
+    void TestZeroDelay();
+};
+
+RtMhrRouteRequestHeapTestCase::RtMhrRouteRequestHeapTestCase()
+    : TestCase("RT-MHR RREQ retry heap test")
+{
+}
+
+RtMhrRouteRequestHeapTestCase::~RtMhrRouteRequestHeapTestCase()
+{
+}
+
+void
+RtMhrRouteRequestHeapTestCase::Discover(Ptr<RtMhr> protocol, uint32_t destinations)
+{
+    for (uint32_t i = 0; i < destinations; i++)
+    {
+        protocol->SendRouteRequest(Ipv4Address(0x0a090000 + i + 1));
+    }
+}
+
+Ptr<RtMhr>
+RtMhrRouteRequestHeapTestCase::CreateNode(RtMhrHelper& rtmhr)
+{
+    NodeContainer nodes;
+    nodes.Create(1);
+    SimpleNetDeviceHelper deviceHelper;
+    deviceHelper.SetChannel("ns3::SimpleChannel");
+    NetDeviceContainer devices = deviceHelper.Install(nodes);
+    InternetStackHelper internet;
+    internet.SetRoutingHelper(rtmhr);
+    internet.Install(nodes);
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.1.1.0", "255.255.255.0");
+    ipv4.Assign(devices);
+    MobilityHelper mobility;
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.Install(nodes);
+    return rtmhr.GetRtMhr(nodes.Get(0));
+}
+
+uint64_t
+RtMhrRouteRequestHeapTestCase::CountEvents(uint32_t destinations, uint64_t& rreqs)
+{
+    RtMhrHelper rtmhr;
+    rtmhr.Set("RreqRateLimit", UintegerValue(1000));
+    Ptr<RtMhr> protocol = CreateNode(rtmhr);
+
+    // Four rings and three network-wide RREQs take under 9 s
+    Simulator::Schedule(Seconds(1),
+                        &RtMhrRouteRequestHeapTestCase::Discover,
+                        protocol,
+                        destinations);
+    Simulator::Stop(Seconds(15));
+    Simulator::Run();
+    uint64_t events = Simulator::GetEventCount();
+    RtMhrStats stats = protocol->GetStats();
+    rreqs = stats.sent[RTMHR_RREQ].packets;
+    NS_TEST_EXPECT_MSG_EQ(stats.discoveryFailures, destinations, "Every discovery gave up");
+    NS_TEST_EXPECT_MSG_EQ(protocol->m_rreqDeadlines.size(), 0, "No retry left pending");
+    Simulator::Destroy();
+    return events;
+}
+
+void
+RtMhrRouteRequestHeapTestCase::RetryNow(Ptr<RtMhr> protocol)
+{
+    protocol->ScheduleRouteRequest(Ipv4Address("10.9.0.1"), Time(0));
+}
+
+void
+RtMhrRouteRequestHeapTestCase::CheckRetried(Ptr<RtMhr> protocol)
+{
+    // The retry found no discovery under way and started one
+    NS_TEST_ASSERT_MSG_EQ(protocol->GetStats().discoveries, 1, "Retry due at once ran");
+    NS_TEST_ASSERT_MSG_EQ(protocol->m_rreqTimer.IsRunning(), true, "Next retry armed");
+}
+
+void
+RtMhrRouteRequestHeapTestCase::TestZeroDelay()
+{
+    RtMhrHelper rtmhr;
+    Ptr<RtMhr> protocol = CreateNode(rtmhr);
+    Simulator::Schedule(Seconds(1), &RtMhrRouteRequestHeapTestCase::RetryNow, protocol);
+    Simulator::Schedule(Seconds(1.01),
+                        &RtMhrRouteRequestHeapTestCase::CheckRetried,
+                        this,
+                        protocol);
+    Simulator::Stop(Seconds(1.1));
+    Simulator::Run();
+    Simulator::Destroy();
+}
+
+void
+RtMhrRouteRequestHeapTestCase::DoRun()
+{
+    TestZeroDelay();
+
+    uint64_t oneRreqs;
+    uint64_t manyRreqs;
+    uint64_t one = CountEvents(1, oneRreqs);
+    uint64_t many = CountEvents(16, manyRreqs);
+    NS_TEST_ASSERT_MSG_GT(oneRreqs, 0, "RREQs sent");
+    NS_TEST_ASSERT_MSG_EQ(manyRreqs, 16 * oneRreqs, "Same retries for every destination");
+    // With a timer per destination, every extra RREQ would add its retry
+    // event on top of whatever its frame costs
+    NS_TEST_ASSERT_MSG_LT_OR_EQ(many - one, manyRreqs - oneRreqs, "Retries share the events");
+}
+
+} // namespace ns3
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR distributed simulation partition test case
+ *
+ * A node owned by another rank of a distributed simulation shares the channel
+ * with two local nodes; its RT-MHR instance must stay silent.
+ */
+class RtMhrPartitionTestCase : public TestCase
+{
+  public:
+    RtMhrPartitionTestCase();
+    virtual ~RtMhrPartitionTestCase();
+
+  private:
+    virtual void DoRun() override;
+};
+
+RtMhrPartitionTestCase::RtMhrPartitionTestCase()
+    : TestCase("RT-MHR distributed simulation partition test")
+{
+}
+
+RtMhrPartitionTestCase::~RtMhrPartitionTestCase()
+{
+}
+
+void
+RtMhrPartitionTestCase::DoRun()
+{
+    NodeContainer local;
+    local.Create(2);
+    NodeContainer remote;
+    remote.Create(1, Simulator::GetSystemId() + 1);
+    NodeContainer nodes;
+    nodes.Add(local);
+    nodes.Add(remote);
+    NS_TEST_ASSERT_MSG_EQ(RtMhrHelper::IsLocal(local.Get(0)), true, "Local node");
+    NS_TEST_ASSERT_MSG_EQ(RtMhrHelper::IsLocal(remote.Get(0)), false, "Node of another rank");
+
+    SimpleNetDeviceHelper deviceHelper;
+    deviceHelper.SetChannel("ns3::SimpleChannel");
+    NetDeviceContainer devices = deviceHelper.Install(nodes);
+    InternetStackHelper internet;
+    RtMhrHelper rtmhr;
+    rtmhr.Set("PiggybackMetrics", BooleanValue(true));
+    internet.SetRoutingHelper(rtmhr);
+    internet.Install(nodes);
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.1.1.0", "255.255.255.0");
+    ipv4.Assign(devices);
+    MobilityHelper mobility;
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.Install(nodes);
+
+    Simulator::Stop(Seconds(5));
+    Simulator::Run();
+
+    RtMhrStats silent = rtmhr.GetRtMhr(remote.Get(0))->GetStats();
+    NS_TEST_ASSERT_MSG_EQ(RtMhrStats::GetTotal(silent.sent).packets, 0, "Dormant instance");
+    NS_TEST_ASSERT_MSG_EQ(RtMhrStats::GetTotal(silent.received).packets, 0, "Opened no socket");
+    // The local nodes only know each other, learnt from their HELLOs
+    RtMhrStats first = rtmhr.GetRtMhr(local.Get(0))->GetStats();
+    NS_TEST_ASSERT_MSG_GT(first.received[RTMHR_HELLO].packets, 0, "HELLOs between local nodes");
+    NS_TEST_ASSERT_MSG_EQ(first.routeTableSize, 1, "No route to the other rank's node");
+    NS_TEST_ASSERT_MSG_EQ(rtmhr.GetStats(nodes).routeTableSize, 2, "Local nodes summed");
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR location-aided forwarding test case
+ *
+ * Three nodes share a channel on the x axis, at 0, 150 and 200 m, and a
+ * road-side unit that is not there is known to be at 1000 m. The node at 0
+ * forwards towards it through the node at 200; that one is a dead end and
+ * looks for a route with zone RREQs, which the node at 0, outside the zone,
+ * does not rebroadcast.
+ */
+class RtMhrGeoForwardingTestCase : public TestCase
+{
+  public:
+    RtMhrGeoForwardingTestCase();
+    virtual ~RtMhrGeoForwardingTestCase();
+
+  private:
+    virtual void DoRun() override;
+    void TestLocationTable();
+    void CheckLocationAge();
+    void TestHeader();
+    void TestForwarding();
+    void CheckGreedyRoute();
+    void SendToRoadSideUnit();
+
+    RtMhrLocationTable m_table; ///< Table aged by the simulator
+    NodeContainer m_nodes;      ///< Nodes of the forwarding scenario
+    RtMhrHelper m_rtmhr;        ///< Helper of the forwarding scenario
+};
+
+RtMhrGeoForwardingTestCase::RtMhrGeoForwardingTestCase()
+    : TestCase("RT-MHR location-aided forwarding test")
+{
+}
+
+RtMhrGeoForwardingTestCase::~RtMhrGeoForwardingTestCase()
+{
+}
+
+void
+RtMhrGeoForwardingTestCase::TestLocationTable()
+{
+    Ipv4Address car("10.1.1.1");
+    Ipv4Address rsu("10.1.1.100");
+    m_table.Update(car, Vector(10, 20, 0), Vector(10, 0, 0), Seconds(0));
+    m_table.SetFixed(rsu, Vector(1000, 0, 0));
+    m_table.Update(rsu, Vector(5, 5, 0), Vector(), Seconds(0));
+    NS_TEST_ASSERT_MSG_EQ(m_table.GetSize(), 2, "Two known positions");
+
+    Vector center;
+    double radius;
+    NS_TEST_ASSERT_MSG_EQ(m_table.Lookup(Ipv4Address("10.1.1.9"), center, radius),
+                          false,
+                          "Unknown node");
+    NS_TEST_ASSERT_MSG_EQ(m_table.Lookup(rsu, center, radius), true, "Configured node");
+    NS_TEST_ASSERT_MSG_EQ_TOL(center.x, 1000, 1e-9, "Configured position is kept");
+    NS_TEST_ASSERT_MSG_EQ_TOL(radius, 0, 1e-9, "A stationary node stays put");
+
+    Rectangle zone =
+        RtMhrLocationTable::GetRequestZone(Vector(0, 0, 0), Vector(1000, 0, 0), 50, 100);
+    NS_TEST_ASSERT_MSG_EQ_TOL(zone.xMin, -100, 1e-9, "Zone holds the source");
+    NS_TEST_ASSERT_MSG_EQ_TOL(zone.xMax, 1150, 1e-9, "Zone holds the expected zone");
+    NS_TEST_ASSERT_MSG_EQ_TOL(zone.yMin, -150, 1e-9, "Zone widened by radius and margin");
+    NS_TEST_ASSERT_MSG_EQ_TOL(zone.yMax, 150, 1e-9, "Zone widened by radius and margin");
+
+    m_table.SetLifetime(Seconds(5));
+    Simulator::Schedule(Seconds(2), &RtMhrGeoForwardingTestCase::CheckLocationAge, this);
+    Simulator::Run();
+    Simulator::Destroy();
+}
+
+void
+RtMhrGeoForwardingTestCase::CheckLocationAge()
+{
+    Ipv4Address car("10.1.1.1");
+    Vector center;
+    double radius;
+    NS_TEST_ASSERT_MSG_EQ(m_table.Lookup(car, center, radius), true, "Learned node");
+    NS_TEST_ASSERT_MSG_EQ_TOL(center.x, 10, 1e-9, "Last known position");
+    NS_TEST_ASSERT_MSG_EQ_TOL(radius, 20, 1e-9, "Distance covered in 2 s at 10 m/s");
+
+    // An older sample does not replace a newer one
+    m_table.Update(car, Vector(0, 0, 0), Vector(), Seconds(1));
+    m_table.Update(car, Vector(50, 0, 0), Vector(), Seconds(0.5));
+    m_table.Lookup(car, center, radius);
+    NS_TEST_ASSERT_MSG_EQ_TOL(center.x, 0, 1e-9, "Newest sample kept");
+
+    m_table.SetLifetime(Seconds(0.5));
+    NS_TEST_ASSERT_MSG_EQ(m_table.Lookup(car, center, radius), false, "Stale position");
+    m_table.Purge();
+    NS_TEST_ASSERT_MSG_EQ(m_table.GetSize(), 1, "Only the configured position is left");
+}
+
+void
+RtMhrGeoForwardingTestCase::TestHeader()
+{
+    rtmhr::RtMhrHeader zreq(RTMHR_ZONE_RREQ,
+                            2,
+                            7,
+                            Ipv4Address("10.1.1.100"),
+                            Ipv4Address("10.1.1.3"));
+    zreq.SetPosition(Vector(200.5, -3.25, 0));
+    zreq.SetVelocity(Vector(12.5, 0, 0));
+    zreq.SetRequestZone(Rectangle(100, 1100, -100.5, 100));
+    NS_TEST_ASSERT_MSG_EQ(zreq.GetSerializedSize(), 51, "ZRREQ size");
+
+    Ptr<Packet> packet = Create<Packet>();
+    packet->AddHeader(zreq);
+    rtmhr::RtMhrHeader decoded;
+    packet->RemoveHeader(decoded);
+    NS_TEST_ASSERT_MSG_EQ(decoded.GetMessageType(), RTMHR_ZONE_RREQ, "Message type");
+    NS_TEST_ASSERT_MSG_EQ(decoded.GetRequestId(), 7, "Request ID");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetPosition().y, -3.25, 1e-9, "Originator position");
+    NS_TEST_ASSERT_MSG_EQ_TOL(decoded.GetVelocity().x, 12.5, 1e-9, "Originator velocity");
+    Rectangle zone = decoded.GetRequestZone();
+    NS_TEST_ASSERT_MSG_EQ_TOL(zone.xMin, 100, 1e-9, "Zone x min");
+    NS_TEST_ASSERT_MSG_EQ_TOL(zone.xMax, 1100, 1e-9, "Zone x max");
+    NS_TEST_ASSERT_MSG_EQ_TOL(zone.yMin, -100.5, 1e-9, "Zone y min");
+    NS_TEST_ASSERT_MSG_EQ_TOL(zone.yMax, 100, 1e-9, "Zone y max");
+
+    rtmhr::RtMhrShim shim;
+    shim.SetTarget(Vector(-1500.25, 320.5, 7.0));
+    NS_TEST_ASSERT_MSG_EQ(shim.GetSerializedSize(), 3 + 8, "Target section size");
+    packet = Create<Packet>(10);
+    packet->AddTrailer(shim);
+    rtmhr::RtMhrShim target;
+    NS_TEST_ASSERT_MSG_EQ(rtmhr::RtMhrShim::Peek(packet, target), true, "Shim found");
+    NS_TEST_ASSERT_MSG_EQ(target.HasTarget(), true, "Target section");
+    NS_TEST_ASSERT_MSG_EQ_TOL(target.GetTarget().x, -1500.25, 0.005, "Target x");
+    NS_TEST_ASSERT_MSG_EQ_TOL(target.GetTarget().y, 320.5, 0.005, "Target y");
+    NS_TEST_ASSERT_MSG_EQ_TOL(target.GetTarget().z, 0.0, 1e-12, "Planar target");
+}
+
+void
+RtMhrGeoForwardingTestCase::CheckGreedyRoute()
+{
+    Ptr<RtMhr> source = m_rtmhr.GetRtMhr(m_nodes.Get(0));
+    Ptr<Packet> packet = Create<Packet>(64);
+    Ipv4Header header;
+    header.SetDestination(Ipv4Address("10.1.1.100"));
+    Socket::SocketErrno error;
+    Ptr<Ipv4Route> route = source->RouteOutput(packet, header, nullptr, error);
+    NS_TEST_ASSERT_MSG_EQ((route != nullptr), true, "Route towards the position");
+    NS_TEST_ASSERT_MSG_EQ(route->GetGateway(), Ipv4Address("10.1.1.3"), "Neighbor closest to it");
+    rtmhr::RtMhrShim shim;
+    NS_TEST_ASSERT_MSG_EQ(rtmhr::RtMhrShim::Peek(packet, shim), true, "Shim for the relays");
+    NS_TEST_ASSERT_MSG_EQ(packet->GetSize(), 64 + 3 + 8, "Target section on the air");
+    NS_TEST_ASSERT_MSG_EQ(shim.HasDeadline(), false, "No real-time traffic");
+    NS_TEST_ASSERT_MSG_EQ_TOL(shim.GetTarget().x, 1000, 1e-9, "Position in the shim");
+}
+
+void
+RtMhrGeoForwardingTestCase::SendToRoadSideUnit()
+{
+    Ptr<Socket> socket = Socket::CreateSocket(m_nodes.Get(2), UdpSocketFactory::GetTypeId());
+    socket->SendTo(Create<Packet>(64), 0, InetSocketAddress(Ipv4Address("10.1.1.100"), 9));
+}
+
+void
+RtMhrGeoForwardingTestCase::TestForwarding()
+{
+    m_nodes.Create(3);
+    SimpleNetDeviceHelper deviceHelper;
+    deviceHelper.SetChannel("ns3::SimpleChannel");
+    NetDeviceContainer devices = deviceHelper.Install(m_nodes);
+    InternetStackHelper internet;
+    m_rtmhr.Set("GeoForwarding", BooleanValue(true));
+    m_rtmhr.AddKnownPosition(Ipv4Address("10.1.1.100"), Vector(1000, 0, 0));
+    internet.SetRoutingHelper(m_rtmhr);
+    internet.Install(m_nodes);
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.1.1.0", "255.255.255.0");
+    ipv4.Assign(devices);
+    MobilityHelper mobility;
+    Ptr<ListPositionAllocator> positionAlloc = CreateObject<ListPositionAllocator>();
+    positionAlloc->Add(Vector(0.0, 0.0, 0.0));
+    positionAlloc->Add(Vector(150.0, 0.0, 0.0));
+    positionAlloc->Add(Vector(200.0, 0.0, 0.0));
+    mobility.SetPositionAllocator(positionAlloc);
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.Install(m_nodes);
+
+    Simulator::Schedule(Seconds(4), &RtMhrGeoForwardingTestCase::CheckGreedyRoute, this);
+    Simulator::ScheduleWithContext(m_nodes.Get(2)->GetId(),
+                                   Seconds(4.5),
+                                   &RtMhrGeoForwardingTestCase::SendToRoadSideUnit,
+                                   this);
+    Simulator::Stop(Seconds(6));
+    Simulator::Run();
+
+    RtMhrStats outside = m_rtmhr.GetRtMhr(m_nodes.Get(0))->GetStats();
+    RtMhrStats relay = m_rtmhr.GetRtMhr(m_nodes.Get(1))->GetStats();
+    RtMhrStats deadEnd = m_rtmhr.GetRtMhr(m_nodes.Get(2))->GetStats();
+    NS_TEST_ASSERT_MSG_EQ(outside.greedyForwards, 1, "Forwarded without a route");
+    NS_TEST_ASSERT_MSG_EQ(deadEnd.greedyDeadEnds, 1, "No neighbor closer than the last node");
+    NS_TEST_ASSERT_MSG_GT(deadEnd.sent[RTMHR_ZONE_RREQ].packets, 0, "Zone RREQs sent");
+    NS_TEST_ASSERT_MSG_EQ(deadEnd.sent[RTMHR_RREQ].packets, 0, "No plain RREQ yet");
+    NS_TEST_ASSERT_MSG_GT(relay.sent[RTMHR_ZONE_RREQ].packets, 0, "Rebroadcast inside the zone");
+    NS_TEST_ASSERT_MSG_GT(outside.dropped[RTMHR_ZONE_RREQ].packets, 0, "Dropped outside it");
+    NS_TEST_ASSERT_MSG_EQ(outside.sent[RTMHR_ZONE_RREQ].packets, 0, "Never rebroadcast outside");
+
+    // The zone RREQs told the others where their originator is
+    Vector center;
+    double radius;
+    const RtMhrLocationTable& locations = m_rtmhr.GetRtMhr(m_nodes.Get(0))->GetLocationTable();
+    NS_TEST_ASSERT_MSG_EQ(locations.Lookup(Ipv4Address("10.1.1.3"), center, radius),
+                          true,
+                          "Originator located");
+    NS_TEST_ASSERT_MSG_EQ_TOL(center.x, 200, 0.01, "Originator position");
+    Simulator::Destroy();
+}
+
+void
+RtMhrGeoForwardingTestCase::DoRun()
+{
+    TestLocationTable();
+    TestHeader();
+    TestForwarding();
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR incremental route re-ranking test case
+ */
+class RtMhrRerankTestCase : public TestCase
+{
+  public:
+    RtMhrRerankTestCase();
+    virtual ~RtMhrRerankTestCase();
+
+  private:
+    virtual void DoRun() override;
+};
+
+RtMhrRerankTestCase::RtMhrRerankTestCase()
+    : TestCase("RT-MHR incremental route re-ranking test")
+{
+}
+
+RtMhrRerankTestCase::~RtMhrRerankTestCase()
+{
+}
+
+void
+RtMhrRerankTestCase::DoRun()
+{
+    Ipv4Address a("10.1.1.2");
+    Ipv4Address b("10.1.1.3");
+    Ipv4Address c("10.1.1.4");
+    Ipv4Address d("10.1.1.9");
+    Ipv4Address e("10.1.1.10");
+
+    // The index keeps one link per route and neighbor and forgets stale ones when visited
+    RtMhrRouteIndex index;
+    index.Add(a, d);
+    index.Add(a, d);
+    index.Add(a, e);
+    index.Add(b, d);
+    NS_TEST_ASSERT_MSG_EQ(index.GetSize(), 3, "Duplicate link ignored");
+    uint32_t visited = 0;
+    uint32_t left = index.Visit(a, [&visited, d](Ipv4Address dst) {
+        visited++;
+        return dst == d;
+    });
+    NS_TEST_ASSERT_MSG_EQ(left, 1, "Only the dependent route left");
+    NS_TEST_ASSERT_MSG_EQ(visited, 2, "Only the routes through the neighbor visited");
+    NS_TEST_ASSERT_MSG_EQ(index.GetSize(), 2, "Stale link forgotten");
+    NS_TEST_ASSERT_MSG_EQ(index.Visit(c, [](Ipv4Address) { return true; }), 0, "Unknown neighbor");
+    index.Remove(b, d);
+    index.Remove(b, d);
+    NS_TEST_ASSERT_MSG_EQ(index.GetSize(), 1, "Removed link forgotten once");
+    NS_TEST_ASSERT_MSG_EQ(index.Visit(b, [](Ipv4Address) { return true; }), 0, "None left via b");
+
+    auto makePath = [](Ipv4Address nextHop, uint32_t hopCount, double upstream) {
+        RoutePath path{nextHop, 1, hopCount, Seconds(30), CrossLayerMetric(), Time::Max(),
+                       upstream};
+        path.metric.linkQuality = 1.0;
+        path.metric.hopCount = hopCount;
+        path.metric.mobilityMetric = upstream;
+        return path;
+    };
+    RtMhrMetricEngine engine;
+    RouteEntry entry(d, Seconds(30));
+    entry.SetPrimary(makePath(a, 2, 0.0));
+    entry.OfferPath(makePath(b, 2, 0.0), engine, 3);
+    entry.OfferPath(makePath(c, 3, 0.5), engine, 3);
+    NS_TEST_ASSERT_MSG_EQ(entry.nextHop, a, "Primary wins the tie");
+    NS_TEST_ASSERT_MSG_EQ(entry.backupPaths.size(), 2, "Both backups kept");
+    NS_TEST_ASSERT_MSG_EQ(entry.backupPaths[0].nextHop, b, "Shorter backup first");
+
+    // A weaker first link demotes the primary, which sinks to its rank
+    entry.route = Create<Ipv4Route>();
+    NS_TEST_ASSERT_MSG_EQ(entry.Reprice(a, 0.2, 0.0, engine), true, "Backup overtakes");
+    NS_TEST_ASSERT_MSG_EQ(entry.nextHop, b, "Best backup promoted");
+    NS_TEST_ASSERT_MSG_EQ(entry.route, nullptr, "Cached route dropped");
+    NS_TEST_ASSERT_MSG_EQ(entry.backupPaths[0].nextHop, c, "Longer but better path first");
+    NS_TEST_ASSERT_MSG_EQ(entry.backupPaths[1].nextHop, a, "Demoted primary last");
+    NS_TEST_ASSERT_MSG_EQ_TOL(entry.backupPaths[1].metric.linkQuality,
+                              0.2,
+                              1e-9,
+                              "First link refreshed");
+
+    // A repriced backup only moves among the backups, keeping its path's mobility
+    NS_TEST_ASSERT_MSG_EQ(entry.Reprice(c, 0.1, 0.0, engine), false, "Primary unchanged");
+    NS_TEST_ASSERT_MSG_EQ(entry.backupPaths[0].nextHop, a, "Other backup moves up");
+    NS_TEST_ASSERT_MSG_EQ(entry.backupPaths[1].nextHop, c, "Repriced backup sinks");
+    NS_TEST_ASSERT_MSG_EQ_TOL(entry.backupPaths[1].metric.mobilityMetric,
+                              0.5,
+                              1e-9,
+                              "Upstream mobility kept");
+
+    // The primary keeps ties, and loses to a backup that is strictly better
+    NS_TEST_ASSERT_MSG_EQ(entry.Reprice(a, 1.0, 0.0, engine), false, "Tie kept by the primary");
+    NS_TEST_ASSERT_MSG_EQ(entry.nextHop, b, "Primary unchanged by a tie");
+    NS_TEST_ASSERT_MSG_EQ(entry.Reprice(b, 0.9, 0.0, engine), true, "Primary overtaken");
+    NS_TEST_ASSERT_MSG_EQ(entry.nextHop, a, "Recovered path promoted");
+    NS_TEST_ASSERT_MSG_EQ(entry.backupPaths[0].nextHop, b, "Old primary best backup");
+
+    // A less stable first link than the rest of the path rates it
+    NS_TEST_ASSERT_MSG_EQ(entry.Reprice(a, 1.0, 3.0, engine), true, "Unstable link demoted");
+    NS_TEST_ASSERT_MSG_EQ(entry.nextHop, b, "Stable path promoted");
+    NS_TEST_ASSERT_MSG_EQ_TOL(entry.backupPaths[0].metric.mobilityMetric,
+                              3.0,
+                              1e-9,
+                              "Link mobility rates the path");
+    NS_TEST_ASSERT_MSG_EQ(entry.Reprice(Ipv4Address("10.1.1.5"), 0.5, 0.0, engine),
+                          false,
+                          "No path through the next hop");
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR real-time deadline and admission control test case
+ */
+class RtMhrDeadlineTestCase : public TestCase
+{
+  public:
+    RtMhrDeadlineTestCase();
+    virtual ~RtMhrDeadlineTestCase();
+
+  private:
+    virtual void DoRun() override;
+    void CheckAdmission();
+    void CheckDeadlineDrop();
+    void Forwarded(Ptr<Ipv4Route> route, Ptr<const Packet> p, const Ipv4Header& header);
+    void Dropped(Ptr<const Packet> p, const Ipv4Header& header, Socket::SocketErrno err);
+
+    /**
+     * \brief Relay a real-time packet through the middle node
+     * \param deadline the deadline it carries
+     */
+    void Relay(Time deadline);
+
+    NodeContainer m_nodes;        ///< Source, relay and destination
+    NetDeviceContainer m_devices; ///< Their devices
+    RtMhrHelper m_rtmhr;          ///< Helper of the scenario
+    uint32_t m_forwarded;         ///< Packets the relay passed on
+    uint32_t m_dropped;           ///< Packets the relay dropped
+};
+
+RtMhrDeadlineTestCase::RtMhrDeadlineTestCase()
+    : TestCase("RT-MHR real-time deadline and admission control test"),
+      m_forwarded(0),
+      m_dropped(0)
+{
+}
+
+RtMhrDeadlineTestCase::~RtMhrDeadlineTestCase()
+{
+}
+
+void
+RtMhrDeadlineTestCase::Forwarded(Ptr<Ipv4Route> route,
+                                 Ptr<const Packet> p,
+                                 const Ipv4Header& header)
+{
+    m_forwarded++;
+}
+
+void
+RtMhrDeadlineTestCase::Dropped(Ptr<const Packet> p,
+                               const Ipv4Header& header,
+                               Socket::SocketErrno err)
+{
+    m_dropped++;
+}
+
+void
+RtMhrDeadlineTestCase::CheckAdmission()
+{
+    Ptr<RtMhr> source = m_rtmhr.GetRtMhr(m_nodes.Get(0));
+    Ipv4Header header;
+    header.SetDestination(Ipv4Address("10.1.1.2"));
+    header.SetProtocol(17);
+    Socket::SocketErrno error;
+
+    // One clean link of 2 ms fits the 10 ms budget
+    Ptr<Packet> packet = Create<Packet>(64);
+    NS_TEST_ASSERT_MSG_NE(source->RouteOutput(packet, header, nullptr, error),
+                          nullptr,
+                          "Flow admitted");
+    rtmhr::RtMhrShim shim;
+    NS_TEST_ASSERT_MSG_EQ(rtmhr::RtMhrShim::Peek(packet, shim), true, "Real-time packet shimmed");
+    NS_TEST_ASSERT_MSG_EQ(packet->GetSize(), 64 + 3 + 4, "Deadline section on the air");
+    NS_TEST_ASSERT_MSG_EQ(shim.HasDeadline(), true, "Deadline section");
+    NS_TEST_ASSERT_MSG_EQ(shim.GetDeadline(),
+                          Simulator::Now() + MilliSeconds(10),
+                          "Deadline is the send time plus the budget");
+    NS_TEST_ASSERT_MSG_EQ(source->GetStats().shims.bytes, 7, "Shim bytes counted");
+
+    // TCP is medium priority by default: no deadline, no admission control
+    header.SetProtocol(6);
+    packet = Create<Packet>(64);
+    source->RouteOutput(packet, header, nullptr, error);
+    NS_TEST_ASSERT_MSG_EQ(packet->GetSize(), 64, "Other traffic has no shim");
+
+    // Over slower links a new flow is refused, while the admitted one keeps going
+    source->SetAttribute("LinkDelay", TimeValue(MilliSeconds(20)));
+    header.SetProtocol(17);
+    header.SetDestination(Ipv4Address("10.1.1.3"));
+    NS_TEST_ASSERT_MSG_EQ(source->RouteOutput(Create<Packet>(64), header, nullptr, error),
+                          nullptr,
+                          "New flow refused");
+    NS_TEST_ASSERT_MSG_EQ(error, Socket::ERROR_NOROUTETOHOST, "Refusal reported");
+    header.SetDestination(Ipv4Address("10.1.1.2"));
+    NS_TEST_ASSERT_MSG_NE(source->RouteOutput(Create<Packet>(64), header, nullptr, error),
+                          nullptr,
+                          "Admitted flow kept");
+
+    RtMhrStats stats = source->GetStats();
+    NS_TEST_ASSERT_MSG_EQ(stats.admissions, 1, "One flow admitted");
+    NS_TEST_ASSERT_MSG_EQ(stats.admissionRejects, 1, "One flow refused");
+}
+
+void
+RtMhrDeadlineTestCase::Relay(Time deadline)
+{
+    rtmhr::RtMhrShim shim;
+    shim.SetDeadline(deadline);
+    Ptr<Packet> packet = Create<Packet>(64);
+    packet->AddTrailer(shim);
+    Ipv4Header header;
+    header.SetSource(Ipv4Address("10.1.1.1"));
+    header.SetDestination(Ipv4Address("10.1.1.3"));
+    header.SetProtocol(17);
+    header.SetTtl(64);
+    m_rtmhr.GetRtMhr(m_nodes.Get(1))
+        ->RouteInput(packet,
+                     header,
+                     m_devices.Get(1),
+                     MakeCallback(&RtMhrDeadlineTestCase::Forwarded, this),
+                     Ipv4RoutingProtocol::MulticastForwardCallback(),
+                     Ipv4RoutingProtocol::LocalDeliverCallback(),
+                     MakeCallback(&RtMhrDeadlineTestCase::Dropped, this));
+}
+
+void
+RtMhrDeadlineTestCase::CheckDeadlineDrop()
+{
+    // The last link takes 2 ms: 1 ms left is too little, 1 s plenty
+    Relay(Simulator::Now() + MilliSeconds(1));
+    Relay(Simulator::Now() + Seconds(1));
+    NS_TEST_ASSERT_MSG_EQ(m_dropped, 1, "Late packet dropped");
+    NS_TEST_ASSERT_MSG_EQ(m_forwarded, 1, "Timely packet forwarded");
+    RtMhrStats stats = m_rtmhr.GetRtMhr(m_nodes.Get(1))->GetStats();
+    NS_TEST_ASSERT_MSG_EQ(stats.deadlineDrops, 1, "Deadline drop counted");
+}
+
+void
+RtMhrDeadlineTestCase::DoRun()
+{
+    rtmhr::RtMhrShim shim;
+    shim.SetDeadline(Seconds(1.5));
+    NS_TEST_ASSERT_MSG_EQ(shim.GetSerializedSize(), 3 + 4, "Deadline section size");
+    Ptr<Packet> shimmed = Create<Packet>(10);
+    shimmed->AddTrailer(shim);
+    rtmhr::RtMhrShim copy;
+    rtmhr::RtMhrShim::Peek(shimmed, copy);
+    NS_TEST_ASSERT_MSG_EQ(copy.GetDeadline(), Seconds(1.5), "Deadline round trip");
+    NS_TEST_ASSERT_MSG_EQ(copy.HasDigest(), false, "Only the deadline section");
+
+    // Only the low-order 32 bits of microseconds travel, read as the nearest
+    // time that has them
+    shim.SetDeadline(MicroSeconds(uint64_t(1) << 32) + MilliSeconds(1));
+    NS_TEST_ASSERT_MSG_EQ(shim.GetDeadline(), MilliSeconds(1), "Deadline a wrap away");
+
+    m_nodes.Create(3);
+    SimpleNetDeviceHelper deviceHelper;
+    deviceHelper.SetChannel("ns3::SimpleChannel");
+    m_devices = deviceHelper.Install(m_nodes);
+    InternetStackHelper internet;
+    m_rtmhr.Set("DeadlineBudget", TimeValue(MilliSeconds(10)));
+    internet.SetRoutingHelper(m_rtmhr);
+    internet.Install(m_nodes);
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.1.1.0", "255.255.255.0");
+    ipv4.Assign(m_devices);
+
+    Simulator::Schedule(Seconds(4), &RtMhrDeadlineTestCase::CheckAdmission, this);
+    Simulator::Schedule(Seconds(4.5), &RtMhrDeadlineTestCase::CheckDeadlineDrop, this);
+    Simulator::Stop(Seconds(5));
+    Simulator::Run();
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR test topology generator test case
+ */
+class RtMhrTestTopologyTestCase : public TestCase
+{
+  public:
+    RtMhrTestTopologyTestCase();
+    virtual ~RtMhrTestTopologyTestCase();
+
+  private:
+    virtual void DoRun() override;
+
+    /**
+     * \brief Check that HELLOs found exactly the nodes in range
+     * \param topology the scenario
+     */
+    void CheckNeighbors(const RtMhrTestTopology* topology);
+
+    RtMhrHelper m_rtmhr; ///< Helper of the scenarios
+};
+
+RtMhrTestTopologyTestCase::RtMhrTestTopologyTestCase()
+    : TestCase("RT-MHR test topology generator test")
+{
+}
+
+RtMhrTestTopologyTestCase::~RtMhrTestTopologyTestCase()
+{
+}
+
+void
+RtMhrTestTopologyTestCase::CheckNeighbors(const RtMhrTestTopology* topology)
+{
+    for (uint32_t i = 0; i < topology->GetNodes().GetN(); i++)
+    {
+        RtMhrStats stats = m_rtmhr.GetRtMhr(topology->GetNodes().Get(i))->GetStats();
+        NS_TEST_ASSERT_MSG_EQ(stats.neighborTableSize,
+                              topology->GetDegree(i),
+                              "Neighbors of node " << i << " are the nodes in range");
+    }
+}
+
+void
+RtMhrTestTopologyTestCase::DoRun()
+{
+    // 3x3 grid, 100 m apart: diagonals are in range, two steps are not
+    RtMhrTestTopology grid(RtMhrTestTopology::GRID, 9);
+    grid.SetSpacing(100.0);
+    grid.SetRange(150.0);
+    grid.Install(m_rtmhr);
+    NS_TEST_ASSERT_MSG_EQ(grid.GetPosition(5).x, 200.0, "Grid column");
+    NS_TEST_ASSERT_MSG_EQ(grid.GetPosition(5).y, 100.0, "Grid row");
+    NS_TEST_ASSERT_MSG_EQ(grid.GetDegree(0), 3, "Corner degree");
+    NS_TEST_ASSERT_MSG_EQ(grid.GetDegree(4), 8, "Center degree");
+    NS_TEST_ASSERT_MSG_EQ(grid.GetHopCounts(0)[8], 2, "Corner to corner through the center");
+    NS_TEST_ASSERT_MSG_EQ(grid.GetAddress(8), Ipv4Address("10.1.0.9"), "Addresses in order");
+    Simulator::Schedule(Seconds(3), &RtMhrTestTopologyTestCase::CheckNeighbors, this, &grid);
+    Simulator::Stop(Seconds(3.5));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    // The same seed gives the same layout, another seed another one
+    std::vector<Vector> first;
+    for (uint32_t seed : {7, 7, 8})
+    {
+        RtMhrTestTopology random(RtMhrTestTopology::RANDOM_GEOMETRIC, 20);
+        random.SetSeed(seed);
+        random.Install(m_rtmhr);
+        for (uint32_t i = 0; i < 20; i++)
+        {
+            const Vector& position = random.GetPosition(i);
+            NS_TEST_ASSERT_MSG_EQ((position.x >= 0 && position.x < 120.0 * std::sqrt(20) &&
+                                   position.y >= 0 && position.y < 120.0 * std::sqrt(20)),
+                                  true,
+                                  "Random position inside the square");
+        }
+        if (first.empty())
+        {
+            for (uint32_t i = 0; i < 20; i++)
+            {
+                first.push_back(random.GetPosition(i));
+            }
+        }
+        else
+        {
+            bool same = true;
+            for (uint32_t i = 0; i < 20; i++)
+            {
+                same = same && first[i].x == random.GetPosition(i).x &&
+                       first[i].y == random.GetPosition(i).y;
+            }
+            NS_TEST_ASSERT_MSG_EQ(same, seed == 7, "Layout follows the seed");
+        }
+        Simulator::Destroy();
+    }
+
+    // Alternate lanes drive in opposite directions
+    RtMhrTestTopology highway(RtMhrTestTopology::HIGHWAY, 8);
+    highway.SetLanes(2);
+    highway.SetSpeed(25.0);
+    highway.Install(m_rtmhr);
+    Ptr<MobilityModel> east = highway.GetNodes().Get(2)->GetObject<MobilityModel>();
+    Ptr<MobilityModel> west = highway.GetNodes().Get(3)->GetObject<MobilityModel>();
+    NS_TEST_ASSERT_MSG_EQ(east->GetVelocity().x, 25.0, "Even lane drives east");
+    NS_TEST_ASSERT_MSG_EQ(west->GetVelocity().x, -25.0, "Odd lane drives west");
+    NS_TEST_ASSERT_MSG_EQ(highway.GetPosition(3).x, 180.0, "Odd lanes are staggered");
+    NS_TEST_ASSERT_MSG_EQ(highway.GetPosition(3).y, 4.0, "Lanes 4 m apart");
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR large-scale regression test case
+ *
+ * Runs a topology of hundreds of nodes on the idealized channel for 15 s and
+ * starts route discoveries between nodes 2 to 12 hops apart at 5 s. The bounds
+ * are loose enough to hold on any machine yet catch a protocol change that
+ * makes discoveries fail or wait, floods the network or bloats the tables:
+ *
+ * - nine discoveries out of ten succeed, in under 4096 ms for 95% of them;
+ *   the expanding ring alone gives up on a ring after at most 720 ms;
+ * - each node sends at most 512 bytes of control messages per second, where
+ *   a HELLO a second and the unicast PROBEs to a dozen neighbors make ~100;
+ * - no routing table outgrows 16 KiB, that is the neighbors and the routes
+ *   to some 20 flow ends, with room to spare;
+ * - the run stays within a wall-clock budget for its size, when the
+ *   RTMHR_ENFORCE_WALL_CLOCK environment variable is set; otherwise the run
+ *   time is only reported, as it depends on the machine and its load.
+ */
+class RtMhrScalingTestCase : public TestCase
+{
+  public:
+    /**
+     * \brief Constructor
+     * \param layout the layout
+     * \param nodes the number of nodes
+     * \param budget the longest the run may take, in wall-clock ms
+     */
+    RtMhrScalingTestCase(RtMhrTestTopology::Layout layout, uint32_t nodes, int64_t budget);
+    virtual ~RtMhrScalingTestCase();
+
+  private:
+    virtual void DoRun() override;
+
+    /**
+     * \brief Name a test case
+     * \param layout the layout
+     * \param nodes the number of nodes
+     * \return the name
+     */
+    static std::string GetName(RtMhrTestTopology::Layout layout, uint32_t nodes);
+
+    /// Pick the flows: distinct sources, destinations several hops away
+    void PickFlows();
+
+    /**
+     * \brief Send a datagram along a flow
+     * \param flow the flow index
+     */
+    void Send(uint32_t flow);
+
+    /// Flows of the scenario
+    static constexpr uint32_t FLOWS = 10;
+
+    RtMhrTestTopology m_topology;                       ///< Scenario
+    int64_t m_budget;                                   ///< Wall-clock budget, in ms
+    RtMhrHelper m_rtmhr;                                ///< Helper of the scenario
+    std::vector<std::pair<uint32_t, uint32_t>> m_flows; ///< Source and destination indices
+};
+
+RtMhrScalingTestCase::RtMhrScalingTestCase(RtMhrTestTopology::Layout layout,
+                                           uint32_t nodes,
+                                           int64_t budget)
+    : TestCase(GetName(layout, nodes)),
+      m_topology(layout, nodes),
+      m_budget(budget)
+{
+}
+
+RtMhrScalingTestCase::~RtMhrScalingTestCase()
+{
+}
+
+std::string
+RtMhrScalingTestCase::GetName(RtMhrTestTopology::Layout layout, uint32_t nodes)
+{
+    const char* names[] = {"grid", "random geometric", "highway"};
+    std::ostringstream name;
+    name << "RT-MHR scaling test, " << nodes << " node " << names[layout];
+    return name.str();
+}
+
+void
+RtMhrScalingTestCase::PickFlows()
+{
+    // 7919 is prime, so the sources run through every node in a fixed order
+    uint32_t nodes = m_topology.GetNodes().GetN();
+    for (uint32_t i = 0; i < nodes && m_flows.size() < FLOWS; i++)
+    {
+        uint32_t source = (i * 7919 + 13) % nodes;
+        std::vector<uint32_t> hops = m_topology.GetHopCounts(source);
+        std::vector<uint32_t> candidates;
+        for (uint32_t j = 0; j < nodes; j++)
+        {
+            if (hops[j] >= 2 && hops[j] <= 12)
+            {
+                candidates.push_back(j);
+            }
+        }
+        if (!candidates.empty())
+        {
+            uint32_t k = m_flows.size();
+            m_flows.emplace_back(source, candidates[(k * 31) % candidates.size()]);
+        }
+    }
+}
+
+void
+RtMhrScalingTestCase::Send(uint32_t flow)
+{
+    Ptr<Node> source = m_topology.GetNodes().Get(m_flows[flow].first);
+    Ipv4Address destination = m_topology.GetAddress(m_flows[flow].second);
+    Ptr<Socket> socket = Socket::CreateSocket(source, UdpSocketFactory::GetTypeId());
+    socket->SendTo(Create<Packet>(64), 0, InetSocketAddress(destination, 9));
+    socket->Close();
+}
+
+void
+RtMhrScalingTestCase::DoRun()
+{
+    SystemWallClockMs clock;
+    clock.Start();
+    m_topology.Install(m_rtmhr);
+    PickFlows();
+    NS_TEST_ASSERT_MSG_EQ(m_flows.size(), FLOWS, "Enough routable flows");
+    for (uint32_t i = 0; i < FLOWS; i++)
+    {
+        // Stagger the flows a little, as applications would
+        Simulator::Schedule(Seconds(5) + MilliSeconds(10 * i),
+                            &RtMhrScalingTestCase::Send,
+                            this,
+                            i);
+    }
+    Time duration = Seconds(15);
+    Simulator::Stop(duration);
+    Simulator::Run();
+    int64_t elapsed = clock.End();
+
+    RtMhrStats total;
+    uint32_t largest = 0;
+    for (uint32_t i = 0; i < m_topology.GetNodes().GetN(); i++)
+    {
+        RtMhrStats stats = m_rtmhr.GetRtMhr(m_topology.GetNodes().Get(i))->GetStats();
+        total.Merge(stats);
+        largest = std::max(largest, stats.routeTableSize);
+    }
+    Simulator::Destroy();
+
+    NS_TEST_ASSERT_MSG_GT_OR_EQ(total.discoveries, FLOWS, "Every flow needed a discovery");
+    NS_TEST_ASSERT_MSG_GT_OR_EQ(total.discoveryLatency.GetCount() * 10,
+                                FLOWS * 9,
+                                "Discoveries succeed");
+
+    // The ceilings below are provisional: they were set from the protocol's
+    // timers and message sizes, not from measured runs, and only catch gross
+    // regressions. The measured values are reported so they can be tightened
+    Time latency = total.discoveryLatency.GetQuantile(0.95);
+    double overhead = RtMhrStats::GetTotal(total.sent).bytes /
+                      (m_topology.GetNodes().GetN() * duration.GetSeconds());
+    uint32_t memory = largest * sizeof(RtMhrRoutingTable::Value);
+    std::clog << TestCase::GetName() << ": 95th percentile discovery latency "
+              << latency.As(Time::MS) << ", " << overhead << " control bytes per node and second, "
+              << memory << " bytes in the largest routing table" << std::endl;
+    NS_TEST_ASSERT_MSG_LT_OR_EQ(latency, MilliSeconds(4096), "Discovery latency");
+    NS_TEST_ASSERT_MSG_LT_OR_EQ(overhead, 512.0, "Control bytes per node and second");
+    NS_TEST_ASSERT_MSG_LT_OR_EQ(memory, 16384, "Routing table memory per node");
+    if (std::getenv("RTMHR_ENFORCE_WALL_CLOCK"))
+    {
+        NS_TEST_ASSERT_MSG_LT_OR_EQ(elapsed, m_budget, "Wall-clock time");
+    }
+    else
+    {
+        std::clog << TestCase::GetName() << ": " << elapsed << " ms of a " << m_budget
+                  << " ms wall-clock budget" << std::endl;
+    }
+}
+
+/**
+ * \ingroup rtmhr-test
+ * \ingroup tests
+ * \brief RT-MHR Test Suite
+ */
+class RtMhrTestSuite : public TestSuite
+{
+  public:
+    RtMhrTestSuite();
+};
+
+RtMhrTestSuite::RtMhrTestSuite()
+    : TestSuite("rtmhr", Type::UNIT)
+{
+    AddTestCase(new RtMhrBasicTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrMetricTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrRouteCacheTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrTableTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrIdCacheTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrTimingWheelTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrRequestQueueTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrDeferredRouteTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrRreqRateLimitTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrRouteRefreshTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrHeaderTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrDispatchTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrMetricDigestTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrPriorityQueueTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrClassifierTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrMultipathTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrLinkEstimationTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrBeaconSchedulerTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrMobilityTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrRouteFreshnessTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrDiscoveryTestCase(false), Duration::QUICK);
+    AddTestCase(new RtMhrDiscoveryTestCase(true), Duration::QUICK);
+    AddTestCase(new RtMhrFloodControlTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrStatsTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrSnapshotTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrRouteRequestHeapTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrPartitionTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrGeoForwardingTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrRerankTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrDeadlineTestCase, Duration::QUICK);
+    AddTestCase(new RtMhrTestTopologyTestCase, Duration::QUICK);
+
+    // Large-scale regressions, on the idealized channel; run with --fullness=EXTENSIVE
+    for (auto layout : {RtMhrTestTopology::GRID,
+                        RtMhrTestTopology::RANDOM_GEOMETRIC,
+                        RtMhrTestTopology::HIGHWAY})
+    {
+        AddTestCase(new RtMhrScalingTestCase(layout, 100, 30000), Duration::EXTENSIVE);
+        AddTestCase(new RtMhrScalingTestCase(layout, 500, 120000), Duration::EXTENSIVE);
+        AddTestCase(new RtMhrScalingTestCase(layout, 1000, 300000), Duration::EXTENSIVE);
+    }
 }
 
 // Do not forget to allocate an instance of this TestSuite
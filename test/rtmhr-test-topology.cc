@@ -0,0 +1,279 @@
+#include "rtmhr-test-topology.h"
+
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/double.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/log.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/wifi-helper.h"
+#include "ns3/wifi-mac-helper.h"
+#include "ns3/yans-wifi-helper.h"
+
+#include <cmath>
+#include <deque>
+#include <random>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("RtMhrTestTopology");
+
+NS_OBJECT_ENSURE_REGISTERED(RtMhrTestChannel);
+
+TypeId
+RtMhrTestChannel::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::RtMhrTestChannel")
+                            .SetParent<SimpleChannel>()
+                            .SetGroupName("RtMhr")
+                            .AddConstructor<RtMhrTestChannel>()
+                            .AddAttribute("Range",
+                                          "Distance, in meters, up to which frames are received.",
+                                          DoubleValue(250.0),
+                                          MakeDoubleAccessor(&RtMhrTestChannel::m_range),
+                                          MakeDoubleChecker<double>(0.0))
+                            .AddAttribute("PropagationDelay",
+                                          "Delay between sending and receiving a frame.",
+                                          TimeValue(MicroSeconds(1)),
+                                          MakeTimeAccessor(&RtMhrTestChannel::m_delay),
+                                          MakeTimeChecker(Time(0)));
+    return tid;
+}
+
+RtMhrTestChannel::RtMhrTestChannel()
+    : m_range(250.0),
+      m_delay(MicroSeconds(1))
+{
+}
+
+void
+RtMhrTestChannel::Send(Ptr<Packet> p,
+                       uint16_t protocol,
+                       Mac48Address to,
+                       Mac48Address from,
+                       Ptr<SimpleNetDevice> sender)
+{
+    NS_LOG_FUNCTION(this << p << protocol << to << from << sender);
+    Ptr<MobilityModel> source = sender->GetNode()->GetObject<MobilityModel>();
+    for (std::size_t i = 0; i < m_devices.size(); i++)
+    {
+        Ptr<SimpleNetDevice> device = m_devices[i];
+        if (device == sender || source->GetDistanceFrom(GetMobility(i)) > m_range)
+        {
+            continue;
+        }
+        Simulator::ScheduleWithContext(device->GetNode()->GetId(),
+                                       m_delay,
+                                       &SimpleNetDevice::Receive,
+                                       device,
+                                       p->Copy(),
+                                       protocol,
+                                       to,
+                                       from);
+    }
+}
+
+void
+RtMhrTestChannel::Add(Ptr<SimpleNetDevice> device)
+{
+    m_devices.push_back(device);
+    m_mobility.push_back(nullptr);
+}
+
+std::size_t
+RtMhrTestChannel::GetNDevices() const
+{
+    return m_devices.size();
+}
+
+Ptr<NetDevice>
+RtMhrTestChannel::GetDevice(std::size_t i) const
+{
+    return m_devices[i];
+}
+
+Ptr<MobilityModel>
+RtMhrTestChannel::GetMobility(std::size_t i)
+{
+    // Devices are attached before the mobility models are installed
+    if (!m_mobility[i])
+    {
+        m_mobility[i] = m_devices[i]->GetNode()->GetObject<MobilityModel>();
+    }
+    return m_mobility[i];
+}
+
+RtMhrTestTopology::RtMhrTestTopology(Layout layout, uint32_t nodes)
+    : m_layout(layout),
+      m_size(nodes),
+      m_spacing(120.0),
+      m_range(250.0),
+      m_seed(1),
+      m_lanes(4),
+      m_speed(30.0),
+      m_ideal(true)
+{
+}
+
+void
+RtMhrTestTopology::Place()
+{
+    m_positions.clear();
+    m_positions.reserve(m_size);
+    if (m_layout == GRID)
+    {
+        uint32_t width = std::ceil(std::sqrt(m_size));
+        for (uint32_t i = 0; i < m_size; i++)
+        {
+            m_positions.emplace_back((i % width) * m_spacing, (i / width) * m_spacing, 0.0);
+        }
+    }
+    else if (m_layout == RANDOM_GEOMETRIC)
+    {
+        // Only the engine's output is specified by the standard, the
+        // distributions are not: scale it by hand
+        std::mt19937 engine(m_seed);
+        double side = m_spacing * std::sqrt(m_size);
+        double scale = side / 4294967296.0;
+        for (uint32_t i = 0; i < m_size; i++)
+        {
+            double x = engine() * scale;
+            double y = engine() * scale;
+            m_positions.emplace_back(x, y, 0.0);
+        }
+    }
+    else
+    {
+        // Lanes are 4 m apart; odd lanes are shifted by half a spacing
+        for (uint32_t i = 0; i < m_size; i++)
+        {
+            uint32_t lane = i % m_lanes;
+            double x = (i / m_lanes) * m_spacing + (lane % 2 ? m_spacing / 2 : 0.0);
+            m_positions.emplace_back(x, lane * 4.0, 0.0);
+        }
+    }
+}
+
+void
+RtMhrTestTopology::Link()
+{
+    m_links.assign(m_size, std::vector<uint32_t>());
+    for (uint32_t i = 0; i < m_size; i++)
+    {
+        for (uint32_t j = i + 1; j < m_size; j++)
+        {
+            if (CalculateDistance(m_positions[i], m_positions[j]) <= m_range)
+            {
+                m_links[i].push_back(j);
+                m_links[j].push_back(i);
+            }
+        }
+    }
+}
+
+void
+RtMhrTestTopology::InstallWifi()
+{
+    WifiHelper wifi;
+    wifi.SetStandard(WIFI_STANDARD_80211b);
+    wifi.SetRemoteStationManager("ns3::ConstantRateWifiManager",
+                                 "DataMode",
+                                 StringValue("DsssRate11Mbps"),
+                                 "ControlMode",
+                                 StringValue("DsssRate1Mbps"));
+
+    YansWifiChannelHelper wifiChannel;
+    wifiChannel.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
+    wifiChannel.AddPropagationLoss("ns3::RangePropagationLossModel",
+                                   "MaxRange",
+                                   DoubleValue(m_range));
+    YansWifiPhyHelper wifiPhy;
+    wifiPhy.SetChannel(wifiChannel.Create());
+
+    WifiMacHelper wifiMac;
+    wifiMac.SetType("ns3::AdhocWifiMac");
+    m_devices = wifi.Install(wifiPhy, wifiMac, m_nodes);
+}
+
+void
+RtMhrTestTopology::Install(const Ipv4RoutingHelper& routing)
+{
+    NS_LOG_FUNCTION(this << m_layout << m_size);
+    Place();
+    Link();
+    m_nodes.Create(m_size);
+
+    Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator>();
+    for (const Vector& position : m_positions)
+    {
+        positions->Add(position);
+    }
+    MobilityHelper mobility;
+    mobility.SetPositionAllocator(positions);
+    if (m_layout == HIGHWAY)
+    {
+        mobility.SetMobilityModel("ns3::ConstantVelocityMobilityModel");
+        mobility.Install(m_nodes);
+        for (uint32_t i = 0; i < m_size; i++)
+        {
+            double speed = (i % m_lanes) % 2 ? -m_speed : m_speed;
+            m_nodes.Get(i)->GetObject<ConstantVelocityMobilityModel>()->SetVelocity(
+                Vector(speed, 0.0, 0.0));
+        }
+    }
+    else
+    {
+        mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+        mobility.Install(m_nodes);
+    }
+
+    if (m_ideal)
+    {
+        SimpleNetDeviceHelper deviceHelper;
+        deviceHelper.SetChannel("ns3::RtMhrTestChannel");
+        deviceHelper.SetChannelAttribute("Range", DoubleValue(m_range));
+        m_devices = deviceHelper.Install(m_nodes);
+    }
+    else
+    {
+        InstallWifi();
+    }
+
+    InternetStackHelper internet;
+    internet.SetRoutingHelper(routing);
+    internet.Install(m_nodes);
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.1.0.0", "255.255.0.0");
+    m_interfaces = ipv4.Assign(m_devices);
+}
+
+std::vector<uint32_t>
+RtMhrTestTopology::GetHopCounts(uint32_t from) const
+{
+    std::vector<uint32_t> hops(m_size, UNREACHABLE);
+    std::deque<uint32_t> frontier;
+    hops[from] = 0;
+    frontier.push_back(from);
+    while (!frontier.empty())
+    {
+        uint32_t node = frontier.front();
+        frontier.pop_front();
+        for (uint32_t neighbor : m_links[node])
+        {
+            if (hops[neighbor] == UNREACHABLE)
+            {
+                hops[neighbor] = hops[node] + 1;
+                frontier.push_back(neighbor);
+            }
+        }
+    }
+    return hops;
+}
+
+} // namespace ns3
@@ -0,0 +1,236 @@
+#ifndef RTMHR_TEST_TOPOLOGY_H
+#define RTMHR_TEST_TOPOLOGY_H
+
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/ipv4-routing-helper.h"
+#include "ns3/mobility-model.h"
+#include "ns3/net-device-container.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/vector.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * \ingroup rtmhr-test
+ * \brief Idealized radio channel for large RT-MHR tests
+ *
+ * A SimpleChannel that hands every frame, after a fixed delay, to the devices
+ * within a fixed range of the sender: a unit disc, without loss, interference
+ * or contention. Positions are read from the nodes' MobilityModels when the
+ * frame is sent, so moving nodes gain and lose links. A frame costs one
+ * distance per attached device, where the Wi-Fi PHY tracks interference at
+ * every receiver; this is what makes runs with a thousand nodes take seconds.
+ */
+class RtMhrTestChannel : public SimpleChannel
+{
+  public:
+    /**
+     * \brief Get the type ID
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    RtMhrTestChannel();
+
+    void Send(Ptr<Packet> p,
+              uint16_t protocol,
+              Mac48Address to,
+              Mac48Address from,
+              Ptr<SimpleNetDevice> sender) override;
+    void Add(Ptr<SimpleNetDevice> device) override;
+    std::size_t GetNDevices() const override;
+    Ptr<NetDevice> GetDevice(std::size_t i) const override;
+
+  private:
+    /**
+     * \brief Get the mobility model of an attached device's node
+     * \param i the device index
+     * \return the model, looked up on first use
+     */
+    Ptr<MobilityModel> GetMobility(std::size_t i);
+
+    double m_range;                              ///< Reception range, in meters
+    Time m_delay;                                ///< Delivery delay
+    std::vector<Ptr<SimpleNetDevice>> m_devices; ///< Attached devices
+    std::vector<Ptr<MobilityModel>> m_mobility;  ///< Their nodes' mobility models
+};
+
+/**
+ * \ingroup rtmhr-test
+ * \brief Deterministic topologies for RT-MHR regression tests
+ *
+ * Builds the nodes, positions, devices, internet stack and addresses of a
+ * scenario in one call:
+ *
+ * - GRID: rows of a square grid, filled row by row;
+ * - RANDOM_GEOMETRIC: uniform positions in a square as dense as the grid;
+ * - HIGHWAY: lanes of evenly spaced vehicles, driving in alternate
+ *   directions.
+ *
+ * Random positions come from a Mersenne twister seeded with SetSeed(), so a
+ * layout is the same whatever the ns-3 run number or stream assignment. The
+ * devices sit on an RtMhrTestChannel with the transmission range, or on an
+ * 802.11b ad hoc network cut off at the same range by a
+ * RangePropagationLossModel. GetHopCounts() answers on the unit disc graph of
+ * the initial positions, for tests to pick flows that can be routed.
+ */
+class RtMhrTestTopology
+{
+  public:
+    /// Layout of the nodes
+    enum Layout
+    {
+        GRID,             ///< Square grid
+        RANDOM_GEOMETRIC, ///< Uniform in a square
+        HIGHWAY           ///< Vehicles in lanes
+    };
+
+    /// Hop count of unreachable nodes
+    static constexpr uint32_t UNREACHABLE = UINT32_MAX;
+
+    /**
+     * \brief Constructor, with 120 m spacing, 250 m range and the ideal channel
+     * \param layout the layout
+     * \param nodes the number of nodes
+     */
+    RtMhrTestTopology(Layout layout, uint32_t nodes);
+
+    /**
+     * \brief Set the distance between grid neighbors or vehicles of a lane
+     * \param spacing the distance, in meters
+     */
+    void SetSpacing(double spacing)
+    {
+        m_spacing = spacing;
+    }
+
+    /**
+     * \brief Set the transmission range
+     * \param range the range, in meters
+     */
+    void SetRange(double range)
+    {
+        m_range = range;
+    }
+
+    /**
+     * \brief Set the seed of the random geometric layout
+     * \param seed the seed
+     */
+    void SetSeed(uint32_t seed)
+    {
+        m_seed = seed;
+    }
+
+    /**
+     * \brief Set the number of highway lanes
+     * \param lanes the lanes, at least one
+     */
+    void SetLanes(uint32_t lanes)
+    {
+        m_lanes = lanes;
+    }
+
+    /**
+     * \brief Set the highway speed
+     * \param speed the speed, in m/s
+     */
+    void SetSpeed(double speed)
+    {
+        m_speed = speed;
+    }
+
+    /**
+     * \brief Choose between the ideal channel and the Wi-Fi PHY
+     * \param ideal true for RtMhrTestChannel, false for 802.11b
+     */
+    void SetIdealChannel(bool ideal)
+    {
+        m_ideal = ideal;
+    }
+
+    /**
+     * \brief Build the scenario
+     * \param routing the routing helper of the internet stack
+     */
+    void Install(const Ipv4RoutingHelper& routing);
+
+    /**
+     * \brief Get the nodes
+     * \return the nodes, in layout order
+     */
+    const NodeContainer& GetNodes() const
+    {
+        return m_nodes;
+    }
+
+    /**
+     * \brief Get the address of a node
+     * \param i the node index
+     * \return its address, in 10.1.0.0/16
+     */
+    Ipv4Address GetAddress(uint32_t i) const
+    {
+        return m_interfaces.GetAddress(i);
+    }
+
+    /**
+     * \brief Get the initial position of a node
+     * \param i the node index
+     * \return the position
+     */
+    const Vector& GetPosition(uint32_t i) const
+    {
+        return m_positions[i];
+    }
+
+    /**
+     * \brief Get the number of nodes initially in range of a node
+     * \param i the node index
+     * \return the degree
+     */
+    uint32_t GetDegree(uint32_t i) const
+    {
+        return m_links[i].size();
+    }
+
+    /**
+     * \brief Get the initial hop counts from a node
+     * \param from the node index
+     * \return the hops to every node, UNREACHABLE if disconnected
+     */
+    std::vector<uint32_t> GetHopCounts(uint32_t from) const;
+
+  private:
+    /// Compute the initial positions
+    void Place();
+    /// Link the nodes initially in range of each other
+    void Link();
+    /// Install the Wi-Fi devices
+    void InstallWifi();
+
+    Layout m_layout;                            ///< Layout
+    uint32_t m_size;                            ///< Number of nodes
+    double m_spacing;                           ///< Grid or lane spacing, in meters
+    double m_range;                             ///< Transmission range, in meters
+    uint32_t m_seed;                            ///< Seed of the random layout
+    uint32_t m_lanes;                           ///< Highway lanes
+    double m_speed;                             ///< Highway speed, in m/s
+    bool m_ideal;                               ///< Use RtMhrTestChannel
+    std::vector<Vector> m_positions;            ///< Initial positions
+    std::vector<std::vector<uint32_t>> m_links; ///< Nodes initially in range, by node
+    NodeContainer m_nodes;                      ///< Nodes
+    NetDeviceContainer m_devices;               ///< Their devices
+    Ipv4InterfaceContainer m_interfaces;        ///< Their addresses
+};
+
+} // namespace ns3
+
+#endif /* RTMHR_TEST_TOPOLOGY_H */